@@ -0,0 +1,117 @@
+#pragma once
+
+/**
+ * @file AccessLog.hpp
+ * @brief asynchronous access log written in batches by a background thread
+ * @version 1.0.0
+ *
+ * log() formats a record on the calling thread into that thread's ring
+ * buffer (single producer, single consumer, no locks) and returns. A
+ * background thread drains all rings with one writev per round, either
+ * every flush interval or sooner when a ring fills past half. When a ring
+ * is full the record is dropped and counted, or with OverflowPolicy::BLOCK
+ * the caller waits for the writer to make room.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include "HttpDefinitions.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace http_parser {
+
+enum class PARSER_EXPORT LogFormat {
+  COMMON,   // host ident user [date] "request" status bytes
+  COMBINED, // common plus "referer" "user-agent"
+  JSON,     // one object per line
+};
+
+enum class PARSER_EXPORT OverflowPolicy {
+  DROP,  // discard the record and count it
+  BLOCK, // wait until the writer made room
+};
+
+struct PARSER_EXPORT AccessLogOptions {
+  LogFormat format = LogFormat::COMBINED;
+  OverflowPolicy overflow = OverflowPolicy::DROP;
+  std::size_t ringBytes = 1 << 20; // per thread, rounded up to a power of 2
+  std::chrono::milliseconds flushInterval{100};
+  // request headers appended to every record
+  std::vector<std::string> extraHeaders;
+};
+
+// Per request values that are not part of the parsed messages.
+struct PARSER_EXPORT AccessLogEntry {
+  std::string_view remoteAddress;
+  std::string_view user;
+  std::uint64_t bytesSent = 0;
+  std::chrono::microseconds duration{0};
+  // seconds since the epoch, 0 for the current time
+  std::int64_t time = 0;
+};
+
+struct PARSER_EXPORT AccessLogStats {
+  std::uint64_t records = 0;
+  std::uint64_t dropped = 0;
+  std::uint64_t bytesWritten = 0;
+  std::uint64_t writeErrors = 0;
+};
+
+class AccessLog {
+public:
+  // records longer than this are dropped
+  static constexpr std::size_t MAX_RECORD_SIZE = 8 * 1024;
+
+  // Starts the writer thread. The descriptor is not owned.
+  PARSER_EXPORT explicit AccessLog(int file_descriptor,
+                                   AccessLogOptions options = {});
+  // Flushes everything and stops the writer thread.
+  PARSER_EXPORT ~AccessLog();
+  AccessLog(const AccessLog &) = delete;
+  AccessLog &operator=(const AccessLog &) = delete;
+
+  PARSER_EXPORT void log(const Request &request, const Response &response,
+                         const AccessLogEntry &entry = {});
+  // Waits until every record logged before the call is written.
+  PARSER_EXPORT void flush();
+  PARSER_EXPORT AccessLogStats stats() const;
+
+private:
+  struct Ring;
+
+  int fd;
+  AccessLogOptions options;
+  std::uint64_t id;
+  std::mutex mutex;
+  std::condition_variable wakeWriter;
+  std::condition_variable flushed;
+  std::vector<std::shared_ptr<Ring>> rings;
+  std::uint64_t flushRequests;
+  std::uint64_t flushesDone;
+  bool stopping;
+  std::atomic<std::uint64_t> recordCount{0};
+  std::atomic<std::uint64_t> droppedCount{0};
+  std::atomic<std::uint64_t> bytesWritten{0};
+  std::atomic<std::uint64_t> writeErrors{0};
+  std::thread writer;
+
+  Ring &threadRing();
+  void format(std::string &out, const Request &request,
+              const Response &response, const AccessLogEntry &entry) const;
+  bool drain();
+  void run();
+};
+
+}; // namespace http_parser
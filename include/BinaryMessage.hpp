@@ -0,0 +1,114 @@
+#pragma once
+
+/**
+ * @file BinaryMessage.hpp
+ * @brief compact binary encoding of parsed requests and responses
+ * @version 1.0.0
+ *
+ * Lets one process parse a message and hand it to another (over a socket
+ * or through shared memory) without the receiver parsing HTTP again.
+ * Layout, all integers little-endian and offsets relative to the start of
+ * the message:
+ *
+ *   0  u32 magic "HPBM"      20 u32 header table offset
+ *   4  u16 format version    24 u32 url / reason offset
+ *   6  u8  kind              28 u32 url / reason length
+ *   7  u8  method            32 u32 body offset
+ *   8  u8  http version      36 u32 body length
+ *   9  u8  reserved          40 header table, 16 bytes per header:
+ *   10 u16 status code          u32 key offset, u32 value offset,
+ *   12 u32 total size           u32 value length, u16 key length,
+ *   16 u32 header count         u8 HeaderId, u8 reserved
+ *
+ * followed by the string bytes. Well known header names are stored only as
+ * their HeaderId. BinaryMessageView checks all offsets once in attach() and
+ * then reads fields straight from the buffer, so a message in a mapped or
+ * shared region is used in place without decoding or allocating.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include "HttpDefinitions.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace http_parser {
+
+constexpr std::uint32_t BINARY_MESSAGE_MAGIC = 0x4d425048; // "HPBM"
+constexpr std::uint16_t BINARY_MESSAGE_VERSION = 1;
+constexpr std::size_t BINARY_MESSAGE_HEADER_SIZE = 40;
+constexpr std::size_t BINARY_MESSAGE_ENTRY_SIZE = 16;
+
+enum class PARSER_EXPORT BinaryMessageKind : std::uint8_t {
+  REQUEST = 1,
+  RESPONSE = 2,
+};
+
+// Bytes needed to encode the message, 0 if it does not fit the format.
+std::size_t PARSER_EXPORT binary_encoded_size(const Request &request,
+                                              std::string_view body = {});
+std::size_t PARSER_EXPORT binary_encoded_size(const Response &response,
+                                              std::string_view body = {});
+
+// Encodes into `out`, returns the bytes written or 0 if `capacity` is too
+// small or the message does not fit the format.
+std::size_t PARSER_EXPORT binary_encode(const Request &request,
+                                        std::string_view body, char *out,
+                                        std::size_t capacity);
+std::size_t PARSER_EXPORT binary_encode(const Response &response,
+                                        std::string_view body, char *out,
+                                        std::size_t capacity);
+// Appends the encoding to `out`.
+bool PARSER_EXPORT binary_encode(const Request &request, std::string_view body,
+                                 std::string &out);
+bool PARSER_EXPORT binary_encode(const Response &response,
+                                 std::string_view body, std::string &out);
+
+class PARSER_EXPORT BinaryMessageView {
+public:
+  BinaryMessageView() = default;
+
+  // Checks the buffer and binds the view to it. Returns false if it does
+  // not hold a complete message of a supported version.
+  bool attach(const void *data, std::size_t size);
+  bool valid() const { return base != nullptr; }
+  // encoded size, the next message of a stream starts after it
+  std::size_t size() const;
+
+  BinaryMessageKind kind() const;
+  bool is_request() const { return kind() == BinaryMessageKind::REQUEST; }
+  Method method() const;
+  Version version() const;
+  StatusCode status_code() const;
+  // request target of a request, reason phrase of a response
+  std::string_view url() const { return text(); }
+  std::string_view status_message() const { return text(); }
+  std::string_view body() const;
+
+  std::size_t header_count() const;
+  HeaderView header(std::size_t i) const;
+  // position of the first header with the id at or after `from`, or
+  // header_count()
+  std::size_t find(HeaderId id, std::size_t from = 0) const;
+  std::string_view value_of(HeaderId id,
+                            std::string_view fallback = {}) const;
+
+  // copies into the regular structures when an owned message is needed
+  Request to_request() const;
+  Response to_response() const;
+
+private:
+  const unsigned char *base = nullptr;
+
+  std::string_view text() const;
+  std::string_view slice(std::uint32_t offset, std::uint32_t length) const {
+    return std::string_view(reinterpret_cast<const char *>(base) + offset,
+                            length);
+  }
+};
+
+}; // namespace http_parser
@@ -0,0 +1,84 @@
+#pragma once
+
+/**
+ * @file BodyForwarder.hpp
+ * @brief zero-copy forwarding of a message body between two descriptors
+ * @version 1.0.0
+ *
+ * Used in proxy mode once the header block has been parsed: the body is
+ * moved from the source to the destination with splice() through a pipe,
+ * so payload bytes never enter user space. Framing is kept as it is: a
+ * content-length body is spliced in one run, a chunked body has its chunk
+ * lines and trailers read into a small buffer and passed to BodyParser
+ * while the chunk data itself is spliced. Bytes the caller read past the
+ * header block are forwarded first, and anything beyond the end of the
+ * body (a pipelined next message) is handed back through leftover().
+ *
+ * Blocking and non-blocking descriptors are supported; on systems without
+ * splice the body is copied through the buffer instead.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include "BodyParser.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace http_parser {
+
+enum class PARSER_EXPORT ForwardResult {
+  DONE,        // the whole body reached the destination
+  WOULD_BLOCK, // a non-blocking descriptor is not ready, call again
+  PEER_CLOSED, // the source ended before the body was complete
+  ERROR,       // I/O error or malformed chunked framing
+};
+
+class BodyForwarder {
+public:
+  static constexpr std::size_t FRAMING_BUFFER_SIZE = 512;
+
+  PARSER_EXPORT BodyForwarder();
+  PARSER_EXPORT ~BodyForwarder();
+  BodyForwarder(const BodyForwarder &) = delete;
+  BodyForwarder &operator=(const BodyForwarder &) = delete;
+
+  // Prepares forwarding of one body. `buffered` are the bytes already read
+  // from the source after the header block; they must stay valid until
+  // forwarding is done.
+  PARSER_EXPORT bool start(BodyFraming framing, std::uint64_t contentLength,
+                           std::string_view buffered = std::string_view());
+  PARSER_EXPORT ForwardResult forward(int source, int destination);
+
+  // bytes read from the source that follow the body, valid until the next
+  // start()
+  std::string_view leftover() const {
+    return std::string_view(input + inputOffset, inputLength - inputOffset);
+  }
+  std::uint64_t bytes_forwarded() const { return forwarded; }
+  // bytes that went through the pipe instead of user space
+  std::uint64_t bytes_spliced() const { return spliced; }
+
+private:
+  BodyParser parser;
+  std::vector<char> framingBuffer;
+  int pipeFds[2];
+  std::size_t pipeCapacity;
+  std::size_t pipeBytes;
+  const char *input;
+  std::size_t inputLength;
+  std::size_t inputOffset;
+  const char *pendingWrite;
+  std::size_t pendingLength;
+  std::uint64_t forwarded;
+  std::uint64_t spliced;
+
+  bool canSplice() const { return pipeFds[0] >= 0; }
+  void openPipe();
+  void closePipe();
+};
+
+}; // namespace http_parser
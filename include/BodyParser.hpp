@@ -0,0 +1,93 @@
+#pragma once
+
+/**
+ * @file BodyParser.hpp
+ * @brief message body framing (content-length, chunked, until close)
+ * @version 1.0.0
+ *
+ * BodyParser removes the framing of a body and hands out the payload as
+ * views into the buffer it is fed, so the body is never copied by the
+ * parser itself. Chunked trailers are parsed with HeaderParser.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include "HeaderParser.h"
+#include "HttpDefinitions.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace http_parser {
+
+enum class PARSER_EXPORT BodyFraming {
+  NONE,           // no body
+  CONTENT_LENGTH, // fixed number of bytes
+  CHUNKED,        // transfer-encoding: chunked
+  UNTIL_CLOSE,    // response body delimited by the end of the connection
+  INVALID,        // conflicting or malformed framing headers
+};
+
+enum class BodyParseState {
+  CONTENT,
+  UNTIL_CLOSE,
+  CHUNK_SIZE,
+  CHUNK_EXTENSION,
+  CHUNK_SIZE_LF,
+  CHUNK_DATA,
+  CHUNK_DATA_CR,
+  CHUNK_DATA_LF,
+  TRAILERS,
+  DONE,
+  PARSE_ERROR,
+};
+
+// Framing of a request body as defined by RFC 9112 section 6.3.
+BodyFraming PARSER_EXPORT request_body_framing(const Request &request,
+                                               std::uint64_t &contentLength);
+// Framing of a response body, `requestMethod` is the method of the request
+// it answers (responses to HEAD never have a body).
+BodyFraming PARSER_EXPORT response_body_framing(const Response &response,
+                                                Method requestMethod,
+                                                std::uint64_t &contentLength);
+
+class BodyParser {
+public:
+  PARSER_EXPORT BodyParser();
+
+  PARSER_EXPORT void reset(BodyFraming framing,
+                           std::uint64_t contentLength = 0);
+  // Consumes framing and payload bytes and returns how many were used.
+  // Payload found in this call is returned through `body` as a view into
+  // `data`; call again with the rest of the data until everything is
+  // consumed or the body is complete.
+  PARSER_EXPORT std::size_t execute(const char *data, std::size_t length,
+                                    std::string_view &body);
+  // Marks up to `length` payload bytes of the current content or chunk as
+  // passed on without looking at them, e.g. after moving them with splice.
+  // Returns how many were accounted for.
+  PARSER_EXPORT std::uint64_t skip(std::uint64_t length);
+  // the peer closed the connection, completes UNTIL_CLOSE bodies
+  PARSER_EXPORT void finish();
+
+  BodyParseState get_state() const { return currentParseState; }
+  bool done() const { return currentParseState == BodyParseState::DONE; }
+  bool failed() const {
+    return currentParseState == BodyParseState::PARSE_ERROR;
+  }
+  BodyFraming framing() const { return bodyFraming; }
+  // payload bytes left in the current content or chunk
+  std::uint64_t remaining() const { return remainingBytes; }
+  const Headers &trailers() const { return trailerParser.headers(); }
+
+private:
+  BodyFraming bodyFraming;
+  BodyParseState currentParseState;
+  std::uint64_t remainingBytes;
+  int chunkSizeDigits;
+  HeaderParser trailerParser;
+};
+
+}; // namespace http_parser
@@ -0,0 +1,87 @@
+#pragma once
+
+/**
+ * @file CaptureParser.hpp
+ * @brief parallel parsing of memory mapped HTTP request captures
+ * @version 1.0.0
+ *
+ * A capture is a raw stream of HTTP/1.x requests as they arrived on the
+ * wire, bodies included. The file is mapped once and cut into regions at
+ * request line boundaries; every thread then runs the buffer driven
+ * RequestParser and BodyParser over its region, owning the messages that
+ * start inside it. A region whose start turned out to lie inside the
+ * previous region's last message (a body that looks like a request line)
+ * is parsed again from where that message ended, so every message is
+ * counted once. Unparseable bytes are skipped up to the next boundary and
+ * reported.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include "HttpDefinitions.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace http_parser {
+
+struct PARSER_EXPORT CaptureStats {
+  static constexpr std::size_t METHOD_COUNT =
+      static_cast<std::size_t>(Method::METHOD_UNKOWN) + 1;
+
+  std::uint64_t messages = 0;
+  std::uint64_t parseErrors = 0;
+  std::uint64_t skippedBytes = 0; // bytes passed over after errors
+  std::uint64_t headerBytes = 0;  // request line and header block
+  std::uint64_t bodyBytes = 0;    // body including chunked framing
+  std::uint64_t headers = 0;
+  std::array<std::uint64_t, METHOD_COUNT> methods{};
+
+  void merge(const CaptureStats &other);
+};
+
+struct PARSER_EXPORT CaptureOptions {
+  unsigned threads = 0;             // 0 uses every hardware thread
+  std::size_t minRegionBytes = 1 << 20;
+  bool emitRecords = false;         // binary request records, see below
+};
+
+// Read-only mapping of a whole file.
+class CaptureFile {
+public:
+  PARSER_EXPORT CaptureFile() = default;
+  PARSER_EXPORT ~CaptureFile();
+  CaptureFile(const CaptureFile &) = delete;
+  CaptureFile &operator=(const CaptureFile &) = delete;
+
+  PARSER_EXPORT bool open(const std::string &path);
+  PARSER_EXPORT void close();
+  const char *data() const { return mapping; }
+  std::size_t size() const { return length; }
+
+private:
+  const char *mapping = nullptr;
+  std::size_t length = 0;
+};
+
+// Offset of the first request line starting at or after `from`, or `size`.
+// A request line starts a line and is "<method> SP ... HTTP/1.<digit>".
+std::size_t PARSER_EXPORT find_message_boundary(const char *data,
+                                               std::size_t size,
+                                               std::size_t from);
+
+// Parses all requests of the buffer. With emitRecords set, `records` is
+// called with the requests of each region in the binary_encode format
+// (bodies not included), in capture order and on the calling thread, as
+// soon as the region is final.
+CaptureStats PARSER_EXPORT
+parse_capture(const char *data, std::size_t size,
+              const CaptureOptions &options = {},
+              const std::function<void(std::string_view)> &records = nullptr);
+
+}; // namespace http_parser
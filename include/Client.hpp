@@ -0,0 +1,135 @@
+#pragma once
+
+/**
+ * @file Client.hpp
+ * @brief keep-alive client connections and a per-host connection pool
+ * @version 1.0.0
+ *
+ * ClientConnection writes requests with RequestSerializer and reads the
+ * replies into a buffer with large reads, which ResponseParser::execute and
+ * BodyParser then consume incrementally. Requests may be pipelined up to a
+ * depth limit; the methods of requests in flight are kept in a FIFO so each
+ * response is matched to its request in order and framed correctly (HEAD
+ * responses have no body). ConnectionPool keeps idle connections per
+ * host:port so calls reuse the TCP connection instead of reconnecting.
+ *
+ * I/O is blocking, like the parse(fd) entry points of the parsers.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include "BodyParser.hpp"
+#include "HttpDefinitions.hpp"
+#include "RequestSerializer.hpp"
+#include "ResponseParser.hpp"
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace http_parser {
+
+struct PARSER_EXPORT ClientResponse {
+  Response response;
+  std::string body;
+};
+
+class ClientConnection {
+public:
+  static constexpr std::size_t READ_BUFFER_SIZE = 16 * 1024;
+
+  // takes ownership of a connected socket
+  PARSER_EXPORT ClientConnection(int file_descriptor, std::string host,
+                                 std::string port,
+                                 std::size_t maxPipelineDepth = 1);
+  PARSER_EXPORT ~ClientConnection();
+  ClientConnection(const ClientConnection &) = delete;
+  ClientConnection &operator=(const ClientConnection &) = delete;
+
+  // Resolves host and connects, nullptr on failure.
+  PARSER_EXPORT static std::unique_ptr<ClientConnection>
+  connect(const std::string &host, const std::string &port,
+          std::size_t maxPipelineDepth = 1);
+
+  // Writes a request. Returns false if the pipeline is full, the request
+  // cannot be serialized or the write failed.
+  PARSER_EXPORT bool send(const Request &request,
+                          std::string_view body = std::string_view());
+  // Reads the response to the oldest request in flight. Interim 1xx
+  // responses are skipped, except 101 which ends the HTTP exchange.
+  PARSER_EXPORT bool receive(ClientResponse &out);
+
+  std::size_t in_flight() const { return inFlight.size(); }
+  bool can_send() const {
+    return !closed && inFlight.size() < maxPipelineDepth;
+  }
+  // true if the connection can be handed back to a pool
+  bool reusable() const { return !closed && inFlight.empty(); }
+  // false until the connection has completed at least one exchange
+  bool reused() const { return completedResponses > 0; }
+  // bytes of the current response have been read
+  bool response_started() const { return responseStarted; }
+  const std::string &host() const { return hostName; }
+  const std::string &port() const { return portName; }
+  int get_fd() const { return fd; }
+
+private:
+  int fd;
+  std::string hostName;
+  std::string portName;
+  std::size_t maxPipelineDepth;
+  std::size_t completedResponses;
+  bool closed;
+  bool readingBody;
+  bool responseStarted;
+  std::deque<Method> inFlight;
+  RequestSerializer serializer;
+  ResponseParser responseParser;
+  BodyParser bodyParser;
+  std::vector<char> readBuffer;
+  std::size_t readStart;
+  std::size_t readEnd;
+
+  bool fill();
+  bool fail();
+};
+
+class ConnectionPool {
+public:
+  PARSER_EXPORT explicit ConnectionPool(std::size_t maxIdlePerHost = 8,
+                                        std::size_t maxPipelineDepth = 1);
+
+  // An idle connection to host:port, or a new one. nullptr if connecting
+  // fails.
+  PARSER_EXPORT std::unique_ptr<ClientConnection>
+  acquire(const std::string &host, const std::string &port);
+  // Returns a connection to the pool; closed or busy connections and
+  // connections beyond the idle limit are dropped.
+  PARSER_EXPORT void release(std::unique_ptr<ClientConnection> connection);
+  // One request/response exchange on a pooled connection. An idempotent
+  // request that fails on a reused connection before any response byte
+  // arrived (the server closed the idle connection) is retried once on a
+  // newly opened connection, not another idle one; other requests fail.
+  PARSER_EXPORT bool request(const std::string &host, const std::string &port,
+                             const Request &request, std::string_view body,
+                             ClientResponse &out);
+  PARSER_EXPORT std::size_t idle_count(const std::string &host,
+                                       const std::string &port) const;
+  PARSER_EXPORT void clear();
+
+private:
+  std::size_t maxIdlePerHost;
+  std::size_t maxPipelineDepth;
+  mutable std::mutex mutex;
+  std::unordered_map<std::string,
+                     std::vector<std::unique_ptr<ClientConnection>>>
+      idle;
+};
+
+}; // namespace http_parser
@@ -0,0 +1,112 @@
+#pragma once
+
+/**
+ * @file Conditional.hpp
+ * @brief entity tags and evaluation of conditional requests
+ * @version 1.0.0
+ *
+ * evaluate_preconditions applies If-Match, If-Unmodified-Since,
+ * If-None-Match and If-Modified-Since in the order of RFC 9110 section
+ * 13.2.2 and tells the caller whether to answer with 304 or 412 instead of
+ * the normal response. Header values are scanned in place, nothing is
+ * allocated.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include "HttpDefinitions.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+namespace http_parser {
+
+struct PARSER_EXPORT EntityTag {
+  std::string_view opaque; // between the quotes
+  bool weak = false;
+};
+
+// Parses a single entity-tag such as "xyz" or W/"xyz".
+bool PARSER_EXPORT parse_entity_tag(std::string_view text, EntityTag &tag);
+// strong comparison: neither tag is weak and the opaque parts are equal
+bool PARSER_EXPORT strong_match(const EntityTag &a, const EntityTag &b);
+// weak comparison: the opaque parts are equal
+bool PARSER_EXPORT weak_match(const EntityTag &a, const EntityTag &b);
+
+// Iterates over the entity-tags of an If-Match / If-None-Match value. The
+// closing quote of each tag is found with memchr, so long lists cost one
+// pass over the bytes. Iteration stops at the first malformed member and
+// valid() turns false.
+class PARSER_EXPORT EntityTagList {
+public:
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = EntityTag;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const EntityTag *;
+    using reference = const EntityTag &;
+
+    const_iterator() = default;
+    const_iterator(std::string_view remaining, bool *valid);
+
+    const EntityTag &operator*() const { return current; }
+    const EntityTag *operator->() const { return &current; }
+    const_iterator &operator++();
+    const_iterator operator++(int) {
+      const_iterator previous = *this;
+      ++*this;
+      return previous;
+    }
+    bool operator==(const const_iterator &other) const {
+      return atEnd == other.atEnd &&
+             (atEnd || current.opaque.data() == other.current.opaque.data());
+    }
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+
+  private:
+    std::string_view remaining;
+    EntityTag current;
+    bool *valid = nullptr;
+    bool atEnd = true;
+  };
+
+  EntityTagList() = default;
+  explicit EntityTagList(std::string_view value);
+
+  // the value is "*"
+  bool is_wildcard() const { return wildcard; }
+  bool valid() const { return wellFormed; }
+  const_iterator begin() const {
+    return wildcard ? end() : const_iterator(value, &wellFormed);
+  }
+  const_iterator end() const { return const_iterator(); }
+
+  // true if a member matches `tag` with the given comparison
+  bool contains(const EntityTag &tag, bool weakComparison) const;
+
+private:
+  std::string_view value;
+  bool wildcard = false;
+  mutable bool wellFormed = true;
+};
+
+// What the server knows about the selected representation.
+struct PARSER_EXPORT ResourceValidators {
+  std::string_view etag;          // as sent in ETag, empty if none
+  std::int64_t lastModified = -1; // epoch seconds, negative if unknown
+  bool exists = true;             // false if there is no current representation
+};
+
+// Returns NOT_MODIFIED or PRECONDITION_FAILED when the request must be
+// answered with that status instead, OK when it should be processed
+// normally. Invalid dates are ignored as RFC 9110 requires.
+StatusCode PARSER_EXPORT evaluate_preconditions(
+    const Request &request, const ResourceValidators &validators);
+
+}; // namespace http_parser
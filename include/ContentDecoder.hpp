@@ -0,0 +1,98 @@
+#pragma once
+
+/**
+ * @file ContentDecoder.hpp
+ * @brief streaming gzip / deflate decoding of message bodies
+ * @version 1.0.0
+ *
+ * ContentDecoder is a stage after BodyParser: it is fed the payload views
+ * BodyParser hands out, so transfer framing such as chunked is already
+ * gone, and inflates them into an output buffer of fixed size that is
+ * handed out one piece at a time. The total decoded size is capped to
+ * guard against decompression bombs. gzip and deflate need the library to
+ * be built with zlib (HTTP_PARSER_WITH_ZLIB); without it only identity can
+ * be decoded.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include "HttpDefinitions.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+namespace http_parser {
+
+enum class PARSER_EXPORT ContentCoding {
+  IDENTITY,
+  GZIP,    // gzip, x-gzip
+  DEFLATE, // zlib format, raw deflate from broken servers is accepted too
+  UNSUPPORTED,
+};
+
+// Coding of the Content-Encoding headers; more than one coding, or one
+// that is not known, is UNSUPPORTED.
+ContentCoding PARSER_EXPORT content_coding(const Headers &headers);
+
+enum class DecodeState {
+  DECODING,
+  DONE,
+  TOO_LARGE, // the decoded size exceeded the limit
+  PARSE_ERROR,
+};
+
+class ContentDecoder {
+public:
+  static constexpr std::size_t DEFAULT_BUFFER_SIZE = 16 * 1024;
+  static constexpr std::uint64_t DEFAULT_MAX_OUTPUT = 64 * 1024 * 1024;
+
+  PARSER_EXPORT explicit ContentDecoder(
+      std::size_t bufferSize = DEFAULT_BUFFER_SIZE);
+  PARSER_EXPORT ~ContentDecoder();
+  ContentDecoder(const ContentDecoder &) = delete;
+  ContentDecoder &operator=(const ContentDecoder &) = delete;
+
+  // Starts a body, returns false if the coding cannot be decoded.
+  PARSER_EXPORT bool reset(ContentCoding coding,
+                           std::uint64_t maxOutput = DEFAULT_MAX_OUTPUT);
+  // Decodes payload bytes and returns how many were used. At most one
+  // buffer of output is produced per call and returned through `out`,
+  // valid until the next call; identity payload is passed through as a
+  // view into `data`. Call again with the rest of the data, and while
+  // pending() is true, until everything is consumed.
+  PARSER_EXPORT std::size_t execute(const char *data, std::size_t length,
+                                    std::string_view &out);
+  // the body ended, fails a compressed stream that is incomplete
+  PARSER_EXPORT void finish();
+
+  // the output buffer was filled, more output may follow without input
+  bool pending() const { return outputPending; }
+  DecodeState get_state() const { return currentState; }
+  bool done() const { return currentState == DecodeState::DONE; }
+  bool failed() const {
+    return currentState == DecodeState::TOO_LARGE ||
+           currentState == DecodeState::PARSE_ERROR;
+  }
+  std::uint64_t decoded_size() const { return outputBytes; }
+
+private:
+  struct Stream;
+
+  ContentCoding contentCoding;
+  DecodeState currentState;
+  std::unique_ptr<Stream> stream;
+  std::unique_ptr<char[]> buffer;
+  std::size_t bufferSize;
+  std::uint64_t maxOutputBytes;
+  std::uint64_t outputBytes;
+  bool outputPending;
+  bool started;
+
+  std::size_t inflate(const char *data, std::size_t length,
+                      std::string_view &out);
+};
+
+}; // namespace http_parser
@@ -0,0 +1,78 @@
+#pragma once
+
+/**
+ * @file Cookie.hpp
+ * @brief lazy iteration over the pairs of a Cookie header
+ * @version 1.0.0
+ *
+ * Cookies walks a Cookie header value (RFC 6265 section 5.4) one pair at a
+ * time, finding the separators with memchr, and hands out names and values
+ * as views into the header. A cookie-octet can be neither a DQUOTE nor a
+ * backslash, so unquoting a value is only dropping its quotes and nothing
+ * is ever allocated.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+
+namespace http_parser {
+
+struct PARSER_EXPORT Cookie {
+  std::string_view name;  // empty for a nameless cookie
+  std::string_view value; // without surrounding quotes
+};
+
+class PARSER_EXPORT Cookies {
+public:
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Cookie;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Cookie *;
+    using reference = const Cookie &;
+
+    const_iterator() = default;
+    explicit const_iterator(std::string_view remaining);
+
+    const Cookie &operator*() const { return current; }
+    const Cookie *operator->() const { return &current; }
+    const_iterator &operator++();
+    const_iterator operator++(int) {
+      const_iterator previous = *this;
+      ++*this;
+      return previous;
+    }
+    bool operator==(const const_iterator &other) const {
+      return atEnd == other.atEnd &&
+             (atEnd || current.value.data() == other.current.value.data());
+    }
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+
+  private:
+    std::string_view remaining;
+    Cookie current;
+    bool atEnd = true;
+  };
+
+  Cookies() = default;
+  explicit Cookies(std::string_view header) : header(header) {}
+
+  const_iterator begin() const { return const_iterator(header); }
+  const_iterator end() const { return const_iterator(); }
+  // value of the first cookie called `name` (names are case-sensitive),
+  // false if there is none
+  bool find(std::string_view name, std::string_view &value) const;
+
+private:
+  std::string_view header;
+};
+
+}; // namespace http_parser
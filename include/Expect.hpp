@@ -0,0 +1,72 @@
+#pragma once
+
+/**
+ * @file Expect.hpp
+ * @brief Expect: 100-continue handling for request bodies
+ * @version 1.0.0
+ *
+ * A client that sends Expect: 100-continue waits for an interim 100
+ * (Continue) response before it sends the body. ContinueHandler tracks
+ * that exchange for one request: the server either sends the interim
+ * response and reads the body as usual, or answers with a final response
+ * (401, 413, 417, ...) right away, in which case the body is never read and
+ * the connection is closed after the response since the unread body would
+ * otherwise be taken for the next request.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include "HttpDefinitions.hpp"
+#include "IoVec.h"
+#include <cstddef>
+#include <string_view>
+
+namespace http_parser {
+
+enum class PARSER_EXPORT ContinueState {
+  NONE,      // no 100-continue exchange, the body is read as usual
+  PENDING,   // the client waits for 100 (Continue) or a final response
+  CONTINUED, // the interim response was sent, the body follows
+  REJECTED,  // answered before the body was read
+};
+
+class ContinueHandler {
+public:
+  PARSER_EXPORT ContinueHandler();
+
+  // Starts the exchange for a parsed request. The state is PENDING if the
+  // request expects 100-continue and has a body, NONE otherwise. Requests
+  // with an expectation other than 100-continue should be rejected with
+  // 417 (Expectation Failed).
+  PARSER_EXPORT ContinueState start(const Request &request);
+  ContinueState state() const { return currentState; }
+  // true unless the request was rejected, in which case the body must not
+  // be read from the connection
+  bool body_readable() const {
+    return currentState != ContinueState::REJECTED;
+  }
+
+  // Writes the interim response while PENDING, call it before reading the
+  // body. Same partial write semantics as ResponseSerializer::write; the
+  // state is CONTINUED once all of it was written.
+  PARSER_EXPORT bool send_continue(int file_descriptor);
+  // The interim response bytes still to send, for callers that write it
+  // together with other output, and consume to mark them as sent.
+  PARSER_EXPORT std::string_view interim() const;
+  PARSER_EXPORT void consume(std::size_t bytes);
+
+  // Answers the request without reading its body: clears keep_alive of the
+  // request and adds connection: close to the final response. A partly
+  // written interim response has to be completed before the final one.
+  PARSER_EXPORT void reject(Request &request, Response &response);
+
+private:
+  ContinueState currentState;
+  iovec iov;
+  std::size_t iovIndex;
+  std::size_t remainingBytes;
+};
+
+}; // namespace http_parser
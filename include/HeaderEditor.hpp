@@ -0,0 +1,112 @@
+#pragma once
+
+/**
+ * @file HeaderEditor.hpp
+ * @brief edits a received header block without serializing it again
+ * @version 1.0.0
+ *
+ * The editor indexes the lines of a start line and header block exactly
+ * as they were received and records removals, replacements and additions
+ * against them. build() then produces an iovec list in which runs of
+ * untouched lines are single slices of the original buffer and only the
+ * changed lines are small fragments from a scratch buffer, so a proxy
+ * forwards a modified request by copying almost nothing.
+ *
+ * The block is expected to have been validated by the request or response
+ * parser already.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include "HeaderList.hpp"
+#include "IoVec.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace http_parser {
+
+class HeaderEditor {
+public:
+  PARSER_EXPORT HeaderEditor();
+
+  // Indexes `head`, the start line and header block up to and including
+  // the empty line, e.g. the bytes consumed by RequestParser::execute. The
+  // buffer must stay valid while the iovecs are in use. Returns false if
+  // it does not end with an empty line.
+  PARSER_EXPORT bool attach(std::string_view head);
+
+  // number of header lines, the start line not included
+  std::size_t size() const { return lines.size(); }
+  std::string_view key(std::size_t i) const { return lines[i].key; }
+  std::string_view value(std::size_t i) const { return lines[i].value; }
+  std::string_view start_line() const { return startLine; }
+
+  PARSER_EXPORT void remove(HeaderId id);
+  PARSER_EXPORT void remove(std::string_view name);
+  // Removes Connection, Proxy-Connection, Keep-Alive, TE, Upgrade and every
+  // header named in Connection. Transfer-Encoding is left alone since the
+  // body is forwarded with its framing; Content-Length, Transfer-Encoding
+  // and Host are kept even when Connection names them.
+  PARSER_EXPORT void remove_hop_by_hop();
+  // Sets the value of the first header called `name` and removes the other
+  // ones, adds the header if there is none.
+  PARSER_EXPORT void set(std::string_view name, std::string_view value);
+  // Adds `value` as a new list member, e.g. for X-Forwarded-For and Via:
+  // the first header called `name` gets ", value" appended.
+  PARSER_EXPORT void append(std::string_view name, std::string_view value);
+  PARSER_EXPORT void add(std::string_view name, std::string_view value);
+  // e.g. an absolute-form request line rewritten to origin-form; `line`
+  // without the line ending
+  PARSER_EXPORT void set_start_line(std::string_view line);
+
+  // Builds the iovec list for the current edits.
+  PARSER_EXPORT void build();
+  const iovec *iovecs() const { return iov.data() + iovIndex; }
+  std::size_t iovec_count() const { return iov.size() - iovIndex; }
+  // bytes left to write
+  std::size_t output_size() const { return remainingBytes; }
+  // same semantics as ResponseSerializer::write
+  PARSER_EXPORT bool write(int file_descriptor);
+
+private:
+  enum class Edit : std::uint8_t { KEEP, REMOVE, REPLACE };
+
+  struct Line {
+    std::size_t offset;
+    std::size_t length; // including the line ending
+    std::string_view key;
+    std::string_view value;
+    HeaderId id;
+    Edit edit;
+    std::size_t fragmentOffset;
+    std::size_t fragmentLength;
+  };
+
+  struct Fragment {
+    std::size_t offset;
+    std::size_t length;
+  };
+
+  std::string_view head;
+  std::string_view startLine;
+  std::size_t startLineLength; // including the line ending
+  bool startLineReplaced;
+  Fragment startLineFragment;
+  std::vector<Line> lines;
+  std::vector<Fragment> additions;
+  std::string scratch;
+  std::vector<iovec> iov;
+  std::size_t iovIndex;
+  std::size_t remainingBytes;
+
+  Fragment writeLine(std::string_view name, std::string_view value,
+                     std::string_view extra = std::string_view());
+  bool matches(const Line &line, std::string_view name) const;
+};
+
+}; // namespace http_parser
@@ -0,0 +1,279 @@
+#pragma once
+
+/**
+ * @file HeaderList.hpp
+ * @brief compact header storage for parsed requests and responses
+ * @version 1.0.0
+ *
+ * Header names and values are copied into one shared byte buffer and
+ * described by offset/length columns (structure of arrays). The first
+ * InlineCapacity entries live inside the object, so typical messages never
+ * allocate for the bookkeeping and a lookup by HeaderId only touches the
+ * ids column.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace http_parser {
+
+enum class PARSER_EXPORT HeaderId : std::uint8_t {
+  UNKOWN = 0,
+  ACCEPT,
+  ACCEPT_CHARSET,
+  ACCEPT_ENCODING,
+  ACCEPT_LANGUAGE,
+  ACCEPT_RANGES,
+  AGE,
+  ALLOW,
+  AUTHORIZATION,
+  CACHE_CONTROL,
+  CONNECTION,
+  CONTENT_DISPOSITION,
+  CONTENT_ENCODING,
+  CONTENT_LANGUAGE,
+  CONTENT_LENGTH,
+  CONTENT_LOCATION,
+  CONTENT_RANGE,
+  CONTENT_TYPE,
+  COOKIE,
+  DATE,
+  ETAG,
+  EXPECT,
+  EXPIRES,
+  FORWARDED,
+  FROM,
+  HOST,
+  HTTP2_SETTINGS,
+  IF_MATCH,
+  IF_MODIFIED_SINCE,
+  IF_NONE_MATCH,
+  IF_RANGE,
+  IF_UNMODIFIED_SINCE,
+  KEEP_ALIVE,
+  LAST_MODIFIED,
+  LINK,
+  LOCATION,
+  MAX_FORWARDS,
+  ORIGIN,
+  PRAGMA,
+  PROXY_AUTHENTICATE,
+  PROXY_AUTHORIZATION,
+  PROXY_CONNECTION,
+  RANGE,
+  REFERER,
+  RETRY_AFTER,
+  SEC_WEBSOCKET_ACCEPT,
+  SEC_WEBSOCKET_EXTENSIONS,
+  SEC_WEBSOCKET_KEY,
+  SEC_WEBSOCKET_PROTOCOL,
+  SEC_WEBSOCKET_VERSION,
+  SERVER,
+  SET_COOKIE,
+  STRICT_TRANSPORT_SECURITY,
+  TE,
+  TRAILER,
+  TRANSFER_ENCODING,
+  UPGRADE,
+  USER_AGENT,
+  VARY,
+  VIA,
+  WWW_AUTHENTICATE,
+  X_FORWARDED_FOR,
+  X_FORWARDED_HOST,
+  X_FORWARDED_PROTO,
+  X_REQUEST_ID,
+  HEADER_ID_COUNT,
+};
+
+// Case-insensitive lookup of a well known header name, UNKOWN otherwise.
+HeaderId PARSER_EXPORT string_to_header_id(std::string_view name);
+// Canonical lower-case spelling of a well known header, empty for UNKOWN.
+std::string_view PARSER_EXPORT header_id_to_string(HeaderId id);
+bool PARSER_EXPORT header_name_equals(std::string_view a, std::string_view b);
+
+struct PARSER_EXPORT HeaderView {
+  std::string_view key;
+  std::string_view value;
+  HeaderId id;
+};
+
+template <std::size_t InlineCapacity = 16> class HeaderList {
+  static_assert(InlineCapacity > 0, "HeaderList needs inline capacity");
+
+public:
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = HeaderView;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const HeaderView *;
+    using reference = HeaderView;
+
+    const_iterator() = default;
+    const_iterator(const HeaderList *list, std::size_t index)
+        : list(list), index(index) {}
+
+    HeaderView operator*() const { return (*list)[index]; }
+    const_iterator &operator++() {
+      ++index;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator previous = *this;
+      ++index;
+      return previous;
+    }
+    bool operator==(const const_iterator &other) const {
+      return index == other.index;
+    }
+    bool operator!=(const const_iterator &other) const {
+      return index != other.index;
+    }
+    std::size_t position() const { return index; }
+
+  private:
+    const HeaderList *list = nullptr;
+    std::size_t index = 0;
+  };
+
+  // Appends a header, returns false if the name or the total size does not
+  // fit the offset columns.
+  bool add(std::string_view key, std::string_view value) {
+    return add(string_to_header_id(key), key, value);
+  }
+
+  bool add(HeaderId id, std::string_view key, std::string_view value) {
+    if (key.size() > UINT16_MAX ||
+        bytes.size() + key.size() + value.size() > UINT32_MAX) {
+      return false;
+    }
+    std::uint32_t keyOffset = static_cast<std::uint32_t>(bytes.size());
+    bytes.append(key.data(), key.size());
+    std::uint32_t valueOffset = static_cast<std::uint32_t>(bytes.size());
+    bytes.append(value.data(), value.size());
+    if (count < InlineCapacity) {
+      ids[count] = id;
+      keyLengths[count] = static_cast<std::uint16_t>(key.size());
+      keyOffsets[count] = keyOffset;
+      valueOffsets[count] = valueOffset;
+      valueLengths[count] = static_cast<std::uint32_t>(value.size());
+    } else {
+      overflow.push_back(Entry{keyOffset, valueOffset,
+                               static_cast<std::uint32_t>(value.size()),
+                               static_cast<std::uint16_t>(key.size()), id});
+    }
+    ++count;
+    return true;
+  }
+
+  void clear() {
+    count = 0;
+    bytes.clear();
+    overflow.clear();
+  }
+
+  void reserve_bytes(std::size_t n) { bytes.reserve(n); }
+
+  std::size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  HeaderView operator[](std::size_t i) const {
+    if (i < InlineCapacity) {
+      return HeaderView{
+          std::string_view(bytes.data() + keyOffsets[i], keyLengths[i]),
+          std::string_view(bytes.data() + valueOffsets[i], valueLengths[i]),
+          ids[i]};
+    }
+    const Entry &e = overflow[i - InlineCapacity];
+    return HeaderView{
+        std::string_view(bytes.data() + e.keyOffset, e.keyLength),
+        std::string_view(bytes.data() + e.valueOffset, e.valueLength), e.id};
+  }
+
+  HeaderId id_at(std::size_t i) const {
+    return i < InlineCapacity ? ids[i] : overflow[i - InlineCapacity].id;
+  }
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, count); }
+
+  // First header with the given id, starting the scan at position `from`.
+  const_iterator find(HeaderId id, std::size_t from = 0) const {
+    if (id == HeaderId::UNKOWN) {
+      return end();
+    }
+    std::size_t inlineCount = count < InlineCapacity ? count : InlineCapacity;
+    for (std::size_t i = from; i < inlineCount; i++) {
+      if (ids[i] == id) {
+        return const_iterator(this, i);
+      }
+    }
+    std::size_t start = from > InlineCapacity ? from - InlineCapacity : 0;
+    for (std::size_t i = start; i < overflow.size(); i++) {
+      if (overflow[i].id == id) {
+        return const_iterator(this, i + InlineCapacity);
+      }
+    }
+    return end();
+  }
+
+  const_iterator find(std::string_view name, std::size_t from = 0) const {
+    HeaderId id = string_to_header_id(name);
+    if (id != HeaderId::UNKOWN) {
+      return find(id, from);
+    }
+    for (std::size_t i = from; i < count; i++) {
+      HeaderView header = (*this)[i];
+      if (header.id == HeaderId::UNKOWN &&
+          header_name_equals(header.key, name)) {
+        return const_iterator(this, i);
+      }
+    }
+    return end();
+  }
+
+  bool contains(HeaderId id) const { return find(id) != end(); }
+
+  // Value of the first matching header, or `fallback` when absent.
+  std::string_view value_of(HeaderId id,
+                            std::string_view fallback = {}) const {
+    const_iterator it = find(id);
+    return it == end() ? fallback : (*it).value;
+  }
+
+  std::string_view value_of(std::string_view name,
+                            std::string_view fallback = {}) const {
+    const_iterator it = find(name);
+    return it == end() ? fallback : (*it).value;
+  }
+
+private:
+  struct Entry {
+    std::uint32_t keyOffset;
+    std::uint32_t valueOffset;
+    std::uint32_t valueLength;
+    std::uint16_t keyLength;
+    HeaderId id;
+  };
+
+  std::size_t count = 0;
+  std::array<HeaderId, InlineCapacity> ids{};
+  std::array<std::uint16_t, InlineCapacity> keyLengths{};
+  std::array<std::uint32_t, InlineCapacity> keyOffsets{};
+  std::array<std::uint32_t, InlineCapacity> valueOffsets{};
+  std::array<std::uint32_t, InlineCapacity> valueLengths{};
+  std::vector<Entry> overflow;
+  std::string bytes;
+};
+
+}; // namespace http_parser
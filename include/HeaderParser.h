@@ -1,22 +1,93 @@
 #pragma once
 
+/**
+ * @file HeaderParser.h
+ * @brief header block parser shared by the request and response parsers
+ * @version 1.0.0
+ *
+ * Parses `key: value` lines up to and including the empty line that ends
+ * the block. It is used after the request line and the status line, and on
+ * its own for chunked trailers and multipart part headers. Keys must be
+ * tokens, values may contain visible characters, SP, HTAB and obs-text;
+ * whitespace around the value is trimmed. Runs of key and value bytes are
+ * scanned with a lookup table and appended in one go.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include "HeaderList.hpp"
+#include "HttpDefinitions.hpp"
+#include "ParserPolicy.hpp"
+#include <bitset>
+#include <cstddef>
+#include <string>
+
 namespace http_parser {
 
 enum class HeaderParseState {
   HEADER_KEY,
   HEADER_DELIMITER,
   HEADER_VALUE,
-  HEADER_LINE_END_CR,
   HEADER_LINE_END_LF,
-  END_OF_HEADER_CR,
   END_OF_HEADER_LF,
   DONE,
   PARSE_ERROR,
 };
 
-class HeaderParser{
+template <typename Policy> class BasicHeaderParser {
 public:
-    bool parse(int fd);
+  PARSER_EXPORT BasicHeaderParser();
+
+  PARSER_EXPORT void reset();
+  // Consumes bytes up to the end of the header block and returns how many
+  // were used, bytes after the block are left to the caller.
+  PARSER_EXPORT std::size_t execute(const char *data, std::size_t length);
+  // Reads the header block from fd one byte at a time, so nothing after the
+  // block is taken from the descriptor.
+  PARSER_EXPORT bool parse(int file_descriptor);
+
+  HeaderParseState state() const { return currentParseState; }
+  bool done() const { return currentParseState == HeaderParseState::DONE; }
+  bool failed() const {
+    return currentParseState == HeaderParseState::PARSE_ERROR;
+  }
+  // true if a well known header was present, also when headers aren't stored
+  bool seen(HeaderId id) const {
+    return seenHeaders.test(static_cast<std::size_t>(id));
+  }
+  // options of the Connection and Expect headers, collected whenever keys
+  // are identified, also when headers aren't stored
+  const ConnectionOptions &connection() const { return connectionOptions; }
+  Expectation expectation() const { return expect; }
+  Headers &headers() { return headerList; }
+  const Headers &headers() const { return headerList; }
+  const std::string &getErrorMessage() const { return errorMessage; }
+
+private:
+  HeaderParseState currentParseState;
+  Headers headerList;
+  std::bitset<static_cast<std::size_t>(HeaderId::HEADER_ID_COUNT)>
+      seenHeaders;
+  ConnectionOptions connectionOptions;
+  Expectation expect;
+  std::string currentHeaderKey;
+  HeaderId currentHeaderId; // identified when the colon is reached
+  std::string currentHeaderValue;
+  std::size_t keyLength;
+  std::string errorMessage;
+
+  void commitHeader();
+  void fail(const std::string &message);
 };
 
-};
\ No newline at end of file
+// instantiated in HeaderParser.cpp for the shipped parser policies
+extern template class BasicHeaderParser<HeaderPolicyOf<DefaultParserPolicy>>;
+extern template class BasicHeaderParser<HeaderPolicyOf<StrictParserPolicy>>;
+extern template class BasicHeaderParser<
+    HeaderPolicyOf<HealthCheckParserPolicy>>;
+
+using HeaderParser = BasicHeaderParser<HeaderPolicyOf<DefaultParserPolicy>>;
+
+}; // namespace http_parser
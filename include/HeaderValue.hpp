@@ -0,0 +1,142 @@
+#pragma once
+
+/**
+ * @file HeaderValue.hpp
+ * @brief non allocating iteration over list based header values
+ * @version 1.0.0
+ *
+ * TokenList walks the elements of a comma separated header value (RFC 9110
+ * section 5.6.1) and Parameters the `;name=value` parameters that follow
+ * an element, e.g. the media type parameters of Accept or the q-value of
+ * Accept-Encoding. Both hand out views into the header value; quoted
+ * strings are recognized so a comma or semicolon inside quotes does not
+ * split.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+namespace http_parser {
+
+// Elements of a comma separated list, trimmed; empty elements are skipped.
+class PARSER_EXPORT TokenList {
+public:
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::string_view *;
+    using reference = const std::string_view &;
+
+    const_iterator() = default;
+    explicit const_iterator(std::string_view remaining);
+
+    const std::string_view &operator*() const { return current; }
+    const std::string_view *operator->() const { return &current; }
+    const_iterator &operator++();
+    const_iterator operator++(int) {
+      const_iterator previous = *this;
+      ++*this;
+      return previous;
+    }
+    bool operator==(const const_iterator &other) const {
+      return atEnd == other.atEnd &&
+             (atEnd || current.data() == other.current.data());
+    }
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+
+  private:
+    std::string_view remaining;
+    std::string_view current;
+    bool atEnd = true;
+  };
+
+  TokenList() = default;
+  explicit TokenList(std::string_view value) : value(value) {}
+
+  const_iterator begin() const { return const_iterator(value); }
+  const_iterator end() const { return const_iterator(); }
+  // true if one of the elements equals `token`, ignoring case
+  bool contains(std::string_view token) const;
+
+private:
+  std::string_view value;
+};
+
+struct PARSER_EXPORT Parameter {
+  std::string_view name;
+  // without the quotes of a quoted string, backslash escapes are kept
+  std::string_view value;
+  bool quoted = false;
+};
+
+// `;` separated name=value parameters, names are matched ignoring case.
+class PARSER_EXPORT Parameters {
+public:
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Parameter;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Parameter *;
+    using reference = const Parameter &;
+
+    const_iterator() = default;
+    explicit const_iterator(std::string_view remaining);
+
+    const Parameter &operator*() const { return current; }
+    const Parameter *operator->() const { return &current; }
+    const_iterator &operator++();
+    const_iterator operator++(int) {
+      const_iterator previous = *this;
+      ++*this;
+      return previous;
+    }
+    bool operator==(const const_iterator &other) const {
+      return atEnd == other.atEnd &&
+             (atEnd || current.name.data() == other.current.name.data());
+    }
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+
+  private:
+    std::string_view remaining;
+    Parameter current;
+    bool atEnd = true;
+  };
+
+  Parameters() = default;
+  explicit Parameters(std::string_view parameters) : parameters(parameters) {}
+
+  const_iterator begin() const { return const_iterator(parameters); }
+  const_iterator end() const { return const_iterator(); }
+  bool find(std::string_view name, std::string_view &value) const;
+
+private:
+  std::string_view parameters;
+};
+
+// Splits a list element such as `text/html;level=1;q=0.5` into its value
+// and its parameters.
+std::string_view PARSER_EXPORT split_parameters(std::string_view element,
+                                                Parameters &parameters);
+
+// Parses a qvalue ("0", "0.5", "1.000", ...) into thousandths.
+bool PARSER_EXPORT parse_qvalue(std::string_view text, std::uint16_t &q);
+
+// Value and weight of an element; a missing or malformed q parameter
+// weighs 1000 and 0 respectively.
+std::string_view PARSER_EXPORT weighted_element(std::string_view element,
+                                                std::uint16_t &q);
+
+}; // namespace http_parser
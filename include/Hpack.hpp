@@ -0,0 +1,179 @@
+#pragma once
+
+/**
+ * @file Hpack.hpp
+ * @brief HPACK header compression for HTTP/2 (RFC 7541)
+ * @version 1.0.0
+ *
+ * HpackDecoder turns a complete header block into the Headers / Request /
+ * Response model used for HTTP/1.1, HpackEncoder does the reverse. Both
+ * keep a dynamic table whose entries live in a ring, so adding a field and
+ * evicting the oldest ones never moves the others. Huffman strings are
+ * decoded four bits at a time through a state table derived once from the
+ * code table of appendix B; the shortest code is five bits long, so each
+ * step emits at most one symbol.
+ *
+ * Every length and index read from the wire is checked against the input
+ * and the tables before it is used, a malformed block fails the decoder
+ * instead of reading out of bounds.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include "HttpDefinitions.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace http_parser {
+
+constexpr std::size_t HPACK_DEFAULT_TABLE_SIZE = 4096;
+constexpr std::size_t HPACK_STATIC_TABLE_ENTRIES = 61;
+
+// Huffman code of appendix B
+std::size_t PARSER_EXPORT hpack_huffman_encoded_size(std::string_view in);
+void PARSER_EXPORT hpack_huffman_encode(std::string_view in, std::string &out);
+// Appends the decoded string to `out`, false on an invalid code or padding.
+bool PARSER_EXPORT hpack_huffman_decode(std::string_view in, std::string &out);
+
+// Dynamic table of section 2.3.2, entry 0 is the newest one.
+class HpackTable {
+public:
+  PARSER_EXPORT explicit HpackTable(std::size_t maxSize);
+
+  // evicts entries until the table fits
+  PARSER_EXPORT void set_max_size(std::size_t maxSize);
+  // Adds a field, evicting old entries as needed. A field larger than the
+  // table empties it and is not added (section 4.4).
+  PARSER_EXPORT void add(std::string_view name, std::string_view value);
+  std::string_view name(std::size_t i) const {
+    const Entry &entry = at(i);
+    return std::string_view(entry.field).substr(0, entry.nameLength);
+  }
+  std::string_view value(std::size_t i) const {
+    const Entry &entry = at(i);
+    return std::string_view(entry.field).substr(entry.nameLength);
+  }
+
+  std::size_t max_size() const { return maxOctets; }
+  // size as defined by section 4.1: name + value + 32 per entry
+  std::size_t size() const { return octets; }
+  std::size_t count() const { return entryCount; }
+
+private:
+  struct Entry {
+    std::string field; // name followed by value
+    std::size_t nameLength = 0;
+  };
+
+  std::vector<Entry> ring; // power of two sized
+  std::size_t newest;
+  std::size_t entryCount;
+  std::size_t octets;
+  std::size_t maxOctets;
+
+  const Entry &at(std::size_t i) const {
+    return ring[(newest - i) & (ring.size() - 1)];
+  }
+  void evictOldest();
+};
+
+class HpackDecoder {
+public:
+  static constexpr std::size_t DEFAULT_MAX_HEADER_LIST_SIZE = 64 * 1024;
+
+  PARSER_EXPORT explicit HpackDecoder(
+      std::size_t maxTableSize = HPACK_DEFAULT_TABLE_SIZE);
+
+  // SETTINGS_HEADER_TABLE_SIZE announced to the peer, the upper bound of
+  // the table size updates it may send
+  PARSER_EXPORT void set_max_table_size(std::size_t size);
+  // SETTINGS_MAX_HEADER_LIST_SIZE, larger blocks fail to decode
+  void set_max_header_list_size(std::size_t size) { maxHeaderList = size; }
+
+  // Decodes a complete header block (HEADERS and CONTINUATION fragments
+  // joined) and appends the fields to `headers`. Returns false on a
+  // compression error, after which the connection can't be used since
+  // the table state is lost.
+  PARSER_EXPORT bool decode(const char *data, std::size_t length,
+                            Headers &headers);
+  // Decodes a block and maps the pseudo-header fields (RFC 9113 section
+  // 8.3) onto the request or response. Returns false on a compression
+  // error or a malformed message, compression_error() tells them apart.
+  PARSER_EXPORT bool decode_request(const char *data, std::size_t length,
+                                    Request &request);
+  PARSER_EXPORT bool decode_response(const char *data, std::size_t length,
+                                     Response &response);
+  // Decodes a trailer block into `trailers`. Pseudo-header fields, names
+  // that are not lower case and connection-specific fields make the message
+  // malformed, as in the header block.
+  PARSER_EXPORT bool decode_trailers(const char *data, std::size_t length,
+                                     Headers &trailers);
+
+  bool compression_error() const { return compressionError; }
+  const std::string &getErrorMessage() const { return errorMessage; }
+  const HpackTable &table() const { return dynamicTable; }
+
+private:
+  HpackTable dynamicTable;
+  std::size_t maxTableSize;
+  std::size_t maxHeaderList;
+  bool compressionError;
+  std::string errorMessage;
+  std::string name;
+  std::string value;
+  Headers fields;
+
+  bool fail(const char *message);
+  bool malformed(const std::string &message);
+  bool readString(const unsigned char *&p, const unsigned char *end,
+                  std::string &out);
+  bool field(std::size_t index, std::string_view &fieldName,
+             std::string_view &fieldValue) const;
+};
+
+class HpackEncoder {
+public:
+  PARSER_EXPORT explicit HpackEncoder(
+      std::size_t maxTableSize = HPACK_DEFAULT_TABLE_SIZE);
+
+  // SETTINGS_HEADER_TABLE_SIZE received from the peer, signalled at the
+  // start of the next block; `maxTableSize` of the constructor stays the
+  // upper bound
+  PARSER_EXPORT void set_max_table_size(std::size_t size);
+
+  // Appends one field; sensitive fields are never indexed, also not by
+  // intermediaries.
+  PARSER_EXPORT void encode(std::string_view name, std::string_view value,
+                            std::string &out, bool sensitive = false);
+  // Appends the fields, names are lower-cased and connection-specific
+  // fields, which HTTP/2 does not allow, are dropped.
+  PARSER_EXPORT void encode(const Headers &headers, std::string &out);
+  // pseudo-header fields followed by the headers; the host header becomes
+  // :authority and an absolute-form target is split into its parts
+  PARSER_EXPORT void encode_request(const Request &request, std::string &out,
+                                    std::string_view scheme = "http");
+  // Returns false without writing anything if the status code is not
+  // three digits.
+  PARSER_EXPORT bool encode_response(const Response &response,
+                                     std::string &out);
+
+  const HpackTable &table() const { return dynamicTable; }
+
+private:
+  HpackTable dynamicTable;
+  std::size_t maxTableSize;
+  std::size_t pendingMinSize;
+  std::size_t pendingSize;
+  bool sizeUpdatePending;
+  std::string lowered;
+
+  void flushSizeUpdate(std::string &out);
+  void encodeFields(const Headers &headers, std::string &out, bool skipHost);
+};
+
+}; // namespace http_parser
@@ -0,0 +1,299 @@
+#pragma once
+
+/**
+ * @file Http2.hpp
+ * @brief server side HTTP/2 framing and connection state (RFC 9113)
+ * @version 1.0.0
+ *
+ * Http2Connection reads frames from a byte stream in whatever pieces they
+ * arrive and keeps the state of one connection: settings in both
+ * directions, the HPACK tables, the open streams and the flow control
+ * windows. Request headers are decoded into the same Request model as
+ * HTTP/1.1 requests and bodies are handed out as views into the input, so
+ * handlers don't need to know which protocol a request came in. Responses
+ * and data are queued as frames in an output buffer the caller writes.
+ *
+ * Connections start with the client preface, either right away (prior
+ * knowledge) or after an HTTP/1.1 request upgraded with `Upgrade: h2c`,
+ * which becomes stream 1. Stream state lives in a table sorted by stream id
+ * that only holds open streams; streams are removed as soon as both sides
+ * have closed them.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include "Hpack.hpp"
+#include "HttpDefinitions.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace http_parser {
+
+constexpr std::size_t HTTP2_FRAME_HEADER_SIZE = 9;
+constexpr std::string_view HTTP2_PREFACE = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+enum class PARSER_EXPORT Http2FrameType : std::uint8_t {
+  DATA = 0x0,
+  HEADERS = 0x1,
+  PRIORITY = 0x2,
+  RST_STREAM = 0x3,
+  SETTINGS = 0x4,
+  PUSH_PROMISE = 0x5,
+  PING = 0x6,
+  GOAWAY = 0x7,
+  WINDOW_UPDATE = 0x8,
+  CONTINUATION = 0x9,
+};
+
+enum class PARSER_EXPORT Http2ErrorCode : std::uint32_t {
+  NONE = 0x0, // NO_ERROR, which collides with a Windows macro
+  PROTOCOL_ERROR = 0x1,
+  INTERNAL_ERROR = 0x2,
+  FLOW_CONTROL_ERROR = 0x3,
+  SETTINGS_TIMEOUT = 0x4,
+  STREAM_CLOSED = 0x5,
+  FRAME_SIZE_ERROR = 0x6,
+  REFUSED_STREAM = 0x7,
+  CANCEL = 0x8,
+  COMPRESSION_ERROR = 0x9,
+  CONNECT_ERROR = 0xa,
+  ENHANCE_YOUR_CALM = 0xb,
+  INADEQUATE_SECURITY = 0xc,
+  HTTP_1_1_REQUIRED = 0xd,
+};
+
+// Initial values of section 6.5.2, UINT32_MAX stands for unlimited.
+struct PARSER_EXPORT Http2Settings {
+  std::uint32_t headerTableSize = 4096;
+  std::uint32_t enablePush = 1;
+  std::uint32_t maxConcurrentStreams = UINT32_MAX;
+  std::uint32_t initialWindowSize = 65535;
+  std::uint32_t maxFrameSize = 16384;
+  std::uint32_t maxHeaderListSize = UINT32_MAX;
+};
+
+// Applies the parameters of a SETTINGS payload, unknown ones are ignored.
+// Returns false with PROTOCOL_ERROR, FLOW_CONTROL_ERROR or FRAME_SIZE_ERROR
+// through `error` when the payload or a value is invalid.
+bool PARSER_EXPORT apply_http2_settings(const char *data, std::size_t length,
+                                        Http2Settings &settings,
+                                        Http2ErrorCode &error);
+// true if `data` is, or starts with, the client connection preface; a
+// shorter prefix of it also matches, so the sniffing can be repeated as
+// more bytes arrive
+bool PARSER_EXPORT is_http2_preface(const char *data, std::size_t length);
+// HTTP/1.1 request asking for `Upgrade: h2c` with exactly one
+// HTTP2-Settings header
+bool PARSER_EXPORT is_h2c_upgrade(const Request &request);
+// Fills `response` with the 101 answer to an h2c upgrade.
+void PARSER_EXPORT h2c_upgrade_response(Response &response);
+
+enum class PARSER_EXPORT Http2Event {
+  NONE,
+  REQUEST,       // request headers of stream_id(), see request()
+  DATA,          // a piece of the request body of stream_id()
+  TRAILERS,      // trailer fields of stream_id(), see trailers()
+  STREAM_RESET,  // the client reset stream_id() with peer_error_code()
+  WINDOW_UPDATE, // the send window of stream_id() (0: connection) grew
+  SETTINGS,      // the client changed its settings, see peer_settings()
+  GOAWAY,        // the client is going away, debug data in the payload
+};
+
+enum class Http2ParseState {
+  PREFACE,
+  FRAME_HEADER,
+  PAYLOAD,
+  DATA_PAD_LENGTH,
+  DATA_PAYLOAD,
+  DATA_PADDING,
+  PARSE_ERROR,
+};
+
+class Http2Connection {
+public:
+  // settings announced by the server unless others are given
+  static Http2Settings default_settings() {
+    Http2Settings settings;
+    settings.enablePush = 0;
+    settings.maxConcurrentStreams = 100;
+    settings.maxHeaderListSize = 64 * 1024;
+    return settings;
+  }
+
+  // Queues the server's SETTINGS frame, which has to be the first frame
+  // sent on the connection.
+  PARSER_EXPORT explicit Http2Connection(
+      const Http2Settings &settings = default_settings());
+
+  // Takes over an upgraded HTTP/1.1 request as stream 1, half closed since
+  // its body was read already, and applies the client's HTTP2-Settings.
+  // Send the 101 response, then the pending output, and answer the request
+  // on stream 1. Returns false if the request is not a valid upgrade.
+  PARSER_EXPORT bool upgrade(const Request &request);
+
+  // Consumes bytes up to the next event and returns how many were used.
+  // Body data is returned through `payload` as a view into `data`. Call
+  // again with the rest of the data until everything is consumed. On a
+  // connection error failed() turns true and a GOAWAY frame is queued;
+  // write the pending output and close the connection.
+  PARSER_EXPORT std::size_t execute(const char *data, std::size_t length,
+                                    Http2Event &event,
+                                    std::string_view &payload);
+
+  // Queues the response headers of a stream, informational (1xx) responses
+  // may precede the final one. Returns false if the stream is not open, the
+  // final response was sent already or the status code is 101 or not three
+  // digits.
+  PARSER_EXPORT bool submit_response(std::uint32_t stream,
+                                     const Response &response,
+                                     bool endStream);
+  // Queues as much body data as the flow control windows allow and returns
+  // how many bytes were taken; the stream is only ended once all of the
+  // data was taken. Wait for a WINDOW_UPDATE event to submit the rest.
+  PARSER_EXPORT std::size_t submit_data(std::uint32_t stream,
+                                        const char *data, std::size_t length,
+                                        bool endStream);
+  // trailer fields, ending the stream
+  PARSER_EXPORT bool submit_trailers(std::uint32_t stream,
+                                     const Headers &trailers);
+  PARSER_EXPORT void reset_stream(std::uint32_t stream, Http2ErrorCode code);
+  // Marks `bytes` of the body of a stream as processed, which reopens the
+  // receive windows. Padding is accounted for by the connection.
+  PARSER_EXPORT void consume(std::uint32_t stream, std::size_t bytes);
+  // Queues GOAWAY: streams opened after the last one seen are ignored,
+  // the open ones can still be completed.
+  PARSER_EXPORT void shutdown(Http2ErrorCode code = Http2ErrorCode::NONE);
+
+  // frames waiting to be written
+  std::string_view pending_output() const {
+    return std::string_view(output).substr(outputOffset);
+  }
+  PARSER_EXPORT void output_written(std::size_t bytes);
+  // Writes pending output to the descriptor, restarting after partial
+  // writes and EINTR. On error the progress is kept.
+  PARSER_EXPORT bool write(int file_descriptor);
+
+  Http2ParseState get_state() const { return currentParseState; }
+  bool failed() const {
+    return currentParseState == Http2ParseState::PARSE_ERROR;
+  }
+  const std::string &getErrorMessage() const { return errorMessage; }
+  // code of the GOAWAY sent after a connection error
+  Http2ErrorCode error_code() const { return errorCode; }
+
+  // stream of the last event
+  std::uint32_t stream_id() const { return eventStream; }
+  // the last event closed the client's side of stream_id()
+  bool end_stream() const { return eventEndStream; }
+  // valid until the next call to execute
+  const Request &request() const { return currentRequest; }
+  const Headers &trailers() const { return currentTrailers; }
+  // code of a STREAM_RESET or GOAWAY event
+  Http2ErrorCode peer_error_code() const { return peerErrorCode; }
+
+  const Http2Settings &local_settings() const { return localSettings; }
+  const Http2Settings &peer_settings() const { return peerSettings; }
+  // highest stream opened by the client
+  std::uint32_t last_stream_id() const { return lastStreamId; }
+  bool goaway_received() const { return goawayReceived; }
+  std::size_t stream_count() const { return streams.size(); }
+  bool has_stream(std::uint32_t stream) const {
+    return findStream(stream) != nullptr;
+  }
+  // bytes submit_data can send right now, 0 for the connection window
+  PARSER_EXPORT std::int64_t send_window(std::uint32_t stream) const;
+
+private:
+  struct Stream {
+    std::uint32_t id;
+    std::uint8_t flags;
+    std::int32_t receiveWindow;
+    std::uint32_t unacknowledged; // consumed, not yet sent as WINDOW_UPDATE
+    std::int64_t sendWindow;
+    std::uint64_t contentLength; // noContentLength without the header
+    std::uint64_t received;      // DATA payload bytes, without padding
+  };
+
+  Http2ParseState currentParseState;
+  Http2Settings localSettings;
+  Http2Settings peerSettings;
+  bool localSettingsAcknowledged;
+  bool peerSettingsReceived;
+  HpackDecoder decoder;
+  HpackEncoder encoder;
+  std::vector<Stream> streams; // sorted by id
+
+  // frame being read
+  unsigned char header[HTTP2_FRAME_HEADER_SIZE];
+  std::size_t headerBytes;
+  std::size_t prefaceBytes;
+  std::uint32_t frameLength;
+  Http2FrameType frameType;
+  std::uint8_t frameFlags;
+  std::uint32_t frameStream;
+  std::string payloadBuffer;
+  std::uint32_t dataRemaining;
+  std::uint32_t paddingRemaining;
+  bool discardData;
+
+  // header block spread over HEADERS and CONTINUATION frames
+  std::string headerBlock;
+  std::uint32_t headerBlockStream;
+  bool headerBlockEndStream;
+  bool expectContinuation;
+
+  std::int64_t connectionSendWindow;
+  std::int64_t connectionReceiveWindow;
+  std::uint32_t connectionUnacknowledged;
+  std::uint32_t lastStreamId;
+  std::uint32_t goawayLastStream;
+  bool goawaySent;
+  bool goawayReceived;
+
+  std::uint32_t eventStream;
+  bool eventEndStream;
+  Request currentRequest;
+  Headers currentTrailers;
+  Http2ErrorCode peerErrorCode;
+  Http2ErrorCode errorCode;
+  std::string errorMessage;
+
+  std::string output;
+  std::size_t outputOffset;
+  std::string headerScratch;
+
+  Stream *findStream(std::uint32_t id);
+  const Stream *findStream(std::uint32_t id) const;
+  Stream &openStream(std::uint32_t id, bool remoteClosed);
+  void removeStream(std::uint32_t id);
+  void closeRemote(Stream &stream);
+  void closeLocal(Stream &stream);
+  std::int32_t receiveInitialWindow() const;
+  bool bodyLengthValid(const Stream &stream, bool endStream) const;
+
+  void fail(Http2ErrorCode code, const char *message);
+  void resetStream(std::uint32_t id, Http2ErrorCode code);
+  bool beginFrame(Http2Event &event);
+  bool beginData(Http2Event &event);
+  bool beginDataPayload(Http2Event &event);
+  void processFrame(const char *payload, Http2Event &event,
+                    std::string_view &eventPayload);
+  void processHeaders(const char *payload, Http2Event &event);
+  void processContinuation(const char *payload, Http2Event &event);
+  void processHeaderBlock(Http2Event &event);
+  void processSettings(const char *payload, Http2Event &event);
+  void processWindowUpdate(const char *payload, Http2Event &event);
+  void creditReceived(std::uint32_t stream, std::size_t bytes);
+
+  void writeFrameHeader(std::uint32_t length, Http2FrameType type,
+                        std::uint8_t flags, std::uint32_t stream);
+  void writeHeaderBlock(std::uint32_t stream, bool endStream);
+  void writeWindowUpdate(std::uint32_t stream, std::uint32_t increment);
+};
+
+}; // namespace http_parser
@@ -0,0 +1,42 @@
+#pragma once
+
+/**
+ * @file HttpDate.hpp
+ * @brief HTTP-date formatting with a per-thread cache, and parsing
+ * @version 1.0.0
+ *
+ * http_date_now returns the current time as an IMF-fixdate
+ * ("Sun, 06 Nov 1994 08:49:37 GMT"). The string is kept per thread and only
+ * formatted again when the second changes, so a busy thread formats it once
+ * a second instead of once per response. parse_http_date accepts the three
+ * formats RFC 9110 section 5.6.7 requires recipients to understand.
+ * Conversions use civil calendar arithmetic instead of gmtime/timegm.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace http_parser {
+
+constexpr std::size_t HTTP_DATE_LENGTH = 29;
+
+// Current time as IMF-fixdate. The view stays valid on the calling thread
+// and its contents change when the second does.
+std::string_view PARSER_EXPORT http_date_now();
+
+// Writes `epochSeconds` as IMF-fixdate into `out`, which must provide
+// HTTP_DATE_LENGTH bytes, and returns a view of it.
+std::string_view PARSER_EXPORT format_http_date(std::int64_t epochSeconds,
+                                                char *out);
+
+// Parses an IMF-fixdate, RFC 850 or asctime date into seconds since the
+// epoch. Returns false if `text` is none of them.
+bool PARSER_EXPORT parse_http_date(std::string_view text,
+                                   std::int64_t &epochSeconds);
+
+}; // namespace http_parser
@@ -1,7 +1,11 @@
 #pragma once
 
 #include "API.h"
+#include "Cookie.hpp"
+#include "HeaderList.hpp"
+#include "Url.hpp"
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace http_parser {
@@ -18,9 +22,12 @@ enum class PARSER_EXPORT Method {
   METHOD_UNKOWN
 };
 
+// the values are stored by the binary message encoding, keep them stable
 enum class PARSER_EXPORT Version {
-  HTTP_1_1,
-  VERSION_UNKOWN,
+  HTTP_1_1 = 0,
+  VERSION_UNKOWN = 1,
+  HTTP_1_0 = 2,
+  HTTP_2 = 3, // requests and responses decoded from HTTP/2 streams
 };
 
 struct PARSER_EXPORT Header {
@@ -30,23 +37,78 @@ struct PARSER_EXPORT Header {
   Header() = default;
 };
 
+using Headers = HeaderList<16>;
+
+// Expect header of a request, 100-continue is the only expectation defined
+// (RFC 9110 section 10.1.1), anything else is answered with 417
+enum class PARSER_EXPORT Expectation {
+  NONE,
+  CONTINUE,
+  UNSUPPORTED,
+};
+
 struct PARSER_EXPORT Request {
   Method method;
   std::string url;
   Version version;
-  std::vector<Header> headers;
+  Headers headers;
+  // set by the parser from the version and the Connection options
+  bool keep_alive = true;
+  // Expect header of an HTTP/1.1 request, set by the parser
+  Expectation expectation = Expectation::NONE;
+
+  // path, query and fragment views into url, split on first use
+  UrlView target() const { return UrlView(url); }
+  // pairs of the Cookie header, split on iteration
+  Cookies cookies() const {
+    return Cookies(headers.value_of(HeaderId::COOKIE));
+  }
+  bool should_keep_alive() const { return keep_alive; }
+  bool expects_continue() const {
+    return expectation == Expectation::CONTINUE;
+  }
 };
 
 std::string PARSER_EXPORT method_to_string(Method m);
+// GET, HEAD, OPTIONS, TRACE, PUT and DELETE (RFC 9110 section 9.2.2), safe
+// to repeat after a connection failed before the response arrived
+bool PARSER_EXPORT is_idempotent(Method m);
 std::string PARSER_EXPORT version_to_string(Version v);
 Method PARSER_EXPORT string_to_method(const std::string &s);
+// "HTTP/1.0" and "HTTP/1.1", other HTTP/1.x minor versions are handled
+// with HTTP/1.1 semantics
 Version PARSER_EXPORT string_to_version(const std::string &s);
 
+// Connection header options that decide whether a connection persists.
+struct PARSER_EXPORT ConnectionOptions {
+  bool close = false;
+  bool keepAlive = false;
+  bool upgrade = false;
+};
+
+// Adds the options listed in one Connection header value.
+void PARSER_EXPORT add_connection_options(std::string_view value,
+                                          ConnectionOptions &options);
+ConnectionOptions PARSER_EXPORT connection_options(const Headers &headers);
+// HTTP/1.1 connections persist unless closed, HTTP/1.0 ones only when the
+// keep-alive option is given (RFC 9112 section 9.3); HTTP/2 connections
+// always persist
+bool PARSER_EXPORT is_persistent(Version version,
+                                 const ConnectionOptions &options);
+// Adds the expectations listed in one Expect header value.
+void PARSER_EXPORT add_expectations(std::string_view value,
+                                    Expectation &expectation);
+
+// Values are the numeric codes. Codes without an enumerator, such as 103 or
+// 429, are carried as their number; UNKOWN means no valid code.
 enum class PARSER_EXPORT StatusCode {
+  CONTINUE = 100,
+  SWITCHING_PROTOCOLS = 101,
   OK = 200,
   CREATED = 201,
   ACCEPTED = 202,
   NO_CONTENT = 204,
+  PARTIAL_CONTENT = 206,
   MOVED_PERMANENTLY = 301,
   FOUND = 302,
   SEE_OTHER = 303,
@@ -57,6 +119,10 @@ enum class PARSER_EXPORT StatusCode {
   NOT_FOUND = 404,
   METHOD_NOT_ALLOWED = 405,
   REQUEST_TIMEOUT = 408,
+  PRECONDITION_FAILED = 412,
+  CONTENT_TOO_LARGE = 413,
+  RANGE_NOT_SATISFIABLE = 416,
+  EXPECTATION_FAILED = 417,
   INTERNAL_SERVER_ERROR = 500,
   NOT_IMPLEMENTED = 501,
   BAD_GATEWAY = 502,
@@ -65,14 +131,24 @@ enum class PARSER_EXPORT StatusCode {
   UNKOWN = 0,
 };
 
+// three digits, empty for UNKOWN
 std::string PARSER_EXPORT status_code_to_string(StatusCode s);
+// any three digit code, UNKOWN if `s` is not one
 StatusCode PARSER_EXPORT string_to_status_code(const std::string &s);
+// standard reason phrase, empty for UNKOWN
+std::string_view PARSER_EXPORT status_code_to_reason(StatusCode s);
+// precomputed "HTTP/1.1 <code> <reason>\r\n", empty for UNKOWN
+std::string_view PARSER_EXPORT status_line(StatusCode s);
 
 struct PARSER_EXPORT Response {
   Version version;
   StatusCode status_code;
   std::string status_message;
-  std::vector<Header> headers;
+  Headers headers;
+  // set by the parser from the version and the Connection options
+  bool keep_alive = true;
+
+  bool should_keep_alive() const { return keep_alive; }
 };
 
 }; // namespace http_parser
\ No newline at end of file
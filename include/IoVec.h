@@ -0,0 +1,50 @@
+#pragma once
+
+/**
+ * @file IoVec.h
+ * @brief scatter/gather buffer type used by the serializers
+ * @version 1.0.0
+ *
+ * On POSIX this is the system iovec, so arrays can be passed straight to
+ * writev and sendmsg.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include <cstddef>
+
+#ifdef _WIN32
+
+namespace http_parser {
+struct iovec {
+  void *iov_base;
+  std::size_t iov_len;
+};
+}; // namespace http_parser
+
+#else
+
+#include <sys/uio.h>
+
+namespace http_parser {
+using ::iovec;
+}; // namespace http_parser
+
+#endif
+
+namespace http_parser {
+
+// Marks `bytes` of iov[index..count) as sent: whole entries are skipped by
+// advancing `index`, a partially sent entry is trimmed in place.
+void PARSER_EXPORT iovec_consume(iovec *iov, std::size_t count,
+                                 std::size_t &index, std::size_t bytes);
+// Writes iov[index..count) to the descriptor, restarting after partial
+// writes and EINTR. `remaining` is decreased by the bytes written. On error
+// the progress is kept so the write can be resumed.
+bool PARSER_EXPORT iovec_write(int file_descriptor, iovec *iov,
+                               std::size_t count, std::size_t &index,
+                               std::size_t &remaining);
+
+}; // namespace http_parser
@@ -0,0 +1,100 @@
+#pragma once
+
+/**
+ * @file Multipart.hpp
+ * @brief streaming multipart/form-data parser
+ * @version 1.0.0
+ *
+ * MultipartParser splits a multipart body (RFC 2046 section 5.1, RFC 7578)
+ * into parts while it is being received. Delimiters are found with a
+ * Boyer-Moore-Horspool search; a delimiter cut by the end of a buffer is
+ * remembered by how much of it matched, and since those bytes are a prefix
+ * of the delimiter they are handed back from the delimiter itself if it
+ * turns out not to be one. Part bodies are views into the fed buffers, so
+ * memory use does not depend on the size of the upload. Part headers are
+ * parsed with HeaderParser.
+ *
+ * The parser is fed the payload, i.e. after BodyParser removed the
+ * transfer framing.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include "HeaderParser.h"
+#include "HttpDefinitions.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace http_parser {
+
+// Boundary parameter of a multipart/* Content-Type value as a view into
+// it. Returns false if the media type is not multipart or the boundary is
+// missing or invalid.
+bool PARSER_EXPORT parse_multipart_boundary(std::string_view contentType,
+                                            std::string_view &boundary);
+
+enum class PARSER_EXPORT MultipartEvent {
+  NONE,
+  PART_BEGIN, // the headers of a part were parsed, see part_headers()
+  PART_DATA,  // a piece of the current part's body
+  PART_END,
+  DONE, // the close delimiter was found, the epilogue is ignored
+};
+
+enum class MultipartParseState {
+  PREAMBLE,
+  BOUNDARY_END,
+  BOUNDARY_LF,
+  CLOSE_DASH,
+  HEADERS,
+  DATA,
+  DONE,
+  PARSE_ERROR,
+};
+
+class MultipartParser {
+public:
+  static constexpr std::size_t MAX_BOUNDARY_LENGTH = 70;
+  static constexpr std::size_t MAX_PART_HEADER_BYTES = 8192;
+
+  PARSER_EXPORT MultipartParser();
+
+  // Starts a body with the given boundary, returns false if it is invalid.
+  PARSER_EXPORT bool reset(std::string_view boundary);
+  // Consumes body bytes up to the next event and returns how many were
+  // used. PART_DATA is returned through `partData` as a view into `data`
+  // or, for a suspected delimiter that was cut by the end of the previous
+  // buffer, into the parser. Call again with the rest of the data until
+  // everything is consumed.
+  PARSER_EXPORT std::size_t execute(const char *data, std::size_t length,
+                                    MultipartEvent &event,
+                                    std::string_view &partData);
+  // end of the body, fails a body without close delimiter
+  PARSER_EXPORT void finish();
+
+  MultipartParseState get_state() const { return currentParseState; }
+  bool done() const { return currentParseState == MultipartParseState::DONE; }
+  bool failed() const {
+    return currentParseState == MultipartParseState::PARSE_ERROR;
+  }
+  // headers of the current part, valid from PART_BEGIN to the next part
+  const Headers &part_headers() const { return headerParser.headers(); }
+
+private:
+  MultipartParseState currentParseState;
+  std::string delimiter; // CRLF "--" boundary
+  std::array<std::uint8_t, 256> shift;
+  std::size_t matched; // delimiter bytes matched at the end of a buffer
+  std::size_t headerBytes;
+  HeaderParser headerParser;
+
+  std::size_t search(const char *data, std::size_t length) const;
+  std::size_t partialMatch(const char *data, std::size_t length) const;
+};
+
+}; // namespace http_parser
@@ -0,0 +1,67 @@
+#pragma once
+
+/**
+ * @file Negotiation.hpp
+ * @brief proactive content negotiation (Accept, Accept-Encoding, ...)
+ * @version 1.0.0
+ *
+ * A Negotiator holds the values a server can produce, in its order of
+ * preference, and picks the best of them for a request header following
+ * RFC 9110 section 12.5: the most specific matching range decides the
+ * weight of a value, q=0 excludes it and ties go to the server's order.
+ * Header values repeat heavily across clients, so select() remembers
+ * recent results in a small direct mapped cache per thread, keyed on the
+ * negotiator and the raw header value.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace http_parser {
+
+enum class PARSER_EXPORT NegotiationKind {
+  MEDIA_TYPE, // Accept: type/subtype ranges with wildcards, parameters
+              // other than q are ignored
+  ENCODING,   // Accept-Encoding, Accept-Charset: tokens and "*"; identity
+              // is acceptable unless excluded
+  LANGUAGE,   // Accept-Language: basic filtering of RFC 4647 section 3.3.1
+};
+
+class Negotiator {
+public:
+  static constexpr std::size_t CACHE_ENTRIES = 64;
+  // longer header values are negotiated without the cache
+  static constexpr std::size_t MAX_CACHED_VALUE = 256;
+
+  PARSER_EXPORT Negotiator(NegotiationKind kind,
+                           std::vector<std::string> supported);
+
+  // Index into the supported values of the best acceptable one for a
+  // header value, -1 if none is acceptable. An empty value accepts
+  // anything for media types and languages, and only identity for
+  // encodings, so include "identity" if unencoded content can be sent.
+  PARSER_EXPORT int select(std::string_view headerValue) const;
+  // same as select, without the per-thread cache
+  PARSER_EXPORT int evaluate(std::string_view headerValue) const;
+
+  NegotiationKind kind() const { return negotiationKind; }
+  const std::string &value(std::size_t i) const { return supported[i]; }
+  std::size_t size() const { return supported.size(); }
+
+private:
+  NegotiationKind negotiationKind;
+  std::vector<std::string> supported;
+  std::uint64_t id;
+
+  // weight in thousandths a header value gives supported[i]
+  std::uint16_t weight(std::string_view headerValue, std::size_t i) const;
+};
+
+}; // namespace http_parser
@@ -0,0 +1,72 @@
+#pragma once
+
+/**
+ * @file ParserPolicy.hpp
+ * @brief compile time behaviour switches shared by the parsers
+ * @version 1.0.0
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+namespace http_parser {
+
+/**
+ * Parser behaviour is chosen at compile time through a policy type, so a
+ * specialization only contains the branches it needs. A policy provides:
+ *  - requireCRLF: reject lines terminated by a bare LF
+ *  - lowercaseHeaderKeys: store header keys in lower case
+ *  - skipLeadingWhitespace: tolerate extra whitespace before the request
+ *    line and between its tokens
+ *  - storeHeaders: keep parsed headers, otherwise they are only validated
+ *  - requireHost: fail HTTP/1.1 requests without a Host header
+ */
+struct DefaultParserPolicy {
+  static constexpr bool requireCRLF = false;
+  static constexpr bool lowercaseHeaderKeys = true;
+  static constexpr bool skipLeadingWhitespace = true;
+  static constexpr bool storeHeaders = true;
+  static constexpr bool requireHost = true;
+};
+
+// edge facing servers, exactly one SP between tokens and CRLF line endings
+struct StrictParserPolicy : DefaultParserPolicy {
+  static constexpr bool requireCRLF = true;
+  static constexpr bool skipLeadingWhitespace = false;
+};
+
+// trusted internal traffic
+struct LenientParserPolicy : DefaultParserPolicy {
+  static constexpr bool requireHost = false;
+};
+
+// health checks only look at the request line
+struct HealthCheckParserPolicy : DefaultParserPolicy {
+  static constexpr bool lowercaseHeaderKeys = false;
+  static constexpr bool storeHeaders = false;
+  static constexpr bool requireHost = false;
+};
+
+/**
+ * The part of a parser policy the header block parser depends on. Parser
+ * policies that only differ elsewhere map to the same header policy and so
+ * share one header parser instantiation.
+ *  - identifyHeaders: collect keys to know which well known headers were
+ *    present, and the Connection and Expect options, even if headers are
+ *    not stored. Request parsers always need them for keep-alive.
+ */
+template <bool RequireCRLF, bool LowercaseHeaderKeys, bool StoreHeaders,
+          bool IdentifyHeaders>
+struct HeaderPolicy {
+  static constexpr bool requireCRLF = RequireCRLF;
+  static constexpr bool lowercaseHeaderKeys = LowercaseHeaderKeys;
+  static constexpr bool storeHeaders = StoreHeaders;
+  static constexpr bool identifyHeaders = IdentifyHeaders;
+};
+
+template <typename Policy>
+using HeaderPolicyOf =
+    HeaderPolicy<Policy::requireCRLF, Policy::lowercaseHeaderKeys,
+                 Policy::storeHeaders, true>;
+
+}; // namespace http_parser
@@ -0,0 +1,115 @@
+#pragma once
+
+/**
+ * @file Range.hpp
+ * @brief byte range requests and 206 / multipart/byteranges responses
+ * @version 1.0.0
+ *
+ * parse_range reads a "bytes=" range set without allocating, resolves
+ * suffix and open ended specs against the content length, then sorts and
+ * coalesces overlapping or adjacent ranges. RangeBody turns the result into
+ * response headers and a list of body views for the iovec serializer: a
+ * single range is a slice of the content, several ranges become
+ * multipart/byteranges with the part framing kept in one scratch buffer.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include "Conditional.hpp"
+#include "HttpDefinitions.hpp"
+#include "ResponseSerializer.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace http_parser {
+
+struct PARSER_EXPORT ByteRange {
+  std::uint64_t first; // inclusive
+  std::uint64_t last;  // inclusive
+
+  std::uint64_t length() const { return last - first + 1; }
+};
+
+class PARSER_EXPORT ByteRanges {
+public:
+  // every range needs a framing and a content view, plus the closing
+  // delimiter, within ResponseSerializer::MAX_BODY_PARTS
+  static constexpr std::size_t MAX_RANGES =
+      (ResponseSerializer::MAX_BODY_PARTS - 1) / 2;
+
+  std::size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  const ByteRange &operator[](std::size_t i) const { return ranges[i]; }
+  const ByteRange *begin() const { return ranges.data(); }
+  const ByteRange *end() const { return ranges.data() + count; }
+  // total number of selected bytes
+  std::uint64_t bytes() const;
+
+  void clear() { count = 0; }
+  bool push(ByteRange range);
+  // sorts by start and merges overlapping or adjacent ranges
+  void coalesce();
+
+private:
+  std::array<ByteRange, MAX_RANGES> ranges{};
+  std::size_t count = 0;
+};
+
+enum class PARSER_EXPORT RangeResult {
+  NONE,          // no usable range, send the full representation (200)
+  SATISFIABLE,   // send the selected ranges (206)
+  UNSATISFIABLE, // no range overlaps the content (416)
+};
+
+// Parses the value of a Range header against `contentLength`. Unknown
+// units, syntax errors and range sets with more than MAX_RANGES members
+// after coalescing yield NONE, which means the header is ignored.
+RangeResult PARSER_EXPORT parse_range(std::string_view value,
+                                      std::uint64_t contentLength,
+                                      ByteRanges &ranges);
+
+// Range handling for a GET request, including If-Range: the ranges are
+// only honoured when If-Range matches the validators (strong ETag match,
+// or a date equal to the last modification time).
+RangeResult PARSER_EXPORT evaluate_range(const Request &request,
+                                         std::uint64_t contentLength,
+                                         const ResourceValidators &validators,
+                                         ByteRanges &ranges);
+
+class RangeBody {
+public:
+  static constexpr std::size_t MAX_PARTS = ByteRanges::MAX_RANGES * 2 + 1;
+
+  PARSER_EXPORT RangeBody();
+
+  // Sets status 206 and the content-range or content-type headers on
+  // `response` and prepares the body views into `content`, which must hold
+  // the whole representation. The response must not carry content-type or
+  // content-length yet. Returns false if `ranges` is empty or out of bounds.
+  PARSER_EXPORT bool prepare(Response &response, const ByteRanges &ranges,
+                             std::string_view content,
+                             std::string_view contentType);
+  // Sets status 416 and "content-range: bytes */<length>".
+  PARSER_EXPORT void prepare_unsatisfiable(Response &response,
+                                           std::uint64_t contentLength);
+
+  // views to pass to ResponseSerializer::serialize, valid while this object
+  // and the content are unchanged
+  const std::string_view *parts() const { return partViews.data(); }
+  std::size_t part_count() const { return partCount; }
+  std::string_view boundary() const { return boundaryText; }
+
+private:
+  std::string framing;
+  std::string headerValue;
+  std::string boundaryText;
+  std::array<std::string_view, MAX_PARTS> partViews;
+  std::size_t partCount;
+};
+
+}; // namespace http_parser
@@ -16,6 +16,9 @@
 
 #include "HttpDefinitions.hpp"
 #include "API.h"
+#include "HeaderParser.h"
+#include "ParserPolicy.hpp"
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -34,23 +37,23 @@ enum class ParseState {
   VERSION_DOT,
   VERSION_MINOR,
   REQUEST_LINE_END,
-  HEADER_KEY,
-  HEADER_DELIMITER,
-  HEADER_VALUE,
-  HEADER_LINE_END_CR,
-  HEADER_LINE_END_LF,
-  END_OF_HEADER_CR,
-  END_OF_HEADER_LF,
+  REQUEST_LINE_END_LF,
+  HEADERS,
   DONE,
   PARSE_ERROR,
 };
 
-class  RequestParser {
+template <typename Policy> class BasicRequestParser {
 public:
-  PARSER_EXPORT RequestParser();
-  PARSER_EXPORT ~RequestParser();
+  PARSER_EXPORT BasicRequestParser();
+  PARSER_EXPORT ~BasicRequestParser();
   bool PARSER_EXPORT parse(int file_descriptor);
+  // Buffer driven parsing, consumes bytes up to the end of the header block
+  // and returns how many were used. May be called again with more data
+  // until get_state() is DONE or PARSE_ERROR.
+  std::size_t PARSER_EXPORT execute(const char *data, std::size_t length);
   void PARSER_EXPORT reset();
+  ParseState get_state() const { return currentParseState; }
   Request PARSER_EXPORT get_request();
   std::string PARSER_EXPORT getErrorMessage();
 
@@ -60,8 +63,7 @@ private:
   std::string currentMethod;
   std::string currentUrl;
   std::string currentVersion;
-  std::string currentHeaderKey;
-  std::string currentHeaderValue;
+  BasicHeaderParser<HeaderPolicyOf<Policy>> headerParser;
   std::string requestData;
   std::string errorMessage;
   int currentCharIndex;
@@ -71,7 +73,8 @@ private:
 
   bool isValidUrlChar(char c);
 
-  void processRequest(int file_descriptor);
+  void processChar(char nextChar);
+  void finishHeaders();
   void parseMethod(char nextChar, ParseState &currentParseState,
                    bool &readNextChar);
   void parseUrl(char nextChar, ParseState &currentParseState,
@@ -96,19 +99,18 @@ private:
                          bool &readNextChar);
   void parseRequestLineEnd(char nextChar, ParseState &currentParseState,
                            bool &readNextChar);
-  void parseHeaderKey(char nextChar, ParseState &currentParseState,
-                      bool &readNextChar);
-  void parseHeaderDelimiter(char nextChar, ParseState &currentParseState,
-                            bool &readNextChar);
-  void parseHeaderValue(char nextChar, ParseState &currentParseState,
-                        bool &readNextChar);
-  void parseHeaderLineEndCR(char nextChar, ParseState &currentParseState,
-                            bool &readNextChar);
-  void parseHeaderLineEndLF(char nextChar, ParseState &currentParseState,
-                            bool &readNextChar);
-  void parseEndOfHeaderCR(char nextChar, ParseState &currentParseState,
-                          bool &readNextChar);
-  void parseEndOfHeaderLF(char nextChar, ParseState &currentParseState,
-                          bool &readNextChar);
+  void parseRequestLineEndLF(char nextChar, ParseState &currentParseState,
+                             bool &readNextChar);
 };
+
+// instantiated in RequestParser.cpp
+extern template class BasicRequestParser<DefaultParserPolicy>;
+extern template class BasicRequestParser<StrictParserPolicy>;
+extern template class BasicRequestParser<LenientParserPolicy>;
+extern template class BasicRequestParser<HealthCheckParserPolicy>;
+
+using RequestParser = BasicRequestParser<DefaultParserPolicy>;
+using StrictRequestParser = BasicRequestParser<StrictParserPolicy>;
+using LenientRequestParser = BasicRequestParser<LenientParserPolicy>;
+using HealthCheckRequestParser = BasicRequestParser<HealthCheckParserPolicy>;
 }; // namespace http_parser
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+/**
+ * @file RequestSerializer.hpp
+ * @brief serializes a Request into an iovec array for writev
+ * @version 1.0.0
+ *
+ * Client side counterpart of ResponseSerializer. The request line and the
+ * header block are written into one scratch buffer that is reused between
+ * requests, body parts are referenced in place. A content-length header is
+ * added when the request has a body but neither content-length nor
+ * transfer-encoding, and a host header is added from set_host when the
+ * request does not carry one.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include "HttpDefinitions.hpp"
+#include "IoVec.h"
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace http_parser {
+
+class RequestSerializer {
+public:
+  static constexpr std::size_t MAX_BODY_PARTS = 30;
+
+  PARSER_EXPORT RequestSerializer();
+
+  // host header used for requests that do not set one
+  void set_host(std::string_view host) { defaultHost.assign(host); }
+
+  PARSER_EXPORT bool serialize(const Request &request,
+                               std::string_view body = std::string_view());
+  PARSER_EXPORT bool serialize(const Request &request,
+                               const std::string_view *bodyParts,
+                               std::size_t partCount);
+
+  const iovec *iovecs() const { return iov.data() + iovIndex; }
+  std::size_t iovec_count() const { return iovCount - iovIndex; }
+  // bytes left to write
+  std::size_t size() const { return remainingBytes; }
+  std::size_t body_size() const { return bodyBytes; }
+
+  // same semantics as ResponseSerializer::write
+  PARSER_EXPORT bool write(int file_descriptor);
+  PARSER_EXPORT void consume(std::size_t bytes);
+
+private:
+  std::string headerBuffer;
+  std::string defaultHost;
+  std::array<iovec, MAX_BODY_PARTS + 1> iov;
+  std::size_t iovCount;
+  std::size_t iovIndex;
+  std::size_t remainingBytes;
+  std::size_t bodyBytes;
+};
+
+}; // namespace http_parser
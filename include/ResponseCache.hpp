@@ -0,0 +1,121 @@
+#pragma once
+
+/**
+ * @file ResponseCache.hpp
+ * @brief sharded in-memory cache of serialized responses
+ * @version 1.0.0
+ *
+ * Entries are keyed on the method, the effective request URI (scheme, Host
+ * and normalized target) and the values of the request headers named by
+ * the response's Vary header, and hold the
+ * response exactly as it goes on the wire, so a hit is written out without
+ * calling a handler or serializing again. The key space is split over
+ * shards, each guarded by a shared_mutex: lookups only take the shared
+ * lock and mark the entry with an atomic reference bit, so all cores can
+ * read at the same time. Inserts take the exclusive lock of one shard and
+ * evict with the CLOCK policy until the entry fits the shard's byte budget.
+ *
+ * Stored bytes are served as they are, including any date header they
+ * carry. Each entry keeps the end of its freshness lifetime, computed when
+ * it is stored from s-maxage, max-age, Expires or Last-Modified (RFC 9111
+ * section 4.2); stale entries are misses. The cache doesn't revalidate, so
+ * responses that require it (no-cache or no freshness) are not stored.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include "HttpDefinitions.hpp"
+#include "ResponseSerializer.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace http_parser {
+
+struct PARSER_EXPORT CacheStats {
+  std::uint64_t hits = 0;
+  std::uint64_t misses = 0;
+  std::uint64_t insertions = 0;
+  std::uint64_t evictions = 0;
+  std::uint64_t entries = 0;
+  std::uint64_t bytes = 0;
+};
+
+class ResponseCache {
+public:
+  using Entry = std::shared_ptr<const std::string>;
+
+  // `scheme` is the one of the connections the requests arrive on, it is
+  // part of the key of origin-form targets
+  PARSER_EXPORT explicit ResponseCache(std::size_t capacityBytes,
+                                       std::size_t shardCount = 16,
+                                       std::string_view scheme = "http");
+  ResponseCache(const ResponseCache &) = delete;
+  ResponseCache &operator=(const ResponseCache &) = delete;
+
+  // GET requests without "cache-control: no-store" or no-cache
+  PARSER_EXPORT static bool is_cacheable(const Request &request);
+  // fresh 200 responses without no-store, no-cache, private, Set-Cookie or
+  // "vary: *"
+  PARSER_EXPORT static bool is_storable(const Response &response);
+
+  // The serialized response for `request`, or nullptr on a miss. The
+  // returned bytes stay valid while the caller holds the pointer, even if
+  // the entry is evicted meanwhile.
+  PARSER_EXPORT Entry lookup(const Request &request);
+  // Stores `bytes` as the answer to `request`. Returns false if either is
+  // not cacheable, the request carries Authorization and the response
+  // doesn't allow sharing with public, s-maxage or must-revalidate, or the
+  // entry is larger than a shard.
+  PARSER_EXPORT bool insert(const Request &request, const Response &response,
+                            std::string_view bytes);
+  // stores what `serializer` is about to write, before write() is called
+  PARSER_EXPORT bool insert(const Request &request, const Response &response,
+                            const ResponseSerializer &serializer);
+  PARSER_EXPORT void clear();
+  PARSER_EXPORT CacheStats stats() const;
+
+private:
+  struct Node {
+    std::string key; // primary key, '\0', vary values
+    std::size_t primaryLength;
+    std::int64_t expires; // seconds since the epoch
+    Entry bytes;
+    mutable std::atomic<bool> referenced{false};
+  };
+
+  struct Shard {
+    mutable std::shared_mutex mutex;
+    struct Variants {
+      std::string varyNames; // lower-case, sorted, comma separated
+      std::size_t count = 0;
+    };
+    std::unordered_map<std::string, Variants> variants;
+    std::list<Node> nodes;
+    std::unordered_map<std::string_view, std::list<Node>::iterator> index;
+    std::list<Node>::iterator hand;
+    std::size_t bytes = 0;
+  };
+
+  std::string scheme;
+  std::size_t shardCapacity;
+  std::vector<std::unique_ptr<Shard>> shards;
+  std::atomic<std::uint64_t> hitCount{0};
+  std::atomic<std::uint64_t> missCount{0};
+  std::atomic<std::uint64_t> insertCount{0};
+  std::atomic<std::uint64_t> evictionCount{0};
+
+  Shard &shardFor(std::string_view primaryKey);
+  void evictOne(Shard &shard);
+};
+
+}; // namespace http_parser
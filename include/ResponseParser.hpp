@@ -11,8 +11,10 @@
  * GNU General Public License v3.0
  */
 
+#include "HeaderParser.h"
 #include "HttpDefinitions.hpp"
 #include <API.h>
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -33,13 +35,7 @@ enum class ResponseParseState {
   STATUS_MESSAGE,
   STATUS_MESSAGE_CR,
   STATUS_MESSAGE_LF,
-  HEADER_KEY,
-  HEADER_DELIMITER,
-  HEADER_VALUE,
-  HEADER_LINE_END_CR,
-  HEADER_LINE_END_LF,
-  END_OF_HEADER_CR,
-  END_OF_HEADER_LF,
+  HEADERS,
   DONE,
   PARSE_ERROR,
 };
@@ -50,8 +46,12 @@ public:
   PARSER_EXPORT ~ResponseParser() = default;
 
   PARSER_EXPORT bool parse(int file_descriptor);
+  // Buffer driven parsing, consumes bytes up to the end of the header block
+  // and returns how many were used.
+  PARSER_EXPORT std::size_t execute(const char *data, std::size_t length);
   PARSER_EXPORT void reset();
   PARSER_EXPORT Response get_response() const;
+  ResponseParseState get_state() const { return currentParseState; }
 
 private:
   ResponseParseState currentParseState;
@@ -59,11 +59,9 @@ private:
   std::string currentVersion;
   std::string currentStatusCode;
   std::string currentStatusMessage;
-  std::string currentHeaderKey;
-  std::string currentHeaderValue;
+  HeaderParser headerParser;
   bool isValidStatusCodeChar(char c);
-  bool isValidHeaderKeyChar(char c);
-  void processResponse(int file_descriptor);
+  void processChar(char nextChar);
   void parseVersion(char nextChar, ResponseParseState &currentParseState,
                     bool &readNextChar);
   void parseVersionHttpH(char nextChar, ResponseParseState &currentParseState,
@@ -95,23 +93,6 @@ private:
   void parseStatusMessageLF(char nextChar,
                             ResponseParseState &currentParseState,
                             bool &readNextChar);
-  void parseHeaderKey(char nextChar, ResponseParseState &currentParseState,
-                      bool &readNextChar);
-  void parseHeaderDelimiter(char nextChar,
-                            ResponseParseState &currentParseState,
-                            bool &readNextChar);
-  void parseHeaderValue(char nextChar, ResponseParseState &currentParseState,
-                        bool &readNextChar);
-  void parseHeaderLineEndCR(char nextChar,
-                            ResponseParseState &currentParseState,
-                            bool &readNextChar);
-  void parseHeaderLineEndLF(char nextChar,
-                            ResponseParseState &currentParseState,
-                            bool &readNextChar);
-  void parseEndOfHeaderCR(char nextChar, ResponseParseState &currentParseState,
-                          bool &readNextChar);
-  void parseEndOfHeaderLF(char nextChar, ResponseParseState &currentParseState,
-                          bool &readNextChar);
 };
 
 } // namespace http_parser
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+/**
+ * @file ResponseSerializer.hpp
+ * @brief serializes a Response into an iovec array for writev
+ * @version 1.0.0
+ *
+ * The status line comes from the precomputed table in HttpDefinitions, the
+ * header block is written into one scratch buffer that is reused between
+ * responses, and body parts are referenced in place. A content-length
+ * header is added when the response has neither content-length nor
+ * transfer-encoding and the status allows a body, unless disabled with
+ * set_content_length_header, and a date header from the per-thread cache
+ * in HttpDate unless disabled with set_date_header. Status codes outside
+ * 100 to 599 are refused.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include "HttpDefinitions.hpp"
+#include "IoVec.h"
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace http_parser {
+
+class ResponseSerializer {
+public:
+  static constexpr std::size_t MAX_BODY_PARTS = 30;
+
+  PARSER_EXPORT ResponseSerializer();
+
+  // add a date header to final responses that do not carry one
+  void set_date_header(bool enabled) { addDateHeader = enabled; }
+  // Add "content-length: <body size>" to responses without framing headers.
+  // Turn it off for answers to HEAD, which carry no body but would announce
+  // the length of the GET representation.
+  void set_content_length_header(bool enabled) { addContentLength = enabled; }
+
+  PARSER_EXPORT bool serialize(const Response &response,
+                               std::string_view body = std::string_view());
+  // body made of several views, e.g. multipart framing around file slices
+  PARSER_EXPORT bool serialize(const Response &response,
+                               const std::string_view *bodyParts,
+                               std::size_t partCount);
+
+  const iovec *iovecs() const { return iov.data() + iovIndex; }
+  std::size_t iovec_count() const { return iovCount - iovIndex; }
+  // bytes left to write
+  std::size_t size() const { return remainingBytes; }
+  std::size_t body_size() const { return bodyBytes; }
+
+  // Writes the remaining bytes with writev, restarting after partial
+  // writes. Returns false on error; with a non blocking descriptor the
+  // progress is kept and write can be called again once it is writable.
+  PARSER_EXPORT bool write(int file_descriptor);
+  // marks `bytes` as sent by the caller, e.g. after its own sendmsg
+  PARSER_EXPORT void consume(std::size_t bytes);
+
+private:
+  std::string headerBuffer;
+  std::array<iovec, MAX_BODY_PARTS + 2> iov;
+  std::size_t iovCount;
+  std::size_t iovIndex;
+  std::size_t remainingBytes;
+  std::size_t bodyBytes;
+  bool addDateHeader;
+  bool addContentLength;
+};
+
+}; // namespace http_parser
@@ -0,0 +1,82 @@
+#pragma once
+
+/**
+ * @file Router.hpp
+ * @brief radix tree router matching a parsed request on method and path
+ * @version 1.0.0
+ *
+ * Patterns are made of static text, named segments (`/users/:id`) and a
+ * trailing wildcard segment (`*path` as the last segment after a slash,
+ * capturing the rest of the path). Each Method has its own compressed
+ * radix tree; static edges win over named segments, which win over
+ * wildcards. Matching never allocates, captured values are views into the
+ * matched path and names are views into the router.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include "HttpDefinitions.hpp"
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+namespace http_parser {
+
+struct PARSER_EXPORT RouteParam {
+  std::string_view name;
+  std::string_view value;
+};
+
+class PARSER_EXPORT RouteMatch {
+public:
+  static constexpr std::size_t MAX_PARAMS = 8;
+
+  std::size_t route_id() const { return routeId; }
+  std::size_t size() const { return count; }
+  const RouteParam &operator[](std::size_t i) const { return params[i]; }
+  const RouteParam *begin() const { return params.data(); }
+  const RouteParam *end() const { return params.data() + count; }
+  // captured value for `name`, empty if the route has no such parameter
+  std::string_view param(std::string_view name) const;
+
+private:
+  friend class Router;
+  std::array<RouteParam, MAX_PARAMS> params{};
+  std::size_t count = 0;
+  std::size_t routeId = 0;
+};
+
+class Router {
+public:
+  PARSER_EXPORT Router();
+  PARSER_EXPORT ~Router();
+  Router(const Router &) = delete;
+  Router &operator=(const Router &) = delete;
+
+  // Registers `pattern` for `method`, returns false if the pattern is
+  // malformed or conflicts with an existing route.
+  PARSER_EXPORT bool add(Method method, std::string_view pattern,
+                         std::size_t routeId);
+  PARSER_EXPORT bool match(Method method, std::string_view path,
+                           RouteMatch &match) const;
+  // matches on the method and the path of the request target
+  PARSER_EXPORT bool match(const Request &request, RouteMatch &match) const;
+
+private:
+  struct Node;
+  static constexpr std::size_t METHOD_COUNT =
+      static_cast<std::size_t>(Method::METHOD_UNKOWN);
+
+  std::array<std::unique_ptr<Node>, METHOD_COUNT> roots;
+
+  static Node *insertStatic(Node *node, std::string_view text);
+  static const Node *findStatic(const Node *node, std::string_view text);
+  static bool fits(const Node *root, std::string_view pattern);
+  static bool matchNode(const Node *node, std::string_view path,
+                        RouteMatch &match);
+};
+
+}; // namespace http_parser
@@ -0,0 +1,148 @@
+#pragma once
+
+/**
+ * @file Url.hpp
+ * @brief non allocating decomposition of a request target
+ * @version 1.0.0
+ *
+ * UrlView splits a request target (origin, absolute, authority or asterisk
+ * form) into views of the original string on first use. The target is
+ * expected to have been validated by the request parser already, so the
+ * split only looks for delimiters. percent_decode writes into memory owned by
+ * the caller and leaves segments without escapes untouched.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+namespace http_parser {
+
+enum class PARSER_EXPORT TargetForm {
+  ORIGIN,    // /path?query
+  ABSOLUTE,  // http://host:port/path?query (proxies)
+  AUTHORITY, // host:port (CONNECT)
+  ASTERISK,  // * (server wide OPTIONS)
+  UNKOWN,
+};
+
+struct PARSER_EXPORT QueryParam {
+  std::string_view key;
+  std::string_view value; // still percent encoded
+};
+
+// Iterates over key=value pairs of a raw query string separated by '&'.
+class PARSER_EXPORT QueryParams {
+public:
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = QueryParam;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const QueryParam *;
+    using reference = const QueryParam &;
+
+    const_iterator() = default;
+    explicit const_iterator(std::string_view remaining);
+
+    const QueryParam &operator*() const { return current; }
+    const QueryParam *operator->() const { return &current; }
+    const_iterator &operator++();
+    const_iterator operator++(int) {
+      const_iterator previous = *this;
+      ++*this;
+      return previous;
+    }
+    bool operator==(const const_iterator &other) const {
+      return atEnd == other.atEnd &&
+             (atEnd || current.key.data() == other.current.key.data());
+    }
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+
+  private:
+    std::string_view remaining;
+    QueryParam current;
+    bool atEnd = true;
+  };
+
+  QueryParams() = default;
+  explicit QueryParams(std::string_view query) : query(query) {}
+
+  const_iterator begin() const { return const_iterator(query); }
+  const_iterator end() const { return const_iterator(); }
+  // raw value of the first parameter named `key`, false if it is absent
+  bool find(std::string_view key, std::string_view &value) const;
+
+private:
+  std::string_view query;
+};
+
+class PARSER_EXPORT UrlView {
+public:
+  UrlView() = default;
+  explicit UrlView(std::string_view target) : target(target) {}
+
+  std::string_view raw() const { return target; }
+  TargetForm form() const;
+  std::string_view scheme() const;
+  // userinfo@host:port for absolute form, host:port for authority form
+  std::string_view authority() const;
+  std::string_view host() const;
+  std::string_view port() const;
+  std::string_view path() const;
+  std::string_view query() const;
+  std::string_view fragment() const;
+  QueryParams query_params() const { return QueryParams(query()); }
+
+private:
+  struct Span {
+    std::uint32_t offset = 0;
+    std::uint32_t length = 0;
+  };
+
+  std::string_view target;
+  mutable bool parsed = false;
+  mutable TargetForm targetForm = TargetForm::UNKOWN;
+  mutable Span schemeSpan;
+  mutable Span authoritySpan;
+  mutable Span hostSpan;
+  mutable Span portSpan;
+  mutable Span pathSpan;
+  mutable Span querySpan;
+  mutable Span fragmentSpan;
+
+  void split() const;
+  void splitAuthority() const;
+  void splitPath(std::size_t start) const;
+  std::string_view view(const Span &span) const {
+    return target.substr(span.offset, span.length);
+  }
+};
+
+// true if `in` holds a '%' escape (or a '+' when form encoded)
+bool PARSER_EXPORT needs_percent_decoding(std::string_view in,
+                                          bool formEncoded = false);
+
+// Decodes %XX escapes of `in` into `out`, which must provide at least
+// in.size() bytes. When nothing needs decoding `decoded` aliases `in` and
+// `out` is left untouched. Returns false on a malformed escape.
+bool PARSER_EXPORT percent_decode(std::string_view in, char *out,
+                                  std::string_view &decoded,
+                                  bool formEncoded = false);
+
+// Canonical form of a request target for use as a lookup key (RFC 3986
+// section 6.2.2): scheme and host are lower-cased, a default port is
+// dropped, escapes of unreserved characters are decoded, the hex digits of
+// the remaining escapes are upper-cased and the fragment is removed. The
+// result is appended to `out`. Returns false on a malformed escape.
+bool PARSER_EXPORT normalize_target(std::string_view target, std::string &out);
+
+}; // namespace http_parser
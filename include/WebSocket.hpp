@@ -0,0 +1,147 @@
+#pragma once
+
+/**
+ * @file WebSocket.hpp
+ * @brief WebSocket upgrade handshake and frame parser (RFC 6455)
+ * @version 1.0.0
+ *
+ * validate_websocket_upgrade checks an opening handshake on a parsed
+ * Request and websocket_accept computes the Sec-WebSocket-Accept value for
+ * the 101 response. WebSocketFrameParser reads frames from a byte stream
+ * in whatever pieces they arrive, handles extended lengths, fragmented
+ * messages and interleaved control frames, and unmasks payloads in place.
+ * Unmasking XORs 32 bytes at a time with AVX2 or 16 with SSE2 when the
+ * build targets them.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include "API.h"
+#include "HttpDefinitions.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace http_parser {
+
+constexpr std::size_t WEBSOCKET_ACCEPT_LENGTH = 28;
+constexpr std::size_t WEBSOCKET_MAX_FRAME_HEADER = 14;
+
+enum class PARSER_EXPORT WebSocketUpgrade {
+  NONE,        // not a WebSocket upgrade request
+  VALID,
+  BAD_VERSION, // answer 426 with sec-websocket-version: 13
+  INVALID,     // answer 400
+};
+
+// Checks the opening handshake of RFC 6455 section 4.2.1 and returns the
+// Sec-WebSocket-Key through `key`.
+WebSocketUpgrade PARSER_EXPORT
+validate_websocket_upgrade(const Request &request, std::string_view &key);
+// base64(SHA-1(key + GUID)), writes WEBSOCKET_ACCEPT_LENGTH bytes
+void PARSER_EXPORT websocket_accept(std::string_view key, char *out);
+// Fills `response` with the 101 answer to a valid upgrade request.
+void PARSER_EXPORT websocket_accept_response(std::string_view key,
+                                             Response &response);
+
+enum class PARSER_EXPORT WebSocketOpcode : std::uint8_t {
+  CONTINUATION = 0x0,
+  TEXT = 0x1,
+  BINARY = 0x2,
+  CLOSE = 0x8,
+  PING = 0x9,
+  PONG = 0xA,
+};
+
+struct PARSER_EXPORT WebSocketFrameHeader {
+  bool fin = false;
+  bool rsv1 = false; // for extensions such as permessage-deflate
+  WebSocketOpcode opcode = WebSocketOpcode::CONTINUATION;
+  bool masked = false;
+  std::uint8_t mask[4] = {0, 0, 0, 0};
+  std::uint64_t length = 0;
+};
+
+// XORs `data` with the masking key, `offset` is the position of data[0]
+// in the payload. Masking and unmasking are the same operation.
+void PARSER_EXPORT websocket_unmask(char *data, std::size_t length,
+                                    const std::uint8_t mask[4],
+                                    std::uint64_t offset = 0);
+// Writes a frame header to `out` (WEBSOCKET_MAX_FRAME_HEADER bytes) and
+// returns its size; `mask` is null for unmasked frames.
+std::size_t PARSER_EXPORT websocket_frame_header(
+    WebSocketOpcode opcode, bool fin, std::uint64_t length,
+    const std::uint8_t *mask, char *out);
+
+enum class PARSER_EXPORT WebSocketEvent {
+  NONE,
+  FRAME_BEGIN, // a frame header was parsed, see frame()
+  PAYLOAD,     // a piece of the current frame's payload, unmasked
+};
+
+enum class WebSocketParseState {
+  HEADER,
+  PAYLOAD,
+  PARSE_ERROR,
+};
+
+class WebSocketFrameParser {
+public:
+  static constexpr std::uint64_t DEFAULT_MAX_FRAME_SIZE = 16 * 1024 * 1024;
+
+  // A server requires masked frames from clients, a client requires
+  // unmasked frames from servers.
+  PARSER_EXPORT explicit WebSocketFrameParser(bool server = true);
+
+  PARSER_EXPORT void reset();
+  void set_max_frame_size(std::uint64_t bytes) { maxFrameSize = bytes; }
+  // RSV1 is only allowed once an extension such as permessage-deflate
+  // was negotiated
+  void set_allow_rsv1(bool allowed) { allowRsv1 = allowed; }
+  // Consumes frame bytes up to the next event and returns how many were
+  // used. Payload is unmasked in place and returned through `payload` as a
+  // view into `data`. Call again with the rest of the data until
+  // everything is consumed.
+  PARSER_EXPORT std::size_t execute(char *data, std::size_t length,
+                                    WebSocketEvent &event,
+                                    std::string_view &payload);
+
+  WebSocketParseState get_state() const { return currentParseState; }
+  bool failed() const {
+    return currentParseState == WebSocketParseState::PARSE_ERROR;
+  }
+  const std::string &getErrorMessage() const { return errorMessage; }
+  // close status code to send when the parser failed
+  std::uint16_t close_code() const { return closeCode; }
+  const WebSocketFrameHeader &frame() const { return currentFrame; }
+  // the current frame's payload has been handed out completely
+  bool frame_complete() const {
+    return currentParseState == WebSocketParseState::HEADER;
+  }
+  // TEXT or BINARY for the data frames of a (fragmented) message
+  WebSocketOpcode message_opcode() const { return messageOpcode; }
+  // the current frame is the last of its message, or a control frame
+  bool message_complete() const { return currentFrame.fin; }
+
+private:
+  bool server;
+  bool allowRsv1;
+  WebSocketParseState currentParseState;
+  WebSocketFrameHeader currentFrame;
+  WebSocketOpcode messageOpcode;
+  bool inMessage;
+  std::uint64_t maxFrameSize;
+  std::uint64_t payloadOffset;
+  unsigned char header[WEBSOCKET_MAX_FRAME_HEADER];
+  std::size_t headerBytes;
+  std::string errorMessage;
+  std::uint16_t closeCode;
+
+  std::size_t headerSize() const;
+  bool finishHeader();
+  void fail(const char *message, std::uint16_t code);
+};
+
+}; // namespace http_parser
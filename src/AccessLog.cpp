@@ -0,0 +1,391 @@
+#include "AccessLog.hpp"
+#include "IoVec.h"
+#include "Text.h"
+#include <climits>
+#include <cstring>
+#include <ctime>
+
+using http_parser::AccessLog;
+using http_parser::AccessLogEntry;
+using http_parser::AccessLogStats;
+using http_parser::HeaderId;
+using http_parser::LogFormat;
+using http_parser::OverflowPolicy;
+using http_parser::Request;
+using http_parser::Response;
+using http_parser::detail::appendNumber;
+
+struct AccessLog::Ring {
+  explicit Ring(std::size_t capacity)
+      : buffer(new char[capacity]), mask(capacity - 1) {}
+
+  std::size_t capacity() const { return mask + 1; }
+
+  std::unique_ptr<char[]> buffer;
+  std::size_t mask;
+  // positions grow forever and are masked on access; head is only written
+  // by the owning thread, tail only by the writer thread
+  alignas(64) std::atomic<std::uint64_t> head{0};
+  alignas(64) std::atomic<std::uint64_t> tail{0};
+};
+
+namespace {
+
+std::atomic<std::uint64_t> nextLogId{1};
+
+#ifdef IOV_MAX
+constexpr std::size_t maxIovecs = IOV_MAX < 1024 ? IOV_MAX : 1024;
+#else
+constexpr std::size_t maxIovecs = 1024;
+#endif
+
+std::size_t roundUpToPowerOfTwo(std::size_t n) {
+  std::size_t result = 4096;
+  while (result < n) {
+    result <<= 1;
+  }
+  return result;
+}
+
+struct LogDates {
+  std::int64_t second = -1;
+  char common[32];  // 10/Oct/2000:13:55:36 +0000
+  char iso8601[32]; // 2000-10-10T13:55:36Z
+};
+
+// formatted once per second and thread, like the date header cache
+const LogDates &logDates(std::int64_t now) {
+  thread_local LogDates dates;
+  if (dates.second != now) {
+    std::time_t time = static_cast<std::time_t>(now);
+    std::tm parts;
+#ifdef _WIN32
+    gmtime_s(&parts, &time);
+#else
+    gmtime_r(&time, &parts);
+#endif
+    std::strftime(dates.common, sizeof(dates.common),
+                  "%d/%b/%Y:%H:%M:%S +0000", &parts);
+    std::strftime(dates.iso8601, sizeof(dates.iso8601),
+                  "%Y-%m-%dT%H:%M:%SZ", &parts);
+    dates.second = now;
+  }
+  return dates;
+}
+
+void appendHexEscape(std::string &out, const char *prefix, unsigned char c) {
+  static constexpr char hex[] = "0123456789abcdef";
+  out += prefix;
+  out += hex[c >> 4];
+  out += hex[c & 0xf];
+}
+
+// quoted field of the common log format, escaped like Apache httpd does
+void appendQuoted(std::string &out, std::string_view text) {
+  out += '"';
+  for (char c : text) {
+    unsigned char u = static_cast<unsigned char>(c);
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (u < 0x20 || u >= 0x7f) {
+      appendHexEscape(out, "\\x", u);
+    } else {
+      out += c;
+    }
+  }
+  out += '"';
+}
+
+void appendJsonString(std::string &out, std::string_view text) {
+  out += '"';
+  for (char c : text) {
+    unsigned char u = static_cast<unsigned char>(c);
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (u < 0x20 || u >= 0x7f) {
+      // bytes are not known to be UTF-8, keep the output valid JSON
+      appendHexEscape(out, "\\u00", u);
+    } else {
+      out += c;
+    }
+  }
+  out += '"';
+}
+
+void appendOrDash(std::string &out, std::string_view text) {
+  if (text.empty()) {
+    out += '-';
+  } else {
+    out.append(text.data(), text.size());
+  }
+}
+
+} // namespace
+
+AccessLog::AccessLog(int file_descriptor, AccessLogOptions options)
+    : fd{file_descriptor}, options(std::move(options)),
+      id{nextLogId.fetch_add(1)}, flushRequests{0}, flushesDone{0},
+      stopping{false} {
+  this->options.ringBytes = roundUpToPowerOfTwo(this->options.ringBytes);
+  writer = std::thread(&AccessLog::run, this);
+}
+
+AccessLog::~AccessLog() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wakeWriter.notify_one();
+  writer.join();
+}
+
+AccessLog::Ring &AccessLog::threadRing() {
+  // rings of this thread, one per log it has written to
+  thread_local std::vector<std::pair<std::uint64_t, std::shared_ptr<Ring>>>
+      threadRings;
+  for (auto &entry : threadRings) {
+    if (entry.first == id) {
+      return *entry.second;
+    }
+  }
+  std::shared_ptr<Ring> ring = std::make_shared<Ring>(options.ringBytes);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    rings.push_back(ring);
+  }
+  threadRings.emplace_back(id, ring);
+  return *ring;
+}
+
+void AccessLog::format(std::string &out, const Request &request,
+                       const Response &response,
+                       const AccessLogEntry &entry) const {
+  std::int64_t now = entry.time != 0
+                         ? entry.time
+                         : static_cast<std::int64_t>(std::time(nullptr));
+  const LogDates &dates = logDates(now);
+  std::string method = http_parser::method_to_string(request.method);
+  std::string version = http_parser::version_to_string(request.version);
+  unsigned long long status =
+      static_cast<unsigned long long>(response.status_code);
+
+  if (options.format == LogFormat::JSON) {
+    out += "{\"time\":\"";
+    out += dates.iso8601;
+    out += "\",\"remote\":";
+    appendJsonString(out, entry.remoteAddress);
+    if (!entry.user.empty()) {
+      out += ",\"user\":";
+      appendJsonString(out, entry.user);
+    }
+    out += ",\"method\":";
+    appendJsonString(out, method);
+    out += ",\"url\":";
+    appendJsonString(out, request.url);
+    out += ",\"version\":";
+    appendJsonString(out, version);
+    out += ",\"status\":";
+    appendNumber(out, status);
+    out += ",\"bytes\":";
+    appendNumber(out, entry.bytesSent);
+    out += ",\"duration_us\":";
+    appendNumber(out, static_cast<unsigned long long>(entry.duration.count()));
+    out += ",\"referer\":";
+    appendJsonString(out, request.headers.value_of(HeaderId::REFERER));
+    out += ",\"user_agent\":";
+    appendJsonString(out, request.headers.value_of(HeaderId::USER_AGENT));
+    if (!options.extraHeaders.empty()) {
+      out += ",\"headers\":{";
+      for (std::size_t i = 0; i < options.extraHeaders.size(); i++) {
+        if (i > 0) {
+          out += ',';
+        }
+        appendJsonString(out, options.extraHeaders[i]);
+        out += ':';
+        appendJsonString(out,
+                         request.headers.value_of(options.extraHeaders[i]));
+      }
+      out += '}';
+    }
+    out += "}\n";
+    return;
+  }
+
+  appendOrDash(out, entry.remoteAddress);
+  out += " - ";
+  appendOrDash(out, entry.user);
+  out += " [";
+  out += dates.common;
+  out += "] ";
+  appendQuoted(out, method + ' ' + request.url + ' ' + version);
+  out += ' ';
+  appendNumber(out, status);
+  out += ' ';
+  if (entry.bytesSent == 0) {
+    out += '-';
+  } else {
+    appendNumber(out, entry.bytesSent);
+  }
+  if (options.format == LogFormat::COMBINED) {
+    out += ' ';
+    appendQuoted(out, request.headers.value_of(HeaderId::REFERER, "-"));
+    out += ' ';
+    appendQuoted(out, request.headers.value_of(HeaderId::USER_AGENT, "-"));
+    for (const std::string &name : options.extraHeaders) {
+      out += ' ';
+      appendQuoted(out, request.headers.value_of(name, "-"));
+    }
+    // request time in microseconds, like %D of Apache httpd
+    out += ' ';
+    appendNumber(out, static_cast<unsigned long long>(entry.duration.count()));
+  }
+  out += '\n';
+}
+
+void AccessLog::log(const Request &request, const Response &response,
+                    const AccessLogEntry &entry) {
+  thread_local std::string record;
+  record.clear();
+  format(record, request, response, entry);
+  Ring &ring = threadRing();
+  if (record.size() > MAX_RECORD_SIZE || record.size() > ring.capacity()) {
+    droppedCount.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  std::uint64_t head = ring.head.load(std::memory_order_relaxed);
+  while (true) {
+    std::uint64_t used = head - ring.tail.load(std::memory_order_acquire);
+    if (ring.capacity() - used >= record.size()) {
+      std::size_t offset = static_cast<std::size_t>(head) & ring.mask;
+      std::size_t first = ring.capacity() - offset;
+      if (first > record.size()) {
+        first = record.size();
+      }
+      std::memcpy(ring.buffer.get() + offset, record.data(), first);
+      std::memcpy(ring.buffer.get(), record.data() + first,
+                  record.size() - first);
+      ring.head.store(head + record.size(), std::memory_order_release);
+      recordCount.fetch_add(1, std::memory_order_relaxed);
+      // wake the writer early once the ring crosses half full
+      std::size_t half = ring.capacity() / 2;
+      if (used < half && used + record.size() >= half) {
+        wakeWriter.notify_one();
+      }
+      return;
+    }
+    wakeWriter.notify_one();
+    if (options.overflow == OverflowPolicy::DROP) {
+      droppedCount.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    std::this_thread::yield();
+  }
+}
+
+void AccessLog::flush() {
+  std::unique_lock<std::mutex> lock(mutex);
+  std::uint64_t target = ++flushRequests;
+  wakeWriter.notify_one();
+  flushed.wait(lock, [&] { return flushesDone >= target; });
+}
+
+AccessLogStats AccessLog::stats() const {
+  AccessLogStats result;
+  result.records = recordCount.load(std::memory_order_relaxed);
+  result.dropped = droppedCount.load(std::memory_order_relaxed);
+  result.bytesWritten = bytesWritten.load(std::memory_order_relaxed);
+  result.writeErrors = writeErrors.load(std::memory_order_relaxed);
+  return result;
+}
+
+// Writes the pending bytes of every ring, batched into as few writev calls
+// as the iovec limit allows. Returns false if nothing was pending.
+bool AccessLog::drain() {
+  thread_local std::vector<std::shared_ptr<Ring>> snapshot;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    snapshot.assign(rings.begin(), rings.end());
+  }
+  iovec iov[maxIovecs];
+  std::uint64_t heads[maxIovecs];
+  Ring *batch[maxIovecs];
+  bool wroteAny = false;
+  std::size_t next = 0;
+  while (next < snapshot.size()) {
+    std::size_t iovCount = 0;
+    std::size_t ringCount = 0;
+    std::size_t pending = 0;
+    for (; next < snapshot.size() && iovCount + 2 <= maxIovecs; next++) {
+      Ring &ring = *snapshot[next];
+      std::uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+      std::uint64_t head = ring.head.load(std::memory_order_acquire);
+      if (head == tail) {
+        continue;
+      }
+      std::size_t offset = static_cast<std::size_t>(tail) & ring.mask;
+      std::size_t length = static_cast<std::size_t>(head - tail);
+      std::size_t first = ring.capacity() - offset;
+      if (first > length) {
+        first = length;
+      }
+      iov[iovCount++] = iovec{ring.buffer.get() + offset, first};
+      if (length > first) {
+        iov[iovCount++] = iovec{ring.buffer.get(), length - first};
+      }
+      heads[ringCount] = head;
+      batch[ringCount++] = &ring;
+      pending += length;
+    }
+    if (ringCount == 0) {
+      continue;
+    }
+    std::size_t index = 0;
+    std::size_t remaining = pending;
+    if (!http_parser::iovec_write(fd, iov, iovCount, index, remaining)) {
+      // the records are lost rather than blocking the producers forever
+      writeErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+    bytesWritten.fetch_add(pending - remaining, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < ringCount; i++) {
+      batch[i]->tail.store(heads[i], std::memory_order_release);
+    }
+    wroteAny = true;
+  }
+  snapshot.clear();
+  // rings of exited threads are released once they are empty
+  std::lock_guard<std::mutex> lock(mutex);
+  for (std::size_t i = 0; i < rings.size();) {
+    Ring &ring = *rings[i];
+    if (rings[i].use_count() == 1 &&
+        ring.head.load(std::memory_order_acquire) ==
+            ring.tail.load(std::memory_order_relaxed)) {
+      rings[i] = std::move(rings.back());
+      rings.pop_back();
+    } else {
+      i++;
+    }
+  }
+  return wroteAny;
+}
+
+void AccessLog::run() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    if (!stopping && flushRequests == flushesDone) {
+      wakeWriter.wait_for(lock, options.flushInterval);
+    }
+    std::uint64_t target = flushRequests;
+    bool stop = stopping;
+    lock.unlock();
+    drain();
+    lock.lock();
+    flushesDone = target;
+    flushed.notify_all();
+    if (stop) {
+      return;
+    }
+  }
+}
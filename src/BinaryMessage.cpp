@@ -0,0 +1,318 @@
+#include "BinaryMessage.hpp"
+#include <cstring>
+
+using http_parser::BinaryMessageKind;
+using http_parser::BinaryMessageView;
+using http_parser::HeaderId;
+using http_parser::HeaderView;
+using http_parser::Headers;
+using http_parser::Request;
+using http_parser::Response;
+
+namespace {
+
+// field offsets of the fixed header
+constexpr std::size_t magicField = 0;
+constexpr std::size_t versionField = 4;
+constexpr std::size_t kindField = 6;
+constexpr std::size_t methodField = 7;
+constexpr std::size_t httpVersionField = 8;
+constexpr std::size_t statusField = 10;
+constexpr std::size_t totalSizeField = 12;
+constexpr std::size_t headerCountField = 16;
+constexpr std::size_t headerTableField = 20;
+constexpr std::size_t textOffsetField = 24;
+constexpr std::size_t textLengthField = 28;
+constexpr std::size_t bodyOffsetField = 32;
+constexpr std::size_t bodyLengthField = 36;
+
+inline std::uint16_t load16(const unsigned char *p) {
+  return static_cast<std::uint16_t>(p[0] | p[1] << 8);
+}
+
+inline std::uint32_t load32(const unsigned char *p) {
+  return static_cast<std::uint32_t>(p[0]) |
+         static_cast<std::uint32_t>(p[1]) << 8 |
+         static_cast<std::uint32_t>(p[2]) << 16 |
+         static_cast<std::uint32_t>(p[3]) << 24;
+}
+
+inline void store16(unsigned char *p, std::uint16_t value) {
+  p[0] = static_cast<unsigned char>(value);
+  p[1] = static_cast<unsigned char>(value >> 8);
+}
+
+inline void store32(unsigned char *p, std::uint32_t value) {
+  p[0] = static_cast<unsigned char>(value);
+  p[1] = static_cast<unsigned char>(value >> 8);
+  p[2] = static_cast<unsigned char>(value >> 16);
+  p[3] = static_cast<unsigned char>(value >> 24);
+}
+
+// known names are implied by the id and not stored
+inline bool storesKey(HeaderId id) { return id == HeaderId::UNKOWN; }
+
+std::size_t encodedSize(const Headers &headers, std::string_view text,
+                        std::string_view body) {
+  std::uint64_t size = http_parser::BINARY_MESSAGE_HEADER_SIZE +
+                       headers.size() * http_parser::BINARY_MESSAGE_ENTRY_SIZE +
+                       text.size() + body.size();
+  for (HeaderView header : headers) {
+    size += header.value.size();
+    if (storesKey(header.id)) {
+      size += header.key.size();
+    }
+  }
+  return size > UINT32_MAX ? 0 : static_cast<std::size_t>(size);
+}
+
+std::size_t encode(BinaryMessageKind kind, std::uint8_t method,
+                   std::uint8_t version, std::uint16_t status,
+                   const Headers &headers, std::string_view text,
+                   std::string_view body, char *buffer, std::size_t capacity) {
+  std::size_t size = encodedSize(headers, text, body);
+  if (size == 0 || size > capacity) {
+    return 0;
+  }
+  unsigned char *out = reinterpret_cast<unsigned char *>(buffer);
+  std::memset(out, 0, http_parser::BINARY_MESSAGE_HEADER_SIZE);
+  store32(out + magicField, http_parser::BINARY_MESSAGE_MAGIC);
+  store16(out + versionField, http_parser::BINARY_MESSAGE_VERSION);
+  out[kindField] = static_cast<unsigned char>(kind);
+  out[methodField] = method;
+  out[httpVersionField] = version;
+  store16(out + statusField, status);
+  store32(out + totalSizeField, static_cast<std::uint32_t>(size));
+  store32(out + headerCountField, static_cast<std::uint32_t>(headers.size()));
+  store32(out + headerTableField, http_parser::BINARY_MESSAGE_HEADER_SIZE);
+
+  std::uint32_t cursor = static_cast<std::uint32_t>(
+      http_parser::BINARY_MESSAGE_HEADER_SIZE +
+      headers.size() * http_parser::BINARY_MESSAGE_ENTRY_SIZE);
+  auto put = [&](std::string_view bytes) {
+    std::uint32_t offset = cursor;
+    std::memcpy(out + cursor, bytes.data(), bytes.size());
+    cursor += static_cast<std::uint32_t>(bytes.size());
+    return offset;
+  };
+  store32(out + textOffsetField, put(text));
+  store32(out + textLengthField, static_cast<std::uint32_t>(text.size()));
+
+  unsigned char *entry = out + http_parser::BINARY_MESSAGE_HEADER_SIZE;
+  for (HeaderView header : headers) {
+    std::uint16_t keyLength = 0;
+    std::uint32_t keyOffset = 0;
+    if (storesKey(header.id)) {
+      keyLength = static_cast<std::uint16_t>(header.key.size());
+      keyOffset = put(header.key);
+    }
+    store32(entry, keyOffset);
+    store32(entry + 4, put(header.value));
+    store32(entry + 8, static_cast<std::uint32_t>(header.value.size()));
+    store16(entry + 12, keyLength);
+    entry[14] = static_cast<unsigned char>(header.id);
+    entry[15] = 0;
+    entry += http_parser::BINARY_MESSAGE_ENTRY_SIZE;
+  }
+  store32(out + bodyOffsetField, put(body));
+  store32(out + bodyLengthField, static_cast<std::uint32_t>(body.size()));
+  return size;
+}
+
+inline bool inBounds(std::uint64_t offset, std::uint64_t length,
+                     std::uint64_t size) {
+  return offset <= size && length <= size - offset;
+}
+
+} // namespace
+
+std::size_t http_parser::binary_encoded_size(const Request &request,
+                                             std::string_view body) {
+  return encodedSize(request.headers, request.url, body);
+}
+
+std::size_t http_parser::binary_encoded_size(const Response &response,
+                                             std::string_view body) {
+  return encodedSize(response.headers, response.status_message, body);
+}
+
+std::size_t http_parser::binary_encode(const Request &request,
+                                       std::string_view body, char *out,
+                                       std::size_t capacity) {
+  return encode(BinaryMessageKind::REQUEST,
+                static_cast<std::uint8_t>(request.method),
+                static_cast<std::uint8_t>(request.version), 0,
+                request.headers, request.url, body, out, capacity);
+}
+
+std::size_t http_parser::binary_encode(const Response &response,
+                                       std::string_view body, char *out,
+                                       std::size_t capacity) {
+  return encode(BinaryMessageKind::RESPONSE, 0,
+                static_cast<std::uint8_t>(response.version),
+                static_cast<std::uint16_t>(response.status_code),
+                response.headers, response.status_message, body, out,
+                capacity);
+}
+
+bool http_parser::binary_encode(const Request &request, std::string_view body,
+                                std::string &out) {
+  std::size_t size = binary_encoded_size(request, body);
+  std::size_t start = out.size();
+  out.resize(start + size);
+  if (size == 0 ||
+      binary_encode(request, body, out.data() + start, size) != size) {
+    out.resize(start);
+    return false;
+  }
+  return true;
+}
+
+bool http_parser::binary_encode(const Response &response,
+                                std::string_view body, std::string &out) {
+  std::size_t size = binary_encoded_size(response, body);
+  std::size_t start = out.size();
+  out.resize(start + size);
+  if (size == 0 ||
+      binary_encode(response, body, out.data() + start, size) != size) {
+    out.resize(start);
+    return false;
+  }
+  return true;
+}
+
+bool BinaryMessageView::attach(const void *data, std::size_t size) {
+  base = nullptr;
+  const unsigned char *in = static_cast<const unsigned char *>(data);
+  if (in == nullptr || size < BINARY_MESSAGE_HEADER_SIZE ||
+      load32(in + magicField) != BINARY_MESSAGE_MAGIC ||
+      load16(in + versionField) != BINARY_MESSAGE_VERSION) {
+    return false;
+  }
+  std::uint32_t total = load32(in + totalSizeField);
+  unsigned char kind = in[kindField];
+  if (total > size || total < BINARY_MESSAGE_HEADER_SIZE ||
+      (kind != static_cast<unsigned char>(BinaryMessageKind::REQUEST) &&
+       kind != static_cast<unsigned char>(BinaryMessageKind::RESPONSE)) ||
+      in[methodField] > static_cast<unsigned char>(Method::METHOD_UNKOWN) ||
+      in[httpVersionField] >
+          static_cast<unsigned char>(Version::HTTP_2)) {
+    return false;
+  }
+  std::uint64_t count = load32(in + headerCountField);
+  std::uint32_t table = load32(in + headerTableField);
+  if (!inBounds(table, count * BINARY_MESSAGE_ENTRY_SIZE, total) ||
+      !inBounds(load32(in + textOffsetField), load32(in + textLengthField),
+                total) ||
+      !inBounds(load32(in + bodyOffsetField), load32(in + bodyLengthField),
+                total)) {
+    return false;
+  }
+  // every entry is checked once so the accessors can trust the table
+  const unsigned char *entry = in + table;
+  for (std::uint64_t i = 0; i < count; i++) {
+    if (!inBounds(load32(entry), load16(entry + 12), total) ||
+        !inBounds(load32(entry + 4), load32(entry + 8), total) ||
+        entry[14] >= static_cast<unsigned char>(HeaderId::HEADER_ID_COUNT)) {
+      return false;
+    }
+    entry += BINARY_MESSAGE_ENTRY_SIZE;
+  }
+  base = in;
+  return true;
+}
+
+std::size_t BinaryMessageView::size() const {
+  return load32(base + totalSizeField);
+}
+
+BinaryMessageKind BinaryMessageView::kind() const {
+  return static_cast<BinaryMessageKind>(base[kindField]);
+}
+
+http_parser::Method BinaryMessageView::method() const {
+  return static_cast<Method>(base[methodField]);
+}
+
+http_parser::Version BinaryMessageView::version() const {
+  return static_cast<Version>(base[httpVersionField]);
+}
+
+http_parser::StatusCode BinaryMessageView::status_code() const {
+  return static_cast<StatusCode>(load16(base + statusField));
+}
+
+std::string_view BinaryMessageView::text() const {
+  return slice(load32(base + textOffsetField),
+               load32(base + textLengthField));
+}
+
+std::string_view BinaryMessageView::body() const {
+  return slice(load32(base + bodyOffsetField),
+               load32(base + bodyLengthField));
+}
+
+std::size_t BinaryMessageView::header_count() const {
+  return load32(base + headerCountField);
+}
+
+HeaderView BinaryMessageView::header(std::size_t i) const {
+  const unsigned char *entry = base + load32(base + headerTableField) +
+                               i * BINARY_MESSAGE_ENTRY_SIZE;
+  HeaderId id = static_cast<HeaderId>(entry[14]);
+  std::string_view key = storesKey(id)
+                             ? slice(load32(entry), load16(entry + 12))
+                             : header_id_to_string(id);
+  return HeaderView{key, slice(load32(entry + 4), load32(entry + 8)), id};
+}
+
+std::size_t BinaryMessageView::find(HeaderId id, std::size_t from) const {
+  std::size_t count = header_count();
+  const unsigned char *ids = base + load32(base + headerTableField) + 14;
+  for (std::size_t i = from; i < count; i++) {
+    if (ids[i * BINARY_MESSAGE_ENTRY_SIZE] == static_cast<unsigned char>(id)) {
+      return i;
+    }
+  }
+  return count;
+}
+
+std::string_view BinaryMessageView::value_of(HeaderId id,
+                                              std::string_view fallback) const {
+  std::size_t i = find(id);
+  return i == header_count() ? fallback : header(i).value;
+}
+
+Request BinaryMessageView::to_request() const {
+  Request request;
+  request.method = method();
+  request.version = version();
+  request.url = std::string(url());
+  for (std::size_t i = 0; i < header_count(); i++) {
+    HeaderView view = header(i);
+    request.headers.add(view.id, view.key, view.value);
+  }
+  request.keep_alive = http_parser::is_persistent(
+      request.version, http_parser::connection_options(request.headers));
+  if (request.version == http_parser::Version::HTTP_1_1) {
+    for (std::size_t i = find(HeaderId::EXPECT); i < header_count();
+         i = find(HeaderId::EXPECT, i + 1)) {
+      http_parser::add_expectations(header(i).value, request.expectation);
+    }
+  }
+  return request;
+}
+
+Response BinaryMessageView::to_response() const {
+  Response response;
+  response.version = version();
+  response.status_code = status_code();
+  response.status_message = std::string(status_message());
+  for (std::size_t i = 0; i < header_count(); i++) {
+    HeaderView view = header(i);
+    response.headers.add(view.id, view.key, view.value);
+  }
+  response.keep_alive = http_parser::is_persistent(
+      response.version, http_parser::connection_options(response.headers));
+  return response;
+}
@@ -0,0 +1,210 @@
+#include "BodyForwarder.hpp"
+#include "OS.h"
+#include <cerrno>
+
+#ifdef __linux__
+#include <fcntl.h>
+#endif
+
+using http_parser::BodyForwarder;
+using http_parser::BodyFraming;
+using http_parser::BodyParseState;
+using http_parser::ForwardResult;
+
+namespace {
+
+// buffer size when the body has to be copied through user space
+constexpr std::size_t copyBufferSize = 64 * 1024;
+// pipe size asked for, the kernel may grant less
+constexpr int wantedPipeSize = 1 << 20;
+
+enum class IoStatus { OK, AGAIN, FAILED };
+
+IoStatus ioStatus(long result) {
+  if (result >= 0) {
+    return IoStatus::OK;
+  }
+  if (errno == EAGAIN || errno == EWOULDBLOCK) {
+    return IoStatus::AGAIN;
+  }
+  return IoStatus::FAILED;
+}
+
+ForwardResult toResult(IoStatus status) {
+  return status == IoStatus::AGAIN ? ForwardResult::WOULD_BLOCK
+                                   : ForwardResult::ERROR;
+}
+
+} // namespace
+
+BodyForwarder::BodyForwarder()
+    : pipeFds{-1, -1}, pipeCapacity{0}, pipeBytes{0}, input{nullptr},
+      inputLength{0}, inputOffset{0}, pendingWrite{nullptr},
+      pendingLength{0}, forwarded{0}, spliced{0} {
+  openPipe();
+}
+
+BodyForwarder::~BodyForwarder() { closePipe(); }
+
+void BodyForwarder::openPipe() {
+#ifdef __linux__
+  if (::pipe2(pipeFds, O_CLOEXEC) == 0) {
+    ::fcntl(pipeFds[1], F_SETPIPE_SZ, wantedPipeSize);
+    int size = ::fcntl(pipeFds[1], F_GETPIPE_SZ);
+    pipeCapacity = size > 0 ? static_cast<std::size_t>(size) : 65536;
+  } else {
+    pipeFds[0] = -1;
+    pipeFds[1] = -1;
+  }
+#endif
+  framingBuffer.resize(canSplice() ? FRAMING_BUFFER_SIZE : copyBufferSize);
+}
+
+void BodyForwarder::closePipe() {
+  if (pipeFds[0] >= 0) {
+    ::close(pipeFds[0]);
+    ::close(pipeFds[1]);
+  }
+  pipeFds[0] = -1;
+  pipeFds[1] = -1;
+  pipeBytes = 0;
+}
+
+bool BodyForwarder::start(BodyFraming framing, std::uint64_t contentLength,
+                          std::string_view buffered) {
+  if (framing == BodyFraming::INVALID) {
+    return false;
+  }
+  if (pipeBytes > 0) {
+    // a previous body was abandoned with data in the pipe, the pipe can't
+    // be emptied without a destination so it is replaced
+    closePipe();
+    openPipe();
+  }
+  parser.reset(framing, contentLength);
+  input = buffered.data();
+  inputLength = buffered.size();
+  inputOffset = 0;
+  pendingWrite = nullptr;
+  pendingLength = 0;
+  forwarded = 0;
+  spliced = 0;
+  return true;
+}
+
+ForwardResult BodyForwarder::forward(int source, int destination) {
+  while (true) {
+    // bytes handed to the parser go out before anything else
+    if (pendingLength > 0) {
+#ifdef _WIN32
+      long written = ::send(destination, pendingWrite,
+                            static_cast<int>(pendingLength), 0);
+#else
+      long written = ::write(destination, pendingWrite, pendingLength);
+#endif
+      if (written < 0 && errno == EINTR) {
+        continue;
+      }
+      IoStatus status = ioStatus(written);
+      if (status != IoStatus::OK) {
+        return toResult(status);
+      }
+      pendingWrite += written;
+      pendingLength -= static_cast<std::size_t>(written);
+      continue;
+    }
+#ifdef __linux__
+    if (pipeBytes > 0) {
+      long moved = ::splice(pipeFds[0], nullptr, destination, nullptr,
+                            pipeBytes, SPLICE_F_MOVE | SPLICE_F_MORE);
+      if (moved < 0 && errno == EINTR) {
+        continue;
+      }
+      IoStatus status = ioStatus(moved);
+      if (status != IoStatus::OK) {
+        return toResult(status);
+      }
+      pipeBytes -= static_cast<std::size_t>(moved);
+      continue;
+    }
+#endif
+    if (parser.done()) {
+      return ForwardResult::DONE;
+    }
+    if (parser.failed()) {
+      return ForwardResult::ERROR;
+    }
+
+    if (inputOffset < inputLength) {
+      std::string_view payload;
+      std::size_t consumed = parser.execute(
+          input + inputOffset, inputLength - inputOffset, payload);
+      pendingWrite = input + inputOffset;
+      pendingLength = consumed;
+      inputOffset += consumed;
+      forwarded += consumed;
+      continue;
+    }
+
+    BodyParseState state = parser.get_state();
+#ifdef __linux__
+    bool inPayload = ((state == BodyParseState::CONTENT ||
+                       state == BodyParseState::CHUNK_DATA) &&
+                      parser.remaining() > 0) ||
+                     state == BodyParseState::UNTIL_CLOSE;
+    if (canSplice() && inPayload) {
+      std::size_t want = pipeCapacity;
+      if (state != BodyParseState::UNTIL_CLOSE &&
+          parser.remaining() < want) {
+        want = static_cast<std::size_t>(parser.remaining());
+      }
+      long moved = ::splice(source, nullptr, pipeFds[1], nullptr, want,
+                            SPLICE_F_MOVE | SPLICE_F_MORE);
+      if (moved < 0 && errno == EINTR) {
+        continue;
+      }
+      IoStatus status = ioStatus(moved);
+      if (status != IoStatus::OK) {
+        return toResult(status);
+      }
+      if (moved == 0) {
+        parser.finish();
+        if (parser.done()) {
+          continue;
+        }
+        return ForwardResult::PEER_CLOSED;
+      }
+      pipeBytes += static_cast<std::size_t>(moved);
+      parser.skip(static_cast<std::uint64_t>(moved));
+      forwarded += static_cast<std::uint64_t>(moved);
+      spliced += static_cast<std::uint64_t>(moved);
+      continue;
+    }
+#endif
+
+    // chunk lines, trailers, or no splice available: read into the buffer
+#ifdef _WIN32
+    long bytesRead = ::recv(source, framingBuffer.data(),
+                            static_cast<int>(framingBuffer.size()), 0);
+#else
+    long bytesRead = ::read(source, framingBuffer.data(), framingBuffer.size());
+#endif
+    if (bytesRead < 0 && errno == EINTR) {
+      continue;
+    }
+    IoStatus status = ioStatus(bytesRead);
+    if (status != IoStatus::OK) {
+      return toResult(status);
+    }
+    if (bytesRead == 0) {
+      parser.finish();
+      if (parser.done()) {
+        continue;
+      }
+      return ForwardResult::PEER_CLOSED;
+    }
+    input = framingBuffer.data();
+    inputLength = static_cast<std::size_t>(bytesRead);
+    inputOffset = 0;
+  }
+}
@@ -0,0 +1,295 @@
+#include "BodyParser.hpp"
+#include "Text.h"
+
+using http_parser::BodyFraming;
+using http_parser::BodyParser;
+using http_parser::BodyParseState;
+using http_parser::HeaderId;
+using http_parser::Headers;
+using http_parser::Method;
+using http_parser::Request;
+using http_parser::Response;
+using http_parser::detail::trim;
+
+namespace {
+
+// chunk sizes above this are treated as malformed instead of overflowing
+constexpr int maxChunkSizeDigits = 15;
+
+// true if the last transfer coding applied is chunked; `present` tells if
+// there was any transfer-encoding header at all
+bool chunkedIsLast(const Headers &headers, bool &present) {
+  std::string_view last;
+  present = false;
+  for (auto it = headers.find(HeaderId::TRANSFER_ENCODING);
+       it != headers.end();
+       it = headers.find(HeaderId::TRANSFER_ENCODING, it.position() + 1)) {
+    std::string_view value = (*it).value;
+    std::size_t comma = value.rfind(',');
+    std::string_view coding =
+        trim(comma == std::string_view::npos ? value : value.substr(comma + 1));
+    if (!coding.empty()) {
+      last = coding;
+    }
+    present = true;
+  }
+  return http_parser::header_name_equals(last, "chunked");
+}
+
+// Parses every content-length header; repeated values must agree.
+// Returns false if a value is malformed or the values differ.
+bool contentLength(const Headers &headers, bool &present,
+                   std::uint64_t &length) {
+  present = false;
+  for (auto it = headers.find(HeaderId::CONTENT_LENGTH); it != headers.end();
+       it = headers.find(HeaderId::CONTENT_LENGTH, it.position() + 1)) {
+    std::string_view value = (*it).value;
+    while (!value.empty()) {
+      std::size_t comma = value.find(',');
+      std::string_view item = trim(value.substr(0, comma));
+      value = comma == std::string_view::npos ? std::string_view()
+                                              : value.substr(comma + 1);
+      if (item.empty() || item.size() > 19) {
+        return false;
+      }
+      std::uint64_t parsed = 0;
+      for (char c : item) {
+        if (c < '0' || c > '9') {
+          return false;
+        }
+        parsed = parsed * 10 + static_cast<std::uint64_t>(c - '0');
+      }
+      if (present && parsed != length) {
+        return false;
+      }
+      present = true;
+      length = parsed;
+    }
+  }
+  return true;
+}
+
+int hexDigit(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+} // namespace
+
+BodyFraming http_parser::request_body_framing(const Request &request,
+                                              std::uint64_t &length) {
+  length = 0;
+  bool hasTransferEncoding = false;
+  bool chunked = chunkedIsLast(request.headers, hasTransferEncoding);
+  bool hasContentLength = false;
+  bool validLength =
+      contentLength(request.headers, hasContentLength, length);
+  if (hasTransferEncoding) {
+    // a request with both is a smuggling attempt, and a request body must
+    // always end with the chunked coding
+    if (hasContentLength || !chunked) {
+      return BodyFraming::INVALID;
+    }
+    return BodyFraming::CHUNKED;
+  }
+  if (!validLength) {
+    return BodyFraming::INVALID;
+  }
+  return hasContentLength && length > 0 ? BodyFraming::CONTENT_LENGTH
+                                        : BodyFraming::NONE;
+}
+
+BodyFraming http_parser::response_body_framing(const Response &response,
+                                               Method requestMethod,
+                                               std::uint64_t &length) {
+  length = 0;
+  int code = static_cast<int>(response.status_code);
+  if (requestMethod == Method::METHOD_HEAD || (code >= 100 && code < 200) ||
+      code == 204 || code == 304) {
+    return BodyFraming::NONE;
+  }
+  if (requestMethod == Method::METHOD_CONNECT && code >= 200 && code < 300) {
+    // the connection becomes a tunnel
+    return BodyFraming::NONE;
+  }
+  bool hasTransferEncoding = false;
+  bool chunked = chunkedIsLast(response.headers, hasTransferEncoding);
+  if (hasTransferEncoding) {
+    return chunked ? BodyFraming::CHUNKED : BodyFraming::UNTIL_CLOSE;
+  }
+  bool hasContentLength = false;
+  if (!contentLength(response.headers, hasContentLength, length)) {
+    return BodyFraming::INVALID;
+  }
+  if (!hasContentLength) {
+    return BodyFraming::UNTIL_CLOSE;
+  }
+  return length > 0 ? BodyFraming::CONTENT_LENGTH : BodyFraming::NONE;
+}
+
+BodyParser::BodyParser()
+    : bodyFraming(BodyFraming::NONE), currentParseState(BodyParseState::DONE),
+      remainingBytes{0}, chunkSizeDigits{0} {}
+
+void BodyParser::reset(BodyFraming framing, std::uint64_t contentLength) {
+  bodyFraming = framing;
+  remainingBytes = 0;
+  chunkSizeDigits = 0;
+  trailerParser.reset();
+  switch (framing) {
+  case BodyFraming::NONE:
+    currentParseState = BodyParseState::DONE;
+    break;
+  case BodyFraming::CONTENT_LENGTH:
+    remainingBytes = contentLength;
+    currentParseState = contentLength > 0 ? BodyParseState::CONTENT
+                                          : BodyParseState::DONE;
+    break;
+  case BodyFraming::CHUNKED:
+    currentParseState = BodyParseState::CHUNK_SIZE;
+    break;
+  case BodyFraming::UNTIL_CLOSE:
+    currentParseState = BodyParseState::UNTIL_CLOSE;
+    break;
+  case BodyFraming::INVALID:
+    currentParseState = BodyParseState::PARSE_ERROR;
+    break;
+  }
+}
+
+std::size_t BodyParser::execute(const char *data, std::size_t length,
+                                std::string_view &body) {
+  char cr = 13; // ASCII value for carriage return
+  char lf = 10; // ASCII value for line feed
+  body = std::string_view();
+  std::size_t consumed = 0;
+  while (consumed < length) {
+    char nextChar = data[consumed];
+    switch (currentParseState) {
+    case BodyParseState::CONTENT:
+    case BodyParseState::CHUNK_DATA: {
+      std::size_t available = length - consumed;
+      std::size_t take = remainingBytes < available
+                             ? static_cast<std::size_t>(remainingBytes)
+                             : available;
+      body = std::string_view(data + consumed, take);
+      consumed += take;
+      remainingBytes -= take;
+      if (remainingBytes == 0) {
+        currentParseState = currentParseState == BodyParseState::CONTENT
+                                ? BodyParseState::DONE
+                                : BodyParseState::CHUNK_DATA_CR;
+      }
+      // hand out one contiguous run per call
+      return consumed;
+    }
+    case BodyParseState::UNTIL_CLOSE:
+      body = std::string_view(data + consumed, length - consumed);
+      return length;
+    case BodyParseState::CHUNK_SIZE: {
+      int digit = hexDigit(nextChar);
+      if (digit >= 0) {
+        if (++chunkSizeDigits > maxChunkSizeDigits) {
+          currentParseState = BodyParseState::PARSE_ERROR;
+          return consumed;
+        }
+        remainingBytes = remainingBytes * 16 + static_cast<unsigned>(digit);
+      } else if (chunkSizeDigits > 0 && (nextChar == ';' || nextChar == ' ' ||
+                                         nextChar == '\t')) {
+        currentParseState = BodyParseState::CHUNK_EXTENSION;
+      } else if (chunkSizeDigits > 0 && nextChar == cr) {
+        currentParseState = BodyParseState::CHUNK_SIZE_LF;
+      } else {
+        currentParseState = BodyParseState::PARSE_ERROR;
+        return consumed;
+      }
+      consumed++;
+      break;
+    }
+    case BodyParseState::CHUNK_EXTENSION:
+      // extensions are ignored, but may not contain control characters
+      if (nextChar == cr) {
+        currentParseState = BodyParseState::CHUNK_SIZE_LF;
+      } else if (static_cast<unsigned char>(nextChar) < 32 &&
+                 nextChar != '\t') {
+        currentParseState = BodyParseState::PARSE_ERROR;
+        return consumed;
+      }
+      consumed++;
+      break;
+    case BodyParseState::CHUNK_SIZE_LF:
+      if (nextChar != lf) {
+        currentParseState = BodyParseState::PARSE_ERROR;
+        return consumed;
+      }
+      consumed++;
+      chunkSizeDigits = 0;
+      currentParseState = remainingBytes == 0 ? BodyParseState::TRAILERS
+                                              : BodyParseState::CHUNK_DATA;
+      break;
+    case BodyParseState::CHUNK_DATA_CR:
+      if (nextChar != cr) {
+        currentParseState = BodyParseState::PARSE_ERROR;
+        return consumed;
+      }
+      consumed++;
+      currentParseState = BodyParseState::CHUNK_DATA_LF;
+      break;
+    case BodyParseState::CHUNK_DATA_LF:
+      if (nextChar != lf) {
+        currentParseState = BodyParseState::PARSE_ERROR;
+        return consumed;
+      }
+      consumed++;
+      currentParseState = BodyParseState::CHUNK_SIZE;
+      break;
+    case BodyParseState::TRAILERS:
+      consumed += trailerParser.execute(data + consumed, length - consumed);
+      if (trailerParser.done()) {
+        currentParseState = BodyParseState::DONE;
+      } else if (trailerParser.failed()) {
+        currentParseState = BodyParseState::PARSE_ERROR;
+      }
+      break;
+    case BodyParseState::DONE:
+    case BodyParseState::PARSE_ERROR:
+      return consumed;
+    }
+  }
+  return consumed;
+}
+
+std::uint64_t BodyParser::skip(std::uint64_t length) {
+  if (currentParseState == BodyParseState::UNTIL_CLOSE) {
+    return length;
+  }
+  if (currentParseState != BodyParseState::CONTENT &&
+      currentParseState != BodyParseState::CHUNK_DATA) {
+    return 0;
+  }
+  std::uint64_t take = length < remainingBytes ? length : remainingBytes;
+  remainingBytes -= take;
+  if (remainingBytes == 0) {
+    currentParseState = currentParseState == BodyParseState::CONTENT
+                            ? BodyParseState::DONE
+                            : BodyParseState::CHUNK_DATA_CR;
+  }
+  return take;
+}
+
+void BodyParser::finish() {
+  if (currentParseState == BodyParseState::UNTIL_CLOSE) {
+    currentParseState = BodyParseState::DONE;
+  } else if (currentParseState != BodyParseState::DONE) {
+    // the connection ended inside the body
+    currentParseState = BodyParseState::PARSE_ERROR;
+  }
+}
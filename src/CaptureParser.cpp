@@ -0,0 +1,258 @@
+#include "CaptureParser.hpp"
+#include "BinaryMessage.hpp"
+#include "BodyParser.hpp"
+#include "RequestParser.hpp"
+#include <cstring>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using http_parser::BodyFraming;
+using http_parser::BodyParser;
+using http_parser::CaptureFile;
+using http_parser::CaptureOptions;
+using http_parser::CaptureStats;
+using http_parser::ParseState;
+using http_parser::Request;
+using http_parser::RequestParser;
+
+namespace {
+
+// request lines longer than this are not recognised as boundaries
+constexpr std::size_t maxRequestLine = 8192;
+
+constexpr std::string_view methodTokens[] = {
+    "GET ", "POST ", "PUT ", "DELETE ", "HEAD ",
+    "OPTIONS ", "PATCH ", "TRACE ", "CONNECT "};
+
+bool isRequestLine(const char *line, std::size_t available) {
+  std::string_view text(line, available < maxRequestLine ? available
+                                                         : maxRequestLine);
+  bool knownMethod = false;
+  for (std::string_view method : methodTokens) {
+    if (text.compare(0, method.size(), method) == 0) {
+      knownMethod = true;
+      break;
+    }
+  }
+  if (!knownMethod) {
+    return false;
+  }
+  std::size_t lineEnd = text.find('\n');
+  if (lineEnd == std::string_view::npos) {
+    return false;
+  }
+  std::string_view requestLine = text.substr(0, lineEnd);
+  if (!requestLine.empty() && requestLine.back() == '\r') {
+    requestLine.remove_suffix(1);
+  }
+  // " HTTP/1.x" closes the line
+  return requestLine.size() > 9 &&
+         requestLine.compare(requestLine.size() - 9, 8, " HTTP/1.") == 0 &&
+         requestLine.back() >= '0' && requestLine.back() <= '9';
+}
+
+struct RegionResult {
+  CaptureStats stats;
+  std::size_t end = 0; // where the last message owned by the region ended
+  std::string records;
+};
+
+// Parses the messages starting in [start, limit), the last one may run
+// past limit.
+void parseRegion(const char *data, std::size_t size, std::size_t start,
+                 std::size_t limit, bool emitRecords, RegionResult &result) {
+  RequestParser parser;
+  BodyParser bodyParser;
+  CaptureStats &stats = result.stats;
+  std::size_t pos = start;
+  while (pos < limit) {
+    parser.reset();
+    std::size_t headerLength = parser.execute(data + pos, size - pos);
+    bool parsed = parser.get_state() == ParseState::DONE;
+    std::size_t next = pos + headerLength;
+    if (parsed) {
+      Request request = parser.get_request();
+      std::uint64_t contentLength = 0;
+      BodyFraming framing =
+          http_parser::request_body_framing(request, contentLength);
+      bodyParser.reset(framing, contentLength);
+      // the body is only walked over, views into the mapping are dropped
+      while (!bodyParser.done() && !bodyParser.failed() && next < size) {
+        std::string_view ignored;
+        next += bodyParser.execute(data + next, size - next, ignored);
+      }
+      parsed = bodyParser.done();
+      if (parsed) {
+        stats.messages++;
+        stats.methods[static_cast<std::size_t>(request.method)]++;
+        stats.headerBytes += headerLength;
+        stats.bodyBytes += next - pos - headerLength;
+        stats.headers += request.headers.size();
+        if (emitRecords) {
+          http_parser::binary_encode(request, std::string_view(),
+                                     result.records);
+        }
+        pos = next;
+        continue;
+      }
+    }
+    // resynchronise on the next request line
+    stats.parseErrors++;
+    next = http_parser::find_message_boundary(data, size, pos + 1);
+    stats.skippedBytes += next - pos;
+    pos = next;
+  }
+  result.end = pos;
+}
+
+} // namespace
+
+void CaptureStats::merge(const CaptureStats &other) {
+  messages += other.messages;
+  parseErrors += other.parseErrors;
+  skippedBytes += other.skippedBytes;
+  headerBytes += other.headerBytes;
+  bodyBytes += other.bodyBytes;
+  headers += other.headers;
+  for (std::size_t i = 0; i < methods.size(); i++) {
+    methods[i] += other.methods[i];
+  }
+}
+
+CaptureFile::~CaptureFile() { close(); }
+
+bool CaptureFile::open(const std::string &path) {
+  close();
+#ifdef _WIN32
+  // memory mapping is only implemented for POSIX systems
+  (void)path;
+  return false;
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+    ::close(fd);
+    return false;
+  }
+  void *address = ::mmap(nullptr, static_cast<std::size_t>(info.st_size),
+                         PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (address == MAP_FAILED) {
+    return false;
+  }
+  // every region is read front to back
+  ::madvise(address, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+  mapping = static_cast<const char *>(address);
+  length = static_cast<std::size_t>(info.st_size);
+  return true;
+#endif
+}
+
+void CaptureFile::close() {
+#ifndef _WIN32
+  if (mapping != nullptr) {
+    ::munmap(const_cast<char *>(mapping), length);
+  }
+#endif
+  mapping = nullptr;
+  length = 0;
+}
+
+std::size_t http_parser::find_message_boundary(const char *data,
+                                               std::size_t size,
+                                               std::size_t from) {
+  std::size_t pos = from;
+  while (pos < size) {
+    if (pos > 0 && data[pos - 1] != '\n') {
+      const void *newline = std::memchr(data + pos, '\n', size - pos);
+      if (newline == nullptr) {
+        return size;
+      }
+      pos = static_cast<std::size_t>(static_cast<const char *>(newline) -
+                                     data) +
+            1;
+      continue;
+    }
+    if (isRequestLine(data + pos, size - pos)) {
+      return pos;
+    }
+    pos++;
+  }
+  return size;
+}
+
+CaptureStats http_parser::parse_capture(
+    const char *data, std::size_t size, const CaptureOptions &options,
+    const std::function<void(std::string_view)> &records) {
+  unsigned threads = options.threads != 0
+                         ? options.threads
+                         : std::thread::hardware_concurrency();
+  if (threads == 0) {
+    threads = 1;
+  }
+  std::size_t minRegion = options.minRegionBytes > 0 ? options.minRegionBytes
+                                                     : 1;
+  std::size_t regionCount = size / minRegion;
+  if (regionCount > threads) {
+    regionCount = threads;
+  }
+  if (regionCount == 0) {
+    regionCount = 1;
+  }
+
+  std::vector<std::size_t> starts;
+  starts.push_back(0);
+  for (std::size_t i = 1; i < regionCount; i++) {
+    std::size_t start = find_message_boundary(data, size, size / regionCount * i);
+    if (start > starts.back() && start < size) {
+      starts.push_back(start);
+    }
+  }
+  std::vector<RegionResult> results(starts.size());
+  auto limitOf = [&](std::size_t i) {
+    return i + 1 < starts.size() ? starts[i + 1] : size;
+  };
+  bool emit = options.emitRecords && records;
+
+  std::vector<std::thread> workers;
+  for (std::size_t i = 1; i < starts.size(); i++) {
+    workers.emplace_back(parseRegion, data, size, starts[i], limitOf(i), emit,
+                         std::ref(results[i]));
+  }
+  parseRegion(data, size, starts[0], limitOf(0), emit, results[0]);
+
+  // Regions are joined in order. One that started inside the previous
+  // region's last message is parsed again from where that message really
+  // ended; after that it is final and its records are handed out.
+  CaptureStats total;
+  for (std::size_t i = 0; i < starts.size(); i++) {
+    if (i > 0) {
+      workers[i - 1].join();
+      std::size_t previousEnd = results[i - 1].end;
+      if (previousEnd > starts[i]) {
+        results[i] = RegionResult();
+        parseRegion(data, size, previousEnd, limitOf(i), emit, results[i]);
+        if (results[i].end < previousEnd) {
+          results[i].end = previousEnd;
+        }
+      }
+    }
+    total.merge(results[i].stats);
+    if (emit) {
+      records(results[i].records);
+      std::string().swap(results[i].records);
+    }
+  }
+  return total;
+}
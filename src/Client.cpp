@@ -0,0 +1,285 @@
+#include "Client.hpp"
+#include "OS.h"
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <netdb.h>
+#include <netinet/tcp.h>
+#endif
+
+using http_parser::BodyFraming;
+using http_parser::ClientConnection;
+using http_parser::ClientResponse;
+using http_parser::ConnectionPool;
+using http_parser::HeaderId;
+using http_parser::Method;
+using http_parser::Request;
+using http_parser::ResponseParseState;
+
+namespace {
+
+std::string poolKey(const std::string &host, const std::string &port) {
+  std::string key;
+  key.reserve(host.size() + port.size() + 1);
+  key += host;
+  key += ':';
+  key += port;
+  return key;
+}
+
+} // namespace
+
+ClientConnection::ClientConnection(int file_descriptor, std::string host,
+                                   std::string port,
+                                   std::size_t maxPipelineDepth)
+    : fd{file_descriptor}, hostName(std::move(host)),
+      portName(std::move(port)),
+      maxPipelineDepth{maxPipelineDepth > 0 ? maxPipelineDepth : 1},
+      completedResponses{0}, closed{file_descriptor == INVALID_SOCKET},
+      readingBody{false}, responseStarted{false},
+      readBuffer(READ_BUFFER_SIZE), readStart{0}, readEnd{0} {
+  if (portName.empty() || portName == "80") {
+    serializer.set_host(hostName);
+  } else {
+    serializer.set_host(poolKey(hostName, portName));
+  }
+}
+
+ClientConnection::~ClientConnection() {
+  if (fd != INVALID_SOCKET) {
+    ::close(fd);
+  }
+}
+
+std::unique_ptr<ClientConnection>
+ClientConnection::connect(const std::string &host, const std::string &port,
+                          std::size_t maxPipelineDepth) {
+  addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *addresses = nullptr;
+  if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+    return nullptr;
+  }
+  int socket_fd = INVALID_SOCKET;
+  for (addrinfo *address = addresses; address != nullptr;
+       address = address->ai_next) {
+    socket_fd = static_cast<int>(::socket(
+        address->ai_family, address->ai_socktype, address->ai_protocol));
+    if (socket_fd == INVALID_SOCKET) {
+      continue;
+    }
+    if (::connect(socket_fd, address->ai_addr,
+                  static_cast<socklen_t>(address->ai_addrlen)) == 0) {
+      break;
+    }
+    ::close(socket_fd);
+    socket_fd = INVALID_SOCKET;
+  }
+  ::freeaddrinfo(addresses);
+  if (socket_fd == INVALID_SOCKET) {
+    return nullptr;
+  }
+  // requests are written with a single writev, don't hold them back
+  int noDelay = 1;
+  ::setsockopt(socket_fd, IPPROTO_TCP, TCP_NODELAY,
+               reinterpret_cast<const char *>(&noDelay), sizeof(noDelay));
+  return std::make_unique<ClientConnection>(socket_fd, host, port,
+                                            maxPipelineDepth);
+}
+
+bool ClientConnection::send(const Request &request, std::string_view body) {
+  if (!can_send() || !serializer.serialize(request, body)) {
+    return false;
+  }
+  if (!serializer.write(fd)) {
+    closed = true;
+    return false;
+  }
+  inFlight.push_back(request.method);
+  return true;
+}
+
+bool ClientConnection::fail() {
+  closed = true;
+  return false;
+}
+
+// Reads more bytes after the unconsumed ones, returns false on error or end
+// of stream.
+bool ClientConnection::fill() {
+  if (readStart > 0) {
+    std::memmove(readBuffer.data(), readBuffer.data() + readStart,
+                 readEnd - readStart);
+    readEnd -= readStart;
+    readStart = 0;
+  }
+  if (readEnd == readBuffer.size()) {
+    readBuffer.resize(readBuffer.size() * 2);
+  }
+  while (true) {
+#ifdef _WIN32
+    int bytesRead = ::recv(fd, readBuffer.data() + readEnd,
+                           static_cast<int>(readBuffer.size() - readEnd), 0);
+#else
+    ssize_t bytesRead = ::read(fd, readBuffer.data() + readEnd,
+                               readBuffer.size() - readEnd);
+#endif
+    if (bytesRead < 0 && errno == EINTR) {
+      continue;
+    }
+    if (bytesRead <= 0) {
+      return false;
+    }
+    readEnd += static_cast<std::size_t>(bytesRead);
+    responseStarted = true;
+    return true;
+  }
+}
+
+bool ClientConnection::receive(ClientResponse &out) {
+  if (inFlight.empty() || fd == INVALID_SOCKET) {
+    return false;
+  }
+  out.body.clear();
+  while (true) {
+    if (!readingBody) {
+      readStart += responseParser.execute(readBuffer.data() + readStart,
+                                          readEnd - readStart);
+      ResponseParseState state = responseParser.get_state();
+      if (state == ResponseParseState::PARSE_ERROR) {
+        return fail();
+      }
+      if (state == ResponseParseState::DONE) {
+        out.response = responseParser.get_response();
+        responseParser.reset();
+        int code = static_cast<int>(out.response.status_code);
+        if (code >= 100 && code < 200 && code != 101) {
+          // interim response, the final one follows on the same request
+          continue;
+        }
+        std::uint64_t contentLength = 0;
+        BodyFraming framing = http_parser::response_body_framing(
+            out.response, inFlight.front(), contentLength);
+        if (framing == BodyFraming::INVALID) {
+          return fail();
+        }
+        if (framing == BodyFraming::UNTIL_CLOSE || code == 101 ||
+            !out.response.should_keep_alive()) {
+          // no further responses can follow on this connection
+          closed = true;
+        }
+        bodyParser.reset(framing, contentLength);
+        readingBody = true;
+      }
+    }
+    if (readingBody) {
+      while (!bodyParser.done() && !bodyParser.failed() &&
+             readStart < readEnd) {
+        std::string_view chunk;
+        readStart += bodyParser.execute(readBuffer.data() + readStart,
+                                        readEnd - readStart, chunk);
+        out.body.append(chunk.data(), chunk.size());
+      }
+      if (bodyParser.failed()) {
+        return fail();
+      }
+      if (bodyParser.done()) {
+        readingBody = false;
+        inFlight.pop_front();
+        completedResponses++;
+        responseStarted = false;
+        return true;
+      }
+    }
+    if (!fill()) {
+      if (readingBody) {
+        // end of stream completes bodies delimited by the connection
+        bodyParser.finish();
+        if (bodyParser.done()) {
+          readingBody = false;
+          inFlight.pop_front();
+          completedResponses++;
+          closed = true;
+          return true;
+        }
+      }
+      return fail();
+    }
+  }
+}
+
+ConnectionPool::ConnectionPool(std::size_t maxIdlePerHost,
+                               std::size_t maxPipelineDepth)
+    : maxIdlePerHost{maxIdlePerHost}, maxPipelineDepth{maxPipelineDepth} {}
+
+std::unique_ptr<ClientConnection>
+ConnectionPool::acquire(const std::string &host, const std::string &port) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = idle.find(poolKey(host, port));
+    if (it != idle.end() && !it->second.empty()) {
+      // most recently used first, it is the least likely to be timed out
+      std::unique_ptr<ClientConnection> connection =
+          std::move(it->second.back());
+      it->second.pop_back();
+      return connection;
+    }
+  }
+  return ClientConnection::connect(host, port, maxPipelineDepth);
+}
+
+void ConnectionPool::release(std::unique_ptr<ClientConnection> connection) {
+  if (!connection || !connection->reusable()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  std::vector<std::unique_ptr<ClientConnection>> &connections =
+      idle[poolKey(connection->host(), connection->port())];
+  if (connections.size() < maxIdlePerHost) {
+    connections.push_back(std::move(connection));
+  }
+}
+
+bool ConnectionPool::request(const std::string &host, const std::string &port,
+                             const Request &request, std::string_view body,
+                             ClientResponse &out) {
+  std::unique_ptr<ClientConnection> connection = acquire(host, port);
+  if (!connection) {
+    return false;
+  }
+  bool wasReused = connection->reused();
+  if (connection->send(request, body) && connection->receive(out)) {
+    release(std::move(connection));
+    return true;
+  }
+  // a stale keep-alive connection, retry once on a newly opened one: the
+  // other idle connections are likely stale as well, e.g. after a server
+  // restart. Other methods may have had an effect already (RFC 9110
+  // section 9.2.2).
+  if (!wasReused || connection->response_started() ||
+      !http_parser::is_idempotent(request.method)) {
+    return false;
+  }
+  connection = ClientConnection::connect(host, port, maxPipelineDepth);
+  if (!connection || !connection->send(request, body) ||
+      !connection->receive(out)) {
+    return false;
+  }
+  release(std::move(connection));
+  return true;
+}
+
+std::size_t ConnectionPool::idle_count(const std::string &host,
+                                       const std::string &port) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = idle.find(poolKey(host, port));
+  return it == idle.end() ? 0 : it->second.size();
+}
+
+void ConnectionPool::clear() {
+  std::lock_guard<std::mutex> lock(mutex);
+  idle.clear();
+}
@@ -0,0 +1,178 @@
+#include "Conditional.hpp"
+#include "HttpDate.hpp"
+#include "Text.h"
+#include <cstring>
+
+using http_parser::EntityTag;
+using http_parser::EntityTagList;
+using http_parser::HeaderId;
+using http_parser::Method;
+using http_parser::Request;
+using http_parser::ResourceValidators;
+using http_parser::StatusCode;
+using http_parser::detail::trim;
+
+namespace {
+
+std::string_view trimLeft(std::string_view text) {
+  std::size_t i = 0;
+  while (i < text.size() && (text[i] == ' ' || text[i] == '\t' ||
+                             text[i] == ',')) {
+    i++;
+  }
+  return text.substr(i);
+}
+
+// Reads one entity-tag from the front of `text`, leaving the rest in it.
+bool takeEntityTag(std::string_view &text, EntityTag &tag) {
+  tag.weak = false;
+  if (text.size() >= 2 && text[0] == 'W' && text[1] == '/') {
+    tag.weak = true;
+    text.remove_prefix(2);
+  }
+  if (text.empty() || text[0] != '"') {
+    return false;
+  }
+  const char *close = static_cast<const char *>(
+      std::memchr(text.data() + 1, '"', text.size() - 1));
+  if (close == nullptr) {
+    return false;
+  }
+  tag.opaque = std::string_view(
+      text.data() + 1, static_cast<std::size_t>(close - text.data() - 1));
+  for (char c : tag.opaque) {
+    // etagc is %x21 / %x23-7E / obs-text
+    unsigned char u = static_cast<unsigned char>(c);
+    if (u < 0x21 || u == 0x7f) {
+      return false;
+    }
+  }
+  text.remove_prefix(tag.opaque.size() + 2);
+  return true;
+}
+
+// Evaluates every header line of a match list (headers may be repeated and
+// are then one comma separated list). `present` tells if any was found.
+bool listMatches(const Request &request, HeaderId id, const EntityTag *current,
+                 bool exists, bool weakComparison, bool &present) {
+  present = false;
+  bool matched = false;
+  for (auto it = request.headers.find(id); it != request.headers.end();
+       it = request.headers.find(id, it.position() + 1)) {
+    present = true;
+    EntityTagList list(trim((*it).value));
+    if (list.is_wildcard()) {
+      matched |= exists;
+    } else if (current != nullptr) {
+      matched |= list.contains(*current, weakComparison);
+    }
+  }
+  return matched;
+}
+
+bool headerDate(const Request &request, HeaderId id, std::int64_t &date) {
+  auto it = request.headers.find(id);
+  // a repeated date header is invalid and therefore ignored
+  if (it == request.headers.end() ||
+      request.headers.find(id, it.position() + 1) != request.headers.end()) {
+    return false;
+  }
+  return http_parser::parse_http_date(trim((*it).value), date);
+}
+
+} // namespace
+
+bool http_parser::parse_entity_tag(std::string_view text, EntityTag &tag) {
+  text = trim(text);
+  return takeEntityTag(text, tag) && text.empty();
+}
+
+bool http_parser::strong_match(const EntityTag &a, const EntityTag &b) {
+  return !a.weak && !b.weak && a.opaque == b.opaque;
+}
+
+bool http_parser::weak_match(const EntityTag &a, const EntityTag &b) {
+  return a.opaque == b.opaque;
+}
+
+EntityTagList::EntityTagList(std::string_view value)
+    : value(value), wildcard(trim(value) == "*") {}
+
+EntityTagList::const_iterator::const_iterator(std::string_view remaining,
+                                              bool *valid)
+    : remaining(remaining), valid(valid), atEnd(false) {
+  ++*this;
+}
+
+EntityTagList::const_iterator &EntityTagList::const_iterator::operator++() {
+  remaining = trimLeft(remaining);
+  if (remaining.empty()) {
+    atEnd = true;
+    return *this;
+  }
+  if (!takeEntityTag(remaining, current)) {
+    *valid = false;
+    atEnd = true;
+    return *this;
+  }
+  // members are separated by OWS "," OWS
+  if (!remaining.empty() && remaining[0] != ',' && remaining[0] != ' ' &&
+      remaining[0] != '\t') {
+    *valid = false;
+    atEnd = true;
+  }
+  return *this;
+}
+
+bool EntityTagList::contains(const EntityTag &tag, bool weakComparison) const {
+  for (const EntityTag &member : *this) {
+    if (weakComparison ? weak_match(member, tag) : strong_match(member, tag)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+StatusCode
+http_parser::evaluate_preconditions(const Request &request,
+                                    const ResourceValidators &validators) {
+  EntityTag current;
+  const EntityTag *currentTag = nullptr;
+  if (validators.exists && !validators.etag.empty() &&
+      parse_entity_tag(validators.etag, current)) {
+    currentTag = &current;
+  }
+  bool hasLastModified = validators.exists && validators.lastModified >= 0;
+  bool present = false;
+  std::int64_t date = 0;
+
+  // step 1 and 2: If-Match, otherwise If-Unmodified-Since
+  bool matched = listMatches(request, HeaderId::IF_MATCH, currentTag,
+                             validators.exists, false, present);
+  if (present) {
+    if (!matched) {
+      return StatusCode::PRECONDITION_FAILED;
+    }
+  } else if (hasLastModified &&
+             headerDate(request, HeaderId::IF_UNMODIFIED_SINCE, date) &&
+             validators.lastModified > date) {
+    return StatusCode::PRECONDITION_FAILED;
+  }
+
+  bool safeMethod = request.method == Method::METHOD_GET ||
+                    request.method == Method::METHOD_HEAD;
+  // step 3 and 4: If-None-Match, otherwise If-Modified-Since for GET/HEAD
+  matched = listMatches(request, HeaderId::IF_NONE_MATCH, currentTag,
+                        validators.exists, true, present);
+  if (present) {
+    if (matched) {
+      return safeMethod ? StatusCode::NOT_MODIFIED
+                        : StatusCode::PRECONDITION_FAILED;
+    }
+  } else if (safeMethod && hasLastModified &&
+             headerDate(request, HeaderId::IF_MODIFIED_SINCE, date) &&
+             validators.lastModified <= date) {
+    return StatusCode::NOT_MODIFIED;
+  }
+  return StatusCode::OK;
+}
@@ -0,0 +1,198 @@
+#include "ContentDecoder.hpp"
+#include "HeaderValue.hpp"
+
+#ifdef HTTP_PARSER_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+using http_parser::ContentCoding;
+using http_parser::ContentDecoder;
+using http_parser::DecodeState;
+using http_parser::HeaderId;
+
+struct ContentDecoder::Stream {
+#ifdef HTTP_PARSER_HAS_ZLIB
+  z_stream z{};
+  bool initialized = false;
+  // a gzip member ended and no bytes of another one were seen yet
+  bool memberEnded = false;
+
+  ~Stream() {
+    if (initialized) {
+      inflateEnd(&z);
+    }
+  }
+#endif
+};
+
+ContentCoding http_parser::content_coding(const Headers &headers) {
+  ContentCoding coding = ContentCoding::IDENTITY;
+  for (auto it = headers.find(HeaderId::CONTENT_ENCODING); it != headers.end();
+       it = headers.find(HeaderId::CONTENT_ENCODING, it.position() + 1)) {
+    for (std::string_view token : TokenList((*it).value)) {
+      if (header_name_equals(token, "identity")) {
+        continue;
+      }
+      if (coding != ContentCoding::IDENTITY) {
+        // stacked codings are not decoded
+        return ContentCoding::UNSUPPORTED;
+      }
+      if (header_name_equals(token, "gzip") ||
+          header_name_equals(token, "x-gzip")) {
+        coding = ContentCoding::GZIP;
+      } else if (header_name_equals(token, "deflate")) {
+        coding = ContentCoding::DEFLATE;
+      } else {
+        return ContentCoding::UNSUPPORTED;
+      }
+    }
+  }
+  return coding;
+}
+
+ContentDecoder::ContentDecoder(std::size_t bufferSize)
+    : contentCoding{ContentCoding::IDENTITY}, currentState{DecodeState::DONE},
+      stream{std::make_unique<Stream>()},
+      buffer{std::make_unique<char[]>(bufferSize)}, bufferSize{bufferSize},
+      maxOutputBytes{DEFAULT_MAX_OUTPUT}, outputBytes{0},
+      outputPending{false}, started{false} {}
+
+ContentDecoder::~ContentDecoder() = default;
+
+bool ContentDecoder::reset(ContentCoding coding, std::uint64_t maxOutput) {
+  contentCoding = coding;
+  maxOutputBytes = maxOutput;
+  outputBytes = 0;
+  outputPending = false;
+  started = false;
+  currentState = DecodeState::DECODING;
+  if (coding == ContentCoding::IDENTITY) {
+    return true;
+  }
+#ifdef HTTP_PARSER_HAS_ZLIB
+  if (coding == ContentCoding::GZIP || coding == ContentCoding::DEFLATE) {
+    // the stream is set up with the first byte, which tells zlib wrapped
+    // deflate from raw deflate
+    stream->memberEnded = false;
+    return true;
+  }
+#endif
+  currentState = DecodeState::PARSE_ERROR;
+  return false;
+}
+
+std::size_t ContentDecoder::execute(const char *data, std::size_t length,
+                                    std::string_view &out) {
+  out = std::string_view();
+  if (currentState == DecodeState::DONE) {
+    // anything after the end of the compressed stream is ignored
+    return length;
+  }
+  if (currentState != DecodeState::DECODING) {
+    return 0;
+  }
+  if (contentCoding == ContentCoding::IDENTITY) {
+    if (length > maxOutputBytes - outputBytes) {
+      currentState = DecodeState::TOO_LARGE;
+      return 0;
+    }
+    outputBytes += length;
+    out = std::string_view(data, length);
+    return length;
+  }
+  return inflate(data, length, out);
+}
+
+std::size_t ContentDecoder::inflate(const char *data, std::size_t length,
+                                    std::string_view &out) {
+#ifdef HTTP_PARSER_HAS_ZLIB
+  z_stream &z = stream->z;
+  if (!started) {
+    if (length == 0) {
+      return 0;
+    }
+    int windowBits = 15 + 16; // gzip wrapper
+    if (contentCoding == ContentCoding::DEFLATE) {
+      // a zlib header starts with CM 8 and CINFO at most 7
+      unsigned char first = static_cast<unsigned char>(data[0]);
+      windowBits = (first & 0x0f) == 8 && (first >> 4) <= 7 ? 15 : -15;
+    }
+    int result = stream->initialized ? inflateReset2(&z, windowBits)
+                                     : inflateInit2(&z, windowBits);
+    if (result != Z_OK) {
+      currentState = DecodeState::PARSE_ERROR;
+      return 0;
+    }
+    stream->initialized = true;
+    started = true;
+  }
+
+  // zlib does not modify the input, uInt limits what one call can take
+  std::size_t input = length < UINT32_MAX ? length : UINT32_MAX;
+  z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+  z.avail_in = static_cast<uInt>(input);
+  z.next_out = reinterpret_cast<Bytef *>(buffer.get());
+  z.avail_out = static_cast<uInt>(bufferSize);
+  while (z.avail_out > 0) {
+    int result = ::inflate(&z, Z_NO_FLUSH);
+    if (result == Z_STREAM_END) {
+      if (contentCoding != ContentCoding::GZIP) {
+        currentState = DecodeState::DONE;
+        break;
+      }
+      // gzip bodies may consist of several members
+      inflateReset(&z);
+      stream->memberEnded = true;
+      if (z.avail_in == 0) {
+        break;
+      }
+      continue;
+    }
+    if (result == Z_BUF_ERROR) {
+      // needs more input
+      break;
+    }
+    if (result != Z_OK) {
+      // garbage after a complete gzip member is ignored like gzip does
+      currentState = stream->memberEnded && z.total_out == 0
+                         ? DecodeState::DONE
+                         : DecodeState::PARSE_ERROR;
+      break;
+    }
+    if (z.total_in > 0) {
+      stream->memberEnded = false;
+    }
+  }
+
+  std::size_t produced = bufferSize - z.avail_out;
+  outputPending = z.avail_out == 0 && currentState == DecodeState::DECODING;
+  if (produced > maxOutputBytes - outputBytes) {
+    currentState = DecodeState::TOO_LARGE;
+    outputPending = false;
+    return 0;
+  }
+  outputBytes += produced;
+  out = std::string_view(buffer.get(), produced);
+  if (currentState == DecodeState::DONE) {
+    return length;
+  }
+  return input - z.avail_in;
+#else
+  (void)data;
+  (void)length;
+  (void)out;
+  currentState = DecodeState::PARSE_ERROR;
+  return 0;
+#endif
+}
+
+void ContentDecoder::finish() {
+  if (currentState != DecodeState::DECODING) {
+    return;
+  }
+  bool complete = contentCoding == ContentCoding::IDENTITY || !started;
+#ifdef HTTP_PARSER_HAS_ZLIB
+  complete = complete || (stream->memberEnded && stream->z.total_in == 0);
+#endif
+  currentState = complete ? DecodeState::DONE : DecodeState::PARSE_ERROR;
+}
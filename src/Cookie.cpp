@@ -0,0 +1,56 @@
+#include "Cookie.hpp"
+#include "Text.h"
+#include <cstring>
+
+using http_parser::Cookie;
+using http_parser::Cookies;
+using http_parser::detail::trim;
+
+Cookies::const_iterator::const_iterator(std::string_view remaining)
+    : remaining(remaining), atEnd(false) {
+  ++*this;
+}
+
+Cookies::const_iterator &Cookies::const_iterator::operator++() {
+  while (!remaining.empty()) {
+    const char *semicolon = static_cast<const char *>(
+        std::memchr(remaining.data(), ';', remaining.size()));
+    std::size_t length = semicolon == nullptr
+                             ? remaining.size()
+                             : static_cast<std::size_t>(
+                                   semicolon - remaining.data());
+    std::string_view pair = trim(remaining.substr(0, length));
+    remaining = semicolon == nullptr ? remaining.substr(remaining.size())
+                                     : remaining.substr(length + 1);
+    if (pair.empty()) {
+      continue;
+    }
+    const char *equals =
+        static_cast<const char *>(std::memchr(pair.data(), '=', pair.size()));
+    if (equals == nullptr) {
+      current = Cookie{pair.substr(0, 0), pair};
+    } else {
+      std::size_t split = static_cast<std::size_t>(equals - pair.data());
+      current = Cookie{trim(pair.substr(0, split)),
+                       trim(pair.substr(split + 1))};
+    }
+    std::string_view &value = current.value;
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+      value = value.substr(1, value.size() - 2);
+    }
+    return *this;
+  }
+  atEnd = true;
+  current = Cookie{};
+  return *this;
+}
+
+bool Cookies::find(std::string_view name, std::string_view &value) const {
+  for (const Cookie &cookie : *this) {
+    if (cookie.name == name) {
+      value = cookie.value;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,74 @@
+#include "Expect.hpp"
+#include "BodyParser.hpp"
+
+using http_parser::ContinueHandler;
+using http_parser::ContinueState;
+
+namespace {
+
+constexpr std::string_view continueResponse = "HTTP/1.1 100 Continue\r\n\r\n";
+
+} // namespace
+
+ContinueHandler::ContinueHandler()
+    : currentState{ContinueState::NONE}, iov{nullptr, 0}, iovIndex{0},
+      remainingBytes{0} {}
+
+ContinueState ContinueHandler::start(const Request &request) {
+  iov.iov_base = const_cast<char *>(continueResponse.data());
+  iov.iov_len = continueResponse.size();
+  iovIndex = 0;
+  remainingBytes = continueResponse.size();
+  currentState = ContinueState::NONE;
+  if (!request.expects_continue()) {
+    return currentState;
+  }
+  std::uint64_t contentLength = 0;
+  BodyFraming framing = request_body_framing(request, contentLength);
+  if (framing == BodyFraming::CHUNKED ||
+      (framing == BodyFraming::CONTENT_LENGTH && contentLength > 0)) {
+    currentState = ContinueState::PENDING;
+  }
+  return currentState;
+}
+
+bool ContinueHandler::send_continue(int file_descriptor) {
+  if (currentState != ContinueState::PENDING) {
+    return currentState != ContinueState::REJECTED;
+  }
+  if (!http_parser::iovec_write(file_descriptor, &iov, 1, iovIndex,
+                                remainingBytes)) {
+    return false;
+  }
+  if (remainingBytes == 0) {
+    currentState = ContinueState::CONTINUED;
+  }
+  return true;
+}
+
+std::string_view ContinueHandler::interim() const {
+  if (currentState != ContinueState::PENDING) {
+    return std::string_view();
+  }
+  return continueResponse.substr(continueResponse.size() - remainingBytes);
+}
+
+void ContinueHandler::consume(std::size_t bytes) {
+  if (currentState != ContinueState::PENDING) {
+    return;
+  }
+  bytes = bytes < remainingBytes ? bytes : remainingBytes;
+  http_parser::iovec_consume(&iov, 1, iovIndex, bytes);
+  remainingBytes -= bytes;
+  if (remainingBytes == 0) {
+    currentState = ContinueState::CONTINUED;
+  }
+}
+
+void ContinueHandler::reject(Request &request, Response &response) {
+  currentState = ContinueState::REJECTED;
+  request.keep_alive = false;
+  if (!http_parser::connection_options(response.headers).close) {
+    response.headers.add(HeaderId::CONNECTION, "connection", "close");
+  }
+}
@@ -0,0 +1,255 @@
+#include "HeaderEditor.hpp"
+#include "HeaderValue.hpp"
+#include "Text.h"
+
+using http_parser::HeaderEditor;
+using http_parser::HeaderId;
+using http_parser::TokenList;
+using http_parser::detail::trim;
+
+namespace {
+
+// line without its CRLF or LF ending
+std::string_view stripLineEnd(std::string_view line) {
+  if (!line.empty() && line.back() == '\n') {
+    line.remove_suffix(1);
+  }
+  if (!line.empty() && line.back() == '\r') {
+    line.remove_suffix(1);
+  }
+  return line;
+}
+
+// Framing and routing headers are never connection options: removing them
+// because the sender listed them in Connection would change how the next
+// hop frames or routes the message, which is a request smuggling vector.
+bool protectedOption(std::string_view option) {
+  HeaderId id = http_parser::string_to_header_id(option);
+  return id == HeaderId::CONTENT_LENGTH || id == HeaderId::TRANSFER_ENCODING ||
+         id == HeaderId::HOST;
+}
+
+} // namespace
+
+HeaderEditor::HeaderEditor()
+    : startLineLength{0}, startLineReplaced{false}, startLineFragment{0, 0},
+      iovIndex{0}, remainingBytes{0} {
+  scratch.reserve(512);
+}
+
+bool HeaderEditor::attach(std::string_view block) {
+  head = block;
+  lines.clear();
+  additions.clear();
+  scratch.clear();
+  iov.clear();
+  iovIndex = 0;
+  remainingBytes = 0;
+  startLineReplaced = false;
+
+  std::size_t pos = 0;
+  bool first = true;
+  while (pos < block.size()) {
+    std::size_t newline = block.find('\n', pos);
+    if (newline == std::string_view::npos) {
+      return false;
+    }
+    std::string_view line = block.substr(pos, newline + 1 - pos);
+    std::string_view content = stripLineEnd(line);
+    if (first) {
+      startLine = content;
+      startLineLength = line.size();
+      first = false;
+    } else if (content.empty()) {
+      // the empty line must be the last one
+      return newline + 1 == block.size();
+    } else {
+      std::size_t colon = content.find(':');
+      if (colon == std::string_view::npos) {
+        return false;
+      }
+      std::string_view key = content.substr(0, colon);
+      lines.push_back(Line{pos, line.size(), key,
+                           trim(content.substr(colon + 1)),
+                           string_to_header_id(key), Edit::KEEP, 0, 0});
+    }
+    pos = newline + 1;
+  }
+  return false;
+}
+
+bool HeaderEditor::matches(const Line &line, std::string_view name) const {
+  HeaderId id = string_to_header_id(name);
+  return id != HeaderId::UNKOWN ? line.id == id
+                                : header_name_equals(line.key, name);
+}
+
+HeaderEditor::Fragment HeaderEditor::writeLine(std::string_view name,
+                                               std::string_view value,
+                                               std::string_view extra) {
+  Fragment fragment{scratch.size(), 0};
+  scratch.append(name.data(), name.size());
+  scratch += ": ";
+  scratch.append(value.data(), value.size());
+  scratch.append(extra.data(), extra.size());
+  scratch += "\r\n";
+  fragment.length = scratch.size() - fragment.offset;
+  return fragment;
+}
+
+void HeaderEditor::remove(HeaderId id) {
+  for (Line &line : lines) {
+    if (line.id == id && id != HeaderId::UNKOWN) {
+      line.edit = Edit::REMOVE;
+    }
+  }
+}
+
+void HeaderEditor::remove(std::string_view name) {
+  for (Line &line : lines) {
+    if (matches(line, name)) {
+      line.edit = Edit::REMOVE;
+    }
+  }
+}
+
+void HeaderEditor::remove_hop_by_hop() {
+  // headers listed as connection options go first, the names point into
+  // the original buffer so they stay valid while lines are removed
+  for (const Line &line : lines) {
+    if (line.id != HeaderId::CONNECTION || line.edit == Edit::REMOVE) {
+      continue;
+    }
+    for (std::string_view option : TokenList(line.value)) {
+      if (protectedOption(option)) {
+        continue;
+      }
+      for (Line &other : lines) {
+        if (matches(other, option)) {
+          other.edit = Edit::REMOVE;
+        }
+      }
+    }
+  }
+  for (Line &line : lines) {
+    switch (line.id) {
+    case HeaderId::CONNECTION:
+    case HeaderId::PROXY_CONNECTION:
+    case HeaderId::KEEP_ALIVE:
+    case HeaderId::TE:
+    case HeaderId::UPGRADE:
+      line.edit = Edit::REMOVE;
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+void HeaderEditor::set(std::string_view name, std::string_view value) {
+  bool found = false;
+  for (Line &line : lines) {
+    if (!matches(line, name) || line.edit == Edit::REMOVE) {
+      continue;
+    }
+    if (found) {
+      line.edit = Edit::REMOVE;
+      continue;
+    }
+    Fragment fragment = writeLine(line.key, value);
+    line.edit = Edit::REPLACE;
+    line.fragmentOffset = fragment.offset;
+    line.fragmentLength = fragment.length;
+    found = true;
+  }
+  if (!found) {
+    add(name, value);
+  }
+}
+
+void HeaderEditor::append(std::string_view name, std::string_view value) {
+  for (Line &line : lines) {
+    if (!matches(line, name) || line.edit == Edit::REMOVE) {
+      continue;
+    }
+    std::string_view current = line.value;
+    if (line.edit == Edit::REPLACE) {
+      // value written by an earlier edit, without "key: " and CRLF
+      current = std::string_view(scratch).substr(
+          line.fragmentOffset + line.key.size() + 2,
+          line.fragmentLength - line.key.size() - 4);
+    }
+    std::string combined(current);
+    if (!combined.empty()) {
+      combined += ", ";
+    }
+    Fragment fragment = writeLine(line.key, combined, value);
+    line.edit = Edit::REPLACE;
+    line.fragmentOffset = fragment.offset;
+    line.fragmentLength = fragment.length;
+    return;
+  }
+  add(name, value);
+}
+
+void HeaderEditor::add(std::string_view name, std::string_view value) {
+  additions.push_back(writeLine(name, value));
+}
+
+void HeaderEditor::set_start_line(std::string_view line) {
+  startLineFragment.offset = scratch.size();
+  scratch.append(line.data(), line.size());
+  scratch += "\r\n";
+  startLineFragment.length = scratch.size() - startLineFragment.offset;
+  startLineReplaced = true;
+}
+
+void HeaderEditor::build() {
+  iov.clear();
+  iovIndex = 0;
+  remainingBytes = 0;
+  const char *original = head.data();
+  auto push = [&](const char *data, std::size_t length) {
+    if (length == 0) {
+      return;
+    }
+    // adjacent slices of the same buffer are merged into one iovec
+    if (!iov.empty() &&
+        static_cast<const char *>(iov.back().iov_base) + iov.back().iov_len ==
+            data) {
+      iov.back().iov_len += length;
+    } else {
+      iov.push_back(iovec{const_cast<char *>(data), length});
+    }
+    remainingBytes += length;
+  };
+
+  if (startLineReplaced) {
+    push(scratch.data() + startLineFragment.offset, startLineFragment.length);
+  } else {
+    push(original, startLineLength);
+  }
+  for (const Line &line : lines) {
+    if (line.edit == Edit::KEEP) {
+      push(original + line.offset, line.length);
+    } else if (line.edit == Edit::REPLACE) {
+      push(scratch.data() + line.fragmentOffset, line.fragmentLength);
+    }
+  }
+  for (const Fragment &fragment : additions) {
+    push(scratch.data() + fragment.offset, fragment.length);
+  }
+  // the empty line that ends the block
+  std::size_t endOfHeaders =
+      lines.empty() ? startLineLength
+                    : lines.back().offset + lines.back().length;
+  push(original + endOfHeaders, head.size() - endOfHeaders);
+}
+
+bool HeaderEditor::write(int file_descriptor) {
+  std::size_t index = iovIndex;
+  bool result = http_parser::iovec_write(file_descriptor, iov.data(),
+                                         iov.size(), index, remainingBytes);
+  iovIndex = index;
+  return result;
+}
@@ -0,0 +1,140 @@
+#include "HeaderList.hpp"
+#include <cctype>
+
+using http_parser::HeaderId;
+
+namespace {
+
+constexpr std::size_t headerIdCount =
+    static_cast<std::size_t>(HeaderId::HEADER_ID_COUNT);
+
+// indexed by HeaderId, must follow the enum order
+constexpr std::string_view headerNames[headerIdCount] = {
+    "",
+    "accept",
+    "accept-charset",
+    "accept-encoding",
+    "accept-language",
+    "accept-ranges",
+    "age",
+    "allow",
+    "authorization",
+    "cache-control",
+    "connection",
+    "content-disposition",
+    "content-encoding",
+    "content-language",
+    "content-length",
+    "content-location",
+    "content-range",
+    "content-type",
+    "cookie",
+    "date",
+    "etag",
+    "expect",
+    "expires",
+    "forwarded",
+    "from",
+    "host",
+    "http2-settings",
+    "if-match",
+    "if-modified-since",
+    "if-none-match",
+    "if-range",
+    "if-unmodified-since",
+    "keep-alive",
+    "last-modified",
+    "link",
+    "location",
+    "max-forwards",
+    "origin",
+    "pragma",
+    "proxy-authenticate",
+    "proxy-authorization",
+    "proxy-connection",
+    "range",
+    "referer",
+    "retry-after",
+    "sec-websocket-accept",
+    "sec-websocket-extensions",
+    "sec-websocket-key",
+    "sec-websocket-protocol",
+    "sec-websocket-version",
+    "server",
+    "set-cookie",
+    "strict-transport-security",
+    "te",
+    "trailer",
+    "transfer-encoding",
+    "upgrade",
+    "user-agent",
+    "vary",
+    "via",
+    "www-authenticate",
+    "x-forwarded-for",
+    "x-forwarded-host",
+    "x-forwarded-proto",
+    "x-request-id",
+};
+
+constexpr std::size_t maxKnownLength = 32;
+constexpr std::size_t bucketSize = 8;
+
+// Candidate ids grouped by name length, so a lookup compares against at most
+// a handful of names of the right size.
+struct LengthBuckets {
+  HeaderId ids[maxKnownLength + 1][bucketSize] = {};
+  unsigned char counts[maxKnownLength + 1] = {};
+
+  LengthBuckets() {
+    for (std::size_t i = 1; i < headerIdCount; i++) {
+      std::size_t length = headerNames[i].size();
+      ids[length][counts[length]++] = static_cast<HeaderId>(i);
+    }
+  }
+};
+
+const LengthBuckets &lengthBuckets() {
+  static const LengthBuckets buckets;
+  return buckets;
+}
+
+inline char lower(char c) {
+  return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+}
+
+} // namespace
+
+bool http_parser::header_name_equals(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < a.size(); i++) {
+    if (a[i] != b[i] && lower(a[i]) != lower(b[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+HeaderId http_parser::string_to_header_id(std::string_view name) {
+  if (name.empty() || name.size() > maxKnownLength) {
+    return HeaderId::UNKOWN;
+  }
+  const LengthBuckets &buckets = lengthBuckets();
+  for (unsigned char i = 0; i < buckets.counts[name.size()]; i++) {
+    HeaderId id = buckets.ids[name.size()][i];
+    if (header_name_equals(headerNames[static_cast<std::size_t>(id)], name)) {
+      return id;
+    }
+  }
+  return HeaderId::UNKOWN;
+}
+
+std::string_view http_parser::header_id_to_string(HeaderId id) {
+  std::size_t index = static_cast<std::size_t>(id);
+  if (index >= headerIdCount) {
+    return std::string_view();
+  }
+  return headerNames[index];
+}
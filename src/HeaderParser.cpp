@@ -0,0 +1,233 @@
+#include "HeaderParser.h"
+#include "OS.h"
+#include <array>
+#include <cctype>
+#include <cstdio>
+
+using http_parser::BasicHeaderParser;
+using http_parser::DefaultParserPolicy;
+using http_parser::HeaderId;
+using http_parser::HeaderParseState;
+using http_parser::HeaderPolicyOf;
+using http_parser::HealthCheckParserPolicy;
+using http_parser::StrictParserPolicy;
+
+namespace {
+
+constexpr unsigned char TOKEN_CHAR = 1;
+constexpr unsigned char VALUE_CHAR = 2;
+
+constexpr std::array<unsigned char, 256> makeCharClasses() {
+  std::array<unsigned char, 256> classes{};
+  const char *tokenSpecials = "!#$%&'*+-.^_`|~";
+  for (int c = 0; c < 256; c++) {
+    bool alnum = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+                 (c >= 'A' && c <= 'Z');
+    bool special = false;
+    for (const char *p = tokenSpecials; *p; ++p) {
+      special = special || c == *p;
+    }
+    if (alnum || special) {
+      classes[c] |= TOKEN_CHAR;
+    }
+    // field-vchar, obs-text and the whitespace allowed inside a value
+    if ((c >= 0x21 && c <= 0x7e) || c >= 0x80 || c == ' ' || c == '\t') {
+      classes[c] |= VALUE_CHAR;
+    }
+  }
+  return classes;
+}
+
+constexpr std::array<unsigned char, 256> charClasses = makeCharClasses();
+
+inline bool isClass(char c, unsigned char cls) {
+  return (charClasses[static_cast<unsigned char>(c)] & cls) != 0;
+}
+
+} // namespace
+
+template <typename Policy>
+BasicHeaderParser<Policy>::BasicHeaderParser()
+    : currentParseState(HeaderParseState::HEADER_KEY),
+      expect{Expectation::NONE}, currentHeaderId{HeaderId::UNKOWN},
+      keyLength{0} {}
+
+template <typename Policy> void BasicHeaderParser<Policy>::reset() {
+  currentParseState = HeaderParseState::HEADER_KEY;
+  headerList.clear();
+  seenHeaders.reset();
+  connectionOptions = ConnectionOptions();
+  expect = Expectation::NONE;
+  currentHeaderKey.clear();
+  currentHeaderValue.clear();
+  keyLength = 0;
+  errorMessage.clear();
+}
+
+template <typename Policy>
+std::size_t BasicHeaderParser<Policy>::execute(const char *data,
+                                               std::size_t length) {
+  char cr = 13; // ASCII value for carriage return
+  char lf = 10; // ASCII value for line feed
+  const char *p = data;
+  const char *end = data + length;
+  while (p < end) {
+    char nextChar = *p;
+    switch (currentParseState) {
+    case HeaderParseState::HEADER_KEY: {
+      const char *run = p;
+      while (run < end && isClass(*run, TOKEN_CHAR)) {
+        run++;
+      }
+      if (run != p) {
+        if constexpr (Policy::identifyHeaders) {
+          if constexpr (Policy::lowercaseHeaderKeys) {
+            for (const char *c = p; c < run; ++c) {
+              unsigned char keyChar = static_cast<unsigned char>(*c);
+              currentHeaderKey += static_cast<char>(std::tolower(keyChar));
+            }
+          } else {
+            currentHeaderKey.append(p, static_cast<std::size_t>(run - p));
+          }
+        }
+        keyLength += static_cast<std::size_t>(run - p);
+        p = run;
+      } else if (nextChar == ':' && keyLength > 0) {
+        if constexpr (Policy::identifyHeaders) {
+          currentHeaderId = string_to_header_id(currentHeaderKey);
+        }
+        currentParseState = HeaderParseState::HEADER_DELIMITER;
+        p++;
+      } else if (nextChar == cr && keyLength == 0) {
+        currentParseState = HeaderParseState::END_OF_HEADER_LF;
+        p++;
+      } else if (!Policy::requireCRLF && nextChar == lf && keyLength == 0) {
+        currentParseState = HeaderParseState::DONE;
+        return static_cast<std::size_t>(p + 1 - data);
+      } else {
+        fail("Invalid header key : " + currentHeaderKey +
+             " , contains invalid character with ascii value : " +
+             std::to_string(static_cast<int>(nextChar)));
+        return static_cast<std::size_t>(p - data);
+      }
+      break;
+    }
+    case HeaderParseState::HEADER_DELIMITER:
+      // optional whitespace between the colon and the value
+      if (nextChar == ' ' || nextChar == '\t') {
+        p++;
+      } else {
+        currentParseState = HeaderParseState::HEADER_VALUE;
+      }
+      break;
+    case HeaderParseState::HEADER_VALUE: {
+      const char *run = p;
+      while (run < end && isClass(*run, VALUE_CHAR)) {
+        run++;
+      }
+      if (run != p) {
+        if constexpr (Policy::storeHeaders) {
+          currentHeaderValue.append(p, static_cast<std::size_t>(run - p));
+        } else if constexpr (Policy::identifyHeaders) {
+          // the connection semantics need these values even when headers
+          // aren't stored
+          if (currentHeaderId == HeaderId::CONNECTION ||
+              currentHeaderId == HeaderId::EXPECT) {
+            currentHeaderValue.append(p, static_cast<std::size_t>(run - p));
+          }
+        }
+        p = run;
+      } else if (nextChar == cr) {
+        currentParseState = HeaderParseState::HEADER_LINE_END_LF;
+        p++;
+      } else if (!Policy::requireCRLF && nextChar == lf) {
+        commitHeader();
+        p++;
+      } else {
+        fail("Invalid value for header : " + currentHeaderKey +
+             " , contains invalid character with ascii value : " +
+             std::to_string(static_cast<int>(nextChar)));
+        return static_cast<std::size_t>(p - data);
+      }
+      break;
+    }
+    case HeaderParseState::HEADER_LINE_END_LF:
+      if (nextChar == lf) {
+        commitHeader();
+        p++;
+      } else {
+        fail("Header : " + currentHeaderKey +
+             " doesnot contain line feed after carriage return, it contains "
+             "character with ascii value : " +
+             std::to_string(static_cast<int>(nextChar)));
+        return static_cast<std::size_t>(p - data);
+      }
+      break;
+    case HeaderParseState::END_OF_HEADER_LF:
+      if (nextChar == lf) {
+        currentParseState = HeaderParseState::DONE;
+        return static_cast<std::size_t>(p + 1 - data);
+      }
+      fail("Headers doesnot contain line ending after all the headers, it "
+           "contains character with ascii value : " +
+           std::to_string(static_cast<int>(nextChar)));
+      return static_cast<std::size_t>(p - data);
+    case HeaderParseState::DONE:
+    case HeaderParseState::PARSE_ERROR:
+      return static_cast<std::size_t>(p - data);
+    }
+  }
+  return static_cast<std::size_t>(p - data);
+}
+
+template <typename Policy>
+bool BasicHeaderParser<Policy>::parse(int file_descriptor) {
+  char nextChar;
+  while (!done() && !failed()) {
+    int bytesRead = ::read(file_descriptor, &nextChar, 1);
+    if (bytesRead <= 0) {
+      perror("Error reading from file discriptor");
+      return false;
+    }
+    execute(&nextChar, 1);
+  }
+  return done();
+}
+
+template <typename Policy> void BasicHeaderParser<Policy>::commitHeader() {
+  currentParseState = HeaderParseState::HEADER_KEY;
+  keyLength = 0;
+  if constexpr (Policy::identifyHeaders) {
+    HeaderId id = currentHeaderId;
+    seenHeaders.set(static_cast<std::size_t>(id));
+    // leading whitespace was skipped, trailing whitespace is dropped here
+    std::size_t valueEnd = currentHeaderValue.find_last_not_of(" \t");
+    currentHeaderValue.erase(valueEnd == std::string::npos ? 0 : valueEnd + 1);
+    if (id == HeaderId::CONNECTION) {
+      add_connection_options(currentHeaderValue, connectionOptions);
+    } else if (id == HeaderId::EXPECT) {
+      add_expectations(currentHeaderValue, expect);
+    }
+    if constexpr (Policy::storeHeaders) {
+      if (!headerList.add(id, currentHeaderKey, currentHeaderValue)) {
+        fail("Header key : " + currentHeaderKey + " is too long");
+      }
+    }
+    currentHeaderValue.clear();
+    currentHeaderKey.clear();
+  }
+}
+
+template <typename Policy>
+void BasicHeaderParser<Policy>::fail(const std::string &message) {
+  currentParseState = HeaderParseState::PARSE_ERROR;
+  errorMessage = message;
+  currentHeaderKey.clear();
+  currentHeaderValue.clear();
+}
+
+namespace http_parser {
+template class BasicHeaderParser<HeaderPolicyOf<DefaultParserPolicy>>;
+template class BasicHeaderParser<HeaderPolicyOf<StrictParserPolicy>>;
+template class BasicHeaderParser<HeaderPolicyOf<HealthCheckParserPolicy>>;
+}; // namespace http_parser
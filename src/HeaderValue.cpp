@@ -0,0 +1,153 @@
+#include "HeaderValue.hpp"
+#include "HeaderList.hpp"
+#include "Text.h"
+
+using http_parser::Parameter;
+using http_parser::Parameters;
+using http_parser::TokenList;
+using http_parser::detail::trim;
+
+namespace {
+
+// Position of the first `delimiter` outside of quoted strings, npos if
+// there is none.
+std::size_t findUnquoted(std::string_view text, char delimiter) {
+  bool quoted = false;
+  for (std::size_t i = 0; i < text.size(); i++) {
+    char c = text[i];
+    if (quoted) {
+      if (c == '\\') {
+        i++;
+      } else if (c == '"') {
+        quoted = false;
+      }
+    } else if (c == '"') {
+      quoted = true;
+    } else if (c == delimiter) {
+      return i;
+    }
+  }
+  return std::string_view::npos;
+}
+
+// Takes the text up to the next unquoted `delimiter` off `remaining`.
+std::string_view nextItem(std::string_view &remaining, char delimiter) {
+  std::size_t end = findUnquoted(remaining, delimiter);
+  std::string_view item = remaining.substr(0, end);
+  remaining = end == std::string_view::npos ? remaining.substr(remaining.size())
+                                            : remaining.substr(end + 1);
+  return trim(item);
+}
+
+} // namespace
+
+TokenList::const_iterator::const_iterator(std::string_view remaining)
+    : remaining(remaining), atEnd(false) {
+  ++*this;
+}
+
+TokenList::const_iterator &TokenList::const_iterator::operator++() {
+  while (!remaining.empty()) {
+    current = nextItem(remaining, ',');
+    if (!current.empty()) {
+      return *this;
+    }
+  }
+  atEnd = true;
+  current = std::string_view();
+  return *this;
+}
+
+bool TokenList::contains(std::string_view token) const {
+  for (std::string_view element : *this) {
+    if (http_parser::header_name_equals(element, token)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+Parameters::const_iterator::const_iterator(std::string_view remaining)
+    : remaining(remaining), atEnd(false) {
+  ++*this;
+}
+
+Parameters::const_iterator &Parameters::const_iterator::operator++() {
+  while (!remaining.empty()) {
+    std::string_view item = nextItem(remaining, ';');
+    if (item.empty()) {
+      continue;
+    }
+    std::size_t equals = item.find('=');
+    current.name = trim(item.substr(0, equals));
+    current.value = equals == std::string_view::npos
+                        ? item.substr(item.size())
+                        : trim(item.substr(equals + 1));
+    current.quoted = current.value.size() >= 2 &&
+                     current.value.front() == '"' &&
+                     current.value.back() == '"';
+    if (current.quoted) {
+      current.value = current.value.substr(1, current.value.size() - 2);
+    }
+    return *this;
+  }
+  atEnd = true;
+  current = Parameter{};
+  return *this;
+}
+
+bool Parameters::find(std::string_view name, std::string_view &value) const {
+  for (const Parameter &parameter : *this) {
+    if (http_parser::header_name_equals(parameter.name, name)) {
+      value = parameter.value;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string_view http_parser::split_parameters(std::string_view element,
+                                               Parameters &parameters) {
+  std::size_t semicolon = findUnquoted(element, ';');
+  if (semicolon == std::string_view::npos) {
+    parameters = Parameters();
+    return trim(element);
+  }
+  parameters = Parameters(element.substr(semicolon + 1));
+  return trim(element.substr(0, semicolon));
+}
+
+bool http_parser::parse_qvalue(std::string_view text, std::uint16_t &q) {
+  // qvalue = ( "0" [ "." 0*3DIGIT ] ) / ( "1" [ "." 0*3("0") ] )
+  if (text.empty() || text.size() > 5 || (text[0] != '0' && text[0] != '1')) {
+    return false;
+  }
+  if (text.size() > 1 && text[1] != '.') {
+    return false;
+  }
+  std::uint16_t value = static_cast<std::uint16_t>(text[0] - '0') * 1000;
+  std::uint16_t scale = 100;
+  for (std::size_t i = 2; i < text.size(); i++, scale /= 10) {
+    if (text[i] < '0' || text[i] > '9') {
+      return false;
+    }
+    value += static_cast<std::uint16_t>(text[i] - '0') * scale;
+  }
+  if (value > 1000) {
+    return false;
+  }
+  q = value;
+  return true;
+}
+
+std::string_view http_parser::weighted_element(std::string_view element,
+                                               std::uint16_t &q) {
+  Parameters parameters;
+  std::string_view value = split_parameters(element, parameters);
+  q = 1000;
+  std::string_view weight;
+  if (parameters.find("q", weight) && !parse_qvalue(weight, q)) {
+    q = 0;
+  }
+  return value;
+}
@@ -0,0 +1,936 @@
+#include "Hpack.hpp"
+#include <cstring>
+
+using http_parser::HeaderId;
+using http_parser::HPACK_STATIC_TABLE_ENTRIES;
+
+namespace {
+
+struct StaticEntry {
+  std::string_view name;
+  std::string_view value;
+};
+
+struct HuffmanCode {
+  std::uint32_t code;
+  std::uint8_t bits;
+};
+
+// appendix A, index 1 is the first entry
+constexpr StaticEntry staticTable[HPACK_STATIC_TABLE_ENTRIES] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+};
+
+// appendix B, indexed by symbol, 256 is EOS
+constexpr HuffmanCode huffmanCodes[257] = {
+    {0x1ff8, 13}, {0x7fffd8, 23}, {0xfffffe2, 28}, {0xfffffe3, 28},
+    {0xfffffe4, 28}, {0xfffffe5, 28}, {0xfffffe6, 28}, {0xfffffe7, 28},
+    {0xfffffe8, 28}, {0xffffea, 24}, {0x3ffffffc, 30}, {0xfffffe9, 28},
+    {0xfffffea, 28}, {0x3ffffffd, 30}, {0xfffffeb, 28}, {0xfffffec, 28},
+    {0xfffffed, 28}, {0xfffffee, 28}, {0xfffffef, 28}, {0xffffff0, 28},
+    {0xffffff1, 28}, {0xffffff2, 28}, {0x3ffffffe, 30}, {0xffffff3, 28},
+    {0xffffff4, 28}, {0xffffff5, 28}, {0xffffff6, 28}, {0xffffff7, 28},
+    {0xffffff8, 28}, {0xffffff9, 28}, {0xffffffa, 28}, {0xffffffb, 28},
+    {0x14, 6}, {0x3f8, 10}, {0x3f9, 10}, {0xffa, 12},
+    {0x1ff9, 13}, {0x15, 6}, {0xf8, 8}, {0x7fa, 11},
+    {0x3fa, 10}, {0x3fb, 10}, {0xf9, 8}, {0x7fb, 11},
+    {0xfa, 8}, {0x16, 6}, {0x17, 6}, {0x18, 6},
+    {0x0, 5}, {0x1, 5}, {0x2, 5}, {0x19, 6},
+    {0x1a, 6}, {0x1b, 6}, {0x1c, 6}, {0x1d, 6},
+    {0x1e, 6}, {0x1f, 6}, {0x5c, 7}, {0xfb, 8},
+    {0x7ffc, 15}, {0x20, 6}, {0xffb, 12}, {0x3fc, 10},
+    {0x1ffa, 13}, {0x21, 6}, {0x5d, 7}, {0x5e, 7},
+    {0x5f, 7}, {0x60, 7}, {0x61, 7}, {0x62, 7},
+    {0x63, 7}, {0x64, 7}, {0x65, 7}, {0x66, 7},
+    {0x67, 7}, {0x68, 7}, {0x69, 7}, {0x6a, 7},
+    {0x6b, 7}, {0x6c, 7}, {0x6d, 7}, {0x6e, 7},
+    {0x6f, 7}, {0x70, 7}, {0x71, 7}, {0x72, 7},
+    {0xfc, 8}, {0x73, 7}, {0xfd, 8}, {0x1ffb, 13},
+    {0x7fff0, 19}, {0x1ffc, 13}, {0x3ffc, 14}, {0x22, 6},
+    {0x7ffd, 15}, {0x3, 5}, {0x23, 6}, {0x4, 5},
+    {0x24, 6}, {0x5, 5}, {0x25, 6}, {0x26, 6},
+    {0x27, 6}, {0x6, 5}, {0x74, 7}, {0x75, 7},
+    {0x28, 6}, {0x29, 6}, {0x2a, 6}, {0x7, 5},
+    {0x2b, 6}, {0x76, 7}, {0x2c, 6}, {0x8, 5},
+    {0x9, 5}, {0x2d, 6}, {0x77, 7}, {0x78, 7},
+    {0x79, 7}, {0x7a, 7}, {0x7b, 7}, {0x7ffe, 15},
+    {0x7fc, 11}, {0x3ffd, 14}, {0x1ffd, 13}, {0xffffffc, 28},
+    {0xfffe6, 20}, {0x3fffd2, 22}, {0xfffe7, 20}, {0xfffe8, 20},
+    {0x3fffd3, 22}, {0x3fffd4, 22}, {0x3fffd5, 22}, {0x7fffd9, 23},
+    {0x3fffd6, 22}, {0x7fffda, 23}, {0x7fffdb, 23}, {0x7fffdc, 23},
+    {0x7fffdd, 23}, {0x7fffde, 23}, {0xffffeb, 24}, {0x7fffdf, 23},
+    {0xffffec, 24}, {0xffffed, 24}, {0x3fffd7, 22}, {0x7fffe0, 23},
+    {0xffffee, 24}, {0x7fffe1, 23}, {0x7fffe2, 23}, {0x7fffe3, 23},
+    {0x7fffe4, 23}, {0x1fffdc, 21}, {0x3fffd8, 22}, {0x7fffe5, 23},
+    {0x3fffd9, 22}, {0x7fffe6, 23}, {0x7fffe7, 23}, {0xffffef, 24},
+    {0x3fffda, 22}, {0x1fffdd, 21}, {0xfffe9, 20}, {0x3fffdb, 22},
+    {0x3fffdc, 22}, {0x7fffe8, 23}, {0x7fffe9, 23}, {0x1fffde, 21},
+    {0x7fffea, 23}, {0x3fffdd, 22}, {0x3fffde, 22}, {0xfffff0, 24},
+    {0x1fffdf, 21}, {0x3fffdf, 22}, {0x7fffeb, 23}, {0x7fffec, 23},
+    {0x1fffe0, 21}, {0x1fffe1, 21}, {0x3fffe0, 22}, {0x1fffe2, 21},
+    {0x7fffed, 23}, {0x3fffe1, 22}, {0x7fffee, 23}, {0x7fffef, 23},
+    {0xfffea, 20}, {0x3fffe2, 22}, {0x3fffe3, 22}, {0x3fffe4, 22},
+    {0x7ffff0, 23}, {0x3fffe5, 22}, {0x3fffe6, 22}, {0x7ffff1, 23},
+    {0x3ffffe0, 26}, {0x3ffffe1, 26}, {0xfffeb, 20}, {0x7fff1, 19},
+    {0x3fffe7, 22}, {0x7ffff2, 23}, {0x3fffe8, 22}, {0x1ffffec, 25},
+    {0x3ffffe2, 26}, {0x3ffffe3, 26}, {0x3ffffe4, 26}, {0x7ffffde, 27},
+    {0x7ffffdf, 27}, {0x3ffffe5, 26}, {0xfffff1, 24}, {0x1ffffed, 25},
+    {0x7fff2, 19}, {0x1fffe3, 21}, {0x3ffffe6, 26}, {0x7ffffe0, 27},
+    {0x7ffffe1, 27}, {0x3ffffe7, 26}, {0x7ffffe2, 27}, {0xfffff2, 24},
+    {0x1fffe4, 21}, {0x1fffe5, 21}, {0x3ffffe8, 26}, {0x3ffffe9, 26},
+    {0xffffffd, 28}, {0x7ffffe3, 27}, {0x7ffffe4, 27}, {0x7ffffe5, 27},
+    {0xfffec, 20}, {0xfffff3, 24}, {0xfffed, 20}, {0x1fffe6, 21},
+    {0x3fffe9, 22}, {0x1fffe7, 21}, {0x1fffe8, 21}, {0x7ffff3, 23},
+    {0x3fffea, 22}, {0x3fffeb, 22}, {0x1ffffee, 25}, {0x1ffffef, 25},
+    {0xfffff4, 24}, {0xfffff5, 24}, {0x3ffffea, 26}, {0x7ffff4, 23},
+    {0x3ffffeb, 26}, {0x7ffffe6, 27}, {0x3ffffec, 26}, {0x3ffffed, 26},
+    {0x7ffffe7, 27}, {0x7ffffe8, 27}, {0x7ffffe9, 27}, {0x7ffffea, 27},
+    {0x7ffffeb, 27}, {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27},
+    {0x7ffffee, 27}, {0x7ffffef, 27}, {0x7fffff0, 27}, {0x3ffffee, 26},
+    {0x3fffffff, 30},
+};
+
+constexpr std::size_t entryOverhead = 32;
+constexpr std::uint16_t eos = 256;
+constexpr std::uint64_t maxInteger = UINT32_MAX;
+
+// Static entries grouped by name length; entries sharing a name are adjacent
+// in appendix A, so a bucket stores the first index and the run length.
+constexpr std::size_t maxStaticNameLength = 27;
+constexpr std::size_t staticBucketSize = 8;
+
+struct StaticNameBuckets {
+  struct Run {
+    std::uint8_t first;
+    std::uint8_t count;
+  };
+  Run runs[maxStaticNameLength + 1][staticBucketSize] = {};
+  unsigned char counts[maxStaticNameLength + 1] = {};
+
+  StaticNameBuckets() {
+    for (std::size_t i = 0; i < HPACK_STATIC_TABLE_ENTRIES; i++) {
+      std::size_t length = staticTable[i].name.size();
+      if (i > 0 && staticTable[i - 1].name == staticTable[i].name) {
+        ++runs[length][counts[length] - 1].count;
+        continue;
+      }
+      runs[length][counts[length]++] = Run{static_cast<std::uint8_t>(i), 1};
+    }
+  }
+};
+
+const StaticNameBuckets &staticNameBuckets() {
+  static const StaticNameBuckets buckets;
+  return buckets;
+}
+
+// Decoder state table: a state is an inner node of the code tree, the
+// input is consumed one nibble at a time. No code is shorter than five bits,
+// so a nibble completes at most one symbol.
+enum HuffmanFlags : std::uint8_t {
+  EMIT = 1,   // `symbol` was completed by the nibble
+  ACCEPT = 2, // the bits since the last symbol are valid padding
+  FAIL = 4,   // EOS was decoded or the code does not exist
+};
+
+struct HuffmanTransition {
+  std::uint8_t next;
+  std::uint8_t flags;
+  std::uint8_t symbol;
+};
+
+struct HuffmanDecodeTable {
+  HuffmanTransition transitions[256][16] = {};
+
+  HuffmanDecodeTable() {
+    // code tree, 257 leaves need exactly 256 inner nodes
+    constexpr std::int16_t none = -1;
+    std::int16_t children[256][2];
+    std::int16_t leaves[256][2];
+    std::uint8_t depth[256] = {};
+    bool allOnes[256] = {};
+    std::memset(children, 0xff, sizeof(children));
+    std::memset(leaves, 0xff, sizeof(leaves));
+    std::size_t nodes = 1;
+    allOnes[0] = true;
+    for (std::uint16_t symbol = 0; symbol <= eos; symbol++) {
+      const HuffmanCode &code = huffmanCodes[symbol];
+      std::size_t node = 0;
+      for (int bit = code.bits - 1; bit > 0; bit--) {
+        int branch = (code.code >> bit) & 1;
+        if (children[node][branch] == none) {
+          children[node][branch] = static_cast<std::int16_t>(nodes);
+          depth[nodes] = static_cast<std::uint8_t>(depth[node] + 1);
+          allOnes[nodes] = allOnes[node] && branch == 1;
+          ++nodes;
+        }
+        node = static_cast<std::size_t>(children[node][branch]);
+      }
+      leaves[node][code.code & 1] = static_cast<std::int16_t>(symbol);
+    }
+
+    for (std::size_t state = 0; state < nodes; state++) {
+      for (unsigned nibble = 0; nibble < 16; nibble++) {
+        HuffmanTransition &transition = transitions[state][nibble];
+        std::size_t node = state;
+        for (int bit = 3; bit >= 0; bit--) {
+          int branch = (nibble >> bit) & 1;
+          if (children[node][branch] != none) {
+            node = static_cast<std::size_t>(children[node][branch]);
+            continue;
+          }
+          std::int16_t symbol = leaves[node][branch];
+          if (symbol == none || symbol == eos) {
+            transition.flags = FAIL;
+            break;
+          }
+          transition.flags |= EMIT;
+          transition.symbol = static_cast<std::uint8_t>(symbol);
+          node = 0;
+        }
+        if (transition.flags & FAIL) {
+          continue;
+        }
+        transition.next = static_cast<std::uint8_t>(node);
+        if (allOnes[node] && depth[node] < 8) {
+          transition.flags |= ACCEPT;
+        }
+      }
+    }
+  }
+};
+
+const HuffmanDecodeTable &huffmanDecodeTable() {
+  static const HuffmanDecodeTable table;
+  return table;
+}
+
+// Writes an integer with an N bit prefix (section 5.1), `first` carries the
+// representation bits above the prefix.
+void writeInteger(std::string &out, unsigned char first, unsigned prefixBits,
+                  std::uint64_t value) {
+  std::uint64_t limit = (1u << prefixBits) - 1;
+  if (value < limit) {
+    out.push_back(static_cast<char>(first | value));
+    return;
+  }
+  out.push_back(static_cast<char>(first | limit));
+  value -= limit;
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+// Values above 2^32 are refused, no table or string gets that large.
+bool readInteger(const unsigned char *&p, const unsigned char *end,
+                 unsigned prefixBits, std::uint64_t &value) {
+  std::uint64_t limit = (1u << prefixBits) - 1;
+  value = *p++ & limit;
+  if (value < limit) {
+    return true;
+  }
+  for (unsigned shift = 0; p != end; shift += 7) {
+    if (shift > 28) {
+      return false;
+    }
+    unsigned char byte = *p++;
+    value += static_cast<std::uint64_t>(byte & 0x7f) << shift;
+    if (value > maxInteger) {
+      return false;
+    }
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void writeString(std::string &out, std::string_view in) {
+  std::size_t huffmanSize = http_parser::hpack_huffman_encoded_size(in);
+  if (huffmanSize < in.size()) {
+    writeInteger(out, 0x80, 7, huffmanSize);
+    http_parser::hpack_huffman_encode(in, out);
+    return;
+  }
+  writeInteger(out, 0, 7, in.size());
+  out.append(in.data(), in.size());
+}
+
+std::size_t roundUpPowerOfTwo(std::size_t n) {
+  std::size_t size = 8;
+  while (size < n) {
+    size <<= 1;
+  }
+  return size;
+}
+
+// Fields a HTTP/2 message must not carry (RFC 9113 section 8.2.2), TE is
+// allowed with the value "trailers" only.
+bool isConnectionSpecific(HeaderId id, std::string_view value) {
+  switch (id) {
+  case HeaderId::CONNECTION:
+  case HeaderId::PROXY_CONNECTION:
+  case HeaderId::KEEP_ALIVE:
+  case HeaderId::TRANSFER_ENCODING:
+  case HeaderId::UPGRADE:
+  case HeaderId::HTTP2_SETTINGS:
+    return true;
+  case HeaderId::TE:
+    return value != "trailers";
+  default:
+    return false;
+  }
+}
+
+bool isLowerToken(std::string_view name) {
+  if (name.empty()) {
+    return false;
+  }
+  for (char c : name) {
+    unsigned char u = static_cast<unsigned char>(c);
+    if (u <= 0x20 || u >= 0x7f || (c >= 'A' && c <= 'Z') || c == ':' ||
+        std::strchr("\"(),/;<=>?@[\\]{}", c) != nullptr) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool isFieldValue(std::string_view value) {
+  for (char c : value) {
+    if (c == '\0' || c == '\r' || c == '\n') {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+std::size_t http_parser::hpack_huffman_encoded_size(std::string_view in) {
+  std::size_t bits = 0;
+  for (char c : in) {
+    bits += huffmanCodes[static_cast<unsigned char>(c)].bits;
+  }
+  return (bits + 7) / 8;
+}
+
+void http_parser::hpack_huffman_encode(std::string_view in,
+                                       std::string &out) {
+  // codes are at most 30 bits, so 32 pending bits always leave room
+  std::uint64_t pending = 0;
+  unsigned pendingBits = 0;
+  for (char c : in) {
+    const HuffmanCode &code = huffmanCodes[static_cast<unsigned char>(c)];
+    pending = (pending << code.bits) | code.code;
+    pendingBits += code.bits;
+    while (pendingBits >= 8) {
+      pendingBits -= 8;
+      out.push_back(static_cast<char>(pending >> pendingBits));
+    }
+  }
+  if (pendingBits > 0) {
+    // padded with the most significant bits of EOS
+    out.push_back(static_cast<char>((pending << (8 - pendingBits)) |
+                                    (0xff >> pendingBits)));
+  }
+}
+
+bool http_parser::hpack_huffman_decode(std::string_view in,
+                                       std::string &out) {
+  const HuffmanDecodeTable &table = huffmanDecodeTable();
+  out.reserve(out.size() + in.size() * 8 / 5);
+  std::uint8_t state = 0;
+  std::uint8_t flags = ACCEPT;
+  for (char c : in) {
+    unsigned byte = static_cast<unsigned char>(c);
+    const unsigned nibbles[2] = {byte >> 4, byte & 0x0f};
+    for (unsigned nibble : nibbles) {
+      const HuffmanTransition &transition = table.transitions[state][nibble];
+      if (transition.flags & FAIL) {
+        return false;
+      }
+      if (transition.flags & EMIT) {
+        out.push_back(static_cast<char>(transition.symbol));
+      }
+      state = transition.next;
+      flags = transition.flags;
+    }
+  }
+  return (flags & ACCEPT) != 0;
+}
+
+namespace http_parser {
+
+HpackTable::HpackTable(std::size_t maxSize)
+    : ring(8), newest(0), entryCount(0), octets(0), maxOctets(maxSize) {}
+
+void HpackTable::set_max_size(std::size_t maxSize) {
+  maxOctets = maxSize;
+  while (octets > maxOctets) {
+    evictOldest();
+  }
+}
+
+void HpackTable::evictOldest() {
+  const Entry &oldest = at(entryCount - 1);
+  octets -= oldest.field.size() + entryOverhead;
+  --entryCount;
+}
+
+void HpackTable::add(std::string_view name, std::string_view value) {
+  std::size_t entrySize = name.size() + value.size() + entryOverhead;
+  while (entryCount > 0 && octets + entrySize > maxOctets) {
+    evictOldest();
+  }
+  if (entrySize > maxOctets) {
+    return;
+  }
+  if (entryCount == ring.size()) {
+    // keep entry i at (newest - i), the strings move with their storage
+    std::vector<Entry> grown(roundUpPowerOfTwo(ring.size() * 2));
+    for (std::size_t i = 0; i < entryCount; i++) {
+      grown[entryCount - 1 - i] =
+          std::move(ring[(newest - i) & (ring.size() - 1)]);
+    }
+    ring.swap(grown);
+    newest = entryCount - 1;
+  }
+  // the slot of an evicted entry keeps its capacity, so a warmed up table
+  // replaces fields without allocating
+  newest = (newest + 1) & (ring.size() - 1);
+  Entry &entry = ring[newest];
+  entry.field.assign(name.data(), name.size());
+  entry.field.append(value.data(), value.size());
+  entry.nameLength = name.size();
+  octets += entrySize;
+  ++entryCount;
+}
+
+HpackDecoder::HpackDecoder(std::size_t maxTableSize)
+    : dynamicTable(maxTableSize), maxTableSize(maxTableSize),
+      maxHeaderList(DEFAULT_MAX_HEADER_LIST_SIZE), compressionError(false) {}
+
+void HpackDecoder::set_max_table_size(std::size_t size) {
+  maxTableSize = size;
+  if (dynamicTable.max_size() > size) {
+    dynamicTable.set_max_size(size);
+  }
+}
+
+bool HpackDecoder::fail(const char *message) {
+  compressionError = true;
+  errorMessage = message;
+  return false;
+}
+
+bool HpackDecoder::malformed(const std::string &message) {
+  errorMessage = message;
+  return false;
+}
+
+bool HpackDecoder::readString(const unsigned char *&p,
+                              const unsigned char *end, std::string &out) {
+  if (p == end) {
+    return fail("Truncated string literal");
+  }
+  bool huffman = (*p & 0x80) != 0;
+  std::uint64_t length;
+  if (!readInteger(p, end, 7, length)) {
+    return fail("Invalid string length");
+  }
+  if (length > static_cast<std::uint64_t>(end - p)) {
+    return fail("Truncated string literal");
+  }
+  std::string_view raw(reinterpret_cast<const char *>(p),
+                       static_cast<std::size_t>(length));
+  p += length;
+  out.clear();
+  if (!huffman) {
+    out.assign(raw.data(), raw.size());
+    return true;
+  }
+  if (!hpack_huffman_decode(raw, out)) {
+    return fail("Invalid Huffman code");
+  }
+  return true;
+}
+
+bool HpackDecoder::field(std::size_t index, std::string_view &fieldName,
+                         std::string_view &fieldValue) const {
+  if (index == 0) {
+    return false;
+  }
+  if (index <= HPACK_STATIC_TABLE_ENTRIES) {
+    fieldName = staticTable[index - 1].name;
+    fieldValue = staticTable[index - 1].value;
+    return true;
+  }
+  index -= HPACK_STATIC_TABLE_ENTRIES + 1;
+  if (index >= dynamicTable.count()) {
+    return false;
+  }
+  fieldName = dynamicTable.name(index);
+  fieldValue = dynamicTable.value(index);
+  return true;
+}
+
+bool HpackDecoder::decode(const char *data, std::size_t length,
+                          Headers &headers) {
+  compressionError = false;
+  errorMessage.clear();
+  const unsigned char *p = reinterpret_cast<const unsigned char *>(data);
+  const unsigned char *end = p + length;
+  bool sizeUpdateAllowed = true;
+  bool tooLarge = false;
+  std::size_t listSize = 0;
+
+  while (p != end) {
+    unsigned char first = *p;
+    std::uint64_t index;
+    std::string_view fieldName;
+    std::string_view fieldValue;
+
+    if (first & 0x80) {
+      // indexed header field
+      if (!readInteger(p, end, 7, index) ||
+          !field(static_cast<std::size_t>(index), fieldName, fieldValue)) {
+        return fail("Invalid header field index");
+      }
+    } else if ((first & 0xe0) == 0x20) {
+      // dynamic table size update, only ahead of the first field
+      if (!sizeUpdateAllowed) {
+        return fail("Table size update after a header field");
+      }
+      std::uint64_t size;
+      if (!readInteger(p, end, 5, size) || size > maxTableSize) {
+        return fail("Table size update above the announced limit");
+      }
+      dynamicTable.set_max_size(static_cast<std::size_t>(size));
+      continue;
+    } else {
+      // literal with incremental indexing, without indexing or never indexed
+      bool indexing = (first & 0x40) != 0;
+      if (!readInteger(p, end, indexing ? 6 : 4, index)) {
+        return fail("Invalid header field index");
+      }
+      if (index == 0) {
+        if (!readString(p, end, name)) {
+          return false;
+        }
+      } else {
+        // copied, adding the field below may evict the entry it names
+        std::string_view indexedName;
+        if (!field(static_cast<std::size_t>(index), indexedName, fieldValue)) {
+          return fail("Invalid header field index");
+        }
+        name.assign(indexedName.data(), indexedName.size());
+      }
+      if (!readString(p, end, value)) {
+        return false;
+      }
+      if (indexing) {
+        dynamicTable.add(name, value);
+      }
+      fieldName = name;
+      fieldValue = value;
+    }
+    sizeUpdateAllowed = false;
+
+    // the rest of an oversized block is still decoded to keep the table in
+    // sync with the encoder
+    listSize += fieldName.size() + fieldValue.size() + entryOverhead;
+    if (listSize > maxHeaderList) {
+      tooLarge = true;
+    }
+    if (!tooLarge && !headers.add(fieldName, fieldValue)) {
+      tooLarge = true;
+    }
+  }
+  if (tooLarge) {
+    return malformed("Header list too large");
+  }
+  return true;
+}
+
+bool HpackDecoder::decode_request(const char *data, std::size_t length,
+                                  Request &request) {
+  fields.clear();
+  if (!decode(data, length, fields)) {
+    return false;
+  }
+  request.headers.clear();
+  request.url.clear();
+  request.method = Method::METHOD_UNKOWN;
+  request.version = Version::HTTP_2;
+  request.keep_alive = true;
+  request.expectation = Expectation::NONE;
+
+  std::string_view method;
+  std::string_view scheme;
+  std::string_view authority;
+  std::string_view path;
+  bool regular = false;
+  std::string cookie;
+  for (HeaderView header : fields) {
+    if (!header.key.empty() && header.key[0] == ':') {
+      std::string_view *pseudo = nullptr;
+      if (header.key == ":method") {
+        pseudo = &method;
+      } else if (header.key == ":scheme") {
+        pseudo = &scheme;
+      } else if (header.key == ":authority") {
+        pseudo = &authority;
+      } else if (header.key == ":path") {
+        pseudo = &path;
+      }
+      if (pseudo == nullptr || pseudo->data() != nullptr || regular) {
+        return malformed("Invalid pseudo-header field " +
+                         std::string(header.key));
+      }
+      *pseudo = header.value;
+      continue;
+    }
+    regular = true;
+    if (!isLowerToken(header.key) || !isFieldValue(header.value) ||
+        isConnectionSpecific(header.id, header.value)) {
+      return malformed("Invalid header field " + std::string(header.key));
+    }
+    if (header.id == HeaderId::COOKIE) {
+      // crumbs are joined back into one header (RFC 9113 section 8.2.3)
+      if (!cookie.empty()) {
+        cookie += "; ";
+      }
+      cookie.append(header.value.data(), header.value.size());
+      continue;
+    }
+    if (header.id == HeaderId::EXPECT) {
+      add_expectations(header.value, request.expectation);
+    }
+    request.headers.add(header.id, header.key, header.value);
+  }
+
+  if (method.data() == nullptr) {
+    return malformed("Missing :method pseudo-header field");
+  }
+  request.method = string_to_method(std::string(method));
+  if (request.method == Method::METHOD_UNKOWN) {
+    return malformed("Unknown method " + std::string(method));
+  }
+  if (request.method == Method::METHOD_CONNECT) {
+    // authority form, the target is the :authority (section 8.5)
+    if (authority.empty() || scheme.data() != nullptr ||
+        path.data() != nullptr) {
+      return malformed("Invalid CONNECT request");
+    }
+    request.url.assign(authority.data(), authority.size());
+  } else {
+    if (scheme.empty() || path.empty()) {
+      return malformed("Missing :scheme or :path pseudo-header field");
+    }
+    request.url.assign(path.data(), path.size());
+  }
+  if (!authority.empty() && !request.headers.contains(HeaderId::HOST)) {
+    request.headers.add(HeaderId::HOST, "host", authority);
+  }
+  if (!cookie.empty()) {
+    request.headers.add(HeaderId::COOKIE, "cookie", cookie);
+  }
+  return true;
+}
+
+bool HpackDecoder::decode_response(const char *data, std::size_t length,
+                                   Response &response) {
+  fields.clear();
+  if (!decode(data, length, fields)) {
+    return false;
+  }
+  response.headers.clear();
+  response.version = Version::HTTP_2;
+  response.keep_alive = true;
+
+  std::string_view status;
+  bool regular = false;
+  for (HeaderView header : fields) {
+    if (!header.key.empty() && header.key[0] == ':') {
+      if (header.key != ":status" || status.data() != nullptr || regular) {
+        return malformed("Invalid pseudo-header field " +
+                         std::string(header.key));
+      }
+      status = header.value;
+      continue;
+    }
+    regular = true;
+    if (!isLowerToken(header.key) || !isFieldValue(header.value) ||
+        isConnectionSpecific(header.id, header.value)) {
+      return malformed("Invalid header field " + std::string(header.key));
+    }
+    response.headers.add(header.id, header.key, header.value);
+  }
+  if (status.size() != 3 || status[0] < '1' || status[0] > '9' ||
+      status[1] < '0' || status[1] > '9' || status[2] < '0' ||
+      status[2] > '9') {
+    return malformed("Missing or invalid :status pseudo-header field");
+  }
+  response.status_code = string_to_status_code(std::string(status));
+  response.status_message = std::string(
+      status_code_to_reason(response.status_code));
+  return true;
+}
+
+bool HpackDecoder::decode_trailers(const char *data, std::size_t length,
+                                   Headers &trailers) {
+  fields.clear();
+  if (!decode(data, length, fields)) {
+    return false;
+  }
+  trailers.clear();
+  for (HeaderView header : fields) {
+    // pseudo-header fields fail the token check as well
+    if (!isLowerToken(header.key) || !isFieldValue(header.value) ||
+        isConnectionSpecific(header.id, header.value)) {
+      return malformed("Invalid trailer field " + std::string(header.key));
+    }
+    trailers.add(header.id, header.key, header.value);
+  }
+  return true;
+}
+
+HpackEncoder::HpackEncoder(std::size_t maxTableSize)
+    : dynamicTable(maxTableSize), maxTableSize(maxTableSize),
+      pendingMinSize(maxTableSize), pendingSize(maxTableSize),
+      sizeUpdatePending(false) {}
+
+void HpackEncoder::set_max_table_size(std::size_t size) {
+  // the table never grows beyond the size chosen at construction
+  if (size > maxTableSize) {
+    size = maxTableSize;
+  }
+  pendingMinSize = sizeUpdatePending && pendingMinSize < size ? pendingMinSize
+                                                              : size;
+  pendingSize = size;
+  sizeUpdatePending = true;
+}
+
+void HpackEncoder::flushSizeUpdate(std::string &out) {
+  if (!sizeUpdatePending) {
+    return;
+  }
+  // a decrease followed by an increase needs both updates (section 4.2)
+  if (pendingMinSize < pendingSize) {
+    writeInteger(out, 0x20, 5, pendingMinSize);
+    dynamicTable.set_max_size(pendingMinSize);
+  }
+  writeInteger(out, 0x20, 5, pendingSize);
+  dynamicTable.set_max_size(pendingSize);
+  sizeUpdatePending = false;
+}
+
+void HpackEncoder::encode(std::string_view name, std::string_view value,
+                          std::string &out, bool sensitive) {
+  flushSizeUpdate(out);
+
+  // index of an exact match, or of the first entry with the same name
+  std::size_t nameIndex = 0;
+  if (name.size() <= maxStaticNameLength) {
+    const StaticNameBuckets &buckets = staticNameBuckets();
+    for (unsigned char i = 0; i < buckets.counts[name.size()]; i++) {
+      StaticNameBuckets::Run run = buckets.runs[name.size()][i];
+      if (staticTable[run.first].name != name) {
+        continue;
+      }
+      nameIndex = run.first + 1u;
+      for (std::size_t j = run.first; j < run.first + run.count; j++) {
+        if (staticTable[j].value == value && !sensitive) {
+          writeInteger(out, 0x80, 7, j + 1);
+          return;
+        }
+      }
+      break;
+    }
+  }
+  for (std::size_t i = 0; i < dynamicTable.count(); i++) {
+    if (dynamicTable.name(i) != name) {
+      continue;
+    }
+    std::size_t index = HPACK_STATIC_TABLE_ENTRIES + 1 + i;
+    if (!sensitive && dynamicTable.value(i) == value) {
+      writeInteger(out, 0x80, 7, index);
+      return;
+    }
+    if (nameIndex == 0) {
+      nameIndex = index;
+    }
+  }
+
+  // credentials and short cookies are guessable through the compression
+  // ratio, they are never indexed
+  HeaderId id = string_to_header_id(name);
+  if (id == HeaderId::AUTHORIZATION || id == HeaderId::PROXY_AUTHORIZATION ||
+      (id == HeaderId::COOKIE && value.size() < 20)) {
+    sensitive = true;
+  }
+  bool indexing = !sensitive && name.size() + value.size() + entryOverhead <=
+                                    dynamicTable.max_size() * 3 / 4;
+  if (sensitive) {
+    writeInteger(out, 0x10, 4, nameIndex);
+  } else if (indexing) {
+    writeInteger(out, 0x40, 6, nameIndex);
+  } else {
+    writeInteger(out, 0x00, 4, nameIndex);
+  }
+  if (nameIndex == 0) {
+    writeString(out, name);
+  }
+  writeString(out, value);
+  if (indexing) {
+    dynamicTable.add(name, value);
+  }
+}
+
+void HpackEncoder::encode(const Headers &headers, std::string &out) {
+  encodeFields(headers, out, false);
+}
+
+void HpackEncoder::encodeFields(const Headers &headers, std::string &out,
+                                bool skipHost) {
+  for (HeaderView header : headers) {
+    if (isConnectionSpecific(header.id, header.value) ||
+        (skipHost && header.id == HeaderId::HOST)) {
+      continue;
+    }
+    lowered.assign(header.key.data(), header.key.size());
+    for (char &c : lowered) {
+      if (c >= 'A' && c <= 'Z') {
+        c = static_cast<char>(c - 'A' + 'a');
+      }
+    }
+    if (header.id != HeaderId::COOKIE) {
+      encode(lowered, header.value, out);
+      continue;
+    }
+    // crumbs compress better than the whole list (RFC 9113 section 8.2.3)
+    std::string_view cookie = header.value;
+    while (!cookie.empty()) {
+      std::size_t split = cookie.find("; ");
+      encode(lowered, cookie.substr(0, split), out);
+      cookie = split == std::string_view::npos ? std::string_view()
+                                               : cookie.substr(split + 2);
+    }
+  }
+}
+
+void HpackEncoder::encode_request(const Request &request, std::string &out,
+                                  std::string_view scheme) {
+  encode(":method", method_to_string(request.method), out);
+  UrlView target = request.target();
+  std::string_view authority = request.headers.value_of(HeaderId::HOST);
+  if (request.method == Method::METHOD_CONNECT) {
+    encode(":authority", authority.empty() ? target.raw() : authority, out);
+    encodeFields(request.headers, out, true);
+    return;
+  }
+
+  std::string_view path = request.url;
+  std::string absolutePath;
+  if (target.form() == TargetForm::ABSOLUTE) {
+    // split into :scheme, :authority and :path, the fragment is never sent
+    scheme = target.scheme();
+    if (authority.empty()) {
+      authority = target.authority();
+    }
+    path = target.raw().substr(
+        static_cast<std::size_t>(target.path().data() - target.raw().data()));
+    path = path.substr(0, path.find('#'));
+    if (path.empty() || path[0] != '/') {
+      absolutePath = "/";
+      absolutePath.append(path.data(), path.size());
+      path = absolutePath;
+    }
+  }
+  encode(":scheme", scheme, out);
+  if (!authority.empty()) {
+    encode(":authority", authority, out);
+  }
+  encode(":path", path, out);
+  encodeFields(request.headers, out, true);
+}
+
+bool HpackEncoder::encode_response(const Response &response,
+                                   std::string &out) {
+  // the code is sent as its three digits, named or not
+  int code = static_cast<int>(response.status_code);
+  if (code < 100 || code > 999) {
+    return false;
+  }
+  const char status[3] = {static_cast<char>('0' + code / 100),
+                          static_cast<char>('0' + code / 10 % 10),
+                          static_cast<char>('0' + code % 10)};
+  encode(":status", std::string_view(status, sizeof(status)), out);
+  encode(response.headers, out);
+  return true;
+}
+
+}; // namespace http_parser
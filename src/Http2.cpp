@@ -0,0 +1,1053 @@
+#include "Http2.hpp"
+#include "BodyParser.hpp"
+#include "HeaderValue.hpp"
+#include "IoVec.h"
+#include <algorithm>
+#include <cstring>
+
+using http_parser::Http2ErrorCode;
+using http_parser::Http2FrameType;
+using http_parser::HTTP2_PREFACE;
+
+namespace {
+
+enum FrameFlags : std::uint8_t {
+  END_STREAM = 0x1,
+  ACK = 0x1,
+  END_HEADERS = 0x4,
+  PADDED = 0x8,
+  PRIORITY = 0x20,
+};
+
+enum StreamFlags : std::uint8_t {
+  REMOTE_CLOSED = 0x1,
+  LOCAL_CLOSED = 0x2,
+  RESPONSE_SENT = 0x4, // final response headers, data may follow
+};
+
+enum SettingsParameter : std::uint16_t {
+  HEADER_TABLE_SIZE = 0x1,
+  ENABLE_PUSH = 0x2,
+  MAX_CONCURRENT_STREAMS = 0x3,
+  INITIAL_WINDOW_SIZE = 0x4,
+  MAX_FRAME_SIZE = 0x5,
+  MAX_HEADER_LIST_SIZE = 0x6,
+};
+
+constexpr std::uint32_t defaultWindowSize = 65535;
+constexpr std::int64_t maxWindowSize = 0x7fffffff;
+constexpr std::uint32_t minMaxFrameSize = 16384;
+constexpr std::uint32_t maxMaxFrameSize = 16777215;
+constexpr std::uint32_t streamIdMask = 0x7fffffff;
+// bound of a header block when no header list size was announced
+constexpr std::size_t maxHeaderBlock = 1024 * 1024;
+constexpr std::uint64_t noContentLength = UINT64_MAX;
+
+std::uint32_t load32(const unsigned char *p) {
+  return static_cast<std::uint32_t>(p[0]) << 24 |
+         static_cast<std::uint32_t>(p[1]) << 16 |
+         static_cast<std::uint32_t>(p[2]) << 8 | p[3];
+}
+
+std::uint32_t load32(const char *p) {
+  return load32(reinterpret_cast<const unsigned char *>(p));
+}
+
+void append32(std::string &out, std::uint32_t value) {
+  out.push_back(static_cast<char>(value >> 24));
+  out.push_back(static_cast<char>(value >> 16));
+  out.push_back(static_cast<char>(value >> 8));
+  out.push_back(static_cast<char>(value));
+}
+
+void appendSetting(std::string &out, std::uint16_t id, std::uint32_t value) {
+  out.push_back(static_cast<char>(id >> 8));
+  out.push_back(static_cast<char>(id));
+  append32(out, value);
+}
+
+// base64url without padding, as used by HTTP2-Settings (RFC 7540 3.2.1)
+bool base64UrlDecode(std::string_view in, std::string &out) {
+  while (!in.empty() && in.back() == '=') {
+    in.remove_suffix(1);
+  }
+  std::uint32_t bits = 0;
+  int bitCount = 0;
+  for (char c : in) {
+    int value;
+    if (c >= 'A' && c <= 'Z') {
+      value = c - 'A';
+    } else if (c >= 'a' && c <= 'z') {
+      value = c - 'a' + 26;
+    } else if (c >= '0' && c <= '9') {
+      value = c - '0' + 52;
+    } else if (c == '-' || c == '+') {
+      value = 62;
+    } else if (c == '_' || c == '/') {
+      value = 63;
+    } else {
+      return false;
+    }
+    bits = bits << 6 | static_cast<std::uint32_t>(value);
+    bitCount += 6;
+    if (bitCount >= 8) {
+      bitCount -= 8;
+      out.push_back(static_cast<char>(bits >> bitCount));
+    }
+  }
+  return bitCount < 6;
+}
+
+bool isInformational(http_parser::StatusCode status) {
+  int code = static_cast<int>(status);
+  return code >= 100 && code < 200;
+}
+
+} // namespace
+
+bool http_parser::apply_http2_settings(const char *data, std::size_t length,
+                                       Http2Settings &settings,
+                                       Http2ErrorCode &error) {
+  if (length % 6 != 0) {
+    error = Http2ErrorCode::FRAME_SIZE_ERROR;
+    return false;
+  }
+  for (std::size_t pos = 0; pos < length; pos += 6) {
+    const unsigned char *p =
+        reinterpret_cast<const unsigned char *>(data + pos);
+    std::uint16_t id = static_cast<std::uint16_t>(p[0] << 8 | p[1]);
+    std::uint32_t value = load32(p + 2);
+    switch (id) {
+    case HEADER_TABLE_SIZE:
+      settings.headerTableSize = value;
+      break;
+    case ENABLE_PUSH:
+      if (value > 1) {
+        error = Http2ErrorCode::PROTOCOL_ERROR;
+        return false;
+      }
+      settings.enablePush = value;
+      break;
+    case MAX_CONCURRENT_STREAMS:
+      settings.maxConcurrentStreams = value;
+      break;
+    case INITIAL_WINDOW_SIZE:
+      if (value > maxWindowSize) {
+        error = Http2ErrorCode::FLOW_CONTROL_ERROR;
+        return false;
+      }
+      settings.initialWindowSize = value;
+      break;
+    case MAX_FRAME_SIZE:
+      if (value < minMaxFrameSize || value > maxMaxFrameSize) {
+        error = Http2ErrorCode::PROTOCOL_ERROR;
+        return false;
+      }
+      settings.maxFrameSize = value;
+      break;
+    case MAX_HEADER_LIST_SIZE:
+      settings.maxHeaderListSize = value;
+      break;
+    default:
+      break;
+    }
+  }
+  return true;
+}
+
+bool http_parser::is_http2_preface(const char *data, std::size_t length) {
+  std::size_t compared = std::min(length, HTTP2_PREFACE.size());
+  return std::memcmp(data, HTTP2_PREFACE.data(), compared) == 0;
+}
+
+bool http_parser::is_h2c_upgrade(const Request &request) {
+  if (request.version != Version::HTTP_1_1 ||
+      !TokenList(request.headers.value_of(HeaderId::UPGRADE))
+           .contains("h2c")) {
+    return false;
+  }
+  // the Connection header has to list both upgrade and HTTP2-Settings
+  bool settingsOption = false;
+  for (auto it = request.headers.find(HeaderId::CONNECTION);
+       it != request.headers.end();
+       it = request.headers.find(HeaderId::CONNECTION, it.position() + 1)) {
+    settingsOption =
+        settingsOption || TokenList((*it).value).contains("http2-settings");
+  }
+  auto settings = request.headers.find(HeaderId::HTTP2_SETTINGS);
+  return settingsOption && connection_options(request.headers).upgrade &&
+         settings != request.headers.end() &&
+         request.headers.find(HeaderId::HTTP2_SETTINGS,
+                              settings.position() + 1) ==
+             request.headers.end();
+}
+
+void http_parser::h2c_upgrade_response(Response &response) {
+  response.version = Version::HTTP_1_1;
+  response.status_code = StatusCode::SWITCHING_PROTOCOLS;
+  response.status_message = std::string(
+      status_code_to_reason(StatusCode::SWITCHING_PROTOCOLS));
+  response.headers.clear();
+  response.headers.add(HeaderId::CONNECTION, "connection", "Upgrade");
+  response.headers.add(HeaderId::UPGRADE, "upgrade", "h2c");
+}
+
+namespace http_parser {
+
+Http2Connection::Http2Connection(const Http2Settings &settings)
+    : currentParseState(Http2ParseState::PREFACE), localSettings(settings),
+      localSettingsAcknowledged(false), peerSettingsReceived(false),
+      decoder(std::max<std::size_t>(settings.headerTableSize,
+                                    HPACK_DEFAULT_TABLE_SIZE)),
+      headerBytes(0), prefaceBytes(0), frameLength(0),
+      frameType(Http2FrameType::DATA), frameFlags(0), frameStream(0),
+      dataRemaining(0), paddingRemaining(0), discardData(false),
+      headerBlockStream(0), headerBlockEndStream(false),
+      expectContinuation(false), connectionSendWindow(defaultWindowSize),
+      connectionReceiveWindow(defaultWindowSize), connectionUnacknowledged(0),
+      lastStreamId(0), goawayLastStream(0), goawaySent(false),
+      goawayReceived(false), eventStream(0), eventEndStream(false),
+      peerErrorCode(Http2ErrorCode::NONE), errorCode(Http2ErrorCode::NONE),
+      outputOffset(0) {
+  decoder.set_max_header_list_size(settings.maxHeaderListSize);
+
+  std::string payload;
+  appendSetting(payload, HEADER_TABLE_SIZE, settings.headerTableSize);
+  if (settings.maxConcurrentStreams != UINT32_MAX) {
+    appendSetting(payload, MAX_CONCURRENT_STREAMS,
+                  settings.maxConcurrentStreams);
+  }
+  appendSetting(payload, INITIAL_WINDOW_SIZE, settings.initialWindowSize);
+  appendSetting(payload, MAX_FRAME_SIZE, settings.maxFrameSize);
+  if (settings.maxHeaderListSize != UINT32_MAX) {
+    appendSetting(payload, MAX_HEADER_LIST_SIZE, settings.maxHeaderListSize);
+  }
+  writeFrameHeader(static_cast<std::uint32_t>(payload.size()),
+                   Http2FrameType::SETTINGS, 0, 0);
+  output += payload;
+  // the connection window only changes through WINDOW_UPDATE, it is
+  // opened as far as the stream windows
+  if (settings.initialWindowSize > defaultWindowSize) {
+    writeWindowUpdate(0, settings.initialWindowSize - defaultWindowSize);
+    connectionReceiveWindow = settings.initialWindowSize;
+  }
+}
+
+bool Http2Connection::upgrade(const Request &request) {
+  if (!is_h2c_upgrade(request) || lastStreamId != 0) {
+    return false;
+  }
+  std::string payload;
+  Http2ErrorCode error;
+  if (!base64UrlDecode(request.headers.value_of(HeaderId::HTTP2_SETTINGS),
+                       payload) ||
+      !apply_http2_settings(payload.data(), payload.size(), peerSettings,
+                            error)) {
+    return false;
+  }
+  encoder.set_max_table_size(peerSettings.headerTableSize);
+  connectionSendWindow = defaultWindowSize;
+  lastStreamId = 1;
+  openStream(1, true);
+  return true;
+}
+
+Http2Connection::Stream *Http2Connection::findStream(std::uint32_t id) {
+  auto it = std::lower_bound(
+      streams.begin(), streams.end(), id,
+      [](const Stream &stream, std::uint32_t id) { return stream.id < id; });
+  return it != streams.end() && it->id == id ? &*it : nullptr;
+}
+
+const Http2Connection::Stream *
+Http2Connection::findStream(std::uint32_t id) const {
+  return const_cast<Http2Connection *>(this)->findStream(id);
+}
+
+Http2Connection::Stream &Http2Connection::openStream(std::uint32_t id,
+                                                     bool remoteClosed) {
+  // clients open streams in increasing order, so this appends
+  Stream stream{id, static_cast<std::uint8_t>(remoteClosed ? REMOTE_CLOSED : 0),
+                receiveInitialWindow(), 0, peerSettings.initialWindowSize,
+                noContentLength, 0};
+  streams.push_back(stream);
+  return streams.back();
+}
+
+void Http2Connection::removeStream(std::uint32_t id) {
+  Stream *stream = findStream(id);
+  if (stream != nullptr) {
+    streams.erase(streams.begin() + (stream - streams.data()));
+  }
+}
+
+void Http2Connection::closeRemote(Stream &stream) {
+  stream.flags |= REMOTE_CLOSED;
+  if (stream.flags & LOCAL_CLOSED) {
+    removeStream(stream.id);
+  }
+}
+
+void Http2Connection::closeLocal(Stream &stream) {
+  stream.flags |= LOCAL_CLOSED;
+  if (stream.flags & REMOTE_CLOSED) {
+    removeStream(stream.id);
+  }
+}
+
+// Until the client acknowledged the settings it may still rely on the
+// default window, a smaller one only counts afterwards.
+std::int32_t Http2Connection::receiveInitialWindow() const {
+  std::uint32_t window = localSettings.initialWindowSize;
+  if (!localSettingsAcknowledged && window < defaultWindowSize) {
+    window = defaultWindowSize;
+  }
+  return static_cast<std::int32_t>(window);
+}
+
+// A body longer than its content-length, or shorter once the stream
+// ends, makes the request malformed (RFC 9113 section 8.1.1).
+bool Http2Connection::bodyLengthValid(const Stream &stream,
+                                      bool endStream) const {
+  if (stream.contentLength == noContentLength) {
+    return true;
+  }
+  return endStream ? stream.received == stream.contentLength
+                   : stream.received <= stream.contentLength;
+}
+
+std::int64_t Http2Connection::send_window(std::uint32_t stream) const {
+  if (stream == 0) {
+    return connectionSendWindow;
+  }
+  const Stream *found = findStream(stream);
+  if (found == nullptr || (found->flags & LOCAL_CLOSED)) {
+    return 0;
+  }
+  return std::min(found->sendWindow, connectionSendWindow);
+}
+
+void Http2Connection::fail(Http2ErrorCode code, const char *message) {
+  currentParseState = Http2ParseState::PARSE_ERROR;
+  errorCode = code;
+  errorMessage = message;
+  goawayLastStream = goawaySent ? goawayLastStream : lastStreamId;
+  goawaySent = true;
+  writeFrameHeader(8, Http2FrameType::GOAWAY, 0, 0);
+  append32(output, goawayLastStream);
+  append32(output, static_cast<std::uint32_t>(code));
+}
+
+void Http2Connection::resetStream(std::uint32_t id, Http2ErrorCode code) {
+  writeFrameHeader(4, Http2FrameType::RST_STREAM, 0, id);
+  append32(output, static_cast<std::uint32_t>(code));
+  removeStream(id);
+}
+
+void Http2Connection::writeFrameHeader(std::uint32_t length,
+                                       Http2FrameType type,
+                                       std::uint8_t flags,
+                                       std::uint32_t stream) {
+  char frameHeader[HTTP2_FRAME_HEADER_SIZE] = {
+      static_cast<char>(length >> 16),
+      static_cast<char>(length >> 8),
+      static_cast<char>(length),
+      static_cast<char>(type),
+      static_cast<char>(flags),
+      static_cast<char>(stream >> 24),
+      static_cast<char>(stream >> 16),
+      static_cast<char>(stream >> 8),
+      static_cast<char>(stream)};
+  output.append(frameHeader, sizeof(frameHeader));
+}
+
+// HEADERS followed by as many CONTINUATION frames as the client's frame
+// size requires, the block is taken from headerScratch
+void Http2Connection::writeHeaderBlock(std::uint32_t stream, bool endStream) {
+  std::string_view block = headerScratch;
+  Http2FrameType type = Http2FrameType::HEADERS;
+  std::uint8_t flags = endStream ? END_STREAM : 0;
+  do {
+    std::string_view fragment = block.substr(0, peerSettings.maxFrameSize);
+    block.remove_prefix(fragment.size());
+    writeFrameHeader(static_cast<std::uint32_t>(fragment.size()), type,
+                     block.empty() ? flags | END_HEADERS : flags, stream);
+    output.append(fragment.data(), fragment.size());
+    type = Http2FrameType::CONTINUATION;
+    flags = 0;
+  } while (!block.empty());
+}
+
+void Http2Connection::writeWindowUpdate(std::uint32_t stream,
+                                        std::uint32_t increment) {
+  writeFrameHeader(4, Http2FrameType::WINDOW_UPDATE, 0, stream);
+  append32(output, increment);
+}
+
+void Http2Connection::output_written(std::size_t bytes) {
+  outputOffset += std::min(bytes, output.size() - outputOffset);
+  if (outputOffset == output.size()) {
+    output.clear();
+    outputOffset = 0;
+  } else if (outputOffset > output.size() / 2) {
+    output.erase(0, outputOffset);
+    outputOffset = 0;
+  }
+}
+
+bool Http2Connection::write(int file_descriptor) {
+  std::string_view pending = pending_output();
+  iovec iov{const_cast<char *>(pending.data()), pending.size()};
+  std::size_t index = 0;
+  std::size_t remaining = pending.size();
+  bool result = iovec_write(file_descriptor, &iov, 1, index, remaining);
+  output_written(pending.size() - remaining);
+  return result;
+}
+
+bool Http2Connection::submit_response(std::uint32_t stream,
+                                      const Response &response,
+                                      bool endStream) {
+  Stream *found = findStream(stream);
+  if (found == nullptr || (found->flags & (LOCAL_CLOSED | RESPONSE_SENT)) ||
+      failed()) {
+    return false;
+  }
+  // HTTP/2 has no 101 (RFC 9113 section 8.6), other codes go out as their
+  // three digits whether StatusCode names them or not
+  if (response.status_code == StatusCode::SWITCHING_PROTOCOLS) {
+    return false;
+  }
+  bool informational = isInformational(response.status_code);
+  headerScratch.clear();
+  if (!encoder.encode_response(response, headerScratch)) {
+    return false;
+  }
+  writeHeaderBlock(stream, endStream && !informational);
+  if (!informational) {
+    found->flags |= RESPONSE_SENT;
+    if (endStream) {
+      closeLocal(*found);
+    }
+  }
+  return true;
+}
+
+std::size_t Http2Connection::submit_data(std::uint32_t stream,
+                                         const char *data, std::size_t length,
+                                         bool endStream) {
+  Stream *found = findStream(stream);
+  if (found == nullptr || !(found->flags & RESPONSE_SENT) ||
+      (found->flags & LOCAL_CLOSED) || failed()) {
+    return 0;
+  }
+  std::int64_t window = std::min(found->sendWindow, connectionSendWindow);
+  std::size_t take =
+      window <= 0 ? 0
+                  : std::min(length, static_cast<std::size_t>(window));
+  bool ending = endStream && take == length;
+  if (take == 0 && !ending) {
+    return 0;
+  }
+  std::size_t pos = 0;
+  do {
+    std::size_t chunk =
+        std::min<std::size_t>(take - pos, peerSettings.maxFrameSize);
+    bool last = pos + chunk == take;
+    writeFrameHeader(static_cast<std::uint32_t>(chunk), Http2FrameType::DATA,
+                     last && ending ? END_STREAM : 0, stream);
+    output.append(data + pos, chunk);
+    pos += chunk;
+  } while (pos < take);
+  found->sendWindow -= static_cast<std::int64_t>(take);
+  connectionSendWindow -= static_cast<std::int64_t>(take);
+  if (ending) {
+    closeLocal(*found);
+  }
+  return take;
+}
+
+bool Http2Connection::submit_trailers(std::uint32_t stream,
+                                      const Headers &trailers) {
+  Stream *found = findStream(stream);
+  if (found == nullptr || !(found->flags & RESPONSE_SENT) ||
+      (found->flags & LOCAL_CLOSED) || failed()) {
+    return false;
+  }
+  headerScratch.clear();
+  encoder.encode(trailers, headerScratch);
+  writeHeaderBlock(stream, true);
+  closeLocal(*found);
+  return true;
+}
+
+void Http2Connection::reset_stream(std::uint32_t stream, Http2ErrorCode code) {
+  if (findStream(stream) != nullptr && !failed()) {
+    resetStream(stream, code);
+  }
+}
+
+void Http2Connection::consume(std::uint32_t stream, std::size_t bytes) {
+  if (failed()) {
+    return;
+  }
+  // windows are reopened in batches of half their size
+  connectionUnacknowledged += static_cast<std::uint32_t>(bytes);
+  std::uint32_t connectionTarget =
+      std::max(localSettings.initialWindowSize, defaultWindowSize);
+  if (connectionUnacknowledged >= connectionTarget / 2) {
+    writeWindowUpdate(0, connectionUnacknowledged);
+    connectionReceiveWindow += connectionUnacknowledged;
+    connectionUnacknowledged = 0;
+  }
+  Stream *found = findStream(stream);
+  if (found == nullptr || (found->flags & REMOTE_CLOSED)) {
+    return;
+  }
+  found->unacknowledged += static_cast<std::uint32_t>(bytes);
+  if (found->unacknowledged >= localSettings.initialWindowSize / 2 &&
+      found->unacknowledged > 0) {
+    writeWindowUpdate(found->id, found->unacknowledged);
+    found->receiveWindow += static_cast<std::int32_t>(found->unacknowledged);
+    found->unacknowledged = 0;
+  }
+}
+
+void Http2Connection::shutdown(Http2ErrorCode code) {
+  if (failed()) {
+    return;
+  }
+  goawaySent = true;
+  goawayLastStream = lastStreamId;
+  writeFrameHeader(8, Http2FrameType::GOAWAY, 0, 0);
+  append32(output, goawayLastStream);
+  append32(output, static_cast<std::uint32_t>(code));
+}
+
+// padding, discarded data and data of streams that are gone count as
+// consumed right away
+void Http2Connection::creditReceived(std::uint32_t stream, std::size_t bytes) {
+  if (bytes > 0) {
+    consume(stream, bytes);
+  }
+}
+
+bool Http2Connection::beginFrame(Http2Event &event) {
+  frameLength = static_cast<std::uint32_t>(header[0]) << 16 |
+                static_cast<std::uint32_t>(header[1]) << 8 | header[2];
+  frameType = static_cast<Http2FrameType>(header[3]);
+  frameFlags = header[4];
+  frameStream = load32(header + 5) & streamIdMask;
+
+  if (frameLength > localSettings.maxFrameSize) {
+    fail(Http2ErrorCode::FRAME_SIZE_ERROR, "Frame exceeds the maximum size");
+    return false;
+  }
+  if (!peerSettingsReceived && (frameType != Http2FrameType::SETTINGS ||
+                                (frameFlags & ACK) != 0)) {
+    fail(Http2ErrorCode::PROTOCOL_ERROR,
+         "Connection preface is not followed by SETTINGS");
+    return false;
+  }
+  if (expectContinuation && (frameType != Http2FrameType::CONTINUATION ||
+                             frameStream != headerBlockStream)) {
+    fail(Http2ErrorCode::PROTOCOL_ERROR, "Header block was interrupted");
+    return false;
+  }
+
+  switch (frameType) {
+  case Http2FrameType::DATA:
+  case Http2FrameType::HEADERS:
+  case Http2FrameType::PRIORITY:
+  case Http2FrameType::RST_STREAM:
+  case Http2FrameType::CONTINUATION:
+    if (frameStream == 0) {
+      fail(Http2ErrorCode::PROTOCOL_ERROR, "Stream frame on stream 0");
+      return false;
+    }
+    break;
+  case Http2FrameType::SETTINGS:
+  case Http2FrameType::PING:
+  case Http2FrameType::GOAWAY:
+    if (frameStream != 0) {
+      fail(Http2ErrorCode::PROTOCOL_ERROR, "Connection frame on a stream");
+      return false;
+    }
+    break;
+  case Http2FrameType::PUSH_PROMISE:
+    fail(Http2ErrorCode::PROTOCOL_ERROR, "Clients cannot push");
+    return false;
+  default:
+    break;
+  }
+
+  if (frameType == Http2FrameType::DATA) {
+    return beginData(event);
+  }
+  currentParseState = Http2ParseState::PAYLOAD;
+  payloadBuffer.clear();
+  return true;
+}
+
+bool Http2Connection::beginData(Http2Event &event) {
+  if (frameStream > lastStreamId) {
+    fail(Http2ErrorCode::PROTOCOL_ERROR, "DATA on an idle stream");
+    return false;
+  }
+  if (frameLength > connectionReceiveWindow) {
+    fail(Http2ErrorCode::FLOW_CONTROL_ERROR,
+         "DATA exceeds the connection window");
+    return false;
+  }
+  connectionReceiveWindow -= frameLength;
+
+  Stream *stream = findStream(frameStream);
+  discardData = true;
+  if (stream != nullptr && (stream->flags & REMOTE_CLOSED)) {
+    resetStream(frameStream, Http2ErrorCode::STREAM_CLOSED);
+  } else if (stream != nullptr && static_cast<std::int64_t>(frameLength) >
+                                       stream->receiveWindow) {
+    resetStream(frameStream, Http2ErrorCode::FLOW_CONTROL_ERROR);
+  } else if (stream != nullptr) {
+    stream->receiveWindow -= static_cast<std::int32_t>(frameLength);
+    discardData = false;
+  }
+  if (discardData) {
+    // frames of a closed stream are dropped, still counting against the
+    // connection window
+    creditReceived(0, frameLength);
+  }
+
+  paddingRemaining = 0;
+  if (frameFlags & PADDED) {
+    if (frameLength == 0) {
+      fail(Http2ErrorCode::FRAME_SIZE_ERROR, "Padded frame without padding");
+      return false;
+    }
+    currentParseState = Http2ParseState::DATA_PAD_LENGTH;
+    return true;
+  }
+  dataRemaining = frameLength;
+  return beginDataPayload(event);
+}
+
+bool Http2Connection::beginDataPayload(Http2Event &event) {
+  currentParseState = paddingRemaining > 0 ? Http2ParseState::DATA_PADDING
+                                           : Http2ParseState::FRAME_HEADER;
+  if (dataRemaining > 0) {
+    currentParseState = Http2ParseState::DATA_PAYLOAD;
+    return true;
+  }
+  Stream *stream = discardData ? nullptr : findStream(frameStream);
+  if (stream != nullptr && (frameFlags & END_STREAM)) {
+    // an empty frame ending the body
+    if (!bodyLengthValid(*stream, true)) {
+      resetStream(frameStream, Http2ErrorCode::PROTOCOL_ERROR);
+      return true;
+    }
+    eventStream = frameStream;
+    eventEndStream = true;
+    event = Http2Event::DATA;
+    closeRemote(*stream);
+  }
+  return true;
+}
+
+void Http2Connection::processFrame(const char *payload, Http2Event &event,
+                                   std::string_view &eventPayload) {
+  currentParseState = Http2ParseState::FRAME_HEADER;
+  switch (frameType) {
+  case Http2FrameType::HEADERS:
+    processHeaders(payload, event);
+    break;
+  case Http2FrameType::CONTINUATION:
+    processContinuation(payload, event);
+    break;
+  case Http2FrameType::SETTINGS:
+    processSettings(payload, event);
+    break;
+  case Http2FrameType::WINDOW_UPDATE:
+    processWindowUpdate(payload, event);
+    break;
+  case Http2FrameType::PRIORITY:
+    // priority signals are deprecated (RFC 9113 section 5.3.2)
+    if (frameLength != 5) {
+      fail(Http2ErrorCode::FRAME_SIZE_ERROR, "Invalid PRIORITY frame size");
+    }
+    break;
+  case Http2FrameType::RST_STREAM:
+    if (frameLength != 4) {
+      fail(Http2ErrorCode::FRAME_SIZE_ERROR, "Invalid RST_STREAM frame size");
+      break;
+    }
+    if (frameStream > lastStreamId) {
+      fail(Http2ErrorCode::PROTOCOL_ERROR, "RST_STREAM on an idle stream");
+      break;
+    }
+    if (findStream(frameStream) != nullptr) {
+      removeStream(frameStream);
+      eventStream = frameStream;
+      eventEndStream = true;
+      peerErrorCode = static_cast<Http2ErrorCode>(load32(payload));
+      event = Http2Event::STREAM_RESET;
+    }
+    break;
+  case Http2FrameType::PING:
+    if (frameLength != 8) {
+      fail(Http2ErrorCode::FRAME_SIZE_ERROR, "Invalid PING frame size");
+      break;
+    }
+    if (!(frameFlags & ACK)) {
+      writeFrameHeader(8, Http2FrameType::PING, ACK, 0);
+      output.append(payload, 8);
+    }
+    break;
+  case Http2FrameType::GOAWAY:
+    if (frameLength < 8) {
+      fail(Http2ErrorCode::FRAME_SIZE_ERROR, "Invalid GOAWAY frame size");
+      break;
+    }
+    goawayReceived = true;
+    eventStream = load32(payload) & streamIdMask;
+    eventEndStream = false;
+    peerErrorCode = static_cast<Http2ErrorCode>(load32(payload + 4));
+    eventPayload = std::string_view(payload + 8, frameLength - 8);
+    event = Http2Event::GOAWAY;
+    break;
+  default:
+    // unknown frame types are ignored (section 5.5)
+    break;
+  }
+}
+
+void Http2Connection::processHeaders(const char *payload, Http2Event &event) {
+  std::size_t pos = 0;
+  std::size_t padding = 0;
+  if (frameFlags & PADDED) {
+    if (frameLength < 1) {
+      fail(Http2ErrorCode::FRAME_SIZE_ERROR, "Padded frame without padding");
+      return;
+    }
+    padding = static_cast<unsigned char>(payload[0]);
+    pos = 1;
+  }
+  if (frameFlags & PRIORITY) {
+    // exclusive flag, stream dependency and weight, ignored
+    pos += 5;
+  }
+  if (pos + padding > frameLength) {
+    fail(Http2ErrorCode::PROTOCOL_ERROR, "Padding exceeds the frame");
+    return;
+  }
+  headerBlock.assign(payload + pos, frameLength - pos - padding);
+  headerBlockStream = frameStream;
+  headerBlockEndStream = (frameFlags & END_STREAM) != 0;
+  if (frameFlags & END_HEADERS) {
+    processHeaderBlock(event);
+  } else {
+    expectContinuation = true;
+  }
+}
+
+void Http2Connection::processContinuation(const char *payload,
+                                          Http2Event &event) {
+  if (!expectContinuation) {
+    fail(Http2ErrorCode::PROTOCOL_ERROR, "Unexpected CONTINUATION frame");
+    return;
+  }
+  std::size_t limit = localSettings.maxHeaderListSize == UINT32_MAX
+                          ? maxHeaderBlock
+                          : localSettings.maxHeaderListSize;
+  if (headerBlock.size() + frameLength > limit) {
+    fail(Http2ErrorCode::ENHANCE_YOUR_CALM, "Header block too large");
+    return;
+  }
+  headerBlock.append(payload, frameLength);
+  if (frameFlags & END_HEADERS) {
+    expectContinuation = false;
+    processHeaderBlock(event);
+  }
+}
+
+void Http2Connection::processHeaderBlock(Http2Event &event) {
+  std::uint32_t id = headerBlockStream;
+  Stream *stream = findStream(id);
+
+  if (stream != nullptr) {
+    // a second block on an open stream carries trailers
+    bool decoded = decoder.decode_trailers(headerBlock.data(),
+                                           headerBlock.size(), currentTrailers);
+    if (!decoded && decoder.compression_error()) {
+      fail(Http2ErrorCode::COMPRESSION_ERROR, "Header block cannot be decoded");
+      return;
+    }
+    if ((stream->flags & REMOTE_CLOSED) != 0) {
+      resetStream(id, Http2ErrorCode::STREAM_CLOSED);
+      return;
+    }
+    if (!headerBlockEndStream || !decoded ||
+        !bodyLengthValid(*stream, true)) {
+      resetStream(id, Http2ErrorCode::PROTOCOL_ERROR);
+      return;
+    }
+    eventStream = id;
+    eventEndStream = true;
+    event = Http2Event::TRAILERS;
+    closeRemote(*stream);
+    return;
+  }
+
+  // the block is decoded in any case, the HPACK state depends on it
+  bool decoded = decoder.decode_request(headerBlock.data(), headerBlock.size(),
+                                        currentRequest);
+  if (!decoded && decoder.compression_error()) {
+    fail(Http2ErrorCode::COMPRESSION_ERROR, "Header block cannot be decoded");
+    return;
+  }
+  if (id <= lastStreamId) {
+    // frames of closed streams are ignored
+    return;
+  }
+  if ((id & 1) == 0) {
+    fail(Http2ErrorCode::PROTOCOL_ERROR, "Client opened an even stream");
+    return;
+  }
+  lastStreamId = id;
+  if (goawaySent && id > goawayLastStream) {
+    return;
+  }
+  if (streams.size() >= localSettings.maxConcurrentStreams) {
+    resetStream(id, Http2ErrorCode::REFUSED_STREAM);
+    return;
+  }
+  std::uint64_t contentLength = 0;
+  if (!decoded ||
+      request_body_framing(currentRequest, contentLength) ==
+          BodyFraming::INVALID ||
+      (headerBlockEndStream && contentLength > 0)) {
+    resetStream(id, Http2ErrorCode::PROTOCOL_ERROR);
+    return;
+  }
+  Stream &opened = openStream(id, headerBlockEndStream);
+  if (currentRequest.headers.contains(HeaderId::CONTENT_LENGTH)) {
+    opened.contentLength = contentLength;
+  }
+  eventStream = id;
+  eventEndStream = headerBlockEndStream;
+  event = Http2Event::REQUEST;
+}
+
+void Http2Connection::processSettings(const char *payload, Http2Event &event) {
+  if (frameFlags & ACK) {
+    if (frameLength != 0) {
+      fail(Http2ErrorCode::FRAME_SIZE_ERROR, "SETTINGS ACK with a payload");
+      return;
+    }
+    if (!localSettingsAcknowledged) {
+      localSettingsAcknowledged = true;
+      decoder.set_max_table_size(localSettings.headerTableSize);
+    }
+    return;
+  }
+  std::uint32_t previousWindow = peerSettings.initialWindowSize;
+  Http2ErrorCode error;
+  if (!apply_http2_settings(payload, frameLength, peerSettings, error)) {
+    fail(error, "Invalid SETTINGS frame");
+    return;
+  }
+  // a new initial window size applies to all open streams (section 6.9.2)
+  std::int64_t delta = static_cast<std::int64_t>(
+                           peerSettings.initialWindowSize) -
+                       previousWindow;
+  for (Stream &stream : streams) {
+    stream.sendWindow += delta;
+    if (stream.sendWindow > maxWindowSize) {
+      fail(Http2ErrorCode::FLOW_CONTROL_ERROR, "Stream window overflow");
+      return;
+    }
+  }
+  encoder.set_max_table_size(peerSettings.headerTableSize);
+  writeFrameHeader(0, Http2FrameType::SETTINGS, ACK, 0);
+  peerSettingsReceived = true;
+  eventStream = 0;
+  eventEndStream = false;
+  event = Http2Event::SETTINGS;
+}
+
+void Http2Connection::processWindowUpdate(const char *payload,
+                                          Http2Event &event) {
+  if (frameLength != 4) {
+    fail(Http2ErrorCode::FRAME_SIZE_ERROR, "Invalid WINDOW_UPDATE frame size");
+    return;
+  }
+  std::uint32_t increment = load32(payload) & streamIdMask;
+  if (frameStream == 0) {
+    if (increment == 0) {
+      fail(Http2ErrorCode::PROTOCOL_ERROR, "WINDOW_UPDATE of 0");
+      return;
+    }
+    connectionSendWindow += increment;
+    if (connectionSendWindow > maxWindowSize) {
+      fail(Http2ErrorCode::FLOW_CONTROL_ERROR, "Connection window overflow");
+      return;
+    }
+  } else {
+    if (frameStream > lastStreamId) {
+      fail(Http2ErrorCode::PROTOCOL_ERROR, "WINDOW_UPDATE on an idle stream");
+      return;
+    }
+    Stream *stream = findStream(frameStream);
+    if (stream == nullptr) {
+      return;
+    }
+    if (increment == 0) {
+      resetStream(frameStream, Http2ErrorCode::PROTOCOL_ERROR);
+      return;
+    }
+    stream->sendWindow += increment;
+    if (stream->sendWindow > maxWindowSize) {
+      resetStream(frameStream, Http2ErrorCode::FLOW_CONTROL_ERROR);
+      return;
+    }
+  }
+  eventStream = frameStream;
+  eventEndStream = false;
+  event = Http2Event::WINDOW_UPDATE;
+}
+
+std::size_t Http2Connection::execute(const char *data, std::size_t length,
+                                     Http2Event &event,
+                                     std::string_view &payload) {
+  event = Http2Event::NONE;
+  payload = std::string_view();
+  std::size_t pos = 0;
+  while (pos < length) {
+    switch (currentParseState) {
+    case Http2ParseState::PREFACE: {
+      std::size_t take =
+          std::min(length - pos, HTTP2_PREFACE.size() - prefaceBytes);
+      if (std::memcmp(data + pos, HTTP2_PREFACE.data() + prefaceBytes,
+                      take) != 0) {
+        fail(Http2ErrorCode::PROTOCOL_ERROR, "Invalid connection preface");
+        return pos;
+      }
+      pos += take;
+      prefaceBytes += take;
+      if (prefaceBytes == HTTP2_PREFACE.size()) {
+        currentParseState = Http2ParseState::FRAME_HEADER;
+      }
+      break;
+    }
+    case Http2ParseState::FRAME_HEADER: {
+      std::size_t take =
+          std::min(length - pos, HTTP2_FRAME_HEADER_SIZE - headerBytes);
+      std::memcpy(header + headerBytes, data + pos, take);
+      headerBytes += take;
+      pos += take;
+      if (headerBytes < HTTP2_FRAME_HEADER_SIZE) {
+        return pos;
+      }
+      headerBytes = 0;
+      if (!beginFrame(event)) {
+        return pos;
+      }
+      if (currentParseState == Http2ParseState::PAYLOAD && frameLength == 0) {
+        processFrame(data + pos, event, payload);
+      }
+      if (event != Http2Event::NONE || failed()) {
+        return pos;
+      }
+      break;
+    }
+    case Http2ParseState::PAYLOAD: {
+      // taken straight from the input when the frame is complete in it
+      const char *framePayload;
+      if (payloadBuffer.empty() && length - pos >= frameLength) {
+        framePayload = data + pos;
+        pos += frameLength;
+      } else {
+        std::size_t take =
+            std::min(length - pos, frameLength - payloadBuffer.size());
+        payloadBuffer.append(data + pos, take);
+        pos += take;
+        if (payloadBuffer.size() < frameLength) {
+          return pos;
+        }
+        framePayload = payloadBuffer.data();
+      }
+      processFrame(framePayload, event, payload);
+      if (event != Http2Event::NONE || failed()) {
+        return pos;
+      }
+      break;
+    }
+    case Http2ParseState::DATA_PAD_LENGTH: {
+      paddingRemaining = static_cast<unsigned char>(data[pos++]);
+      if (paddingRemaining >= frameLength) {
+        fail(Http2ErrorCode::PROTOCOL_ERROR, "Padding exceeds the frame");
+        return pos;
+      }
+      dataRemaining = frameLength - 1 - paddingRemaining;
+      if (!discardData) {
+        creditReceived(frameStream, 1 + paddingRemaining);
+      }
+      beginDataPayload(event);
+      if (event != Http2Event::NONE) {
+        return pos;
+      }
+      break;
+    }
+    case Http2ParseState::DATA_PAYLOAD: {
+      std::size_t take = std::min<std::size_t>(length - pos, dataRemaining);
+      const char *piece = data + pos;
+      pos += take;
+      dataRemaining -= static_cast<std::uint32_t>(take);
+      if (dataRemaining == 0) {
+        currentParseState = paddingRemaining > 0
+                                ? Http2ParseState::DATA_PADDING
+                                : Http2ParseState::FRAME_HEADER;
+      }
+      // the stream may have been reset since the frame began
+      Stream *stream = discardData ? nullptr : findStream(frameStream);
+      bool endStream = dataRemaining == 0 && (frameFlags & END_STREAM) != 0;
+      if (stream != nullptr) {
+        stream->received += take;
+        if (!bodyLengthValid(*stream, endStream)) {
+          resetStream(frameStream, Http2ErrorCode::PROTOCOL_ERROR);
+          stream = nullptr;
+        }
+      }
+      if (stream == nullptr) {
+        if (!discardData) {
+          // the padding was credited with the pad length already
+          discardData = true;
+          creditReceived(0, take + dataRemaining);
+        }
+        break;
+      }
+      eventStream = frameStream;
+      eventEndStream = endStream;
+      payload = std::string_view(piece, take);
+      event = Http2Event::DATA;
+      if (eventEndStream) {
+        closeRemote(*stream);
+      }
+      return pos;
+    }
+    case Http2ParseState::DATA_PADDING: {
+      std::size_t take = std::min<std::size_t>(length - pos, paddingRemaining);
+      pos += take;
+      paddingRemaining -= static_cast<std::uint32_t>(take);
+      if (paddingRemaining == 0) {
+        currentParseState = Http2ParseState::FRAME_HEADER;
+      }
+      break;
+    }
+    case Http2ParseState::PARSE_ERROR:
+      return pos;
+    }
+  }
+  return pos;
+}
+
+}; // namespace http_parser
@@ -0,0 +1,266 @@
+#include "HttpDate.hpp"
+#include <ctime>
+
+namespace {
+
+constexpr char dayNames[7][4] = {"Sun", "Mon", "Tue", "Wed",
+                                 "Thu", "Fri", "Sat"};
+constexpr char monthNames[12][4] = {"Jan", "Feb", "Mar", "Apr",
+                                    "May", "Jun", "Jul", "Aug",
+                                    "Sep", "Oct", "Nov", "Dec"};
+constexpr std::string_view longDayNames[7] = {
+    "Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday",
+    "Saturday"};
+
+constexpr std::int64_t secondsPerDay = 86400;
+
+// Days since 1970-01-01 of a proleptic Gregorian date (Howard Hinnant's
+// days_from_civil).
+constexpr std::int64_t daysFromCivil(std::int64_t year, unsigned month,
+                                     unsigned day) {
+  year -= month <= 2;
+  const std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+  const unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+  const unsigned dayOfYear =
+      (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  const unsigned dayOfEra =
+      yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097 + static_cast<std::int64_t>(dayOfEra) - 719468;
+}
+
+constexpr void civilFromDays(std::int64_t days, std::int64_t &year,
+                             unsigned &month, unsigned &day) {
+  days += 719468;
+  const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+  const unsigned yearOfEra =
+      (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) /
+      365;
+  const unsigned dayOfYear =
+      dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  const unsigned shiftedMonth = (5 * dayOfYear + 2) / 153;
+  day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+  month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+  year = static_cast<std::int64_t>(yearOfEra) + era * 400 + (month <= 2);
+}
+
+static_assert(daysFromCivil(1970, 1, 1) == 0, "epoch must be day zero");
+static_assert(daysFromCivil(1994, 11, 6) == 9075, "days_from_civil");
+
+inline void writeTwoDigits(char *out, unsigned value) {
+  out[0] = static_cast<char>('0' + value / 10);
+  out[1] = static_cast<char>('0' + value % 10);
+}
+
+// Value of `count` ASCII digits, or -1 if one of them is not a digit.
+inline int readDigits(const char *in, int count) {
+  int value = 0;
+  unsigned invalid = 0;
+  for (int i = 0; i < count; i++) {
+    unsigned digit = static_cast<unsigned char>(in[i]) - '0';
+    invalid |= digit > 9;
+    value = value * 10 + static_cast<int>(digit);
+  }
+  return invalid ? -1 : value;
+}
+
+// 1..12 for a case-sensitive month abbreviation, 0 otherwise
+inline unsigned readMonth(const char *in) {
+  // the three letters packed into one word select the month
+  std::uint32_t key = static_cast<std::uint32_t>(
+      static_cast<unsigned char>(in[0]) << 16 |
+      static_cast<unsigned char>(in[1]) << 8 |
+      static_cast<unsigned char>(in[2]));
+  for (unsigned i = 0; i < 12; i++) {
+    std::uint32_t name = static_cast<std::uint32_t>(
+        static_cast<unsigned char>(monthNames[i][0]) << 16 |
+        static_cast<unsigned char>(monthNames[i][1]) << 8 |
+        static_cast<unsigned char>(monthNames[i][2]));
+    if (key == name) {
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+inline bool isDayName(std::string_view name) {
+  for (const char *day : dayNames) {
+    if (name == day) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// "HH:MM:SS" into seconds of the day
+inline bool readTime(const char *in, std::int64_t &seconds) {
+  int hour = readDigits(in, 2);
+  int minute = readDigits(in + 3, 2);
+  int second = readDigits(in + 6, 2);
+  if (in[2] != ':' || in[5] != ':' || hour < 0 || hour > 23 || minute < 0 ||
+      minute > 59 || second < 0 || second > 60) {
+    return false;
+  }
+  // a leap second is folded into the next minute like timegm does
+  seconds = hour * 3600 + minute * 60 + second;
+  return true;
+}
+
+bool toEpoch(std::int64_t year, unsigned month, int day,
+             std::int64_t secondsOfDay, std::int64_t &epochSeconds) {
+  static constexpr unsigned char monthDays[12] = {31, 29, 31, 30, 31, 30,
+                                                  31, 31, 30, 31, 30, 31};
+  if (month == 0 || day < 1 || day > monthDays[month - 1]) {
+    return false;
+  }
+  bool leapYear = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+  if (month == 2 && day == 29 && !leapYear) {
+    return false;
+  }
+  epochSeconds =
+      daysFromCivil(year, month, static_cast<unsigned>(day)) * secondsPerDay +
+      secondsOfDay;
+  return true;
+}
+
+// Sun, 06 Nov 1994 08:49:37 GMT
+bool parseImfFixdate(std::string_view text, std::int64_t &epochSeconds) {
+  const char *in = text.data();
+  if (text.size() != 29 || in[3] != ',' || in[4] != ' ' || in[7] != ' ' ||
+      in[11] != ' ' || in[16] != ' ' || in[25] != ' ' ||
+      text.substr(26) != "GMT" || !isDayName(text.substr(0, 3))) {
+    return false;
+  }
+  int day = readDigits(in + 5, 2);
+  int year = readDigits(in + 12, 4);
+  std::int64_t secondsOfDay = 0;
+  return year >= 0 && readTime(in + 17, secondsOfDay) &&
+         toEpoch(year, readMonth(in + 8), day, secondsOfDay, epochSeconds);
+}
+
+// Sunday, 06-Nov-94 08:49:37 GMT
+bool parseRfc850(std::string_view text, std::int64_t &epochSeconds) {
+  std::size_t comma = text.find(',');
+  if (comma == std::string_view::npos || text.size() != comma + 24) {
+    return false;
+  }
+  bool knownDay = false;
+  for (std::string_view name : longDayNames) {
+    knownDay |= text.substr(0, comma) == name;
+  }
+  const char *in = text.data() + comma;
+  if (!knownDay || in[1] != ' ' || in[4] != '-' || in[8] != '-' ||
+      in[11] != ' ' || in[20] != ' ' || text.substr(comma + 21) != "GMT") {
+    return false;
+  }
+  int day = readDigits(in + 2, 2);
+  int shortYear = readDigits(in + 9, 2);
+  std::int64_t secondsOfDay = 0;
+  if (shortYear < 0 || !readTime(in + 12, secondsOfDay)) {
+    return false;
+  }
+  // RFC 9110: a two digit year more than 50 years in the future is in the
+  // past century
+  std::time_t now = std::time(nullptr);
+  std::int64_t currentYear = 0;
+  unsigned month = 0;
+  unsigned dayOfMonth = 0;
+  civilFromDays(static_cast<std::int64_t>(now) / secondsPerDay, currentYear,
+                month, dayOfMonth);
+  std::int64_t year = currentYear - currentYear % 100 + shortYear;
+  if (year > currentYear + 50) {
+    year -= 100;
+  }
+  return toEpoch(year, readMonth(in + 5), day, secondsOfDay, epochSeconds);
+}
+
+// Sun Nov  6 08:49:37 1994
+bool parseAsctime(std::string_view text, std::int64_t &epochSeconds) {
+  const char *in = text.data();
+  if (text.size() != 24 || in[3] != ' ' || in[7] != ' ' || in[10] != ' ' ||
+      in[19] != ' ' || !isDayName(text.substr(0, 3))) {
+    return false;
+  }
+  int day = in[8] == ' ' ? readDigits(in + 9, 1) : readDigits(in + 8, 2);
+  int year = readDigits(in + 20, 4);
+  std::int64_t secondsOfDay = 0;
+  return year >= 0 && readTime(in + 11, secondsOfDay) &&
+         toEpoch(year, readMonth(in + 4), day, secondsOfDay, epochSeconds);
+}
+
+struct DateCache {
+  std::int64_t second = -1;
+  char text[http_parser::HTTP_DATE_LENGTH];
+};
+
+} // namespace
+
+std::string_view http_parser::format_http_date(std::int64_t epochSeconds,
+                                               char *out) {
+  std::int64_t days = epochSeconds / secondsPerDay;
+  std::int64_t secondsOfDay = epochSeconds % secondsPerDay;
+  if (secondsOfDay < 0) {
+    secondsOfDay += secondsPerDay;
+    days--;
+  }
+  std::int64_t year = 0;
+  unsigned month = 0;
+  unsigned day = 0;
+  civilFromDays(days, year, month, day);
+  // 1970-01-01 was a Thursday
+  std::int64_t weekday = (days % 7 + 11) % 7;
+  if (year < 0) {
+    year = 0;
+  } else if (year > 9999) {
+    year = 9999;
+  }
+
+  const char *dayName = dayNames[weekday];
+  const char *monthName = monthNames[month - 1];
+  out[0] = dayName[0];
+  out[1] = dayName[1];
+  out[2] = dayName[2];
+  out[3] = ',';
+  out[4] = ' ';
+  writeTwoDigits(out + 5, day);
+  out[7] = ' ';
+  out[8] = monthName[0];
+  out[9] = monthName[1];
+  out[10] = monthName[2];
+  out[11] = ' ';
+  writeTwoDigits(out + 12, static_cast<unsigned>(year / 100));
+  writeTwoDigits(out + 14, static_cast<unsigned>(year % 100));
+  out[16] = ' ';
+  writeTwoDigits(out + 17, static_cast<unsigned>(secondsOfDay / 3600));
+  out[19] = ':';
+  writeTwoDigits(out + 20, static_cast<unsigned>(secondsOfDay / 60 % 60));
+  out[22] = ':';
+  writeTwoDigits(out + 23, static_cast<unsigned>(secondsOfDay % 60));
+  out[25] = ' ';
+  out[26] = 'G';
+  out[27] = 'M';
+  out[28] = 'T';
+  return std::string_view(out, HTTP_DATE_LENGTH);
+}
+
+std::string_view http_parser::http_date_now() {
+  thread_local DateCache cache;
+  std::int64_t now = static_cast<std::int64_t>(std::time(nullptr));
+  if (now != cache.second) {
+    format_http_date(now, cache.text);
+    cache.second = now;
+  }
+  return std::string_view(cache.text, HTTP_DATE_LENGTH);
+}
+
+bool http_parser::parse_http_date(std::string_view text,
+                                  std::int64_t &epochSeconds) {
+  // the formats are told apart by where the day name ends
+  if (text.size() > 3 && text[3] == ',') {
+    return parseImfFixdate(text, epochSeconds);
+  }
+  if (text.size() > 3 && text[3] == ' ') {
+    return parseAsctime(text, epochSeconds);
+  }
+  return parseRfc850(text, epochSeconds);
+}
@@ -1,9 +1,100 @@
 #include "HttpDefinitions.hpp"
+#include "HeaderValue.hpp"
+#include <array>
+#include <cctype>
+#include <string>
 
+using http_parser::ConnectionOptions;
+using http_parser::Expectation;
+using http_parser::HeaderId;
 using http_parser::Method;
 using http_parser::StatusCode;
+using http_parser::TokenList;
 using http_parser::Version;
 
+namespace {
+
+struct StatusLine {
+  StatusCode code;
+  std::string_view reason;
+  std::string_view line;
+};
+
+// one entry per StatusCode, the full status line is stored so serializing
+// a response never formats it
+constexpr StatusLine statusLines[] = {
+    {StatusCode::CONTINUE, "Continue", "HTTP/1.1 100 Continue\r\n"},
+    {StatusCode::SWITCHING_PROTOCOLS, "Switching Protocols",
+     "HTTP/1.1 101 Switching Protocols\r\n"},
+    {StatusCode::OK, "OK", "HTTP/1.1 200 OK\r\n"},
+    {StatusCode::CREATED, "Created", "HTTP/1.1 201 Created\r\n"},
+    {StatusCode::ACCEPTED, "Accepted", "HTTP/1.1 202 Accepted\r\n"},
+    {StatusCode::NO_CONTENT, "No Content", "HTTP/1.1 204 No Content\r\n"},
+    {StatusCode::PARTIAL_CONTENT, "Partial Content",
+     "HTTP/1.1 206 Partial Content\r\n"},
+    {StatusCode::MOVED_PERMANENTLY, "Moved Permanently",
+     "HTTP/1.1 301 Moved Permanently\r\n"},
+    {StatusCode::FOUND, "Found", "HTTP/1.1 302 Found\r\n"},
+    {StatusCode::SEE_OTHER, "See Other", "HTTP/1.1 303 See Other\r\n"},
+    {StatusCode::NOT_MODIFIED, "Not Modified",
+     "HTTP/1.1 304 Not Modified\r\n"},
+    {StatusCode::BAD_REQUEST, "Bad Request", "HTTP/1.1 400 Bad Request\r\n"},
+    {StatusCode::UNAUTHORIZED, "Unauthorized",
+     "HTTP/1.1 401 Unauthorized\r\n"},
+    {StatusCode::FORBIDDEN, "Forbidden", "HTTP/1.1 403 Forbidden\r\n"},
+    {StatusCode::NOT_FOUND, "Not Found", "HTTP/1.1 404 Not Found\r\n"},
+    {StatusCode::METHOD_NOT_ALLOWED, "Method Not Allowed",
+     "HTTP/1.1 405 Method Not Allowed\r\n"},
+    {StatusCode::REQUEST_TIMEOUT, "Request Timeout",
+     "HTTP/1.1 408 Request Timeout\r\n"},
+    {StatusCode::PRECONDITION_FAILED, "Precondition Failed",
+     "HTTP/1.1 412 Precondition Failed\r\n"},
+    {StatusCode::CONTENT_TOO_LARGE, "Content Too Large",
+     "HTTP/1.1 413 Content Too Large\r\n"},
+    {StatusCode::RANGE_NOT_SATISFIABLE, "Range Not Satisfiable",
+     "HTTP/1.1 416 Range Not Satisfiable\r\n"},
+    {StatusCode::EXPECTATION_FAILED, "Expectation Failed",
+     "HTTP/1.1 417 Expectation Failed\r\n"},
+    {StatusCode::INTERNAL_SERVER_ERROR, "Internal Server Error",
+     "HTTP/1.1 500 Internal Server Error\r\n"},
+    {StatusCode::NOT_IMPLEMENTED, "Not Implemented",
+     "HTTP/1.1 501 Not Implemented\r\n"},
+    {StatusCode::BAD_GATEWAY, "Bad Gateway", "HTTP/1.1 502 Bad Gateway\r\n"},
+    {StatusCode::SERVICE_UNAVAILABLE, "Service Unavailable",
+     "HTTP/1.1 503 Service Unavailable\r\n"},
+    {StatusCode::GATEWAY_TIMEOUT, "Gateway Timeout",
+     "HTTP/1.1 504 Gateway Timeout\r\n"},
+};
+
+constexpr std::size_t statusLineCount =
+    sizeof(statusLines) / sizeof(statusLines[0]);
+constexpr unsigned char noStatusLine = 0xFF;
+
+// maps a numeric status code to its index in statusLines
+constexpr std::array<unsigned char, 600> makeStatusIndex() {
+  std::array<unsigned char, 600> index{};
+  for (std::size_t i = 0; i < index.size(); i++) {
+    index[i] = noStatusLine;
+  }
+  for (std::size_t i = 0; i < statusLineCount; i++) {
+    index[static_cast<std::size_t>(statusLines[i].code)] =
+        static_cast<unsigned char>(i);
+  }
+  return index;
+}
+
+constexpr std::array<unsigned char, 600> statusIndex = makeStatusIndex();
+
+const StatusLine *findStatusLine(StatusCode status_code) {
+  std::size_t code = static_cast<std::size_t>(status_code);
+  if (code >= statusIndex.size() || statusIndex[code] == noStatusLine) {
+    return nullptr;
+  }
+  return &statusLines[statusIndex[code]];
+}
+
+} // namespace
+
 std::string http_parser::method_to_string(Method method) {
   switch (method) {
   case Method::METHOD_GET:
@@ -31,6 +122,20 @@ std::string http_parser::method_to_string(Method method) {
   return "UNKOWN";
 }
 
+bool http_parser::is_idempotent(Method method) {
+  switch (method) {
+  case Method::METHOD_GET:
+  case Method::METHOD_HEAD:
+  case Method::METHOD_OPTIONS:
+  case Method::METHOD_TRACE:
+  case Method::METHOD_PUT:
+  case Method::METHOD_DELETE:
+    return true;
+  default:
+    return false;
+  }
+}
+
 Method http_parser::string_to_method(const std::string &s) {
   if (s == "GET") {
     return Method::METHOD_GET;
@@ -56,8 +161,12 @@ Method http_parser::string_to_method(const std::string &s) {
 
 std::string http_parser::version_to_string(Version version) {
   switch (version) {
+  case Version::HTTP_1_0:
+    return "HTTP/1.0";
   case Version::HTTP_1_1:
     return "HTTP/1.1";
+  case Version::HTTP_2:
+    return "HTTP/2";
   case Version::VERSION_UNKOWN:
     break;
   }
@@ -67,12 +176,69 @@ std::string http_parser::version_to_string(Version version) {
 Version http_parser::string_to_version(const std::string &s) {
   if (s == "HTTP/1.1") {
     return Version::HTTP_1_1;
+  } else if (s == "HTTP/1.0") {
+    return Version::HTTP_1_0;
+  } else if (s.size() == 8 && s.compare(0, 7, "HTTP/1.") == 0 &&
+             std::isdigit(static_cast<unsigned char>(s[7]))) {
+    // a higher minor version is understood as the highest one supported
+    return Version::HTTP_1_1;
   }
   return Version::VERSION_UNKOWN;
 }
 
+void http_parser::add_connection_options(std::string_view value,
+                                         ConnectionOptions &options) {
+  for (std::string_view token : TokenList(value)) {
+    if (header_name_equals(token, "close")) {
+      options.close = true;
+    } else if (header_name_equals(token, "keep-alive")) {
+      options.keepAlive = true;
+    } else if (header_name_equals(token, "upgrade")) {
+      options.upgrade = true;
+    }
+  }
+}
+
+ConnectionOptions
+http_parser::connection_options(const Headers &headers) {
+  ConnectionOptions options;
+  for (auto it = headers.find(HeaderId::CONNECTION); it != headers.end();
+       it = headers.find(HeaderId::CONNECTION, it.position() + 1)) {
+    add_connection_options((*it).value, options);
+  }
+  return options;
+}
+
+void http_parser::add_expectations(std::string_view value,
+                                   Expectation &expectation) {
+  for (std::string_view token : TokenList(value)) {
+    if (expectation == Expectation::UNSUPPORTED) {
+      return;
+    }
+    expectation = header_name_equals(token, "100-continue")
+                      ? Expectation::CONTINUE
+                      : Expectation::UNSUPPORTED;
+  }
+}
+
+bool http_parser::is_persistent(Version version,
+                                const ConnectionOptions &options) {
+  if (version == Version::HTTP_2) {
+    return true;
+  }
+  if (options.close) {
+    return false;
+  }
+  return version == Version::HTTP_1_0 ? options.keepAlive
+                                      : version == Version::HTTP_1_1;
+}
+
 StatusCode http_parser::string_to_status_code(const std::string &s) {
-  if (s == "200") {
+  if (s == "100") {
+    return StatusCode::CONTINUE;
+  } else if (s == "101") {
+    return StatusCode::SWITCHING_PROTOCOLS;
+  } else if (s == "200") {
     return StatusCode::OK;
   } else if (s == "201") {
     return StatusCode::CREATED;
@@ -80,6 +246,8 @@ StatusCode http_parser::string_to_status_code(const std::string &s) {
     return StatusCode::ACCEPTED;
   } else if (s == "204") {
     return StatusCode::NO_CONTENT;
+  } else if (s == "206") {
+    return StatusCode::PARTIAL_CONTENT;
   } else if (s == "301") {
     return StatusCode::MOVED_PERMANENTLY;
   } else if (s == "302") {
@@ -100,6 +268,14 @@ StatusCode http_parser::string_to_status_code(const std::string &s) {
     return StatusCode::METHOD_NOT_ALLOWED;
   } else if (s == "408") {
     return StatusCode::REQUEST_TIMEOUT;
+  } else if (s == "412") {
+    return StatusCode::PRECONDITION_FAILED;
+  } else if (s == "413") {
+    return StatusCode::CONTENT_TOO_LARGE;
+  } else if (s == "416") {
+    return StatusCode::RANGE_NOT_SATISFIABLE;
+  } else if (s == "417") {
+    return StatusCode::EXPECTATION_FAILED;
   } else if (s == "500") {
     return StatusCode::INTERNAL_SERVER_ERROR;
   } else if (s == "501") {
@@ -111,11 +287,21 @@ StatusCode http_parser::string_to_status_code(const std::string &s) {
   } else if (s == "504") {
     return StatusCode::GATEWAY_TIMEOUT;
   }
-  return StatusCode::UNKOWN;
+  // codes without an enumerator keep their number
+  if (s.size() != 3 || s[0] < '1' || s[0] > '9' || !std::isdigit(s[1]) ||
+      !std::isdigit(s[2])) {
+    return StatusCode::UNKOWN;
+  }
+  return static_cast<StatusCode>((s[0] - '0') * 100 + (s[1] - '0') * 10 +
+                                 (s[2] - '0'));
 }
 
 std::string http_parser::status_code_to_string(StatusCode status_code) {
   switch (status_code) {
+  case StatusCode::CONTINUE:
+    return "100";
+  case StatusCode::SWITCHING_PROTOCOLS:
+    return "101";
   case StatusCode::OK:
     return "200";
   case StatusCode::CREATED:
@@ -124,6 +310,8 @@ std::string http_parser::status_code_to_string(StatusCode status_code) {
     return "202";
   case StatusCode::NO_CONTENT:
     return "204";
+  case StatusCode::PARTIAL_CONTENT:
+    return "206";
   case StatusCode::MOVED_PERMANENTLY:
     return "301";
   case StatusCode::FOUND:
@@ -144,6 +332,14 @@ std::string http_parser::status_code_to_string(StatusCode status_code) {
     return "405";
   case StatusCode::REQUEST_TIMEOUT:
     return "408";
+  case StatusCode::PRECONDITION_FAILED:
+    return "412";
+  case StatusCode::CONTENT_TOO_LARGE:
+    return "413";
+  case StatusCode::RANGE_NOT_SATISFIABLE:
+    return "416";
+  case StatusCode::EXPECTATION_FAILED:
+    return "417";
   case StatusCode::INTERNAL_SERVER_ERROR:
     return "500";
   case StatusCode::NOT_IMPLEMENTED:
@@ -157,5 +353,19 @@ std::string http_parser::status_code_to_string(StatusCode status_code) {
   case StatusCode::UNKOWN:
     break;
   }
-  return 0;
-}
\ No newline at end of file
+  int code = static_cast<int>(status_code);
+  if (code < 100 || code > 999) {
+    return std::string();
+  }
+  return std::to_string(code);
+}
+
+std::string_view http_parser::status_code_to_reason(StatusCode status_code) {
+  const StatusLine *entry = findStatusLine(status_code);
+  return entry ? entry->reason : std::string_view();
+}
+
+std::string_view http_parser::status_line(StatusCode status_code) {
+  const StatusLine *entry = findStatusLine(status_code);
+  return entry ? entry->line : std::string_view();
+}
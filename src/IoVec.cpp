@@ -0,0 +1,43 @@
+#include "IoVec.h"
+#include "OS.h"
+#include <cerrno>
+
+void http_parser::iovec_consume(iovec *iov, std::size_t count,
+                                std::size_t &index, std::size_t bytes) {
+  while (bytes > 0 && index < count) {
+    iovec &current = iov[index];
+    if (bytes < current.iov_len) {
+      current.iov_base = static_cast<char *>(current.iov_base) + bytes;
+      current.iov_len -= bytes;
+      return;
+    }
+    bytes -= current.iov_len;
+    index++;
+  }
+}
+
+bool http_parser::iovec_write(int file_descriptor, iovec *iov,
+                              std::size_t count, std::size_t &index,
+                              std::size_t &remaining) {
+  while (index < count) {
+#ifdef _WIN32
+    const iovec &current = iov[index];
+    int bytesWritten =
+        ::send(file_descriptor, static_cast<const char *>(current.iov_base),
+               static_cast<int>(current.iov_len), 0);
+#else
+    ssize_t bytesWritten = ::writev(file_descriptor, &iov[index],
+                                    static_cast<int>(count - index));
+#endif
+    if (bytesWritten < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    std::size_t written = static_cast<std::size_t>(bytesWritten);
+    remaining -= written < remaining ? written : remaining;
+    iovec_consume(iov, count, index, written);
+  }
+  return true;
+}
@@ -0,0 +1,277 @@
+#include "Multipart.hpp"
+#include "Text.h"
+#include <cstring>
+
+using http_parser::MultipartEvent;
+using http_parser::MultipartParser;
+using http_parser::MultipartParseState;
+using http_parser::detail::trim;
+
+namespace {
+
+// bchars of RFC 2046 section 5.1.1, CR is not one of them so a delimiter
+// can only start at the CR of its leading CRLF
+bool isBoundaryChar(char c) {
+  if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+      (c >= 'A' && c <= 'Z')) {
+    return true;
+  }
+  return std::strchr("'()+_,-./:=? ", c) != nullptr && c != '\0';
+}
+
+bool validBoundary(std::string_view boundary) {
+  if (boundary.empty() ||
+      boundary.size() > MultipartParser::MAX_BOUNDARY_LENGTH ||
+      boundary.back() == ' ') {
+    return false;
+  }
+  for (char c : boundary) {
+    if (!isBoundaryChar(c)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+bool http_parser::parse_multipart_boundary(std::string_view contentType,
+                                           std::string_view &boundary) {
+  std::size_t semicolon = contentType.find(';');
+  std::string_view mediaType = trim(contentType.substr(0, semicolon));
+  if (mediaType.size() <= 10 ||
+      !header_name_equals(mediaType.substr(0, 10), "multipart/")) {
+    return false;
+  }
+  std::string_view params = semicolon == std::string_view::npos
+                                ? std::string_view()
+                                : contentType.substr(semicolon + 1);
+  while (!params.empty()) {
+    std::size_t equals = params.find('=');
+    if (equals == std::string_view::npos) {
+      return false;
+    }
+    std::string_view name = trim(params.substr(0, equals));
+    params = trim(params.substr(equals + 1));
+    std::string_view value;
+    if (!params.empty() && params.front() == '"') {
+      std::size_t i = 1;
+      while (i < params.size() && params[i] != '"') {
+        i += params[i] == '\\' ? 2 : 1;
+      }
+      if (i >= params.size()) {
+        return false;
+      }
+      value = params.substr(1, i - 1);
+      params = params.substr(i + 1);
+    } else {
+      value = trim(params.substr(0, params.find(';')));
+      params = params.substr(value.size());
+    }
+    if (header_name_equals(name, "boundary")) {
+      if (!validBoundary(value)) {
+        return false;
+      }
+      boundary = value;
+      return true;
+    }
+    std::size_t next = params.find(';');
+    params = next == std::string_view::npos ? std::string_view()
+                                            : params.substr(next + 1);
+  }
+  return false;
+}
+
+MultipartParser::MultipartParser()
+    : currentParseState{MultipartParseState::PARSE_ERROR}, shift{},
+      matched{0}, headerBytes{0} {}
+
+bool MultipartParser::reset(std::string_view boundary) {
+  headerParser.reset();
+  headerBytes = 0;
+  if (!validBoundary(boundary)) {
+    currentParseState = MultipartParseState::PARSE_ERROR;
+    return false;
+  }
+  delimiter.assign("\r\n--");
+  delimiter.append(boundary.data(), boundary.size());
+  std::size_t n = delimiter.size();
+  shift.fill(static_cast<std::uint8_t>(n));
+  for (std::size_t i = 0; i + 1 < n; i++) {
+    shift[static_cast<unsigned char>(delimiter[i])] =
+        static_cast<std::uint8_t>(n - 1 - i);
+  }
+  // the body may start with the delimiter right away, without the CRLF
+  matched = 2;
+  currentParseState = MultipartParseState::PREAMBLE;
+  return true;
+}
+
+std::size_t MultipartParser::search(const char *data,
+                                    std::size_t length) const {
+  std::size_t n = delimiter.size();
+  if (length < n) {
+    return length;
+  }
+  const unsigned char last = static_cast<unsigned char>(delimiter[n - 1]);
+  std::size_t i = 0;
+  while (i <= length - n) {
+    unsigned char c = static_cast<unsigned char>(data[i + n - 1]);
+    if (c == last && std::memcmp(data + i, delimiter.data(), n - 1) == 0) {
+      return i;
+    }
+    i += shift[c];
+  }
+  return length;
+}
+
+std::size_t MultipartParser::partialMatch(const char *data,
+                                          std::size_t length) const {
+  // only the last delimiter.size() - 1 bytes can hold a cut delimiter
+  std::size_t start =
+      length >= delimiter.size() ? length - delimiter.size() + 1 : 0;
+  while (start < length) {
+    const void *cr = std::memchr(data + start, '\r', length - start);
+    if (cr == nullptr) {
+      break;
+    }
+    std::size_t at = static_cast<const char *>(cr) - data;
+    if (std::memcmp(data + at, delimiter.data(), length - at) == 0) {
+      return at;
+    }
+    start = at + 1;
+  }
+  return length;
+}
+
+std::size_t MultipartParser::execute(const char *data, std::size_t length,
+                                     MultipartEvent &event,
+                                     std::string_view &partData) {
+  event = MultipartEvent::NONE;
+  partData = std::string_view();
+  std::size_t pos = 0;
+  while (pos < length) {
+    switch (currentParseState) {
+    case MultipartParseState::PREAMBLE:
+    case MultipartParseState::DATA: {
+      bool inPart = currentParseState == MultipartParseState::DATA;
+      if (matched > 0) {
+        // continue a delimiter cut by the end of the previous buffer
+        std::size_t i = pos;
+        while (i < length && matched < delimiter.size() &&
+               data[i] == delimiter[matched]) {
+          i++;
+          matched++;
+        }
+        if (matched == delimiter.size()) {
+          matched = 0;
+          currentParseState = MultipartParseState::BOUNDARY_END;
+          if (inPart) {
+            event = MultipartEvent::PART_END;
+            return i;
+          }
+          pos = i;
+          break;
+        }
+        if (i == length) {
+          return length;
+        }
+        // not a delimiter, the matched bytes belong to the part
+        std::size_t held = matched;
+        matched = 0;
+        if (inPart) {
+          event = MultipartEvent::PART_DATA;
+          partData = std::string_view(delimiter).substr(0, held);
+          return i;
+        }
+        pos = i;
+        break;
+      }
+      std::size_t found = search(data + pos, length - pos);
+      if (found < length - pos) {
+        if (inPart && found > 0) {
+          event = MultipartEvent::PART_DATA;
+          partData = std::string_view(data + pos, found);
+          return pos + found;
+        }
+        pos += found + delimiter.size();
+        currentParseState = MultipartParseState::BOUNDARY_END;
+        if (inPart) {
+          event = MultipartEvent::PART_END;
+          return pos;
+        }
+        break;
+      }
+      std::size_t tail = partialMatch(data + pos, length - pos);
+      matched = length - pos - tail;
+      if (inPart && tail > 0) {
+        event = MultipartEvent::PART_DATA;
+        partData = std::string_view(data + pos, tail);
+      }
+      return length;
+    }
+    case MultipartParseState::BOUNDARY_END: {
+      char c = data[pos++];
+      if (c == '-') {
+        currentParseState = MultipartParseState::CLOSE_DASH;
+      } else if (c == '\r') {
+        currentParseState = MultipartParseState::BOUNDARY_LF;
+      } else if (c == '\n') {
+        headerParser.reset();
+        headerBytes = 0;
+        currentParseState = MultipartParseState::HEADERS;
+      } else if (c != ' ' && c != '\t') {
+        // only transport padding may follow the boundary
+        currentParseState = MultipartParseState::PARSE_ERROR;
+        return pos - 1;
+      }
+      break;
+    }
+    case MultipartParseState::BOUNDARY_LF:
+      if (data[pos] != '\n') {
+        currentParseState = MultipartParseState::PARSE_ERROR;
+        return pos;
+      }
+      pos++;
+      headerParser.reset();
+      headerBytes = 0;
+      currentParseState = MultipartParseState::HEADERS;
+      break;
+    case MultipartParseState::CLOSE_DASH:
+      if (data[pos] != '-') {
+        currentParseState = MultipartParseState::PARSE_ERROR;
+        return pos;
+      }
+      currentParseState = MultipartParseState::DONE;
+      event = MultipartEvent::DONE;
+      return pos + 1;
+    case MultipartParseState::HEADERS: {
+      std::size_t used = headerParser.execute(data + pos, length - pos);
+      pos += used;
+      headerBytes += used;
+      if (headerParser.done()) {
+        currentParseState = MultipartParseState::DATA;
+        event = MultipartEvent::PART_BEGIN;
+        return pos;
+      }
+      if (headerParser.failed() || headerBytes > MAX_PART_HEADER_BYTES) {
+        currentParseState = MultipartParseState::PARSE_ERROR;
+        return pos;
+      }
+      break;
+    }
+    case MultipartParseState::DONE:
+      // the epilogue is ignored
+      return length;
+    case MultipartParseState::PARSE_ERROR:
+      return pos;
+    }
+  }
+  return pos;
+}
+
+void MultipartParser::finish() {
+  if (currentParseState != MultipartParseState::DONE) {
+    currentParseState = MultipartParseState::PARSE_ERROR;
+  }
+}
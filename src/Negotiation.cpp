@@ -0,0 +1,154 @@
+#include "Negotiation.hpp"
+#include "HeaderList.hpp"
+#include "HeaderValue.hpp"
+#include <array>
+#include <atomic>
+#include <functional>
+
+using http_parser::NegotiationKind;
+using http_parser::Negotiator;
+using http_parser::Parameters;
+
+namespace {
+
+struct CacheEntry {
+  std::uint64_t negotiator = 0; // 0 marks an empty entry
+  std::size_t hash = 0;
+  std::string value;
+  int result = -1;
+};
+
+std::array<CacheEntry, Negotiator::CACHE_ENTRIES> &threadCache() {
+  thread_local std::array<CacheEntry, Negotiator::CACHE_ENTRIES> cache;
+  return cache;
+}
+
+std::atomic<std::uint64_t> nextNegotiatorId{1};
+
+// Specificity of `range` for `value`, 0 if it does not match. Higher is
+// more specific.
+int matchMediaType(std::string_view range, std::string_view value) {
+  if (range == "*/*") {
+    return 1;
+  }
+  std::size_t rangeSlash = range.find('/');
+  std::size_t valueSlash = value.find('/');
+  if (rangeSlash == std::string_view::npos ||
+      valueSlash == std::string_view::npos ||
+      !http_parser::header_name_equals(range.substr(0, rangeSlash),
+                                       value.substr(0, valueSlash))) {
+    return 0;
+  }
+  std::string_view subtype = range.substr(rangeSlash + 1);
+  if (subtype == "*") {
+    return 2;
+  }
+  return http_parser::header_name_equals(subtype,
+                                         value.substr(valueSlash + 1))
+             ? 3
+             : 0;
+}
+
+int matchEncoding(std::string_view range, std::string_view value) {
+  if (range == "*") {
+    return 1;
+  }
+  // x-gzip and x-compress are the same codings as gzip and compress
+  if (range.size() > 2 && (range[0] == 'x' || range[0] == 'X') &&
+      range[1] == '-') {
+    range.remove_prefix(2);
+  }
+  return http_parser::header_name_equals(range, value) ? 2 : 0;
+}
+
+int matchLanguage(std::string_view range, std::string_view value) {
+  if (range == "*") {
+    return 1;
+  }
+  if (range.size() > value.size() ||
+      !http_parser::header_name_equals(range, value.substr(0, range.size())) ||
+      (range.size() < value.size() && value[range.size()] != '-')) {
+    return 0;
+  }
+  // longer ranges are more specific
+  return 2 + static_cast<int>(range.size());
+}
+
+} // namespace
+
+Negotiator::Negotiator(NegotiationKind kind, std::vector<std::string> supported)
+    : negotiationKind{kind}, supported{std::move(supported)},
+      id{nextNegotiatorId.fetch_add(1, std::memory_order_relaxed)} {}
+
+std::uint16_t Negotiator::weight(std::string_view headerValue,
+                                 std::size_t i) const {
+  std::string_view value = supported[i];
+  if (negotiationKind == NegotiationKind::MEDIA_TYPE) {
+    // parameters of the supported type do not take part in matching
+    Parameters parameters;
+    value = split_parameters(value, parameters);
+  }
+  int bestSpecificity = 0;
+  std::uint16_t bestWeight = 0;
+  for (std::string_view element : TokenList(headerValue)) {
+    std::uint16_t q = 0;
+    std::string_view range = weighted_element(element, q);
+    int specificity = 0;
+    switch (negotiationKind) {
+    case NegotiationKind::MEDIA_TYPE:
+      specificity = matchMediaType(range, value);
+      break;
+    case NegotiationKind::ENCODING:
+      specificity = matchEncoding(range, value);
+      break;
+    case NegotiationKind::LANGUAGE:
+      specificity = matchLanguage(range, value);
+      break;
+    }
+    if (specificity > bestSpecificity) {
+      bestSpecificity = specificity;
+      bestWeight = q;
+    }
+  }
+  if (bestSpecificity == 0 && negotiationKind == NegotiationKind::ENCODING &&
+      http_parser::header_name_equals(value, "identity")) {
+    // no content coding is acceptable unless excluded (section 12.5.3)
+    return 1000;
+  }
+  return bestWeight;
+}
+
+int Negotiator::evaluate(std::string_view headerValue) const {
+  if (TokenList(headerValue).begin() == TokenList(headerValue).end() &&
+      negotiationKind != NegotiationKind::ENCODING) {
+    return supported.empty() ? -1 : 0;
+  }
+  int best = -1;
+  std::uint16_t bestWeight = 0;
+  for (std::size_t i = 0; i < supported.size(); i++) {
+    std::uint16_t q = weight(headerValue, i);
+    if (q > bestWeight) {
+      best = static_cast<int>(i);
+      bestWeight = q;
+    }
+  }
+  return best;
+}
+
+int Negotiator::select(std::string_view headerValue) const {
+  if (headerValue.size() > MAX_CACHED_VALUE) {
+    return evaluate(headerValue);
+  }
+  std::size_t hash = std::hash<std::string_view>()(headerValue);
+  CacheEntry &entry =
+      threadCache()[(hash ^ static_cast<std::size_t>(id)) % CACHE_ENTRIES];
+  if (entry.negotiator == id && entry.hash == hash &&
+      entry.value == headerValue) {
+    return entry.result;
+  }
+  entry.negotiator = id;
+  entry.hash = hash;
+  entry.value.assign(headerValue.data(), headerValue.size());
+  entry.result = evaluate(headerValue);
+  return entry.result;
+}
@@ -0,0 +1,298 @@
+#include "Range.hpp"
+#include "HttpDate.hpp"
+#include "Text.h"
+#include <chrono>
+#include <random>
+
+using http_parser::ByteRange;
+using http_parser::ByteRanges;
+using http_parser::HeaderId;
+using http_parser::RangeBody;
+using http_parser::RangeResult;
+using http_parser::detail::appendNumber;
+using http_parser::detail::trim;
+
+namespace {
+
+// Reads a run of digits at `pos`, false if there is none or it overflows.
+bool readNumber(std::string_view text, std::size_t &pos, std::uint64_t &out) {
+  std::size_t start = pos;
+  out = 0;
+  while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+    std::uint64_t digit = static_cast<std::uint64_t>(text[pos] - '0');
+    if (out > (UINT64_MAX - digit) / 10) {
+      return false;
+    }
+    out = out * 10 + digit;
+    pos++;
+  }
+  return pos > start;
+}
+
+void appendContentRange(std::string &out, const ByteRange &range,
+                        std::uint64_t contentLength) {
+  out += "bytes ";
+  appendNumber(out, range.first);
+  out += '-';
+  appendNumber(out, range.last);
+  out += '/';
+  appendNumber(out, contentLength);
+}
+
+// 20 random hex digits, unlikely enough to occur inside the content
+void makeBoundary(std::string &out) {
+  thread_local std::mt19937_64 generator(
+      std::random_device{}() ^
+      static_cast<std::uint64_t>(
+          std::chrono::steady_clock::now().time_since_epoch().count()));
+  static constexpr char hex[] = "0123456789abcdef";
+  out.clear();
+  std::uint64_t high = generator();
+  std::uint64_t low = generator();
+  for (int i = 0; i < 4; i++) {
+    out += hex[(high >> (i * 4)) & 0xf];
+  }
+  for (int i = 0; i < 16; i++) {
+    out += hex[(low >> (i * 4)) & 0xf];
+  }
+}
+
+} // namespace
+
+std::uint64_t ByteRanges::bytes() const {
+  std::uint64_t total = 0;
+  for (const ByteRange &range : *this) {
+    total += range.length();
+  }
+  return total;
+}
+
+bool ByteRanges::push(ByteRange range) {
+  if (count == ranges.size()) {
+    return false;
+  }
+  ranges[count++] = range;
+  return true;
+}
+
+void ByteRanges::coalesce() {
+  // insertion sort, the set is tiny and usually already ordered
+  for (std::size_t i = 1; i < count; i++) {
+    ByteRange current = ranges[i];
+    std::size_t j = i;
+    while (j > 0 && ranges[j - 1].first > current.first) {
+      ranges[j] = ranges[j - 1];
+      j--;
+    }
+    ranges[j] = current;
+  }
+  std::size_t merged = 0;
+  for (std::size_t i = 1; i < count; i++) {
+    ByteRange &previous = ranges[merged];
+    if (ranges[i].first <= previous.last + 1) {
+      if (ranges[i].last > previous.last) {
+        previous.last = ranges[i].last;
+      }
+    } else {
+      ranges[++merged] = ranges[i];
+    }
+  }
+  if (count > 0) {
+    count = merged + 1;
+  }
+}
+
+RangeResult http_parser::parse_range(std::string_view value,
+                                     std::uint64_t contentLength,
+                                     ByteRanges &ranges) {
+  ranges.clear();
+  value = trim(value);
+  if (value.size() < 6 || !header_name_equals(value.substr(0, 6), "bytes=")) {
+    return RangeResult::NONE;
+  }
+  value.remove_prefix(6);
+
+  bool anySpec = false;
+  std::size_t pos = 0;
+  while (pos < value.size()) {
+    // skip empty list elements and OWS
+    if (value[pos] == ',' || value[pos] == ' ' || value[pos] == '\t') {
+      pos++;
+      continue;
+    }
+    std::uint64_t first = 0;
+    std::uint64_t last = 0;
+    bool hasFirst = readNumber(value, pos, first);
+    if (pos >= value.size() || value[pos] != '-') {
+      return RangeResult::NONE;
+    }
+    pos++;
+    bool hasLast = readNumber(value, pos, last);
+    if ((!hasFirst && !hasLast) || (hasFirst && hasLast && last < first)) {
+      return RangeResult::NONE;
+    }
+    while (pos < value.size() && (value[pos] == ' ' || value[pos] == '\t')) {
+      pos++;
+    }
+    if (pos < value.size() && value[pos] != ',') {
+      return RangeResult::NONE;
+    }
+    anySpec = true;
+
+    ByteRange range;
+    if (!hasFirst) {
+      // suffix range: the last `last` bytes
+      if (last == 0 || contentLength == 0) {
+        continue;
+      }
+      range.first = last >= contentLength ? 0 : contentLength - last;
+      range.last = contentLength - 1;
+    } else {
+      if (first >= contentLength) {
+        continue;
+      }
+      range.first = first;
+      range.last =
+          !hasLast || last >= contentLength ? contentLength - 1 : last;
+    }
+    if (!ranges.push(range)) {
+      // too many to keep before merging, merge what we have and retry
+      ranges.coalesce();
+      if (!ranges.push(range)) {
+        ranges.clear();
+        return RangeResult::NONE;
+      }
+    }
+  }
+  if (!anySpec) {
+    return RangeResult::NONE;
+  }
+  if (ranges.empty()) {
+    return RangeResult::UNSATISFIABLE;
+  }
+  ranges.coalesce();
+  return RangeResult::SATISFIABLE;
+}
+
+RangeResult
+http_parser::evaluate_range(const Request &request,
+                            std::uint64_t contentLength,
+                            const ResourceValidators &validators,
+                            ByteRanges &ranges) {
+  ranges.clear();
+  if (request.method != Method::METHOD_GET) {
+    return RangeResult::NONE;
+  }
+  auto range = request.headers.find(HeaderId::RANGE);
+  if (range == request.headers.end()) {
+    return RangeResult::NONE;
+  }
+  auto ifRange = request.headers.find(HeaderId::IF_RANGE);
+  if (ifRange != request.headers.end()) {
+    std::string_view condition = trim((*ifRange).value);
+    EntityTag requested;
+    EntityTag current;
+    std::int64_t date = 0;
+    bool matches = false;
+    if (parse_entity_tag(condition, requested)) {
+      matches = parse_entity_tag(validators.etag, current) &&
+                strong_match(requested, current);
+    } else if (parse_http_date(condition, date)) {
+      matches = validators.lastModified >= 0 &&
+                validators.lastModified == date;
+    }
+    if (!matches) {
+      return RangeResult::NONE;
+    }
+  }
+  return parse_range((*range).value, contentLength, ranges);
+}
+
+RangeBody::RangeBody() : partViews{}, partCount{0} {}
+
+bool RangeBody::prepare(Response &response, const ByteRanges &ranges,
+                        std::string_view content,
+                        std::string_view contentType) {
+  partCount = 0;
+  framing.clear();
+  headerValue.clear();
+  if (ranges.empty()) {
+    return false;
+  }
+  std::uint64_t contentLength = content.size();
+  for (const ByteRange &range : ranges) {
+    if (range.last >= contentLength || range.first > range.last) {
+      return false;
+    }
+  }
+  response.status_code = StatusCode::PARTIAL_CONTENT;
+  response.status_message.clear();
+
+  if (ranges.size() == 1) {
+    const ByteRange &range = ranges[0];
+    appendContentRange(headerValue, range, contentLength);
+    response.headers.add(HeaderId::CONTENT_RANGE, "content-range", headerValue);
+    if (!contentType.empty()) {
+      response.headers.add(HeaderId::CONTENT_TYPE, "content-type",
+                           contentType);
+    }
+    partViews[partCount++] = content.substr(
+        static_cast<std::size_t>(range.first),
+        static_cast<std::size_t>(range.length()));
+    return true;
+  }
+
+  makeBoundary(boundaryText);
+  headerValue += "multipart/byteranges; boundary=";
+  headerValue += boundaryText;
+  response.headers.add(HeaderId::CONTENT_TYPE, "content-type", headerValue);
+
+  // write every framing block first and remember where it ends, the views
+  // are taken once the buffer no longer grows
+  std::array<std::size_t, ByteRanges::MAX_RANGES + 1> framingEnds{};
+  for (std::size_t i = 0; i < ranges.size(); i++) {
+    if (i > 0) {
+      framing += "\r\n";
+    }
+    framing += "--";
+    framing += boundaryText;
+    framing += "\r\n";
+    if (!contentType.empty()) {
+      framing += "content-type: ";
+      framing.append(contentType.data(), contentType.size());
+      framing += "\r\n";
+    }
+    framing += "content-range: ";
+    appendContentRange(framing, ranges[i], contentLength);
+    framing += "\r\n\r\n";
+    framingEnds[i] = framing.size();
+  }
+  framing += "\r\n--";
+  framing += boundaryText;
+  framing += "--\r\n";
+  framingEnds[ranges.size()] = framing.size();
+
+  std::size_t framingStart = 0;
+  for (std::size_t i = 0; i < ranges.size(); i++) {
+    partViews[partCount++] = std::string_view(
+        framing.data() + framingStart, framingEnds[i] - framingStart);
+    partViews[partCount++] = content.substr(
+        static_cast<std::size_t>(ranges[i].first),
+        static_cast<std::size_t>(ranges[i].length()));
+    framingStart = framingEnds[i];
+  }
+  partViews[partCount++] =
+      std::string_view(framing.data() + framingStart,
+                       framingEnds[ranges.size()] - framingStart);
+  return true;
+}
+
+void RangeBody::prepare_unsatisfiable(Response &response,
+                                      std::uint64_t contentLength) {
+  partCount = 0;
+  headerValue = "bytes */";
+  appendNumber(headerValue, contentLength);
+  response.status_code = StatusCode::RANGE_NOT_SATISFIABLE;
+  response.status_message.clear();
+  response.headers.add(HeaderId::CONTENT_RANGE, "content-range", headerValue);
+}
@@ -5,64 +5,85 @@
 #include <ResponseParser.hpp>
 #include <sstream>
 
-using http_parser::Header;
+using http_parser::BasicRequestParser;
+using http_parser::DefaultParserPolicy;
+using http_parser::Expectation;
+using http_parser::HealthCheckParserPolicy;
+using http_parser::HeaderId;
+using http_parser::LenientParserPolicy;
 using http_parser::Method;
 using http_parser::method_to_string;
 using http_parser::ParseState;
 using http_parser::Request;
-using http_parser::RequestParser;
 using http_parser::string_to_method;
+using http_parser::StrictParserPolicy;
 using http_parser::string_to_version;
 using http_parser::Version;
 using http_parser::version_to_string;
 
-RequestParser::RequestParser()
+template <typename Policy>
+BasicRequestParser<Policy>::BasicRequestParser()
     : currentParseState(ParseState::METHOD), currentCharIndex{0} {}
 
-bool RequestParser::parse(int file_discriptor) {
+template <typename Policy>
+bool BasicRequestParser<Policy>::parse(int file_discriptor) {
   // reset all the values
   currentMethod.clear();
   currentUrl.clear();
   currentVersion.clear();
-  currentHeaderKey.clear();
-  currentHeaderValue.clear();
+  headerParser.reset();
+  request = Request();
   requestData.clear();
   errorMessage.clear();
   currentCharIndex = 0;
   currentParseState = ParseState::METHOD;
 
-  processRequest(file_discriptor);
-  if (currentParseState == ParseState::DONE) {
-    // check if request contains host header, if not then it's a invalid request
-    bool hostHeaderFound = false;
-    for (const auto &header : request.headers) {
-      if (header.key == "host") {
-        hostHeaderFound = true;
-        break;
-      }
-    }
-    if (!hostHeaderFound) {
-      currentParseState = ParseState::PARSE_ERROR;
+  // read one byte at a time, so the body is left in the file discriptor
+  char nextChar;
+  while (currentParseState != ParseState::DONE &&
+         currentParseState != ParseState::PARSE_ERROR) {
+    int bytesRead = ::read(file_discriptor, &nextChar, 1);
+    if (bytesRead <= 0) {
+      perror("Error reading from file discriptor");
+      return false;
     }
+    execute(&nextChar, 1);
   }
   return currentParseState == ParseState::DONE;
 }
 
-void RequestParser::processRequest(int file_discriptor) {
-  char nextChar;
-  bool readNextChar = true;
-  while (currentParseState != ParseState::DONE ||
+template <typename Policy>
+std::size_t BasicRequestParser<Policy>::execute(const char *data,
+                                                std::size_t length) {
+  std::size_t consumed = 0;
+  while (consumed < length && currentParseState != ParseState::DONE &&
          currentParseState != ParseState::PARSE_ERROR) {
-    if (readNextChar) {
-      readNextChar = false;
-      int bytesRead = ::read(file_discriptor, &nextChar, 1);
-      if (bytesRead <= 0) {
-        perror("Error reading from file discriptor");
-        return;
+    if (currentParseState == ParseState::HEADERS) {
+      std::size_t used =
+          headerParser.execute(data + consumed, length - consumed);
+      requestData.append(data + consumed, used);
+      currentCharIndex += static_cast<int>(used);
+      consumed += used;
+      if (headerParser.done()) {
+        finishHeaders();
+      } else if (headerParser.failed()) {
+        currentParseState = ParseState::PARSE_ERROR;
+        errorMessage = headerParser.getErrorMessage();
       }
-      requestData += nextChar;
-      currentCharIndex++;
+      continue;
     }
+    processChar(data[consumed]);
+    consumed++;
+  }
+  return consumed;
+}
+
+template <typename Policy>
+void BasicRequestParser<Policy>::processChar(char nextChar) {
+  requestData += nextChar;
+  currentCharIndex++;
+  bool readNextChar = false;
+  while (!readNextChar) {
     switch (currentParseState) {
     case ParseState::METHOD:
       parseMethod(nextChar, currentParseState, readNextChar);
@@ -100,27 +121,10 @@ void RequestParser::processRequest(int file_discriptor) {
     case ParseState::REQUEST_LINE_END:
       parseRequestLineEnd(nextChar, currentParseState, readNextChar);
       break;
-    case ParseState::HEADER_KEY:
-      parseHeaderKey(nextChar, currentParseState, readNextChar);
-      break;
-    case ParseState::HEADER_DELIMITER:
-      parseHeaderDelimiter(nextChar, currentParseState, readNextChar);
-      break;
-    case ParseState::HEADER_VALUE:
-      parseHeaderValue(nextChar, currentParseState, readNextChar);
-      break;
-    case ParseState::HEADER_LINE_END_CR:
-      parseHeaderLineEndCR(nextChar, currentParseState, readNextChar);
-      break;
-    case ParseState::HEADER_LINE_END_LF:
-      parseHeaderLineEndLF(nextChar, currentParseState, readNextChar);
-      break;
-    case ParseState::END_OF_HEADER_CR:
-      parseEndOfHeaderCR(nextChar, currentParseState, readNextChar);
-      break;
-    case ParseState::END_OF_HEADER_LF:
-      parseEndOfHeaderLF(nextChar, currentParseState, readNextChar);
+    case ParseState::REQUEST_LINE_END_LF:
+      parseRequestLineEndLF(nextChar, currentParseState, readNextChar);
       break;
+    case ParseState::HEADERS:
     case ParseState::DONE:
     case ParseState::PARSE_ERROR:
       return;
@@ -128,8 +132,34 @@ void RequestParser::processRequest(int file_discriptor) {
   }
 }
 
-void RequestParser::parseMethod(char nextChar, ParseState &currentParseState,
-                                bool &readNextChar) {
+template <typename Policy> void BasicRequestParser<Policy>::finishHeaders() {
+  if constexpr (Policy::requireHost) {
+    // HTTP/1.0 predates Host (RFC 9112 section 3.2)
+    if (request.version == Version::HTTP_1_1 &&
+        !headerParser.seen(HeaderId::HOST)) {
+      // request without host header is a invalid request
+      currentParseState = ParseState::PARSE_ERROR;
+      errorMessage = "Request doesnot contain the mandatory host header";
+      return;
+    }
+  }
+  request.keep_alive =
+      http_parser::is_persistent(request.version, headerParser.connection());
+  // HTTP/1.0 clients do not know 100-continue, the header is ignored
+  request.expectation = request.version == Version::HTTP_1_1
+                            ? headerParser.expectation()
+                            : Expectation::NONE;
+  if constexpr (Policy::storeHeaders) {
+    request.headers = std::move(headerParser.headers());
+    headerParser.headers().clear();
+  }
+  currentParseState = ParseState::DONE;
+}
+
+template <typename Policy>
+void BasicRequestParser<Policy>::parseMethod(char nextChar,
+                                             ParseState &currentParseState,
+                                             bool &readNextChar) {
   char space = 32; // ASCII value for space
   if (nextChar == space && currentMethod.size() > 0) {
     Method method = string_to_method(currentMethod);
@@ -144,8 +174,9 @@ void RequestParser::parseMethod(char nextChar, ParseState &currentParseState,
     currentParseState = ParseState::URL;
     readNextChar = true;
     currentMethod.clear();
-  } else if (std::isspace(nextChar) && currentMethod.size() == 0) {
-    // ignore leading spaces
+  } else if (Policy::skipLeadingWhitespace && std::isspace(nextChar) &&
+             currentMethod.size() == 0) {
+    // ignore leading spaces and empty lines before the request line
     readNextChar = true;
   } else if (std::isalpha(nextChar)) {
     currentMethod += std::toupper(nextChar);
@@ -159,9 +190,9 @@ void RequestParser::parseMethod(char nextChar, ParseState &currentParseState,
   }
 }
 
-std::vector<std::string>
-http_parser::RequestParser::splitString(const std::string &input,
-                                        const std::string &delimiter) {
+template <typename Policy>
+std::vector<std::string> BasicRequestParser<Policy>::splitString(
+    const std::string &input, const std::string &delimiter) {
   std::vector<std::string> result;
   size_t start = 0;
   size_t end = input.find(delimiter);
@@ -177,12 +208,14 @@ http_parser::RequestParser::splitString(const std::string &input,
   return result;
 }
 
-bool RequestParser::isValidUrlChar(char c) {
+template <typename Policy>
+bool BasicRequestParser<Policy>::isValidUrlChar(char c) {
 
   if (std::isalnum(c)) {
     return true;
   }
-  const char *allowedSpecialChars = "-._~:/?#[]@!$&'()*+,;=";
+  // unreserved, reserved and the '%' of percent encoded octets
+  const char *allowedSpecialChars = "-._~:/?#[]@!$&'()*+,;=%";
   for (const char *p = allowedSpecialChars; *p; ++p) {
     if (c == *p) {
       return true;
@@ -191,15 +224,18 @@ bool RequestParser::isValidUrlChar(char c) {
   return false;
 }
 
-void RequestParser::parseUrl(char nextChar, ParseState &currentParseState,
-                             bool &readNextChar) {
+template <typename Policy>
+void BasicRequestParser<Policy>::parseUrl(char nextChar,
+                                          ParseState &currentParseState,
+                                          bool &readNextChar) {
   char space = 32; // ASCII value for space
   if (nextChar == space && currentUrl.size() > 0) {
     request.url = currentUrl;
     currentParseState = ParseState::VERSION;
     readNextChar = true;
     currentUrl.clear();
-  } else if (std::isspace(nextChar) && currentUrl.size() == 0) {
+  } else if (Policy::skipLeadingWhitespace && nextChar == space &&
+             currentUrl.size() == 0) {
     // ignore leading spaces
     readNextChar = true;
   } else if (isValidUrlChar(nextChar)) {
@@ -214,8 +250,10 @@ void RequestParser::parseUrl(char nextChar, ParseState &currentParseState,
   }
 }
 
-void RequestParser::parseVersion(char nextChar, ParseState &currentParseState,
-                                 bool &readNextChar) {
+template <typename Policy>
+void BasicRequestParser<Policy>::parseVersion(char nextChar,
+                                              ParseState &currentParseState,
+                                              bool &readNextChar) {
   char space = 32; // ASCII value for space
   if (std::isspace(nextChar) && nextChar != space) {
     currentParseState = ParseState::PARSE_ERROR;
@@ -223,7 +261,8 @@ void RequestParser::parseVersion(char nextChar, ParseState &currentParseState,
                    "character it contains character with ascii value : " +
                    std::to_string((int)nextChar);
     currentVersion.clear();
-  } else if (currentVersion.size() == 0 && nextChar == space) {
+  } else if (Policy::skipLeadingWhitespace && currentVersion.size() == 0 &&
+             nextChar == space) {
     // ignore leading spaces
     readNextChar = true;
   } else if (std::isalnum(nextChar) || nextChar == '.' || nextChar == '/') {
@@ -237,9 +276,9 @@ void RequestParser::parseVersion(char nextChar, ParseState &currentParseState,
   }
 }
 
-void RequestParser::parseVersionHttpH(char nextChar,
-                                      ParseState &currentParseState,
-                                      bool &readNextChar) {
+template <typename Policy>
+void BasicRequestParser<Policy>::parseVersionHttpH(
+    char nextChar, ParseState &currentParseState, bool &readNextChar) {
   if (std::isalpha(nextChar) && std::toupper(nextChar) == 'H') {
     currentVersion += nextChar;
     currentParseState = ParseState::VERSION_HTTP_T1;
@@ -253,9 +292,9 @@ void RequestParser::parseVersionHttpH(char nextChar,
   }
 }
 
-void RequestParser::parseVersionHttpT1(char nextChar,
-                                       ParseState &currentParseState,
-                                       bool &readNextChar) {
+template <typename Policy>
+void BasicRequestParser<Policy>::parseVersionHttpT1(
+    char nextChar, ParseState &currentParseState, bool &readNextChar) {
   if (std::isalpha(nextChar) && std::toupper(nextChar) == 'T') {
     currentVersion += nextChar;
     currentParseState = ParseState::VERSION_HTTP_T2;
@@ -269,9 +308,9 @@ void RequestParser::parseVersionHttpT1(char nextChar,
   }
 }
 
-void RequestParser::parseVersionHttpT2(char nextChar,
-                                       ParseState &currentParseState,
-                                       bool &readNextChar) {
+template <typename Policy>
+void BasicRequestParser<Policy>::parseVersionHttpT2(
+    char nextChar, ParseState &currentParseState, bool &readNextChar) {
   if (std::isalpha(nextChar) && std::toupper(nextChar) == 'T') {
     currentVersion += nextChar;
     currentParseState = ParseState::VERSION_HTTP_P1;
@@ -285,9 +324,9 @@ void RequestParser::parseVersionHttpT2(char nextChar,
   }
 }
 
-void RequestParser::parseVersionHttpP1(char nextChar,
-                                       ParseState &currentParseState,
-                                       bool &readNextChar) {
+template <typename Policy>
+void BasicRequestParser<Policy>::parseVersionHttpP1(
+    char nextChar, ParseState &currentParseState, bool &readNextChar) {
   if (std::isalpha(nextChar) && std::toupper(nextChar) == 'P') {
     currentVersion += nextChar;
     currentParseState = ParseState::VERSION_SLASH;
@@ -301,9 +340,9 @@ void RequestParser::parseVersionHttpP1(char nextChar,
   }
 }
 
-void RequestParser::parseVersionSlash(char nextChar,
-                                      ParseState &currentParseState,
-                                      bool &readNextChar) {
+template <typename Policy>
+void BasicRequestParser<Policy>::parseVersionSlash(
+    char nextChar, ParseState &currentParseState, bool &readNextChar) {
   if (nextChar == '/') {
     currentVersion += nextChar;
     currentParseState = ParseState::VERSION_MAJOR;
@@ -317,9 +356,9 @@ void RequestParser::parseVersionSlash(char nextChar,
   }
 }
 
-void RequestParser::parseVersionMajor(char nextChar,
-                                      ParseState &currentParseState,
-                                      bool &readNextChar) {
+template <typename Policy>
+void BasicRequestParser<Policy>::parseVersionMajor(
+    char nextChar, ParseState &currentParseState, bool &readNextChar) {
   if (std::isdigit(nextChar)) {
     currentVersion += nextChar;
     currentParseState = ParseState::VERSION_DOT;
@@ -333,9 +372,10 @@ void RequestParser::parseVersionMajor(char nextChar,
   }
 }
 
-void RequestParser::parseVersionDot(char nextChar,
-                                    ParseState &currentParseState,
-                                    bool &readNextChar) {
+template <typename Policy>
+void BasicRequestParser<Policy>::parseVersionDot(char nextChar,
+                                                 ParseState &currentParseState,
+                                                 bool &readNextChar) {
   if (nextChar == '.') {
     currentVersion += nextChar;
     currentParseState = ParseState::VERSION_MINOR;
@@ -350,9 +390,9 @@ void RequestParser::parseVersionDot(char nextChar,
   }
 }
 
-void RequestParser::parseVersionMinor(char nextChar,
-                                      ParseState &currentParseState,
-                                      bool &readNextChar) {
+template <typename Policy>
+void BasicRequestParser<Policy>::parseVersionMinor(
+    char nextChar, ParseState &currentParseState, bool &readNextChar) {
   char space = 32; // ASCII value for space
   if (std::isdigit(nextChar)) {
     currentVersion += nextChar;
@@ -379,18 +419,19 @@ void RequestParser::parseVersionMinor(char nextChar,
   }
 }
 
-void RequestParser::parseRequestLineEnd(char nextChar,
-                                        ParseState &currentParseState,
-                                        bool &readNextChar) {
+template <typename Policy>
+void BasicRequestParser<Policy>::parseRequestLineEnd(
+    char nextChar, ParseState &currentParseState, bool &readNextChar) {
   char cr = 13; // ASCII value for carriage return
   char lf = 10; // ASCII value for line feed
   char space = 32;
-  if(nextChar == space){
+  if (Policy::skipLeadingWhitespace && nextChar == space) {
     readNextChar = true;
-  }else if (nextChar == cr) {
+  } else if (nextChar == cr) {
+    currentParseState = ParseState::REQUEST_LINE_END_LF;
     readNextChar = true;
-  } else if (nextChar == lf) {
-    currentParseState = ParseState::HEADER_KEY;
+  } else if (!Policy::requireCRLF && nextChar == lf) {
+    currentParseState = ParseState::HEADERS;
     readNextChar = true;
   } else {
     errorMessage = "Missing line ending for request line";
@@ -398,133 +439,25 @@ void RequestParser::parseRequestLineEnd(char nextChar,
   }
 }
 
-void RequestParser::parseHeaderKey(char nextChar, ParseState &currentParseState,
-                                   bool &readNextChar) {
-  char cr = 13; // ASCII value for carriage return
-  if (nextChar == cr) {
-    currentParseState = ParseState::END_OF_HEADER_CR;
-  } else if (nextChar == ':') {
-    currentParseState = ParseState::HEADER_DELIMITER;
-  } else if (std::isalnum(nextChar) || nextChar == '-') {
-    if (std::isalpha(nextChar)) {
-      nextChar = std::tolower(nextChar);
-    }
-    currentHeaderKey += nextChar;
-    readNextChar = true;
-  } else {
-    currentParseState = ParseState::PARSE_ERROR;
-    errorMessage = "Invalid header key in request body, " + currentHeaderKey +
-                   " , contains invalid character with ascii value : " +
-                   std::to_string((int)nextChar) + " , which is incorrect";  
-    currentHeaderKey.clear();
-  }
-}
-
-void RequestParser::parseHeaderDelimiter(char nextChar,
-                                         ParseState &currentParseState,
-                                         bool &readNextChar) {
-  char space = 32; // ASCII value for space
-  if (nextChar == space) {
-    readNextChar = true;
-  } else if (nextChar == ':') {
-    currentParseState = ParseState::HEADER_VALUE;
-    readNextChar = true;
-  } else {
-    currentParseState = ParseState::PARSE_ERROR;
-    errorMessage = "Header key doesnot contain delimiter for header value, it "
-                   "contains character with ascii value : " +
-                   std::to_string((int)nextChar);
-  }
-}
-
-void RequestParser::parseHeaderValue(char nextChar,
-                                     ParseState &currentParseState,
-                                     bool &readNextChar) {
-  char cr = 13;         // ASCII value for carriage return
-  char whitespace = 32; // ASCII value for space
-  if (nextChar == cr) {
-    currentParseState = ParseState::HEADER_LINE_END_CR;
-  } else if (nextChar == whitespace) {
-    readNextChar = true;
-  } else {
-    currentHeaderValue += nextChar;
-    readNextChar = true;
-  }
-}
-
-void RequestParser::parseHeaderLineEndCR(char nextChar,
-                                         ParseState &currentParseState,
-                                         bool &readNextChar) {
-  char cr = 13; // ASCII value for carriage return
-  if (nextChar == cr) {
-    readNextChar = true;
-    currentParseState = ParseState::HEADER_LINE_END_LF;
-  } else {
-    errorMessage = "Header key doesnot contain line ending, it "
-                   "contains character with ascii value : " +
-                   std::to_string((int)nextChar);
-    currentParseState = ParseState::PARSE_ERROR;
-  }
-}
-
-void RequestParser::parseHeaderLineEndLF(char nextChar,
-                                         ParseState &currentParseState,
-                                         bool &readNextChar) {
+template <typename Policy>
+void BasicRequestParser<Policy>::parseRequestLineEndLF(
+    char nextChar, ParseState &currentParseState, bool &readNextChar) {
   char lf = 10; // ASCII value for line feed
   if (nextChar == lf) {
+    currentParseState = ParseState::HEADERS;
     readNextChar = true;
-    request.headers.push_back(Header{currentHeaderKey, currentHeaderValue});
-    currentHeaderKey.clear();
-    currentHeaderValue.clear();
-    currentParseState = ParseState::HEADER_KEY; // read the next header key
   } else {
-    currentParseState = ParseState::PARSE_ERROR;
-    errorMessage = "Header value : " + currentHeaderValue +
-                   " doesnot contain line ending, it "
-                   "contains character with ascii value : " +
-                   std::to_string((int)nextChar);
-    currentHeaderValue.clear();
-    currentHeaderKey.clear();
-  }
-}
-
-void RequestParser::parseEndOfHeaderCR(char nextChar,
-                                       ParseState &currentParseState,
-                                       bool &readNextChar) {
-  char cr = 13; // ASCII value for carriage return
-  if (nextChar == cr) {
-    readNextChar = true;
-    currentParseState = ParseState::END_OF_HEADER_LF;
-  } else {
-    errorMessage =
-        "Headers doesnot contain carriage return after all the "
-        "headers, it contains character with ascii value : " +
-        std::to_string((int)nextChar) + std::string(" where it should have had carriage return");
+    errorMessage = "Missing line feed after carriage return in request line";
     currentParseState = ParseState::PARSE_ERROR;
   }
 }
 
-void RequestParser::parseEndOfHeaderLF(char nextChar,
-                                       ParseState &currentParseState,
-                                       bool &readNextChar) {
-  char lf = 10; // ASCII value for line feed
-  if (nextChar == lf) {
-    currentParseState = ParseState::DONE;
-  } else {
-    currentParseState = ParseState::PARSE_ERROR;
-    errorMessage = "Headers doesnot contain line ending after all the "
-                   "headers, it contains character with ascii value : " +
-                   std::to_string((int)nextChar) +
-                   std::string(" where it should have had line ending");
-  }
-}
-
-void RequestParser::reset() {
+template <typename Policy>
+void BasicRequestParser<Policy>::reset() {
   currentMethod.clear();
   currentUrl.clear();
   currentVersion.clear();
-  currentHeaderKey.clear();
-  currentHeaderValue.clear();
+  headerParser.reset();
   request = Request();
   errorMessage.clear();
   requestData.clear();
@@ -532,9 +465,11 @@ void RequestParser::reset() {
   currentParseState = ParseState::METHOD;
 }
 
-Request RequestParser::get_request() { return request; }
+template <typename Policy>
+Request BasicRequestParser<Policy>::get_request() { return request; }
 
-std::string http_parser::RequestParser::getErrorMessage() {
+template <typename Policy>
+std::string BasicRequestParser<Policy>::getErrorMessage() {
   if (currentParseState != ParseState::PARSE_ERROR) {
     return std::string();
   }
@@ -554,4 +489,12 @@ std::string http_parser::RequestParser::getErrorMessage() {
   return errorMessage + "\n";
 }
 
-RequestParser::~RequestParser() {}
\ No newline at end of file
+template <typename Policy>
+BasicRequestParser<Policy>::~BasicRequestParser() {}
+
+namespace http_parser {
+template class BasicRequestParser<DefaultParserPolicy>;
+template class BasicRequestParser<StrictParserPolicy>;
+template class BasicRequestParser<LenientParserPolicy>;
+template class BasicRequestParser<HealthCheckParserPolicy>;
+}; // namespace http_parser
\ No newline at end of file
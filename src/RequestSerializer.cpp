@@ -0,0 +1,103 @@
+#include "RequestSerializer.hpp"
+#include "Text.h"
+
+using http_parser::HeaderId;
+using http_parser::Method;
+using http_parser::Request;
+using http_parser::RequestSerializer;
+using http_parser::detail::appendNumber;
+
+namespace {
+
+// methods whose requests are expected to carry content
+bool methodExpectsBody(Method method) {
+  return method == Method::METHOD_POST || method == Method::METHOD_PUT ||
+         method == Method::METHOD_PATCH;
+}
+
+bool hasLineBreak(std::string_view text) {
+  return text.find_first_of("\r\n") != std::string_view::npos;
+}
+
+} // namespace
+
+RequestSerializer::RequestSerializer()
+    : iov{}, iovCount{0}, iovIndex{0}, remainingBytes{0}, bodyBytes{0} {
+  headerBuffer.reserve(1024);
+}
+
+bool RequestSerializer::serialize(const Request &request,
+                                  std::string_view body) {
+  return serialize(request, &body, body.empty() ? 0 : 1);
+}
+
+bool RequestSerializer::serialize(const Request &request,
+                                  const std::string_view *bodyParts,
+                                  std::size_t partCount) {
+  iovCount = 0;
+  iovIndex = 0;
+  remainingBytes = 0;
+  bodyBytes = 0;
+  headerBuffer.clear();
+  if (partCount > MAX_BODY_PARTS || request.method == Method::METHOD_UNKOWN ||
+      request.url.empty() ||
+      request.url.find_first_of(" \t\r\n") != std::string::npos) {
+    return false;
+  }
+
+  headerBuffer += http_parser::method_to_string(request.method);
+  headerBuffer += ' ';
+  headerBuffer += request.url;
+  headerBuffer += " HTTP/1.1\r\n";
+
+  for (std::size_t i = 0; i < partCount; i++) {
+    bodyBytes += bodyParts[i].size();
+  }
+
+  for (HeaderView header : request.headers) {
+    // refuse anything that would split the header block
+    if (hasLineBreak(header.key) || hasLineBreak(header.value)) {
+      headerBuffer.clear();
+      return false;
+    }
+    headerBuffer.append(header.key.data(), header.key.size());
+    headerBuffer += ": ";
+    headerBuffer.append(header.value.data(), header.value.size());
+    headerBuffer += "\r\n";
+  }
+  if (!defaultHost.empty() && !request.headers.contains(HeaderId::HOST)) {
+    headerBuffer += "host: ";
+    headerBuffer += defaultHost;
+    headerBuffer += "\r\n";
+  }
+  if ((bodyBytes > 0 || methodExpectsBody(request.method)) &&
+      !request.headers.contains(HeaderId::CONTENT_LENGTH) &&
+      !request.headers.contains(HeaderId::TRANSFER_ENCODING)) {
+    headerBuffer += "content-length: ";
+    appendNumber(headerBuffer, bodyBytes);
+    headerBuffer += "\r\n";
+  }
+  headerBuffer += "\r\n";
+
+  iov[iovCount++] = iovec{headerBuffer.data(), headerBuffer.size()};
+  remainingBytes += headerBuffer.size();
+  for (std::size_t i = 0; i < partCount; i++) {
+    if (bodyParts[i].empty()) {
+      continue;
+    }
+    iov[iovCount++] = iovec{const_cast<char *>(bodyParts[i].data()),
+                            bodyParts[i].size()};
+  }
+  remainingBytes += bodyBytes;
+  return true;
+}
+
+void RequestSerializer::consume(std::size_t bytes) {
+  remainingBytes -= bytes < remainingBytes ? bytes : remainingBytes;
+  http_parser::iovec_consume(iov.data(), iovCount, iovIndex, bytes);
+}
+
+bool RequestSerializer::write(int file_descriptor) {
+  return http_parser::iovec_write(file_descriptor, iov.data(), iovCount,
+                                  iovIndex, remainingBytes);
+}
@@ -0,0 +1,404 @@
+#include "ResponseCache.hpp"
+#include "HeaderValue.hpp"
+#include "HttpDate.hpp"
+#include "Text.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <ctime>
+#include <functional>
+#include <mutex>
+
+using http_parser::CacheStats;
+using http_parser::HeaderId;
+using http_parser::Headers;
+using http_parser::Request;
+using http_parser::Response;
+using http_parser::ResponseCache;
+using http_parser::detail::trim;
+
+namespace {
+
+constexpr std::size_t maxVaryNames = 16;
+// upper bound of the heuristic freshness derived from Last-Modified
+constexpr std::int64_t maxHeuristicLifetime = 24 * 60 * 60;
+
+// Calls `visit` with every element of the comma separated lists in all
+// headers with the given id, stops when it returns false.
+template <typename Visitor>
+void forEachToken(const Headers &headers, HeaderId id, Visitor visit) {
+  for (auto it = headers.find(id); it != headers.end();
+       it = headers.find(id, it.position() + 1)) {
+    for (std::string_view token : http_parser::TokenList((*it).value)) {
+      if (!visit(token)) {
+        return;
+      }
+    }
+  }
+}
+
+// true if cache-control carries one of the given directives
+bool hasDirective(const Headers &headers,
+                  std::initializer_list<std::string_view> directives) {
+  bool found = false;
+  forEachToken(headers, HeaderId::CACHE_CONTROL, [&](std::string_view token) {
+    std::string_view name = trim(token.substr(0, token.find('=')));
+    for (std::string_view directive : directives) {
+      found |= http_parser::header_name_equals(name, directive);
+    }
+    return !found;
+  });
+  return found;
+}
+
+// The value of the first cache-control directive named `name`, without
+// quotes. Returns false if there is no such directive.
+bool directiveValue(const Headers &headers, std::string_view name,
+                    std::string_view &value) {
+  bool found = false;
+  forEachToken(headers, HeaderId::CACHE_CONTROL, [&](std::string_view token) {
+    std::size_t equals = token.find('=');
+    if (!http_parser::header_name_equals(trim(token.substr(0, equals)),
+                                         name)) {
+      return true;
+    }
+    found = true;
+    value = equals == std::string_view::npos ? std::string_view()
+                                             : trim(token.substr(equals + 1));
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+      value = value.substr(1, value.size() - 2);
+    }
+    return false;
+  });
+  return found;
+}
+
+// delta-seconds (RFC 9111 section 1.2.2), saturated; malformed values are 0
+// so the response counts as stale
+std::int64_t deltaSeconds(std::string_view text) {
+  constexpr std::int64_t limit = 2147483648;
+  if (text.empty()) {
+    return 0;
+  }
+  std::int64_t seconds = 0;
+  for (char c : text) {
+    if (c < '0' || c > '9') {
+      return 0;
+    }
+    seconds = std::min(seconds * 10 + (c - '0'), limit);
+  }
+  return seconds;
+}
+
+// Seconds since the epoch until which the response is fresh (RFC 9111
+// section 4.2): s-maxage, max-age, Expires minus Date, or a tenth of the
+// time since Last-Modified. Responses without any of them expire at once.
+std::int64_t expiryTime(const Response &response, std::int64_t now) {
+  const Headers &headers = response.headers;
+  std::int64_t date = now;
+  std::int64_t parsed = 0;
+  if (http_parser::parse_http_date(trim(headers.value_of(HeaderId::DATE)),
+                                   parsed)) {
+    date = parsed;
+  }
+  std::int64_t lifetime = 0;
+  std::string_view value;
+  if (directiveValue(headers, "s-maxage", value) ||
+      directiveValue(headers, "max-age", value)) {
+    lifetime = deltaSeconds(value);
+  } else if (headers.contains(HeaderId::EXPIRES)) {
+    // invalid dates, like "0", mean already expired
+    if (http_parser::parse_http_date(
+            trim(headers.value_of(HeaderId::EXPIRES)), parsed)) {
+      lifetime = parsed - date;
+    }
+  } else if (http_parser::parse_http_date(
+                 trim(headers.value_of(HeaderId::LAST_MODIFIED)), parsed) &&
+             parsed < date) {
+    lifetime = std::min((date - parsed) / 10, maxHeuristicLifetime);
+  }
+  std::int64_t age = std::max(
+      deltaSeconds(trim(headers.value_of(HeaderId::AGE))), now - date);
+  return now + lifetime - std::max<std::int64_t>(age, 0);
+}
+
+std::int64_t currentTime() {
+  return static_cast<std::int64_t>(std::time(nullptr));
+}
+
+// Method and effective request URI (RFC 9112 section 3.3): origin-form
+// targets get the scheme and the Host header in front, so virtual hosts
+// don't share entries.
+bool primaryKey(const Request &request, std::string_view scheme,
+                std::string &out) {
+  out.clear();
+  out += http_parser::method_to_string(request.method);
+  out += ' ';
+  if (request.target().form() != http_parser::TargetForm::ORIGIN) {
+    return http_parser::normalize_target(request.url, out);
+  }
+  std::string_view host = trim(request.headers.value_of(HeaderId::HOST));
+  if (host.find_first_of("/?#@ \t") != std::string_view::npos) {
+    return false;
+  }
+  thread_local std::string uri;
+  uri.assign(scheme.data(), scheme.size());
+  uri += "://";
+  uri.append(host.data(), host.size());
+  uri += request.url;
+  return http_parser::normalize_target(uri, out);
+}
+
+// Lower-cased, sorted and deduplicated names of the vary header. Returns
+// false for "vary: *" or too many names.
+bool varyNames(const Response &response, std::string &out) {
+  std::array<std::string_view, maxVaryNames> names;
+  std::size_t count = 0;
+  bool valid = true;
+  forEachToken(response.headers, HeaderId::VARY, [&](std::string_view name) {
+    if (name == "*" || count == names.size()) {
+      valid = false;
+      return false;
+    }
+    names[count++] = name;
+    return true;
+  });
+  if (!valid) {
+    return false;
+  }
+  auto lessIgnoreCase = [](std::string_view a, std::string_view b) {
+    return std::lexicographical_compare(
+        a.begin(), a.end(), b.begin(), b.end(), [](char x, char y) {
+          return std::tolower(static_cast<unsigned char>(x)) <
+                 std::tolower(static_cast<unsigned char>(y));
+        });
+  };
+  std::sort(names.begin(), names.begin() + count, lessIgnoreCase);
+  out.clear();
+  for (std::size_t i = 0; i < count; i++) {
+    if (i > 0 && http_parser::header_name_equals(names[i], names[i - 1])) {
+      continue;
+    }
+    if (!out.empty()) {
+      out += ',';
+    }
+    for (char c : names[i]) {
+      out += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+  }
+  return true;
+}
+
+// Fresh 200 responses without no-store, no-cache, private, Set-Cookie or
+// "vary: *", with the vary names in `names` and the end of the freshness
+// in `expires`. The cache can't revalidate, so no-cache is never stored.
+bool storableResponse(const Response &response, std::string &names,
+                      std::int64_t &expires) {
+  if (response.status_code != http_parser::StatusCode::OK ||
+      hasDirective(response.headers, {"no-store", "no-cache", "private"}) ||
+      response.headers.contains(HeaderId::SET_COOKIE) ||
+      !varyNames(response, names)) {
+    return false;
+  }
+  std::int64_t now = currentTime();
+  expires = expiryTime(response, now);
+  return expires > now;
+}
+
+// Responses to requests with credentials are only shared when the response
+// allows it explicitly (RFC 9111 section 3.5).
+bool sharedWithCredentials(const Request &request, const Response &response) {
+  return !request.headers.contains(HeaderId::AUTHORIZATION) ||
+         hasDirective(response.headers,
+                      {"public", "s-maxage", "must-revalidate"});
+}
+
+// Appends the request's values of every vary header to the key.
+void appendVaryValues(const Request &request, std::string_view names,
+                      std::string &key) {
+  key += '\0';
+  while (!names.empty()) {
+    std::size_t comma = names.find(',');
+    std::string_view name = names.substr(0, comma);
+    names = comma == std::string_view::npos ? std::string_view()
+                                            : names.substr(comma + 1);
+    for (auto it = request.headers.find(name); it != request.headers.end();
+         it = request.headers.find(name, it.position() + 1)) {
+      key += trim((*it).value);
+      key += ',';
+    }
+    key += '\n';
+  }
+}
+
+} // namespace
+
+ResponseCache::ResponseCache(std::size_t capacityBytes,
+                             std::size_t shardCount, std::string_view scheme)
+    : scheme(scheme) {
+  if (shardCount == 0) {
+    shardCount = 1;
+  }
+  shardCapacity = capacityBytes / shardCount;
+  shards.reserve(shardCount);
+  for (std::size_t i = 0; i < shardCount; i++) {
+    shards.push_back(std::make_unique<Shard>());
+    shards.back()->hand = shards.back()->nodes.end();
+  }
+}
+
+bool ResponseCache::is_cacheable(const Request &request) {
+  return request.method == Method::METHOD_GET &&
+         !hasDirective(request.headers, {"no-store", "no-cache"});
+}
+
+bool ResponseCache::is_storable(const Response &response) {
+  std::string names;
+  std::int64_t expires = 0;
+  return storableResponse(response, names, expires);
+}
+
+ResponseCache::Shard &ResponseCache::shardFor(std::string_view primaryKey) {
+  return *shards[std::hash<std::string_view>{}(primaryKey) % shards.size()];
+}
+
+ResponseCache::Entry ResponseCache::lookup(const Request &request) {
+  thread_local std::string key;
+  if (!is_cacheable(request) || !primaryKey(request, scheme, key)) {
+    missCount.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  Shard &shard = shardFor(key);
+  std::shared_lock<std::shared_mutex> lock(shard.mutex);
+  auto variants = shard.variants.find(key);
+  if (variants != shard.variants.end()) {
+    appendVaryValues(request, variants->second.varyNames, key);
+    auto node = shard.index.find(key);
+    // stale entries are misses, CLOCK drops them once they stay unreferenced
+    if (node != shard.index.end() && node->second->expires > currentTime()) {
+      node->second->referenced.store(true, std::memory_order_relaxed);
+      hitCount.fetch_add(1, std::memory_order_relaxed);
+      return node->second->bytes;
+    }
+  }
+  missCount.fetch_add(1, std::memory_order_relaxed);
+  return nullptr;
+}
+
+bool ResponseCache::insert(const Request &request, const Response &response,
+                           std::string_view bytes) {
+  std::string key;
+  std::string names;
+  std::int64_t expires = 0;
+  if (!is_cacheable(request) || !storableResponse(response, names, expires) ||
+      !sharedWithCredentials(request, response) ||
+      !primaryKey(request, scheme, key)) {
+    return false;
+  }
+  std::size_t primaryLength = key.size();
+  Shard &shard = shardFor(key);
+  std::unique_lock<std::shared_mutex> lock(shard.mutex);
+
+  Shard::Variants &variants = shard.variants[key];
+  appendVaryValues(request, names, key);
+  std::size_t cost = bytes.size() + key.size();
+  if (cost > shardCapacity) {
+    if (variants.count == 0) {
+      shard.variants.erase(key.substr(0, primaryLength));
+    }
+    return false;
+  }
+  // only an accepted entry changes the vary list: a changed list makes the
+  // old variants unreachable, CLOCK drops them as they are never referenced
+  // again
+  variants.varyNames = names;
+
+  auto existing = shard.index.find(key);
+  if (existing != shard.index.end()) {
+    // replaced like a new entry, so the eviction below keeps the shard
+    // within its budget
+    auto node = existing->second;
+    if (shard.hand == node) {
+      ++shard.hand;
+    }
+    shard.index.erase(existing);
+    shard.bytes -= node->bytes->size() + node->key.size();
+    shard.nodes.erase(node);
+  } else {
+    variants.count++;
+  }
+  // evicting may remove the variants record of this key when its count
+  // drops to zero, the new entry is counted first so it stays
+  while (shard.bytes + cost > shardCapacity && !shard.nodes.empty()) {
+    evictOne(shard);
+  }
+  auto node = shard.nodes.emplace(shard.hand);
+  node->key = std::move(key);
+  node->primaryLength = primaryLength;
+  node->expires = expires;
+  node->bytes = std::make_shared<const std::string>(bytes);
+  shard.index.emplace(node->key, node);
+  shard.bytes += cost;
+  insertCount.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+bool ResponseCache::insert(const Request &request, const Response &response,
+                           const ResponseSerializer &serializer) {
+  std::string bytes;
+  bytes.reserve(serializer.size());
+  for (std::size_t i = 0; i < serializer.iovec_count(); i++) {
+    const iovec &part = serializer.iovecs()[i];
+    bytes.append(static_cast<const char *>(part.iov_base), part.iov_len);
+  }
+  return insert(request, response, bytes);
+}
+
+// CLOCK: entries referenced since the hand last passed get a second chance
+void ResponseCache::evictOne(Shard &shard) {
+  while (true) {
+    if (shard.hand == shard.nodes.end()) {
+      shard.hand = shard.nodes.begin();
+    }
+    Node &node = *shard.hand;
+    if (node.referenced.exchange(false, std::memory_order_relaxed)) {
+      ++shard.hand;
+      continue;
+    }
+    std::string_view primary(node.key.data(), node.primaryLength);
+    auto variants = shard.variants.find(std::string(primary));
+    if (variants != shard.variants.end() && --variants->second.count == 0) {
+      shard.variants.erase(variants);
+    }
+    shard.index.erase(node.key);
+    shard.bytes -= node.bytes->size() + node.key.size();
+    shard.hand = shard.nodes.erase(shard.hand);
+    evictionCount.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+}
+
+void ResponseCache::clear() {
+  for (std::unique_ptr<Shard> &shard : shards) {
+    std::unique_lock<std::shared_mutex> lock(shard->mutex);
+    shard->index.clear();
+    shard->variants.clear();
+    shard->nodes.clear();
+    shard->hand = shard->nodes.end();
+    shard->bytes = 0;
+  }
+}
+
+CacheStats ResponseCache::stats() const {
+  CacheStats result;
+  result.hits = hitCount.load(std::memory_order_relaxed);
+  result.misses = missCount.load(std::memory_order_relaxed);
+  result.insertions = insertCount.load(std::memory_order_relaxed);
+  result.evictions = evictionCount.load(std::memory_order_relaxed);
+  for (const std::unique_ptr<Shard> &shard : shards) {
+    std::shared_lock<std::shared_mutex> lock(shard->mutex);
+    result.entries += shard->nodes.size();
+    result.bytes += shard->bytes;
+  }
+  return result;
+}
@@ -3,7 +3,6 @@
 #include "OS.h"
 #include <cctype>
 
-using http_parser::Header;
 using http_parser::Response;
 using http_parser::ResponseParser;
 using http_parser::ResponseParseState;
@@ -15,41 +14,60 @@ ResponseParser::ResponseParser()
 
 bool ResponseParser::parse(int file_descriptor) {
   reset();
-  processResponse(file_descriptor);
+  // read one byte at a time, so the body is left in the file discriptor
+  char nextChar;
+  while (currentParseState != ResponseParseState::DONE &&
+         currentParseState != ResponseParseState::PARSE_ERROR) {
+    int byteRead = ::read(file_descriptor, &nextChar, 1);
+    if (byteRead <= 0) {
+      perror("Error reading from file discriptor");
+      return false;
+    }
+    execute(&nextChar, 1);
+  }
   return currentParseState == ResponseParseState::DONE;
 }
 
+std::size_t ResponseParser::execute(const char *data, std::size_t length) {
+  std::size_t consumed = 0;
+  while (consumed < length &&
+         currentParseState != ResponseParseState::DONE &&
+         currentParseState != ResponseParseState::PARSE_ERROR) {
+    if (currentParseState == ResponseParseState::HEADERS) {
+      consumed += headerParser.execute(data + consumed, length - consumed);
+      if (headerParser.done()) {
+        response.keep_alive = http_parser::is_persistent(
+            response.version, headerParser.connection());
+        response.headers = std::move(headerParser.headers());
+        headerParser.headers().clear();
+        currentParseState = ResponseParseState::DONE;
+      } else if (headerParser.failed()) {
+        currentParseState = ResponseParseState::PARSE_ERROR;
+      }
+      continue;
+    }
+    processChar(data[consumed]);
+    consumed++;
+  }
+  return consumed;
+}
+
 void ResponseParser::reset() {
   currentParseState = ResponseParseState::VERSION;
   response = Response();
   currentVersion = "";
   currentStatusCode = "";
   currentStatusMessage = "";
-  currentHeaderKey = "";
-  currentHeaderValue = "";
+  headerParser.reset();
 }
 
 Response ResponseParser::get_response() const { return response; }
 
 bool ResponseParser::isValidStatusCodeChar(char c) { return isdigit(c); }
 
-bool ResponseParser::isValidHeaderKeyChar(char c) {
-  return isalnum(c) || c == '-';
-}
-
-void ResponseParser::processResponse(int file_descriptor) {
-  char nextChar;
-  bool readNextChar = true;
-  while (currentParseState != ResponseParseState::DONE &&
-         currentParseState != ResponseParseState::PARSE_ERROR) {
-    if (readNextChar) {
-      readNextChar = false;
-      int byteRead = ::read(file_descriptor, &nextChar, 1);
-      if (byteRead <= 0) {
-        perror("Error reading from file discriptor");
-        return;
-      }
-    }
+void ResponseParser::processChar(char nextChar) {
+  bool readNextChar = false;
+  while (!readNextChar) {
     switch (currentParseState) {
     case ResponseParseState::VERSION:
       parseVersion(nextChar, currentParseState, readNextChar);
@@ -93,33 +111,10 @@ void ResponseParser::processResponse(int file_descriptor) {
     case ResponseParseState::STATUS_MESSAGE_LF:
       parseStatusMessageLF(nextChar, currentParseState, readNextChar);
       break;
-    case ResponseParseState::END_OF_HEADER_CR:
-      parseEndOfHeaderCR(nextChar, currentParseState, readNextChar);
-      break;
-    case ResponseParseState::END_OF_HEADER_LF:
-      parseEndOfHeaderLF(nextChar, currentParseState, readNextChar);
-      break;
-    case ResponseParseState::HEADER_KEY:
-      parseHeaderKey(nextChar, currentParseState, readNextChar);
-      break;
-    case ResponseParseState::HEADER_DELIMITER:
-      parseHeaderDelimiter(nextChar, currentParseState, readNextChar);
-      break;
-    case ResponseParseState::HEADER_VALUE:
-      parseHeaderValue(nextChar, currentParseState, readNextChar);
-      break;
-    case ResponseParseState::HEADER_LINE_END_CR:
-      parseHeaderLineEndCR(nextChar, currentParseState, readNextChar);
-      break;
-    case ResponseParseState::HEADER_LINE_END_LF:
-      parseHeaderLineEndLF(nextChar, currentParseState, readNextChar);
-      break;
+    case ResponseParseState::HEADERS:
     case ResponseParseState::DONE:
-      readNextChar = false;
-      break;
     case ResponseParseState::PARSE_ERROR:
-      readNextChar = false;
-      break;
+      return;
     }
   }
 }
@@ -238,7 +233,8 @@ void ResponseParser::parseVersionMinor(char nextChar,
 void ResponseParser::parseStatusCode(char nextChar,
                                      ResponseParseState &currentParseState,
                                      bool &readNextChar) {
-  char whitespace = 32; // ASCII value for space
+  char whitespace = 32;     // ASCII value for space
+  char carriageReturn = 13; // ASCII value for carriage return
   if (isValidStatusCodeChar(nextChar) && currentStatusCode.size() < 3) {
     currentStatusCode += nextChar;
     readNextChar = true;
@@ -250,6 +246,12 @@ void ResponseParser::parseStatusCode(char nextChar,
   } else if (nextChar == whitespace && currentStatusCode.empty()) {
     // ignore whitespace
     readNextChar = true;
+  } else if (nextChar == carriageReturn && currentStatusCode.size() == 3) {
+    // no reason phrase and no space before the line end
+    response.status_code =
+        http_parser::string_to_status_code(currentStatusCode);
+    currentParseState = ResponseParseState::STATUS_MESSAGE_CR;
+    currentStatusCode.clear();
   } else {
     currentParseState = ResponseParseState::PARSE_ERROR;
   }
@@ -270,7 +272,8 @@ void ResponseParser::parseStatusMessage(char nextChar,
                                         ResponseParseState &currentParseState,
                                         bool &readNextChar) {
   char carriageReturn = 13; // ASCII value for carriage return
-  if (nextChar == carriageReturn && !currentStatusMessage.empty()) {
+  // the reason phrase may be empty (RFC 9112 section 4)
+  if (nextChar == carriageReturn) {
     currentParseState = ResponseParseState::STATUS_MESSAGE_CR;
   } else if (std::isprint(nextChar) && nextChar >= 32 && nextChar <= 126) {
     currentStatusMessage += nextChar;
@@ -298,111 +301,10 @@ void ResponseParser::parseStatusMessageLF(char nextChar,
   char lineFeed = 10; // ASCII value for line feed
   if (nextChar == lineFeed) {
     response.status_message = currentStatusMessage;
-    currentParseState = ResponseParseState::HEADER_KEY;
+    currentParseState = ResponseParseState::HEADERS;
     currentStatusMessage.clear();
     readNextChar = true;
   } else {
     currentParseState = ResponseParseState::PARSE_ERROR;
   }
-}
-
-void ResponseParser::parseEndOfHeaderCR(char nextChar,
-                                        ResponseParseState &currentParseState,
-                                        bool &readNextChar) {
-  char carriageReturn = 13; // ASCII value for carriage return
-  if (nextChar == carriageReturn) {
-    currentParseState = ResponseParseState::END_OF_HEADER_LF;
-    readNextChar = true;
-  } else {
-    currentParseState = ResponseParseState::PARSE_ERROR;
-  }
-}
-
-void ResponseParser::parseEndOfHeaderLF(char nextChar,
-                                        ResponseParseState &currentParseState,
-                                        bool &readNextChar) {
-  char lineFeed = 10; // ASCII value for line feed
-  if (nextChar == lineFeed) {
-    currentParseState = ResponseParseState::DONE;
-    readNextChar = true;
-  } else {
-    currentParseState = ResponseParseState::PARSE_ERROR;
-  }
-}
-
-void ResponseParser::parseHeaderKey(char nextChar,
-                                    ResponseParseState &currentParseState,
-                                    bool &readNextChar) {
-  char whitespace = 32;     // ASCII value for space
-  char carriageReturn = 13; // ASCII value for carriage return
-  if (nextChar == carriageReturn) {
-    currentParseState = ResponseParseState::END_OF_HEADER_CR;
-  } else if (isValidHeaderKeyChar(nextChar)) {
-    currentHeaderKey += std::tolower(nextChar);
-    readNextChar = true;
-  } else if (nextChar == whitespace) {
-    // ignore whitespace
-    readNextChar = true;
-  } else if (nextChar == ':') {
-    currentParseState = ResponseParseState::HEADER_DELIMITER;
-  } else {
-    currentParseState = ResponseParseState::PARSE_ERROR;
-  }
-}
-
-void ResponseParser::parseHeaderDelimiter(char nextChar,
-                                          ResponseParseState &currentParseState,
-                                          bool &readNextChar) {
-  char whitespace = 32; // ASCII value for space
-  if (nextChar == whitespace) {
-    // ignore whitespace
-    readNextChar = true;
-  } else if (nextChar == ':') {
-    currentParseState = ResponseParseState::HEADER_VALUE;
-    readNextChar = true;
-  } else {
-    currentParseState = ResponseParseState::PARSE_ERROR;
-  }
-}
-
-void ResponseParser::parseHeaderValue(char nextChar,
-                                      ResponseParseState &currentParseState,
-                                      bool &readNextChar) {
-  char carriageReturn = 13; // ASCII value for carriage return
-  if (nextChar == carriageReturn) {
-    currentParseState = ResponseParseState::HEADER_LINE_END_CR;
-  } else if (std::isprint(nextChar) && nextChar >= 32 && nextChar <= 126) {
-    currentHeaderValue += nextChar;
-    readNextChar = true;
-  } else {
-    currentParseState = ResponseParseState::PARSE_ERROR;
-  }
-}
-
-void ResponseParser::parseHeaderLineEndCR(char nextChar,
-                                          ResponseParseState &currentParseState,
-                                          bool &readNextChar) {
-  char carriageReturn = 13; // ASCII value for carriage return
-  if (nextChar == carriageReturn) {
-    currentParseState = ResponseParseState::HEADER_LINE_END_LF;
-    readNextChar = true;
-  } else {
-    currentParseState = ResponseParseState::PARSE_ERROR;
-  }
-}
-
-void ResponseParser::parseHeaderLineEndLF(char nextChar,
-                                          ResponseParseState &currentParseState,
-                                          bool &readNextChar) {
-  char lineFeed = 10; // ASCII value for line feed
-  if (nextChar == lineFeed) {
-    Header header = {currentHeaderKey, currentHeaderValue};
-    response.headers.push_back(header);
-    currentHeaderKey.clear();
-    currentHeaderValue.clear();
-    currentParseState = ResponseParseState::HEADER_KEY;
-    readNextChar = true;
-  } else {
-    currentParseState = ResponseParseState::PARSE_ERROR;
-  }
 }
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include "ResponseSerializer.hpp"
+#include "HttpDate.hpp"
+#include "Text.h"
+
+using http_parser::HeaderId;
+using http_parser::Response;
+using http_parser::ResponseSerializer;
+using http_parser::StatusCode;
+using http_parser::detail::appendNumber;
+
+namespace {
+
+// 1xx, 204 and 304 responses never carry a body
+bool statusAllowsBody(int code) {
+  return code >= 200 && code != 204 && code != 304;
+}
+
+bool hasLineBreak(std::string_view text) {
+  return text.find_first_of("\r\n") != std::string_view::npos;
+}
+
+} // namespace
+
+ResponseSerializer::ResponseSerializer()
+    : iov{}, iovCount{0}, iovIndex{0}, remainingBytes{0}, bodyBytes{0},
+      addDateHeader{true}, addContentLength{true} {
+  headerBuffer.reserve(1024);
+}
+
+bool ResponseSerializer::serialize(const Response &response,
+                                   std::string_view body) {
+  return serialize(response, &body, body.empty() ? 0 : 1);
+}
+
+bool ResponseSerializer::serialize(const Response &response,
+                                   const std::string_view *bodyParts,
+                                   std::size_t partCount) {
+  iovCount = 0;
+  iovIndex = 0;
+  remainingBytes = 0;
+  bodyBytes = 0;
+  headerBuffer.clear();
+  if (partCount > MAX_BODY_PARTS) {
+    return false;
+  }
+
+  // three digits starting with 1 to 5 (RFC 9110 section 15)
+  int code = static_cast<int>(response.status_code);
+  if (code < 100 || code > 599) {
+    return false;
+  }
+  std::string_view statusLine;
+  if (response.status_message.empty() ||
+      response.status_message ==
+          http_parser::status_code_to_reason(response.status_code)) {
+    statusLine = http_parser::status_line(response.status_code);
+  }
+  if (statusLine.empty()) {
+    // custom reason phrase or a code without a table entry
+    if (hasLineBreak(response.status_message)) {
+      return false;
+    }
+    headerBuffer += "HTTP/1.1 ";
+    appendNumber(headerBuffer, static_cast<unsigned long long>(code));
+    headerBuffer += ' ';
+    headerBuffer += response.status_message;
+    headerBuffer += "\r\n";
+  }
+
+  for (std::size_t i = 0; i < partCount; i++) {
+    bodyBytes += bodyParts[i].size();
+  }
+
+  for (HeaderView header : response.headers) {
+    // refuse anything that would split the header block
+    if (hasLineBreak(header.key) || hasLineBreak(header.value)) {
+      headerBuffer.clear();
+      return false;
+    }
+    headerBuffer.append(header.key.data(), header.key.size());
+    headerBuffer += ": ";
+    headerBuffer.append(header.value.data(), header.value.size());
+    headerBuffer += "\r\n";
+  }
+  if (addDateHeader && code >= 200 &&
+      !response.headers.contains(HeaderId::DATE)) {
+    headerBuffer += "date: ";
+    headerBuffer += http_parser::http_date_now();
+    headerBuffer += "\r\n";
+  }
+  if (addContentLength && statusAllowsBody(code) &&
+      !response.headers.contains(HeaderId::CONTENT_LENGTH) &&
+      !response.headers.contains(HeaderId::TRANSFER_ENCODING)) {
+    headerBuffer += "content-length: ";
+    appendNumber(headerBuffer, bodyBytes);
+    headerBuffer += "\r\n";
+  }
+  headerBuffer += "\r\n";
+
+  if (!statusLine.empty()) {
+    iov[iovCount++] = iovec{const_cast<char *>(statusLine.data()),
+                            statusLine.size()};
+    remainingBytes += statusLine.size();
+  }
+  iov[iovCount++] = iovec{headerBuffer.data(), headerBuffer.size()};
+  remainingBytes += headerBuffer.size();
+  for (std::size_t i = 0; i < partCount; i++) {
+    if (bodyParts[i].empty()) {
+      continue;
+    }
+    iov[iovCount++] = iovec{const_cast<char *>(bodyParts[i].data()),
+                            bodyParts[i].size()};
+  }
+  remainingBytes += bodyBytes;
+  return true;
+}
+
+void ResponseSerializer::consume(std::size_t bytes) {
+  remainingBytes -= bytes < remainingBytes ? bytes : remainingBytes;
+  http_parser::iovec_consume(iov.data(), iovCount, iovIndex, bytes);
+}
+
+bool ResponseSerializer::write(int file_descriptor) {
+  return http_parser::iovec_write(file_descriptor, iov.data(), iovCount,
+                                  iovIndex, remainingBytes);
+}
@@ -0,0 +1,240 @@
+#include "Router.hpp"
+#include <string>
+#include <vector>
+
+using http_parser::Method;
+using http_parser::Request;
+using http_parser::RouteMatch;
+using http_parser::RouteParam;
+using http_parser::Router;
+
+struct Router::Node {
+  std::string prefix;  // static text consumed by this edge
+  std::string indices; // first byte of every static child, same order
+  std::vector<std::unique_ptr<Node>> children;
+  std::unique_ptr<Node> paramChild;    // ":name", one path segment
+  std::unique_ptr<Node> wildcardChild; // "*name", rest of the path
+  std::string name;                    // parameter name of this edge
+  bool hasRoute = false;
+  std::size_t routeId = 0;
+};
+
+// Inserts static text below `node`, splitting edges where the new text
+// diverges, and returns the node at the end of the text.
+Router::Node *Router::insertStatic(Node *node, std::string_view text) {
+  while (!text.empty()) {
+    std::size_t index = node->indices.find(text[0]);
+    if (index == std::string::npos) {
+      auto child = std::make_unique<Node>();
+      child->prefix = std::string(text);
+      node->indices += text[0];
+      node->children.push_back(std::move(child));
+      return node->children.back().get();
+    }
+    Node *child = node->children[index].get();
+    std::size_t common = 0;
+    while (common < child->prefix.size() && common < text.size() &&
+           child->prefix[common] == text[common]) {
+      common++;
+    }
+    if (common < child->prefix.size()) {
+      auto middle = std::make_unique<Node>();
+      middle->prefix = child->prefix.substr(0, common);
+      std::unique_ptr<Node> tail = std::move(node->children[index]);
+      tail->prefix.erase(0, common);
+      middle->indices += tail->prefix[0];
+      middle->children.push_back(std::move(tail));
+      node->children[index] = std::move(middle);
+      child = node->children[index].get();
+    }
+    node = child;
+    text.remove_prefix(common);
+  }
+  return node;
+}
+
+// Node at the end of static text below `node` without modifying the tree,
+// null if the text ends inside an edge or leaves the tree. Inserting such
+// text only creates nodes without routes or parameters.
+const Router::Node *Router::findStatic(const Node *node,
+                                       std::string_view text) {
+  while (!text.empty()) {
+    std::size_t index = node->indices.find(text[0]);
+    if (index == std::string::npos) {
+      return nullptr;
+    }
+    const Node *child = node->children[index].get();
+    if (text.size() < child->prefix.size() ||
+        text.compare(0, child->prefix.size(), child->prefix) != 0) {
+      return nullptr;
+    }
+    node = child;
+    text.remove_prefix(child->prefix.size());
+  }
+  return node;
+}
+
+namespace {
+
+// ':' and '*' only start a parameter at the beginning of a segment
+bool isParamStart(std::string_view pattern, std::size_t i) {
+  return (pattern[i] == ':' || pattern[i] == '*') && i > 0 &&
+         pattern[i - 1] == '/';
+}
+
+} // namespace
+
+std::string_view RouteMatch::param(std::string_view name) const {
+  for (std::size_t i = 0; i < count; i++) {
+    if (params[i].name == name) {
+      return params[i].value;
+    }
+  }
+  return std::string_view();
+}
+
+// Checks a pattern against the syntax and the routes below `root` (which
+// may be null) before anything is inserted.
+bool Router::fits(const Node *root, std::string_view pattern) {
+  if (pattern.empty() || pattern[0] != '/') {
+    return false;
+  }
+  const Node *node = root;
+  std::size_t paramCount = 0;
+  std::size_t i = 0;
+  while (i < pattern.size()) {
+    if (isParamStart(pattern, i)) {
+      bool wildcard = pattern[i] == '*';
+      std::size_t end = pattern.find('/', i);
+      if (end == std::string_view::npos) {
+        end = pattern.size();
+      }
+      std::string_view name = pattern.substr(i + 1, end - i - 1);
+      if (name.empty() || ++paramCount > RouteMatch::MAX_PARAMS ||
+          (wildcard && end != pattern.size())) {
+        return false;
+      }
+      if (node != nullptr) {
+        const std::unique_ptr<Node> &child =
+            wildcard ? node->wildcardChild : node->paramChild;
+        // the same position can't be captured under two names
+        if (child && child->name != name) {
+          return false;
+        }
+        node = child.get();
+      }
+      i = end;
+      continue;
+    }
+    std::size_t end = i + 1;
+    while (end < pattern.size() && !isParamStart(pattern, end)) {
+      end++;
+    }
+    if (node != nullptr) {
+      node = findStatic(node, pattern.substr(i, end - i));
+    }
+    i = end;
+  }
+  return node == nullptr || !node->hasRoute;
+}
+
+Router::Router() = default;
+
+Router::~Router() = default;
+
+bool Router::add(Method method, std::string_view pattern,
+                 std::size_t routeId) {
+  std::size_t methodIndex = static_cast<std::size_t>(method);
+  // validated as a whole first, a rejected pattern leaves the tree as it was
+  if (methodIndex >= METHOD_COUNT || !fits(roots[methodIndex].get(), pattern)) {
+    return false;
+  }
+  if (!roots[methodIndex]) {
+    roots[methodIndex] = std::make_unique<Node>();
+  }
+  Node *node = roots[methodIndex].get();
+  std::size_t i = 0;
+  while (i < pattern.size()) {
+    if (isParamStart(pattern, i)) {
+      bool wildcard = pattern[i] == '*';
+      std::size_t end = pattern.find('/', i);
+      if (end == std::string_view::npos) {
+        end = pattern.size();
+      }
+      std::unique_ptr<Node> &child =
+          wildcard ? node->wildcardChild : node->paramChild;
+      if (!child) {
+        child = std::make_unique<Node>();
+        child->name = std::string(pattern.substr(i + 1, end - i - 1));
+      }
+      node = child.get();
+      i = end;
+      continue;
+    }
+    std::size_t end = i + 1;
+    while (end < pattern.size() && !isParamStart(pattern, end)) {
+      end++;
+    }
+    node = insertStatic(node, pattern.substr(i, end - i));
+    i = end;
+  }
+  node->hasRoute = true;
+  node->routeId = routeId;
+  return true;
+}
+
+bool Router::matchNode(const Node *node, std::string_view path,
+                       RouteMatch &match) {
+  if (path.empty() && node->hasRoute) {
+    match.routeId = node->routeId;
+    return true;
+  }
+  if (!path.empty()) {
+    std::size_t index = node->indices.find(path[0]);
+    if (index != std::string::npos) {
+      const Node *child = node->children[index].get();
+      if (path.size() >= child->prefix.size() &&
+          path.compare(0, child->prefix.size(), child->prefix) == 0 &&
+          matchNode(child, path.substr(child->prefix.size()), match)) {
+        return true;
+      }
+    }
+    if (node->paramChild && path[0] != '/') {
+      std::size_t end = path.find('/');
+      if (end == std::string_view::npos) {
+        end = path.size();
+      }
+      match.params[match.count++] =
+          RouteParam{node->paramChild->name, path.substr(0, end)};
+      if (matchNode(node->paramChild.get(), path.substr(end), match)) {
+        return true;
+      }
+      match.count--;
+    }
+  }
+  if (node->wildcardChild && node->wildcardChild->hasRoute) {
+    match.params[match.count++] = RouteParam{node->wildcardChild->name, path};
+    match.routeId = node->wildcardChild->routeId;
+    return true;
+  }
+  return false;
+}
+
+bool Router::match(Method method, std::string_view path,
+                   RouteMatch &match) const {
+  match.count = 0;
+  std::size_t methodIndex = static_cast<std::size_t>(method);
+  if (methodIndex >= METHOD_COUNT || !roots[methodIndex]) {
+    return false;
+  }
+  return matchNode(roots[methodIndex].get(), path, match);
+}
+
+bool Router::match(const Request &request, RouteMatch &match) const {
+  UrlView target = request.target();
+  std::string_view path = target.path();
+  if (path.empty() && target.form() == TargetForm::ABSOLUTE) {
+    path = "/";
+  }
+  return this->match(request.method, path, match);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+/**
+ * @file Text.h
+ * @brief small text helpers shared by the library sources
+ * @version 1.0.0
+ *
+ * Internal to the library, not installed with the public headers.
+ *
+ * @section LICENSE
+ * GNU General Public License v3.0
+ */
+
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace http_parser {
+namespace detail {
+
+// Appends the decimal digits of `value`.
+inline void appendNumber(std::string &out, unsigned long long value) {
+  char digits[24];
+  std::to_chars_result result =
+      std::to_chars(digits, digits + sizeof(digits), value);
+  out.append(digits, static_cast<std::size_t>(result.ptr - digits));
+}
+
+// `text` without leading and trailing spaces and tabs. An all-whitespace
+// text gives an empty view at its end, so offsets into the input stay
+// meaningful.
+inline std::string_view trim(std::string_view text) {
+  std::size_t start = text.find_first_not_of(" \t");
+  if (start == std::string_view::npos) {
+    return text.substr(text.size());
+  }
+  return text.substr(start, text.find_last_not_of(" \t") - start + 1);
+}
+
+}; // namespace detail
+}; // namespace http_parser
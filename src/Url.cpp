@@ -0,0 +1,370 @@
+#include "Url.hpp"
+#include "HeaderList.hpp"
+#include <cctype>
+#include <cstring>
+#include <string>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using http_parser::QueryParams;
+using http_parser::TargetForm;
+using http_parser::UrlView;
+
+namespace {
+
+// value of a hex digit, or -1
+constexpr signed char hexValue(char c) {
+  return (c >= '0' && c <= '9')   ? static_cast<signed char>(c - '0')
+         : (c >= 'a' && c <= 'f') ? static_cast<signed char>(c - 'a' + 10)
+         : (c >= 'A' && c <= 'F') ? static_cast<signed char>(c - 'A' + 10)
+                                  : static_cast<signed char>(-1);
+}
+
+// Returns the first '%' (or '+' when formEncoded) in [begin, end), or end.
+// Escapes are rare, so the scan runs 16 bytes at a time where SSE2 exists.
+const char *findEscape(const char *begin, const char *end, bool formEncoded) {
+  const char *p = begin;
+#if defined(__SSE2__)
+  const __m128i percent = _mm_set1_epi8('%');
+  const __m128i plus = _mm_set1_epi8(formEncoded ? '+' : '%');
+  while (end - p >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, percent),
+                                _mm_cmpeq_epi8(chunk, plus));
+    int mask = _mm_movemask_epi8(hits);
+    if (mask != 0) {
+      return p + __builtin_ctz(static_cast<unsigned>(mask));
+    }
+    p += 16;
+  }
+#endif
+  for (; p < end; ++p) {
+    if (*p == '%' || (formEncoded && *p == '+')) {
+      return p;
+    }
+  }
+  return end;
+}
+
+bool isSchemeChar(char c, bool first) {
+  if (std::isalpha(static_cast<unsigned char>(c))) {
+    return true;
+  }
+  return !first && (std::isdigit(static_cast<unsigned char>(c)) || c == '+' ||
+                    c == '-' || c == '.');
+}
+
+bool isUnreserved(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '-' ||
+         c == '.' || c == '_' || c == '~';
+}
+
+void appendLower(std::string &out, std::string_view text) {
+  for (char c : text) {
+    out += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  }
+}
+
+// path or query with escapes normalized
+bool appendNormalized(std::string &out, std::string_view text) {
+  static constexpr char hex[] = "0123456789ABCDEF";
+  const char *p = text.data();
+  const char *end = p + text.size();
+  while (p < end) {
+    const char *escape = findEscape(p, end, false);
+    out.append(p, static_cast<std::size_t>(escape - p));
+    if (escape == end) {
+      break;
+    }
+    if (end - escape < 3 || hexValue(escape[1]) < 0 ||
+        hexValue(escape[2]) < 0) {
+      return false;
+    }
+    char decoded = static_cast<char>(hexValue(escape[1]) * 16 +
+                                     hexValue(escape[2]));
+    if (isUnreserved(decoded)) {
+      out += decoded;
+    } else {
+      out += '%';
+      out += hex[static_cast<unsigned char>(decoded) >> 4];
+      out += hex[static_cast<unsigned char>(decoded) & 0xf];
+    }
+    p = escape + 3;
+  }
+  return true;
+}
+
+} // namespace
+
+TargetForm UrlView::form() const {
+  split();
+  return targetForm;
+}
+
+std::string_view UrlView::scheme() const {
+  split();
+  return view(schemeSpan);
+}
+
+std::string_view UrlView::authority() const {
+  split();
+  return view(authoritySpan);
+}
+
+std::string_view UrlView::host() const {
+  split();
+  return view(hostSpan);
+}
+
+std::string_view UrlView::port() const {
+  split();
+  return view(portSpan);
+}
+
+std::string_view UrlView::path() const {
+  split();
+  return view(pathSpan);
+}
+
+std::string_view UrlView::query() const {
+  split();
+  return view(querySpan);
+}
+
+std::string_view UrlView::fragment() const {
+  split();
+  return view(fragmentSpan);
+}
+
+void UrlView::split() const {
+  if (parsed) {
+    return;
+  }
+  parsed = true;
+  if (target.empty() || target.size() > UINT32_MAX) {
+    targetForm = TargetForm::UNKOWN;
+    return;
+  }
+  if (target[0] == '/') {
+    targetForm = TargetForm::ORIGIN;
+    splitPath(0);
+    return;
+  }
+  if (target.size() == 1 && target[0] == '*') {
+    targetForm = TargetForm::ASTERISK;
+    pathSpan = Span{0, 1};
+    return;
+  }
+  std::size_t colon = target.find(':');
+  bool hasScheme = colon != std::string_view::npos && colon > 0 &&
+                   target.compare(colon, 3, "://") == 0;
+  for (std::size_t i = 0; hasScheme && i < colon; i++) {
+    hasScheme = isSchemeChar(target[i], i == 0);
+  }
+  if (hasScheme) {
+    targetForm = TargetForm::ABSOLUTE;
+    schemeSpan = Span{0, static_cast<std::uint32_t>(colon)};
+    std::size_t authorityStart = colon + 3;
+    std::size_t authorityEnd = target.find_first_of("/?#", authorityStart);
+    if (authorityEnd == std::string_view::npos) {
+      authorityEnd = target.size();
+    }
+    authoritySpan =
+        Span{static_cast<std::uint32_t>(authorityStart),
+             static_cast<std::uint32_t>(authorityEnd - authorityStart)};
+    splitPath(authorityEnd);
+  } else {
+    targetForm = TargetForm::AUTHORITY;
+    authoritySpan = Span{0, static_cast<std::uint32_t>(target.size())};
+  }
+  splitAuthority();
+}
+
+void UrlView::splitPath(std::size_t start) const {
+  std::string_view rest = target.substr(start);
+  std::size_t hash = rest.find('#');
+  if (hash != std::string_view::npos) {
+    fragmentSpan = Span{static_cast<std::uint32_t>(start + hash + 1),
+                        static_cast<std::uint32_t>(rest.size() - hash - 1)};
+    rest = rest.substr(0, hash);
+  }
+  std::size_t question = rest.find('?');
+  if (question != std::string_view::npos) {
+    querySpan = Span{static_cast<std::uint32_t>(start + question + 1),
+                     static_cast<std::uint32_t>(rest.size() - question - 1)};
+    rest = rest.substr(0, question);
+  }
+  pathSpan = Span{static_cast<std::uint32_t>(start),
+                  static_cast<std::uint32_t>(rest.size())};
+}
+
+void UrlView::splitAuthority() const {
+  std::string_view authority = view(authoritySpan);
+  std::size_t base = authoritySpan.offset;
+  std::size_t at = authority.rfind('@');
+  if (at != std::string_view::npos) {
+    base += at + 1;
+    authority = authority.substr(at + 1);
+  }
+  std::size_t hostStart = 0;
+  std::size_t hostLength = authority.size();
+  std::size_t portStart = std::string_view::npos;
+  if (!authority.empty() && authority[0] == '[') {
+    // IPv6 literal, the brackets are not part of the host
+    std::size_t close = authority.find(']');
+    if (close == std::string_view::npos) {
+      return;
+    }
+    hostStart = 1;
+    hostLength = close - 1;
+    if (close + 1 < authority.size() && authority[close + 1] == ':') {
+      portStart = close + 2;
+    }
+  } else {
+    std::size_t colon = authority.rfind(':');
+    if (colon != std::string_view::npos) {
+      hostLength = colon;
+      portStart = colon + 1;
+    }
+  }
+  hostSpan = Span{static_cast<std::uint32_t>(base + hostStart),
+                  static_cast<std::uint32_t>(hostLength)};
+  if (portStart != std::string_view::npos) {
+    portSpan = Span{static_cast<std::uint32_t>(base + portStart),
+                    static_cast<std::uint32_t>(authority.size() - portStart)};
+  }
+}
+
+QueryParams::const_iterator::const_iterator(std::string_view remaining)
+    : remaining(remaining), atEnd(false) {
+  ++*this;
+}
+
+QueryParams::const_iterator &QueryParams::const_iterator::operator++() {
+  while (!remaining.empty()) {
+    std::size_t ampersand = remaining.find('&');
+    std::string_view pair = remaining.substr(0, ampersand);
+    remaining = ampersand == std::string_view::npos
+                    ? remaining.substr(remaining.size())
+                    : remaining.substr(ampersand + 1);
+    if (pair.empty()) {
+      continue;
+    }
+    std::size_t equals = pair.find('=');
+    if (equals == std::string_view::npos) {
+      current = QueryParam{pair, pair.substr(pair.size())};
+    } else {
+      current = QueryParam{pair.substr(0, equals), pair.substr(equals + 1)};
+    }
+    return *this;
+  }
+  atEnd = true;
+  current = QueryParam{};
+  return *this;
+}
+
+bool QueryParams::find(std::string_view key, std::string_view &value) const {
+  for (const QueryParam &param : *this) {
+    if (param.key == key) {
+      value = param.value;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool http_parser::needs_percent_decoding(std::string_view in,
+                                         bool formEncoded) {
+  const char *end = in.data() + in.size();
+  return findEscape(in.data(), end, formEncoded) != end;
+}
+
+bool http_parser::percent_decode(std::string_view in, char *out,
+                                 std::string_view &decoded, bool formEncoded) {
+  const char *p = in.data();
+  const char *end = p + in.size();
+  const char *escape = findEscape(p, end, formEncoded);
+  if (escape == end) {
+    decoded = in;
+    return true;
+  }
+  char *o = out;
+  while (escape != end) {
+    // copy the literal run in one go
+    std::memcpy(o, p, static_cast<std::size_t>(escape - p));
+    o += escape - p;
+    if (*escape == '+') {
+      *o++ = ' ';
+      p = escape + 1;
+    } else {
+      if (end - escape < 3) {
+        return false;
+      }
+      signed char high = hexValue(escape[1]);
+      signed char low = hexValue(escape[2]);
+      if (high < 0 || low < 0) {
+        return false;
+      }
+      *o++ = static_cast<char>((high << 4) | low);
+      p = escape + 3;
+    }
+    escape = findEscape(p, end, formEncoded);
+  }
+  std::memcpy(o, p, static_cast<std::size_t>(end - p));
+  o += end - p;
+  decoded = std::string_view(out, static_cast<std::size_t>(o - out));
+  return true;
+}
+
+bool http_parser::normalize_target(std::string_view target, std::string &out) {
+  UrlView url(target);
+  switch (url.form()) {
+  case TargetForm::ASTERISK:
+    out += '*';
+    return true;
+  case TargetForm::AUTHORITY:
+    appendLower(out, url.authority());
+    return true;
+  case TargetForm::ABSOLUTE: {
+    appendLower(out, url.scheme());
+    out += "://";
+    std::string_view host = url.host();
+    bool ipv6 = host.find(':') != std::string_view::npos;
+    if (ipv6) {
+      out += '[';
+    }
+    appendLower(out, host);
+    if (ipv6) {
+      out += ']';
+    }
+    std::string_view port = url.port();
+    bool defaultPort = port.empty() ||
+                       (port == "80" && header_name_equals(url.scheme(),
+                                                           "http")) ||
+                       (port == "443" && header_name_equals(url.scheme(),
+                                                            "https"));
+    if (!defaultPort) {
+      out += ':';
+      out.append(port.data(), port.size());
+    }
+    break;
+  }
+  case TargetForm::ORIGIN:
+  case TargetForm::UNKOWN:
+    break;
+  }
+  std::string_view path = url.path();
+  if (path.empty()) {
+    out += '/';
+  } else if (!appendNormalized(out, path)) {
+    return false;
+  }
+  std::string_view query = url.query();
+  if (!query.empty()) {
+    out += '?';
+    return appendNormalized(out, query);
+  }
+  return true;
+}
@@ -0,0 +1,434 @@
+#include "WebSocket.hpp"
+#include "HeaderValue.hpp"
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using http_parser::HeaderId;
+using http_parser::WebSocketEvent;
+using http_parser::WebSocketFrameParser;
+using http_parser::WebSocketOpcode;
+using http_parser::WebSocketParseState;
+using http_parser::WebSocketUpgrade;
+
+namespace {
+
+constexpr std::string_view websocketGuid =
+    "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+constexpr char base64Alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+inline std::uint32_t rotateLeft(std::uint32_t value, int bits) {
+  return (value << bits) | (value >> (32 - bits));
+}
+
+// SHA-1 (RFC 3174), only needed for the handshake
+class Sha1 {
+public:
+  void update(const unsigned char *data, std::size_t length) {
+    for (std::size_t i = 0; i < length; i++) {
+      block[blockLength++] = data[i];
+      if (blockLength == 64) {
+        transform();
+        blockLength = 0;
+      }
+    }
+    totalLength += length;
+  }
+
+  void digest(unsigned char out[20]) {
+    std::uint64_t bits = totalLength * 8;
+    unsigned char padding = 0x80;
+    update(&padding, 1);
+    padding = 0;
+    while (blockLength != 56) {
+      update(&padding, 1);
+    }
+    unsigned char length[8];
+    for (int i = 0; i < 8; i++) {
+      length[i] = static_cast<unsigned char>(bits >> (56 - 8 * i));
+    }
+    update(length, 8);
+    for (int i = 0; i < 5; i++) {
+      for (int j = 0; j < 4; j++) {
+        out[i * 4 + j] = static_cast<unsigned char>(state[i] >> (24 - 8 * j));
+      }
+    }
+  }
+
+private:
+  std::uint32_t state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476,
+                            0xC3D2E1F0};
+  unsigned char block[64];
+  std::size_t blockLength = 0;
+  std::uint64_t totalLength = 0;
+
+  void transform() {
+    std::uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+      w[i] = static_cast<std::uint32_t>(block[i * 4]) << 24 |
+             static_cast<std::uint32_t>(block[i * 4 + 1]) << 16 |
+             static_cast<std::uint32_t>(block[i * 4 + 2]) << 8 |
+             static_cast<std::uint32_t>(block[i * 4 + 3]);
+    }
+    for (int i = 16; i < 80; i++) {
+      w[i] = rotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+    std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3],
+                  e = state[4];
+    for (int i = 0; i < 80; i++) {
+      std::uint32_t f, k;
+      if (i < 20) {
+        f = (b & c) | (~b & d);
+        k = 0x5A827999;
+      } else if (i < 40) {
+        f = b ^ c ^ d;
+        k = 0x6ED9EBA1;
+      } else if (i < 60) {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8F1BBCDC;
+      } else {
+        f = b ^ c ^ d;
+        k = 0xCA62C1D6;
+      }
+      std::uint32_t temp = rotateLeft(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = rotateLeft(b, 30);
+      b = a;
+      a = temp;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+  }
+};
+
+void base64Encode(const unsigned char *data, std::size_t length, char *out) {
+  std::size_t i = 0;
+  for (; i + 3 <= length; i += 3) {
+    std::uint32_t triple = static_cast<std::uint32_t>(data[i]) << 16 |
+                           static_cast<std::uint32_t>(data[i + 1]) << 8 |
+                           data[i + 2];
+    *out++ = base64Alphabet[(triple >> 18) & 0x3f];
+    *out++ = base64Alphabet[(triple >> 12) & 0x3f];
+    *out++ = base64Alphabet[(triple >> 6) & 0x3f];
+    *out++ = base64Alphabet[triple & 0x3f];
+  }
+  if (i < length) {
+    std::uint32_t triple = static_cast<std::uint32_t>(data[i]) << 16;
+    if (i + 1 < length) {
+      triple |= static_cast<std::uint32_t>(data[i + 1]) << 8;
+    }
+    *out++ = base64Alphabet[(triple >> 18) & 0x3f];
+    *out++ = base64Alphabet[(triple >> 12) & 0x3f];
+    *out++ = i + 1 < length ? base64Alphabet[(triple >> 6) & 0x3f] : '=';
+    *out++ = '=';
+  }
+}
+
+bool isBase64Char(char c) {
+  return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
+         (c >= '0' && c <= '9') || c == '+' || c == '/';
+}
+
+// a base64 encoded 16 byte nonce: 22 characters and "=="
+bool validKey(std::string_view key) {
+  if (key.size() != 24 || key[22] != '=' || key[23] != '=') {
+    return false;
+  }
+  for (std::size_t i = 0; i < 22; i++) {
+    if (!isBase64Char(key[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool isControl(WebSocketOpcode opcode) {
+  return (static_cast<std::uint8_t>(opcode) & 0x8) != 0;
+}
+
+} // namespace
+
+WebSocketUpgrade
+http_parser::validate_websocket_upgrade(const Request &request,
+                                        std::string_view &key) {
+  if (!TokenList(request.headers.value_of(HeaderId::UPGRADE))
+           .contains("websocket")) {
+    return WebSocketUpgrade::NONE;
+  }
+  if (request.method != Method::METHOD_GET ||
+      request.version != Version::HTTP_1_1 ||
+      !connection_options(request.headers).upgrade ||
+      !request.headers.contains(HeaderId::HOST)) {
+    return WebSocketUpgrade::INVALID;
+  }
+  if (request.headers.value_of(HeaderId::SEC_WEBSOCKET_VERSION) != "13") {
+    return WebSocketUpgrade::BAD_VERSION;
+  }
+  key = request.headers.value_of(HeaderId::SEC_WEBSOCKET_KEY);
+  return validKey(key) ? WebSocketUpgrade::VALID : WebSocketUpgrade::INVALID;
+}
+
+void http_parser::websocket_accept(std::string_view key, char *out) {
+  Sha1 sha1;
+  sha1.update(reinterpret_cast<const unsigned char *>(key.data()),
+              key.size());
+  sha1.update(reinterpret_cast<const unsigned char *>(websocketGuid.data()),
+              websocketGuid.size());
+  unsigned char digest[20];
+  sha1.digest(digest);
+  base64Encode(digest, sizeof(digest), out);
+}
+
+void http_parser::websocket_accept_response(std::string_view key,
+                                            Response &response) {
+  char accept[WEBSOCKET_ACCEPT_LENGTH];
+  websocket_accept(key, accept);
+  response.version = Version::HTTP_1_1;
+  response.status_code = StatusCode::SWITCHING_PROTOCOLS;
+  response.status_message = std::string(
+      status_code_to_reason(StatusCode::SWITCHING_PROTOCOLS));
+  response.headers.clear();
+  response.headers.add(HeaderId::UPGRADE, "upgrade", "websocket");
+  response.headers.add(HeaderId::CONNECTION, "connection", "Upgrade");
+  response.headers.add(HeaderId::SEC_WEBSOCKET_ACCEPT, "sec-websocket-accept",
+                       std::string_view(accept, sizeof(accept)));
+}
+
+void http_parser::websocket_unmask(char *data, std::size_t length,
+                                   const std::uint8_t mask[4],
+                                   std::uint64_t offset) {
+  // the key rotated so key[0] applies to data[0]
+  std::uint8_t key[4];
+  for (std::size_t i = 0; i < 4; i++) {
+    key[i] = mask[(offset + i) & 3];
+  }
+  std::uint32_t key32;
+  std::memcpy(&key32, key, sizeof(key32));
+  std::size_t i = 0;
+#if defined(__AVX2__)
+  const __m256i key256 = _mm256_set1_epi32(static_cast<int>(key32));
+  for (; i + 32 <= length; i += 32) {
+    __m256i *p = reinterpret_cast<__m256i *>(data + i);
+    _mm256_storeu_si256(p, _mm256_xor_si256(_mm256_loadu_si256(p), key256));
+  }
+#endif
+#if defined(__SSE2__)
+  const __m128i key128 = _mm_set1_epi32(static_cast<int>(key32));
+  for (; i + 16 <= length; i += 16) {
+    __m128i *p = reinterpret_cast<__m128i *>(data + i);
+    _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), key128));
+  }
+#endif
+  // i is a multiple of 4 here, so the key stays aligned with the data
+  std::uint64_t key64 = static_cast<std::uint64_t>(key32) << 32 | key32;
+  for (; i + 8 <= length; i += 8) {
+    std::uint64_t word;
+    std::memcpy(&word, data + i, sizeof(word));
+    word ^= key64;
+    std::memcpy(data + i, &word, sizeof(word));
+  }
+  for (; i < length; i++) {
+    data[i] = static_cast<char>(data[i] ^ key[i & 3]);
+  }
+}
+
+std::size_t http_parser::websocket_frame_header(WebSocketOpcode opcode,
+                                                bool fin, std::uint64_t length,
+                                                const std::uint8_t *mask,
+                                                char *out) {
+  unsigned char *p = reinterpret_cast<unsigned char *>(out);
+  std::size_t size = 2;
+  p[0] = static_cast<unsigned char>((fin ? 0x80 : 0) |
+                                    static_cast<std::uint8_t>(opcode));
+  unsigned char maskBit = mask != nullptr ? 0x80 : 0;
+  if (length < 126) {
+    p[1] = static_cast<unsigned char>(maskBit | length);
+  } else if (length <= 0xffff) {
+    p[1] = maskBit | 126;
+    p[2] = static_cast<unsigned char>(length >> 8);
+    p[3] = static_cast<unsigned char>(length);
+    size = 4;
+  } else {
+    p[1] = maskBit | 127;
+    for (int i = 0; i < 8; i++) {
+      p[2 + i] = static_cast<unsigned char>(length >> (56 - 8 * i));
+    }
+    size = 10;
+  }
+  if (mask != nullptr) {
+    std::memcpy(p + size, mask, 4);
+    size += 4;
+  }
+  return size;
+}
+
+WebSocketFrameParser::WebSocketFrameParser(bool server)
+    : server{server}, allowRsv1{false}, maxFrameSize{DEFAULT_MAX_FRAME_SIZE} {
+  reset();
+}
+
+void WebSocketFrameParser::reset() {
+  currentParseState = WebSocketParseState::HEADER;
+  currentFrame = WebSocketFrameHeader();
+  messageOpcode = WebSocketOpcode::CONTINUATION;
+  inMessage = false;
+  payloadOffset = 0;
+  headerBytes = 0;
+  errorMessage.clear();
+  closeCode = 0;
+}
+
+void WebSocketFrameParser::fail(const char *message, std::uint16_t code) {
+  currentParseState = WebSocketParseState::PARSE_ERROR;
+  errorMessage = message;
+  closeCode = code;
+}
+
+// bytes of the header announced by the ones read so far
+std::size_t WebSocketFrameParser::headerSize() const {
+  if (headerBytes < 2) {
+    return 2;
+  }
+  std::size_t size = 2;
+  std::uint8_t length = header[1] & 0x7f;
+  size += length == 126 ? 2 : length == 127 ? 8 : 0;
+  size += (header[1] & 0x80) != 0 ? 4 : 0;
+  return size;
+}
+
+bool WebSocketFrameParser::finishHeader() {
+  WebSocketFrameHeader frame;
+  frame.fin = (header[0] & 0x80) != 0;
+  frame.rsv1 = (header[0] & 0x40) != 0;
+  frame.opcode = static_cast<WebSocketOpcode>(header[0] & 0x0f);
+  frame.masked = (header[1] & 0x80) != 0;
+  std::uint8_t length = header[1] & 0x7f;
+  std::size_t pos = 2;
+  if (length == 126) {
+    frame.length = static_cast<std::uint64_t>(header[2]) << 8 | header[3];
+    pos = 4;
+  } else if (length == 127) {
+    for (int i = 0; i < 8; i++) {
+      frame.length = frame.length << 8 | header[2 + i];
+    }
+    pos = 10;
+    if ((frame.length >> 63) != 0) {
+      fail("Frame length has the most significant bit set", 1002);
+      return false;
+    }
+  } else {
+    frame.length = length;
+  }
+  if (frame.masked) {
+    std::memcpy(frame.mask, header + pos, 4);
+  }
+
+  if ((header[0] & 0x30) != 0 || (frame.rsv1 && !allowRsv1)) {
+    fail("Reserved frame bits are set", 1002);
+    return false;
+  }
+  switch (frame.opcode) {
+  case WebSocketOpcode::CONTINUATION:
+    if (!inMessage) {
+      fail("Continuation frame outside of a fragmented message", 1002);
+      return false;
+    }
+    break;
+  case WebSocketOpcode::TEXT:
+  case WebSocketOpcode::BINARY:
+    if (inMessage) {
+      fail("New message before the fragmented one ended", 1002);
+      return false;
+    }
+    messageOpcode = frame.opcode;
+    break;
+  case WebSocketOpcode::CLOSE:
+  case WebSocketOpcode::PING:
+  case WebSocketOpcode::PONG:
+    if (!frame.fin || frame.length > 125) {
+      fail("Control frames must not be fragmented or longer than 125 bytes",
+           1002);
+      return false;
+    }
+    break;
+  default:
+    fail("Unknown frame opcode", 1002);
+    return false;
+  }
+  if (frame.masked != server) {
+    fail(server ? "Client frames must be masked"
+                : "Server frames must not be masked",
+         1002);
+    return false;
+  }
+  if (frame.length > maxFrameSize) {
+    fail("Frame is larger than the configured limit", 1009);
+    return false;
+  }
+  if (!isControl(frame.opcode)) {
+    inMessage = !frame.fin;
+  }
+  currentFrame = frame;
+  payloadOffset = 0;
+  return true;
+}
+
+std::size_t WebSocketFrameParser::execute(char *data, std::size_t length,
+                                          WebSocketEvent &event,
+                                          std::string_view &payload) {
+  event = WebSocketEvent::NONE;
+  payload = std::string_view();
+  std::size_t pos = 0;
+  while (pos < length) {
+    switch (currentParseState) {
+    case WebSocketParseState::HEADER: {
+      // at most 14 bytes, taken as far as the first two tell the size
+      std::size_t needed = headerSize();
+      while (headerBytes < needed && pos < length) {
+        header[headerBytes++] = static_cast<unsigned char>(data[pos++]);
+        needed = headerSize();
+      }
+      if (headerBytes < needed) {
+        return pos;
+      }
+      headerBytes = 0;
+      if (!finishHeader()) {
+        return pos;
+      }
+      if (currentFrame.length > 0) {
+        currentParseState = WebSocketParseState::PAYLOAD;
+      }
+      event = WebSocketEvent::FRAME_BEGIN;
+      return pos;
+    }
+    case WebSocketParseState::PAYLOAD: {
+      std::uint64_t left = currentFrame.length - payloadOffset;
+      std::size_t take = left < length - pos ? static_cast<std::size_t>(left)
+                                             : length - pos;
+      if (currentFrame.masked) {
+        websocket_unmask(data + pos, take, currentFrame.mask, payloadOffset);
+      }
+      payloadOffset += take;
+      if (payloadOffset == currentFrame.length) {
+        currentParseState = WebSocketParseState::HEADER;
+      }
+      event = WebSocketEvent::PAYLOAD;
+      payload = std::string_view(data + pos, take);
+      return pos + take;
+    }
+    case WebSocketParseState::PARSE_ERROR:
+      return pos;
+    }
+  }
+  return pos;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+/**
+ * @file Check.h
+ * @brief assertion helpers shared by the tests
+ *
+ * A failed check is reported and counted, the test goes on so one run shows
+ * every failure. main returns test_result().
+ */
+
+#include <cstdio>
+
+namespace test {
+
+inline int &failure_count() {
+  static int failures = 0;
+  return failures;
+}
+
+inline void check(bool condition, const char *what) {
+  if (!condition) {
+    std::fprintf(stderr, "FAILED: %s\n", what);
+    failure_count()++;
+  }
+}
+
+inline int test_result(const char *name) {
+  if (failure_count() > 0) {
+    std::fprintf(stderr, "%s: %d checks failed\n", name, failure_count());
+    return 1;
+  }
+  std::printf("%s passed\n", name);
+  return 0;
+}
+
+} // namespace test
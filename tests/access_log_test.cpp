@@ -0,0 +1,177 @@
+/**
+ * @file access_log_test.cpp
+ * @brief AccessLog record formats, escaping and the batched writer
+ */
+
+#include "AccessLog.hpp"
+#include "Check.h"
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+// Sun, 06 Nov 1994 08:49:37 GMT
+constexpr std::int64_t logTime = 784111777;
+
+// a temporary file the log writes to, read back after flush()
+class LogFile {
+public:
+  LogFile() {
+    char path[] = "/tmp/access_log_testXXXXXX";
+    fd = ::mkstemp(path);
+    ::unlink(path);
+  }
+  ~LogFile() { ::close(fd); }
+
+  std::string contents() const {
+    std::string out;
+    char buffer[4096];
+    ssize_t n;
+    off_t offset = 0;
+    while ((n = ::pread(fd, buffer, sizeof(buffer), offset)) > 0) {
+      out.append(buffer, static_cast<std::size_t>(n));
+      offset += n;
+    }
+    return out;
+  }
+
+  int fd;
+};
+
+Request makeRequest() {
+  Request request;
+  request.method = Method::METHOD_GET;
+  request.url = "/index.html";
+  request.version = Version::HTTP_1_1;
+  request.headers.add("Referer", "http://example.com/");
+  request.headers.add("User-Agent", "agent \"1\"");
+  request.headers.add("X-Request-Id", "42");
+  return request;
+}
+
+Response makeResponse() {
+  Response response;
+  response.status_code = StatusCode::OK;
+  return response;
+}
+
+AccessLogEntry makeEntry() {
+  AccessLogEntry entry;
+  entry.remoteAddress = "192.0.2.1";
+  entry.bytesSent = 1234;
+  entry.duration = std::chrono::microseconds(56);
+  entry.time = logTime;
+  return entry;
+}
+
+void testCommonAndCombined() {
+  LogFile file;
+  {
+    AccessLogOptions options;
+    options.format = LogFormat::COMMON;
+    AccessLog log(file.fd, options);
+    log.log(makeRequest(), makeResponse(), makeEntry());
+    AccessLogEntry empty = makeEntry();
+    empty.bytesSent = 0;
+    empty.user = "frank";
+    log.log(makeRequest(), makeResponse(), empty);
+    log.flush();
+  }
+  check(file.contents() ==
+            "192.0.2.1 - - [06/Nov/1994:08:49:37 +0000] "
+            "\"GET /index.html HTTP/1.1\" 200 1234\n"
+            "192.0.2.1 - frank [06/Nov/1994:08:49:37 +0000] "
+            "\"GET /index.html HTTP/1.1\" 200 -\n",
+        "common log format");
+
+  LogFile combined;
+  {
+    AccessLogOptions options;
+    options.extraHeaders = {"x-request-id", "x-missing"};
+    AccessLog log(combined.fd, options);
+    log.log(makeRequest(), makeResponse(), makeEntry());
+    log.flush();
+  }
+  check(combined.contents() ==
+            "192.0.2.1 - - [06/Nov/1994:08:49:37 +0000] "
+            "\"GET /index.html HTTP/1.1\" 200 1234 \"http://example.com/\" "
+            "\"agent \\\"1\\\"\" \"42\" \"-\" 56\n",
+        "combined format with extra headers and duration");
+}
+
+void testJson() {
+  LogFile file;
+  {
+    AccessLogOptions options;
+    options.format = LogFormat::JSON;
+    options.extraHeaders = {"x-request-id"};
+    AccessLog log(file.fd, options);
+    Request request = makeRequest();
+    request.url = "/a\x01\"b";
+    log.log(request, makeResponse(), makeEntry());
+    log.flush();
+  }
+  check(file.contents() ==
+            "{\"time\":\"1994-11-06T08:49:37Z\",\"remote\":\"192.0.2.1\","
+            "\"method\":\"GET\",\"url\":\"/a\\u0001\\\"b\","
+            "\"version\":\"HTTP/1.1\",\"status\":200,\"bytes\":1234,"
+            "\"duration_us\":56,\"referer\":\"http://example.com/\","
+            "\"user_agent\":\"agent \\\"1\\\"\","
+            "\"headers\":{\"x-request-id\":\"42\"}}\n",
+        "JSON record with escapes");
+}
+
+void testWriterAndLimits() {
+  LogFile file;
+  constexpr int threads = 4;
+  constexpr int records = 500;
+  AccessLogStats stats;
+  {
+    AccessLogOptions options;
+    options.format = LogFormat::COMMON;
+    options.overflow = OverflowPolicy::BLOCK;
+    options.ringBytes = 4096;
+    AccessLog log(file.fd, options);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+      workers.emplace_back([&log] {
+        for (int i = 0; i < records; i++) {
+          log.log(makeRequest(), makeResponse(), makeEntry());
+        }
+      });
+    }
+    for (std::thread &worker : workers) {
+      worker.join();
+    }
+    Request huge = makeRequest();
+    huge.url.assign(AccessLog::MAX_RECORD_SIZE, 'x');
+    log.log(huge, makeResponse(), makeEntry());
+    log.flush();
+    stats = log.stats();
+  }
+  std::string contents = file.contents();
+  std::size_t lines = 0;
+  for (char c : contents) {
+    lines += c == '\n';
+  }
+  check(lines == threads * records && stats.records == threads * records,
+        "blocking overflow keeps every record of every thread");
+  check(stats.dropped == 1, "oversized records are dropped");
+  check(stats.bytesWritten == contents.size() && stats.writeErrors == 0,
+        "written bytes are counted");
+}
+
+} // namespace
+
+int main() {
+  testCommonAndCombined();
+  testJson();
+  testWriterAndLimits();
+  return test::test_result("access_log_test");
+}
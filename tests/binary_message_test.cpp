@@ -0,0 +1,147 @@
+/**
+ * @file binary_message_test.cpp
+ * @brief binary encoding round trips and checks of untrusted buffers
+ */
+
+#include "BinaryMessage.hpp"
+#include "Check.h"
+#include <random>
+#include <string>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+Request makeRequest() {
+  Request request;
+  request.method = Method::METHOD_POST;
+  request.url = "/upload?x=1";
+  request.version = Version::HTTP_1_1;
+  request.headers.add("Host", "example.com");
+  request.headers.add("X-Custom", "custom value");
+  request.headers.add("Expect", "100-continue");
+  request.headers.add("Content-Length", "4");
+  return request;
+}
+
+void testRequestRoundTrip() {
+  Request request = makeRequest();
+  std::string encoded;
+  check(binary_encode(request, "data", encoded) &&
+            encoded.size() == binary_encoded_size(request, "data"),
+        "encode a request");
+
+  BinaryMessageView view;
+  check(view.attach(encoded.data(), encoded.size()) && view.valid(),
+        "attach");
+  check(view.is_request() && view.method() == Method::METHOD_POST &&
+            view.version() == Version::HTTP_1_1 &&
+            view.url() == "/upload?x=1" && view.body() == "data" &&
+            view.size() == encoded.size(),
+        "request fields");
+  check(view.header_count() == 4 &&
+            view.value_of(HeaderId::HOST) == "example.com" &&
+            view.header(1).key == "X-Custom" &&
+            view.header(1).value == "custom value" &&
+            view.find(HeaderId::CONTENT_LENGTH) == 3 &&
+            view.find(HeaderId::CONTENT_LENGTH, 4) == 4 &&
+            view.value_of(HeaderId::COOKIE, "none") == "none",
+        "header table");
+
+  Request copy = view.to_request();
+  check(copy.url == request.url && copy.headers.size() == 4 &&
+            copy.headers.value_of("x-custom") == "custom value" &&
+            copy.keep_alive && copy.expectation == Expectation::CONTINUE,
+        "owned copy with derived fields");
+}
+
+void testResponsesAndStreams() {
+  Response response;
+  response.version = Version::HTTP_1_0;
+  response.status_code = StatusCode::NOT_FOUND;
+  response.status_message = "Not Found";
+  response.headers.add("Content-Type", "text/plain");
+
+  std::string stream;
+  check(binary_encode(response, "missing", stream) &&
+            binary_encode(makeRequest(), {}, stream),
+        "two messages in one buffer");
+  BinaryMessageView first;
+  BinaryMessageView second;
+  check(first.attach(stream.data(), stream.size()) && !first.is_request() &&
+            first.status_code() == StatusCode::NOT_FOUND &&
+            first.status_message() == "Not Found" &&
+            first.body() == "missing",
+        "response fields");
+  check(second.attach(stream.data() + first.size(),
+                      stream.size() - first.size()) &&
+            second.is_request() && second.body().empty(),
+        "the next message starts after size()");
+  Response copy = first.to_response();
+  check(copy.status_code == StatusCode::NOT_FOUND && !copy.keep_alive &&
+            copy.headers.value_of(HeaderId::CONTENT_TYPE) == "text/plain",
+        "owned response");
+
+  std::size_t size = binary_encoded_size(response, "missing");
+  std::string buffer(size, '\0');
+  check(binary_encode(response, "missing", &buffer[0], size - 1) == 0 &&
+            binary_encode(response, "missing", &buffer[0], size) == size,
+        "the capacity is respected");
+}
+
+void testUntrustedBuffers() {
+  std::string encoded;
+  binary_encode(makeRequest(), "data", encoded);
+  BinaryMessageView view;
+  check(!view.attach(nullptr, 0) && !view.valid(), "no buffer");
+  check(!view.attach(encoded.data(), encoded.size() - 1),
+        "truncated message");
+  std::string magic = encoded;
+  magic[0] = 'X';
+  check(!view.attach(magic.data(), magic.size()), "wrong magic");
+  std::string version = encoded;
+  version[4] = 9;
+  check(!view.attach(version.data(), version.size()), "unknown version");
+  std::string body = encoded;
+  body[36] = '\xff'; // body length
+  check(!view.attach(body.data(), body.size()), "body past the end");
+  std::string table = encoded;
+  table[BINARY_MESSAGE_HEADER_SIZE + 4] = '\xff'; // first value offset
+  check(!view.attach(table.data(), table.size()), "header past the end");
+  std::string id = encoded;
+  id[BINARY_MESSAGE_HEADER_SIZE + 14] = '\xff';
+  check(!view.attach(id.data(), id.size()), "unknown header id");
+
+  // accepted mutations must only yield views inside the buffer, ASan
+  // reports any read outside of it
+  std::mt19937 random(38);
+  std::size_t accepted = 0;
+  for (int round = 0; round < 20000; round++) {
+    std::string mutated = encoded;
+    for (int flips = 0; flips < 3; flips++) {
+      mutated[random() % mutated.size()] = static_cast<char>(random());
+    }
+    if (!view.attach(mutated.data(), mutated.size())) {
+      continue;
+    }
+    accepted++;
+    std::size_t total = view.url().size() + view.body().size();
+    for (std::size_t i = 0; i < view.header_count(); i++) {
+      HeaderView header = view.header(i);
+      total += header.key.size() + header.value.size();
+    }
+    check(total <= mutated.size() * (view.header_count() + 2),
+          "mutated message stays in bounds");
+  }
+  check(accepted > 0, "some mutations keep the message valid");
+}
+
+} // namespace
+
+int main() {
+  testRequestRoundTrip();
+  testResponsesAndStreams();
+  testUntrustedBuffers();
+  return test::test_result("binary_message_test");
+}
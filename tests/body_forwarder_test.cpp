@@ -0,0 +1,173 @@
+/**
+ * @file body_forwarder_test.cpp
+ * @brief forwarding sized, chunked and truncated bodies between sockets
+ */
+
+#include "BodyForwarder.hpp"
+#include "Check.h"
+#include <csignal>
+#include <fcntl.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+// source and destination connections, each a socket pair
+struct Sockets {
+  Sockets() {
+    ::socketpair(AF_UNIX, SOCK_STREAM, 0, source);
+    ::socketpair(AF_UNIX, SOCK_STREAM, 0, destination);
+  }
+  ~Sockets() {
+    for (int fd : {source[0], source[1], destination[0], destination[1]}) {
+      if (fd >= 0) {
+        ::close(fd);
+      }
+    }
+  }
+  void closeSender() {
+    ::close(source[1]);
+    source[1] = -1;
+  }
+
+  // the forwarder reads source[0] and writes destination[0]
+  int source[2];
+  int destination[2];
+};
+
+void writeAll(int fd, const std::string &data) {
+  std::size_t done = 0;
+  while (done < data.size()) {
+    ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+    if (n <= 0) {
+      return;
+    }
+    done += static_cast<std::size_t>(n);
+  }
+}
+
+std::string readAll(int fd) {
+  std::string out;
+  char buffer[65536];
+  ssize_t n;
+  while ((n = ::read(fd, buffer, sizeof(buffer))) > 0) {
+    out.append(buffer, static_cast<std::size_t>(n));
+  }
+  return out;
+}
+
+std::string pattern(std::size_t size) {
+  std::string out(size, '\0');
+  for (std::size_t i = 0; i < size; i++) {
+    out[i] = static_cast<char>('a' + i % 26);
+  }
+  return out;
+}
+
+void testContentLength() {
+  Sockets sockets;
+  std::string body = pattern(3 * 1024 * 1024);
+  std::string buffered = body.substr(0, 1000);
+  std::thread sender([&] {
+    writeAll(sockets.source[1], body.substr(1000) + "GET /next");
+  });
+  std::string received;
+  std::thread receiver([&] { received = readAll(sockets.destination[1]); });
+
+  BodyForwarder forwarder;
+  check(forwarder.start(BodyFraming::CONTENT_LENGTH, body.size(), buffered),
+        "start");
+  check(forwarder.forward(sockets.source[0], sockets.destination[0]) ==
+            ForwardResult::DONE,
+        "sized body forwarded");
+  sender.join();
+  ::shutdown(sockets.destination[0], SHUT_WR);
+  receiver.join();
+  check(received == body && forwarder.bytes_forwarded() == body.size(),
+        "exactly the body arrives");
+  check(forwarder.bytes_spliced() > 0 &&
+            forwarder.bytes_spliced() <= body.size() - buffered.size(),
+        "the payload is spliced");
+  sockets.closeSender();
+  check(readAll(sockets.source[0]) == "GET /next",
+        "the next message stays in the source");
+}
+
+void testChunked() {
+  Sockets sockets;
+  std::string chunk = pattern(200000);
+  std::string body = "30d40\r\n" + chunk + "\r\n5;ext\r\nhello\r\n0\r\n"
+                     "Trailer: 1\r\n\r\n";
+  std::thread sender([&] {
+    writeAll(sockets.source[1], body + "GET /next HTTP/1.1\r\n");
+    ::shutdown(sockets.source[1], SHUT_WR);
+  });
+  std::string received;
+  std::thread receiver([&] { received = readAll(sockets.destination[1]); });
+
+  BodyForwarder forwarder;
+  forwarder.start(BodyFraming::CHUNKED, 0, "3\r\nabc\r\n");
+  check(forwarder.forward(sockets.source[0], sockets.destination[0]) ==
+            ForwardResult::DONE,
+        "chunked body forwarded");
+  sender.join();
+  ::shutdown(sockets.destination[0], SHUT_WR);
+  receiver.join();
+  check(received == "3\r\nabc\r\n" + body, "framing is kept as it is");
+  check(std::string(forwarder.leftover()) + readAll(sockets.source[0]) ==
+            "GET /next HTTP/1.1\r\n",
+        "bytes past the body are handed back");
+}
+
+void testErrors() {
+  {
+    Sockets sockets;
+    writeAll(sockets.source[1], "short");
+    sockets.closeSender();
+    BodyForwarder forwarder;
+    forwarder.start(BodyFraming::CONTENT_LENGTH, 100);
+    check(forwarder.forward(sockets.source[0], sockets.destination[0]) ==
+              ForwardResult::PEER_CLOSED,
+          "truncated body");
+  }
+  {
+    Sockets sockets;
+    writeAll(sockets.source[1], "zz\r\n");
+    BodyForwarder forwarder;
+    forwarder.start(BodyFraming::CHUNKED, 0);
+    check(forwarder.forward(sockets.source[0], sockets.destination[0]) ==
+              ForwardResult::ERROR,
+          "malformed chunk line");
+  }
+  {
+    Sockets sockets;
+    ::fcntl(sockets.source[0], F_SETFL, O_NONBLOCK);
+    BodyForwarder forwarder;
+    forwarder.start(BodyFraming::CONTENT_LENGTH, 4);
+    check(forwarder.forward(sockets.source[0], sockets.destination[0]) ==
+              ForwardResult::WOULD_BLOCK,
+          "non-blocking source without data");
+    writeAll(sockets.source[1], "data");
+    check(forwarder.forward(sockets.source[0], sockets.destination[0]) ==
+                  ForwardResult::DONE &&
+              forwarder.bytes_forwarded() == 4,
+          "forwarding resumes");
+  }
+  BodyForwarder forwarder;
+  check(!forwarder.start(BodyFraming::INVALID, 0), "invalid framing");
+}
+
+} // namespace
+
+int main() {
+  std::signal(SIGPIPE, SIG_IGN);
+  testContentLength();
+  testChunked();
+  testErrors();
+  return test::test_result("body_forwarder_test");
+}
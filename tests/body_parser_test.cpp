@@ -0,0 +1,159 @@
+/**
+ * @file body_parser_test.cpp
+ * @brief body framing selection and BodyParser
+ */
+
+#include "BodyParser.hpp"
+#include "Check.h"
+#include <string>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+Request makeRequest(std::initializer_list<std::pair<const char *, const char *>>
+                        headers) {
+  Request request;
+  request.method = Method::METHOD_POST;
+  request.url = "/";
+  request.version = Version::HTTP_1_1;
+  for (const auto &header : headers) {
+    request.headers.add(header.first, header.second);
+  }
+  return request;
+}
+
+// feeds `data` in pieces of `step` bytes and collects the payload
+bool decode(BodyParser &parser, const std::string &data, std::size_t step,
+            std::string &payload, std::size_t &consumed) {
+  payload.clear();
+  consumed = 0;
+  while (consumed < data.size() && !parser.done() && !parser.failed()) {
+    std::size_t length = std::min(step, data.size() - consumed);
+    std::string_view body;
+    consumed += parser.execute(data.data() + consumed, length, body);
+    payload.append(body.data(), body.size());
+  }
+  return parser.done();
+}
+
+void testRequestFraming() {
+  std::uint64_t length = 0;
+  check(request_body_framing(makeRequest({}), length) == BodyFraming::NONE,
+        "no framing headers, no body");
+  check(request_body_framing(makeRequest({{"Content-Length", "12"}}),
+                             length) == BodyFraming::CONTENT_LENGTH &&
+            length == 12,
+        "content-length");
+  check(request_body_framing(makeRequest({{"Transfer-Encoding", "gzip, chunked"}}),
+                             length) == BodyFraming::CHUNKED,
+        "chunked as the last coding");
+  check(request_body_framing(makeRequest({{"Transfer-Encoding", "chunked"},
+                                          {"Content-Length", "3"}}),
+                             length) == BodyFraming::INVALID,
+        "transfer-encoding with content-length is refused");
+  check(request_body_framing(makeRequest({{"Transfer-Encoding", "gzip"}}),
+                             length) == BodyFraming::INVALID,
+        "request codings must end with chunked");
+  check(request_body_framing(makeRequest({{"Content-Length", "1"},
+                                          {"Content-Length", "2"}}),
+                             length) == BodyFraming::INVALID,
+        "conflicting lengths");
+  check(request_body_framing(makeRequest({{"Content-Length", "-1"}}), length) ==
+            BodyFraming::INVALID,
+        "negative length");
+}
+
+void testResponseFraming() {
+  std::uint64_t length = 0;
+  Response response;
+  response.status_code = StatusCode::OK;
+  response.headers.add("Content-Length", "5");
+  check(response_body_framing(response, Method::METHOD_GET, length) ==
+            BodyFraming::CONTENT_LENGTH,
+        "response content-length");
+  check(response_body_framing(response, Method::METHOD_HEAD, length) ==
+            BodyFraming::NONE,
+        "answers to HEAD have no body");
+  response.status_code = StatusCode::NOT_MODIFIED;
+  check(response_body_framing(response, Method::METHOD_GET, length) ==
+            BodyFraming::NONE,
+        "304 has no body");
+  Response open;
+  open.status_code = StatusCode::OK;
+  check(response_body_framing(open, Method::METHOD_GET, length) ==
+            BodyFraming::UNTIL_CLOSE,
+        "no framing, read until close");
+}
+
+void testContentLength() {
+  BodyParser parser;
+  parser.reset(BodyFraming::CONTENT_LENGTH, 5);
+  std::string payload;
+  std::size_t consumed = 0;
+  check(decode(parser, "helloNEXT", 2, payload, consumed) &&
+            payload == "hello" && consumed == 5,
+        "exactly content-length bytes are taken");
+}
+
+void testChunked() {
+  std::string body = "4;ext=1\r\nWiki\r\n5\r\npedia\r\nE\r\n in\r\n\r\nchunks."
+                     "\r\n0\r\nExpires: never\r\n\r\nNEXT";
+  for (std::size_t step : {std::size_t(1), std::size_t(3), body.size()}) {
+    BodyParser parser;
+    parser.reset(BodyFraming::CHUNKED);
+    std::string payload;
+    std::size_t consumed = 0;
+    bool done = decode(parser, body, step, payload, consumed);
+    check(done && payload == "Wikipedia in\r\n\r\nchunks." &&
+              consumed == body.size() - 4,
+          "chunked body in pieces");
+    check(parser.trailers().value_of("expires") == "never", "trailers");
+  }
+
+  BodyParser parser;
+  parser.reset(BodyFraming::CHUNKED);
+  std::string payload;
+  std::size_t consumed = 0;
+  check(!decode(parser, "zz\r\n", 4, payload, consumed) && parser.failed(),
+        "invalid chunk size");
+  parser.reset(BodyFraming::CHUNKED);
+  check(!decode(parser, "3\r\nabcX\r\n", 9, payload, consumed) &&
+            parser.failed(),
+        "chunk data must end with CRLF");
+  parser.reset(BodyFraming::CHUNKED);
+  check(!decode(parser, "fffffffffffffffffff\r\n", 32, payload, consumed) &&
+            parser.failed(),
+        "chunk size overflow");
+}
+
+void testSkipAndClose() {
+  BodyParser parser;
+  parser.reset(BodyFraming::CONTENT_LENGTH, 10);
+  check(parser.skip(4) == 4 && parser.remaining() == 6, "skip accounts bytes");
+  check(parser.skip(100) == 6 && parser.done(), "skip stops at the end");
+
+  parser.reset(BodyFraming::UNTIL_CLOSE);
+  std::string_view body;
+  check(parser.execute("abc", 3, body) == 3 && body == "abc" &&
+            !parser.done(),
+        "until-close body");
+  parser.finish();
+  check(parser.done(), "finish completes an until-close body");
+
+  parser.reset(BodyFraming::CONTENT_LENGTH, 10);
+  parser.finish();
+  check(parser.failed(), "a closed connection truncates a sized body");
+}
+
+} // namespace
+
+int main() {
+  testRequestFraming();
+  testResponseFraming();
+  testContentLength();
+  testChunked();
+  testSkipAndClose();
+  return test::test_result("body_parser_test");
+}
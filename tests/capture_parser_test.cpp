@@ -0,0 +1,147 @@
+/**
+ * @file capture_parser_test.cpp
+ * @brief boundaries, resynchronisation and parallel capture parsing
+ */
+
+#include "BinaryMessage.hpp"
+#include "CaptureParser.hpp"
+#include "Check.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+constexpr std::string_view junk = "garbage that is no request\r\n";
+
+// GETs, POSTs whose bodies look like request lines, a chunked upload and
+// one line of junk
+std::string makeCapture(std::size_t &messages, std::vector<std::string> &urls) {
+  std::string capture;
+  std::string fakeRequest = "GET /fake HTTP/1.1\r\nHost: x\r\n\r\n";
+  for (int i = 0; i < 200; i++) {
+    std::string url = "/" + std::to_string(i);
+    urls.push_back(url);
+    if (i % 3 == 0) {
+      std::string body = fakeRequest + fakeRequest;
+      capture += "POST " + url + " HTTP/1.1\r\nHost: a\r\nContent-Length: " +
+                 std::to_string(body.size()) + "\r\n\r\n" + body;
+    } else if (i % 7 == 0) {
+      capture += "PUT " + url + " HTTP/1.1\r\nHost: a\r\n"
+                 "Transfer-Encoding: chunked\r\n\r\n"
+                 "5\r\nhello\r\n0\r\n\r\n";
+    } else {
+      capture += "GET " + url + " HTTP/1.1\r\nHost: a\r\nAccept: */*\r\n\r\n";
+    }
+    if (i == 100) {
+      capture += junk;
+    }
+  }
+  messages = urls.size();
+  return capture;
+}
+
+void testBoundaries() {
+  std::string text = "xx\r\nGET / HTTP/1.1\r\n\r\nPOST /a HTTP/1.0\r\n";
+  check(find_message_boundary(text.data(), text.size(), 0) == 4,
+        "first request line");
+  check(find_message_boundary(text.data(), text.size(), 5) == 22,
+        "only at the start of a line");
+  std::string partial = "GET / HTTP/2.0\r\nGET /x HTTP/1.1";
+  check(find_message_boundary(partial.data(), partial.size(), 0) ==
+            partial.size(),
+        "HTTP/1.x only, and only complete lines");
+  std::string unknown = "BREW /pot HTTP/1.1\r\n";
+  check(find_message_boundary(unknown.data(), unknown.size(), 0) ==
+            unknown.size(),
+        "unknown methods are no boundary");
+}
+
+void testSequentialAndParallel() {
+  std::size_t expected = 0;
+  std::vector<std::string> urls;
+  std::string capture = makeCapture(expected, urls);
+
+  CaptureOptions single;
+  single.threads = 1;
+  CaptureStats reference = parse_capture(capture.data(), capture.size(), single);
+  check(reference.messages == expected, "every message is counted");
+  check(reference.parseErrors == 1 && reference.skippedBytes == junk.size(),
+        "junk is skipped up to the next request line");
+  check(reference.methods[static_cast<std::size_t>(Method::METHOD_POST)] ==
+                67 &&
+            reference.methods[static_cast<std::size_t>(Method::METHOD_GET)] ==
+                expected - 67 - 19,
+        "methods");
+  check(reference.headerBytes + reference.bodyBytes + reference.skippedBytes ==
+            capture.size(),
+        "every byte is accounted for");
+
+  // tiny regions start inside bodies that look like requests
+  for (unsigned threads : {2u, 5u, 16u}) {
+    CaptureOptions options;
+    options.threads = threads;
+    options.minRegionBytes = 64;
+    options.emitRecords = true;
+    std::vector<std::string> seen;
+    std::size_t calls = 0;
+    CaptureStats stats = parse_capture(
+        capture.data(), capture.size(), options,
+        [&](std::string_view records) {
+          calls++;
+          BinaryMessageView view;
+          while (!records.empty() &&
+                 view.attach(records.data(), records.size())) {
+            seen.emplace_back(view.url());
+            records.remove_prefix(view.size());
+          }
+        });
+    check(stats.messages == reference.messages &&
+              stats.headers == reference.headers &&
+              stats.bodyBytes == reference.bodyBytes &&
+              stats.parseErrors == reference.parseErrors,
+          "regions count every message once");
+    check(calls == threads && seen == urls,
+          "records arrive once per region in capture order");
+  }
+}
+
+void testCaptureFile() {
+  std::size_t expected = 0;
+  std::vector<std::string> urls;
+  std::string capture = makeCapture(expected, urls);
+  char path[] = "/tmp/capture_testXXXXXX";
+  int fd = ::mkstemp(path);
+  bool written = fd >= 0 &&
+                 ::write(fd, capture.data(), capture.size()) ==
+                     static_cast<ssize_t>(capture.size());
+  if (fd >= 0) {
+    ::close(fd);
+  }
+  check(written, "write capture");
+
+  CaptureFile file;
+  check(file.open(path) && file.size() == capture.size() &&
+            std::string_view(file.data(), file.size()) == capture,
+        "mapped capture");
+  check(parse_capture(file.data(), file.size()).messages == expected,
+        "parse the mapping with every hardware thread");
+  file.close();
+  check(file.data() == nullptr && file.size() == 0, "close");
+  ::unlink(path);
+  check(!file.open(path), "missing file");
+}
+
+} // namespace
+
+int main() {
+  testBoundaries();
+  testSequentialAndParallel();
+  testCaptureFile();
+  return test::test_result("capture_parser_test");
+}
@@ -0,0 +1,289 @@
+/**
+ * @file client_test.cpp
+ * @brief runs ClientConnection and ConnectionPool against a local server
+ * stub: interim responses, status lines the StatusCode enum does not name
+ * and the retry of requests on stale keep-alive connections, and the
+ * request serializer they use
+ */
+
+#include "Check.h"
+#include "Client.hpp"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+// Answers every request with the reply the handler returns for its request
+// line; the connection is closed after a reply when `close` is set.
+class ServerStub {
+public:
+  using Handler = std::function<std::string(const std::string &, bool &)>;
+
+  explicit ServerStub(Handler handler) : handler(std::move(handler)) {
+    listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (::bind(listener, reinterpret_cast<sockaddr *>(&address), length) != 0 ||
+        ::listen(listener, 8) != 0 ||
+        ::getsockname(listener, reinterpret_cast<sockaddr *>(&address),
+                      &length) != 0) {
+      std::perror("server stub");
+      std::exit(1);
+    }
+    port = std::to_string(ntohs(address.sin_port));
+    thread = std::thread([this] { run(); });
+  }
+
+  ~ServerStub() {
+    stopping = true;
+    ::shutdown(listener, SHUT_RDWR);
+    ::close(listener);
+    thread.join();
+  }
+
+  std::string port;
+  std::atomic<int> connections{0};
+  std::atomic<int> requests{0};
+  std::atomic<int> closedConnections{0};
+
+private:
+  Handler handler;
+  int listener;
+  std::atomic<bool> stopping{false};
+  std::thread thread;
+
+  void run() {
+    while (!stopping) {
+      int client = ::accept(listener, nullptr, nullptr);
+      if (client < 0) {
+        return;
+      }
+      connections++;
+      serve(client);
+      ::close(client);
+      closedConnections++;
+    }
+  }
+
+  void serve(int client) {
+    std::string buffer;
+    char chunk[4096];
+    while (true) {
+      std::size_t end = buffer.find("\r\n\r\n");
+      if (end == std::string::npos) {
+        ssize_t n = ::read(client, chunk, sizeof(chunk));
+        if (n <= 0) {
+          return;
+        }
+        buffer.append(chunk, static_cast<std::size_t>(n));
+        continue;
+      }
+      std::string head = buffer.substr(0, end + 4);
+      std::size_t bodyLength = 0;
+      std::size_t field = head.find("content-length: ");
+      if (field == std::string::npos) {
+        field = head.find("Content-Length: ");
+      }
+      if (field != std::string::npos) {
+        bodyLength = std::strtoul(head.c_str() + field + 16, nullptr, 10);
+      }
+      while (buffer.size() < head.size() + bodyLength) {
+        ssize_t n = ::read(client, chunk, sizeof(chunk));
+        if (n <= 0) {
+          return;
+        }
+        buffer.append(chunk, static_cast<std::size_t>(n));
+      }
+      buffer.erase(0, head.size() + bodyLength);
+      requests++;
+      bool close = false;
+      std::string reply = handler(head.substr(0, head.find("\r\n")), close);
+      if (::write(client, reply.data(), reply.size()) < 0 || close) {
+        return;
+      }
+    }
+  }
+};
+
+Request makeRequest(Method method, const std::string &url) {
+  Request request;
+  request.method = method;
+  request.url = url;
+  request.version = Version::HTTP_1_1;
+  return request;
+}
+
+void waitFor(const std::atomic<int> &counter, int value) {
+  for (int i = 0; i < 200 && counter < value; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  // let the FIN reach the client side of the socket
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+
+void testInterimResponses() {
+  ServerStub server([](const std::string &line, bool &) -> std::string {
+    if (line.rfind("GET /hints", 0) == 0) {
+      return "HTTP/1.1 103 Early Hints\r\nLink: </style.css>\r\n\r\n"
+             "HTTP/1.1 100 Continue\r\n\r\n"
+             "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+    }
+    if (line.rfind("GET /limited", 0) == 0) {
+      return "HTTP/1.1 429 Too Many Requests\r\nContent-Length: 4\r\n\r\nslow";
+    }
+    return "HTTP/1.1 204\r\n\r\n";
+  });
+  std::unique_ptr<ClientConnection> connection =
+      ClientConnection::connect("127.0.0.1", server.port);
+  check(connection != nullptr, "connect to the stub");
+  if (!connection) {
+    return;
+  }
+  ClientResponse out;
+  check(connection->send(makeRequest(Method::METHOD_GET, "/hints")) &&
+            connection->receive(out),
+        "response after interim responses");
+  check(static_cast<int>(out.response.status_code) == 200 &&
+            out.body == "ok",
+        "103 and 100 are skipped");
+
+  check(connection->send(makeRequest(Method::METHOD_GET, "/limited")) &&
+            connection->receive(out),
+        "429 response");
+  check(static_cast<int>(out.response.status_code) == 429 &&
+            out.body == "slow",
+        "status without an enumerator keeps its number");
+  check(status_code_to_string(out.response.status_code) == "429",
+        "429 converts back to a string");
+
+  check(connection->send(makeRequest(Method::METHOD_GET, "/empty")) &&
+            connection->receive(out),
+        "status line without reason phrase");
+  check(out.response.status_code == StatusCode::NO_CONTENT &&
+            out.response.status_message.empty() && out.body.empty(),
+        "204 without reason phrase");
+}
+
+void testStaleConnectionRetry() {
+  // every connection answers one request and is then closed by the server,
+  // without announcing it, like an idle timeout
+  ServerStub server([](const std::string &, bool &close) -> std::string {
+    close = true;
+    return "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+  });
+  ConnectionPool pool;
+  ClientResponse out;
+  check(pool.request("127.0.0.1", server.port,
+                     makeRequest(Method::METHOD_GET, "/"), {}, out),
+        "first GET");
+  check(pool.idle_count("127.0.0.1", server.port) == 1,
+        "connection kept idle");
+  waitFor(server.closedConnections, 1);
+
+  check(pool.request("127.0.0.1", server.port,
+                     makeRequest(Method::METHOD_GET, "/"), {}, out) &&
+            out.body == "ok",
+        "GET is retried on a fresh connection");
+  check(server.connections == 2 && server.requests == 2,
+        "GET was sent once per connection");
+  waitFor(server.closedConnections, 2);
+
+  check(!pool.request("127.0.0.1", server.port,
+                      makeRequest(Method::METHOD_POST, "/"), "data", out),
+        "POST on a stale connection fails");
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  check(server.connections == 2 && server.requests == 2,
+        "POST is not replayed");
+}
+
+// After a server restart every idle connection is stale; the retry must
+// not pick the next one from the pool.
+void testRetryAfterRestart() {
+  ServerStub server([](const std::string &, bool &close) -> std::string {
+    close = true;
+    return "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+  });
+  ConnectionPool pool;
+  std::unique_ptr<ClientConnection> first = pool.acquire("127.0.0.1",
+                                                         server.port);
+  std::unique_ptr<ClientConnection> second = pool.acquire("127.0.0.1",
+                                                          server.port);
+  ClientResponse out;
+  check(first && second &&
+            first->send(makeRequest(Method::METHOD_GET, "/")) &&
+            first->receive(out) &&
+            second->send(makeRequest(Method::METHOD_GET, "/")) &&
+            second->receive(out),
+        "two connections answered once each");
+  pool.release(std::move(first));
+  pool.release(std::move(second));
+  check(pool.idle_count("127.0.0.1", server.port) == 2,
+        "both connections idle");
+  waitFor(server.closedConnections, 2);
+
+  check(pool.request("127.0.0.1", server.port,
+                     makeRequest(Method::METHOD_GET, "/"), {}, out) &&
+            out.body == "ok",
+        "GET succeeds on a newly opened connection");
+  check(server.connections == 3 && server.requests == 3,
+        "the retry opened a new connection");
+}
+
+void testRequestSerializer() {
+  RequestSerializer serializer;
+  serializer.set_host("example.com");
+  std::string expected = "POST /submit HTTP/1.1\r\nx-a: 1\r\n"
+                         "host: example.com\r\ncontent-length: 4\r\n\r\n";
+  Request request = makeRequest(Method::METHOD_POST, "/submit");
+  request.headers.add("x-a", "1");
+  check(serializer.serialize(request, "data") && serializer.size() ==
+                                                    expected.size() + 4,
+        "request serialized");
+  const iovec &head = serializer.iovecs()[0];
+  check(std::string(static_cast<const char *>(head.iov_base), head.iov_len) ==
+            expected,
+        "default host and content-length are added");
+
+  Request get = makeRequest(Method::METHOD_GET, "/");
+  get.headers.add("Host", "other");
+  check(serializer.serialize(get) && serializer.size() ==
+                                         std::string("GET / HTTP/1.1\r\n"
+                                                     "Host: other\r\n\r\n")
+                                             .size(),
+        "GET without body gets no content-length, Host is kept");
+
+  check(!serializer.serialize(makeRequest(Method::METHOD_GET, "/a b")),
+        "whitespace in the target is refused");
+  Request injected = makeRequest(Method::METHOD_GET, "/");
+  injected.headers.add("x-a", "1\r\nx-b: 2");
+  check(!serializer.serialize(injected), "line breaks in a value are refused");
+}
+
+} // namespace
+
+int main() {
+  // writes to a connection the stub closed must fail, not kill the test
+  std::signal(SIGPIPE, SIG_IGN);
+  testInterimResponses();
+  testStaleConnectionRetry();
+  testRetryAfterRestart();
+  testRequestSerializer();
+  return test::test_result("client_test");
+}
@@ -0,0 +1,134 @@
+/**
+ * @file conditional_test.cpp
+ * @brief entity tags and the precondition evaluation order
+ */
+
+#include "Check.h"
+#include "Conditional.hpp"
+#include <string>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+Request makeRequest(Method method,
+                    std::initializer_list<std::pair<const char *, const char *>>
+                        headers) {
+  Request request;
+  request.method = method;
+  request.url = "/r";
+  request.version = Version::HTTP_1_1;
+  for (const auto &header : headers) {
+    request.headers.add(header.first, header.second);
+  }
+  return request;
+}
+
+void testEntityTags() {
+  EntityTag tag;
+  check(parse_entity_tag("\"abc\"", tag) && tag.opaque == "abc" && !tag.weak,
+        "strong tag");
+  check(parse_entity_tag("W/\"abc\"", tag) && tag.opaque == "abc" && tag.weak,
+        "weak tag");
+  check(parse_entity_tag("\"\"", tag) && tag.opaque.empty(), "empty tag");
+  check(!parse_entity_tag("abc", tag) && !parse_entity_tag("\"abc", tag) &&
+            !parse_entity_tag("w/\"abc\"", tag),
+        "malformed tags");
+
+  EntityTag strong{"v1", false};
+  EntityTag weak{"v1", true};
+  check(strong_match(strong, strong) && !strong_match(strong, weak) &&
+            weak_match(strong, weak),
+        "strong and weak comparison");
+
+  EntityTagList list("\"a\", W/\"b\" ,\"c\"");
+  std::string seen;
+  for (const EntityTag &member : list) {
+    seen += std::string(member.opaque) + (member.weak ? "w" : "") + ";";
+  }
+  check(seen == "a;bw;c;" && list.valid(), "list members");
+  check(list.contains(EntityTag{"b", false}, true) &&
+            !list.contains(EntityTag{"b", false}, false),
+        "contains with either comparison");
+  check(EntityTagList("*").is_wildcard(), "wildcard list");
+
+  EntityTagList broken("\"a\", b");
+  std::size_t count = 0;
+  for (auto it = broken.begin(); it != broken.end(); ++it) {
+    count++;
+  }
+  check(count == 1 && !broken.valid(), "iteration stops at a bad member");
+}
+
+void testPreconditions() {
+  ResourceValidators validators;
+  validators.etag = "\"v2\"";
+  validators.lastModified = 784111777; // Sun, 06 Nov 1994 08:49:37 GMT
+
+  check(evaluate_preconditions(makeRequest(Method::METHOD_GET, {}),
+                               validators) == StatusCode::OK,
+        "unconditional request");
+  check(evaluate_preconditions(
+            makeRequest(Method::METHOD_GET, {{"If-None-Match", "\"v1\", W/\"v2\""}}),
+            validators) == StatusCode::NOT_MODIFIED,
+        "If-None-Match uses weak comparison");
+  check(evaluate_preconditions(
+            makeRequest(Method::METHOD_PUT, {{"If-None-Match", "*"}}),
+            validators) == StatusCode::PRECONDITION_FAILED,
+        "If-None-Match: * on an unsafe method");
+  check(evaluate_preconditions(
+            makeRequest(Method::METHOD_PUT, {{"If-Match", "W/\"v2\""}}),
+            validators) == StatusCode::PRECONDITION_FAILED,
+        "If-Match uses strong comparison");
+  check(evaluate_preconditions(
+            makeRequest(Method::METHOD_PUT, {{"If-Match", "\"v2\""}}),
+            validators) == StatusCode::OK,
+        "matching If-Match");
+
+  check(evaluate_preconditions(
+            makeRequest(Method::METHOD_GET,
+                        {{"If-Modified-Since", "Sun, 06 Nov 1994 08:49:37 GMT"}}),
+            validators) == StatusCode::NOT_MODIFIED,
+        "not modified since");
+  check(evaluate_preconditions(
+            makeRequest(Method::METHOD_GET,
+                        {{"If-Modified-Since", "Sat, 05 Nov 1994 08:49:37 GMT"}}),
+            validators) == StatusCode::OK,
+        "modified since");
+  check(evaluate_preconditions(
+            makeRequest(Method::METHOD_GET,
+                        {{"If-Modified-Since", "yesterday"}}),
+            validators) == StatusCode::OK,
+        "invalid dates are ignored");
+  check(evaluate_preconditions(
+            makeRequest(Method::METHOD_GET,
+                        {{"If-None-Match", "\"v1\""},
+                         {"If-Modified-Since", "Sun, 06 Nov 1994 08:49:37 GMT"}}),
+            validators) == StatusCode::OK,
+        "If-None-Match takes precedence over If-Modified-Since");
+  check(evaluate_preconditions(
+            makeRequest(Method::METHOD_POST,
+                        {{"If-Unmodified-Since", "Sat, 05 Nov 1994 08:49:37 GMT"}}),
+            validators) == StatusCode::PRECONDITION_FAILED,
+        "modified after If-Unmodified-Since");
+
+  ResourceValidators missing;
+  missing.exists = false;
+  check(evaluate_preconditions(
+            makeRequest(Method::METHOD_PUT, {{"If-Match", "*"}}), missing) ==
+            StatusCode::PRECONDITION_FAILED,
+        "If-Match: * without a representation");
+  check(evaluate_preconditions(
+            makeRequest(Method::METHOD_PUT, {{"If-None-Match", "*"}}),
+            missing) == StatusCode::OK,
+        "If-None-Match: * allows creating it");
+}
+
+} // namespace
+
+int main() {
+  testEntityTags();
+  testPreconditions();
+  return test::test_result("conditional_test");
+}
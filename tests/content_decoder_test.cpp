@@ -0,0 +1,147 @@
+/**
+ * @file content_decoder_test.cpp
+ * @brief Content-Encoding selection and streaming gzip / deflate decoding
+ */
+
+#include "Check.h"
+#include "ContentDecoder.hpp"
+#include <string>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+const std::string plain = "hello hello hello hello, compressed world\n";
+
+// `plain` compressed by zlib as gzip (mtime 0), zlib format and raw deflate
+const char gzipData[] =
+    "\x1f\x8b\x08\x00\x00\x00\x00\x00\x02\x03\xcb\x48\xcd\xc9\xc9\x57\xc8"
+    "\x40\x27\x75\x14\x92\xf3\x73\x0b\x8a\x52\x8b\x8b\x53\x53\x14\xca\xf3"
+    "\x8b\x72\x52\xb8\x00\x56\xc7\x31\x24\x2a\x00\x00\x00";
+const char zlibData[] =
+    "\x78\x9c\xcb\x48\xcd\xc9\xc9\x57\xc8\x40\x27\x75\x14\x92\xf3\x73\x0b"
+    "\x8a\x52\x8b\x8b\x53\x53\x14\xca\xf3\x8b\x72\x52\xb8\x00\x51\x14\x0f"
+    "\x84";
+const char rawData[] =
+    "\xcb\x48\xcd\xc9\xc9\x57\xc8\x40\x27\x75\x14\x92\xf3\x73\x0b\x8a\x52"
+    "\x8b\x8b\x53\x53\x14\xca\xf3\x8b\x72\x52\xb8\x00";
+
+const std::string gzipBody(gzipData, sizeof(gzipData) - 1);
+const std::string zlibBody(zlibData, sizeof(zlibData) - 1);
+const std::string rawBody(rawData, sizeof(rawData) - 1);
+
+// feeds `body` in pieces of `step` bytes, drains pending output and
+// finishes the stream
+std::string decode(ContentDecoder &decoder, const std::string &body,
+                   std::size_t step) {
+  std::string out;
+  std::size_t offset = 0;
+  while ((offset < body.size() || decoder.pending()) && !decoder.failed()) {
+    std::size_t length = std::min(step, body.size() - offset);
+    std::string_view piece;
+    offset += decoder.execute(body.data() + offset, length, piece);
+    out.append(piece.data(), piece.size());
+  }
+  decoder.finish();
+  return out;
+}
+
+void testCodingSelection() {
+  Headers none;
+  check(content_coding(none) == ContentCoding::IDENTITY, "no header");
+  Headers gzip;
+  gzip.add("Content-Encoding", "x-gzip");
+  check(content_coding(gzip) == ContentCoding::GZIP, "x-gzip");
+  Headers deflate;
+  deflate.add("Content-Encoding", " Deflate ");
+  check(content_coding(deflate) == ContentCoding::DEFLATE, "deflate");
+  Headers identity;
+  identity.add("Content-Encoding", "identity");
+  check(content_coding(identity) == ContentCoding::IDENTITY, "identity");
+  Headers stacked;
+  stacked.add("Content-Encoding", "gzip, br");
+  check(content_coding(stacked) == ContentCoding::UNSUPPORTED,
+        "more than one coding");
+  Headers unknown;
+  unknown.add("Content-Encoding", "br");
+  check(content_coding(unknown) == ContentCoding::UNSUPPORTED,
+        "unknown coding");
+}
+
+void testIdentity() {
+  ContentDecoder decoder;
+  check(decoder.reset(ContentCoding::IDENTITY), "identity always decodes");
+  std::string_view out;
+  check(decoder.execute(plain.data(), plain.size(), out) == plain.size() &&
+            out.data() == plain.data(),
+        "identity is passed through as a view");
+  decoder.finish();
+  check(decoder.done() && decoder.decoded_size() == plain.size(),
+        "identity done");
+  check(!decoder.reset(ContentCoding::UNSUPPORTED), "unsupported coding");
+}
+
+void testCompressed() {
+  ContentDecoder probe;
+  if (!probe.reset(ContentCoding::GZIP)) {
+    // built without zlib, only identity can be decoded
+    check(!probe.reset(ContentCoding::DEFLATE), "deflate needs zlib too");
+    return;
+  }
+  for (std::size_t step : {std::size_t(1), std::size_t(5), gzipBody.size()}) {
+    ContentDecoder decoder;
+    decoder.reset(ContentCoding::GZIP);
+    check(decode(decoder, gzipBody, step) == plain && decoder.done(),
+          "gzip in pieces");
+  }
+  ContentDecoder zlib;
+  zlib.reset(ContentCoding::DEFLATE);
+  check(decode(zlib, zlibBody, 7) == plain && zlib.done(), "zlib deflate");
+  ContentDecoder raw;
+  raw.reset(ContentCoding::DEFLATE);
+  check(decode(raw, rawBody, 3) == plain && raw.done(),
+        "raw deflate is accepted");
+
+  ContentDecoder small(8);
+  small.reset(ContentCoding::GZIP);
+  check(decode(small, gzipBody, gzipBody.size()) == plain && small.done() &&
+            small.decoded_size() == plain.size(),
+        "output larger than the buffer comes out in pieces");
+}
+
+void testFailures() {
+  ContentDecoder decoder;
+  if (!decoder.reset(ContentCoding::GZIP, 10)) {
+    return;
+  }
+  decode(decoder, gzipBody, gzipBody.size());
+  check(decoder.get_state() == DecodeState::TOO_LARGE && decoder.failed(),
+        "output above the limit stops decoding");
+
+  decoder.reset(ContentCoding::GZIP);
+  decode(decoder, gzipBody.substr(0, gzipBody.size() - 6), 4);
+  check(decoder.get_state() == DecodeState::PARSE_ERROR,
+        "truncated stream fails on finish");
+
+  std::string corrupt = gzipBody;
+  corrupt[12] = static_cast<char>(corrupt[12] ^ 0xff);
+  decoder.reset(ContentCoding::GZIP);
+  decode(decoder, corrupt, corrupt.size());
+  check(decoder.failed(), "corrupt stream");
+
+  decoder.reset(ContentCoding::GZIP);
+  decode(decoder, "not compressed at all", 64);
+  check(decoder.get_state() == DecodeState::PARSE_ERROR,
+        "plain text labelled gzip");
+}
+
+} // namespace
+
+int main() {
+  testCodingSelection();
+  testIdentity();
+  testCompressed();
+  testFailures();
+  return test::test_result("content_decoder_test");
+}
@@ -0,0 +1,68 @@
+/**
+ * @file cookie_test.cpp
+ * @brief iteration over Cookie header pairs
+ */
+
+#include "Check.h"
+#include "Cookie.hpp"
+#include <string>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+std::string listed(std::string_view header) {
+  std::string out;
+  for (const Cookie &cookie : Cookies(header)) {
+    out += std::string(cookie.name) + "=" + std::string(cookie.value) + ";";
+  }
+  return out;
+}
+
+void testIteration() {
+  check(listed("SID=31d4d96e407aad42; lang=en-US") ==
+            "SID=31d4d96e407aad42;lang=en-US;",
+        "pairs in order");
+  check(listed(" a = 1 ;;  ; b=\"quoted\" ;c=") == "a=1;b=quoted;c=;",
+        "whitespace, empty pairs, quotes and empty values");
+  check(listed("nameless") == "=nameless;", "a pair without '='");
+  check(listed("").empty() && listed(" ; ; ").empty(), "no pairs");
+  check(listed("x=\"") == "x=\";", "a lone quote is kept");
+
+  std::string header = "a=1; b=2";
+  Cookies cookies(header);
+  auto it = cookies.begin();
+  check(it->value.data() == header.data() + 2,
+        "values are views into the header");
+  auto previous = it++;
+  check(previous != it && previous->name == "a" && it->name == "b",
+        "post-increment");
+  check(++it == cookies.end(), "end after the last pair");
+
+  Cookies empties("a=; b=");
+  auto first = empties.begin();
+  auto second = first;
+  ++second;
+  check(first != second && second != empties.end(),
+        "empty values of different pairs are different positions");
+}
+
+void testFind() {
+  Cookies cookies("theme=dark; Theme=light; id=7; id=8");
+  std::string_view value;
+  check(cookies.find("theme", value) && value == "dark",
+        "first cookie with the name");
+  check(cookies.find("Theme", value) && value == "light",
+        "names are case-sensitive");
+  check(cookies.find("id", value) && value == "7", "duplicates");
+  check(!cookies.find("missing", value), "missing cookie");
+}
+
+} // namespace
+
+int main() {
+  testIteration();
+  testFind();
+  return test::test_result("cookie_test");
+}
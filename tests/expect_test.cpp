@@ -0,0 +1,149 @@
+/**
+ * @file expect_test.cpp
+ * @brief Expect: 100-continue detection and the ContinueHandler exchange
+ */
+
+#include "Check.h"
+#include "Expect.hpp"
+#include "RequestParser.hpp"
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+Request parse(const char *message) {
+  RequestParser parser;
+  parser.execute(message, std::strlen(message));
+  return parser.get_request();
+}
+
+std::string drain(int fd) {
+  std::string out;
+  char buffer[256];
+  ssize_t n;
+  while ((n = ::read(fd, buffer, sizeof(buffer))) > 0) {
+    out.append(buffer, static_cast<std::size_t>(n));
+  }
+  return out;
+}
+
+void testDetection() {
+  check(parse("POST / HTTP/1.1\r\nHost: a\r\nExpect: 100-Continue\r\n"
+              "Content-Length: 5\r\n\r\n")
+            .expects_continue(),
+        "100-continue is flagged");
+  check(parse("POST / HTTP/1.1\r\nHost: a\r\nExpect: something\r\n\r\n")
+                .expectation == Expectation::UNSUPPORTED,
+        "other expectations are unsupported");
+  check(parse("POST / HTTP/1.0\r\nExpect: 100-continue\r\n\r\n").expectation ==
+            Expectation::NONE,
+        "HTTP/1.0 requests ignore Expect");
+}
+
+// a parser reused for the next request on the connection starts clean
+void testReusedParser() {
+  const char requests[] = "POST /a HTTP/1.1\r\nHost: a\r\n"
+                          "Expect: 100-continue\r\nContent-Length: 1\r\n\r\nx"
+                          "POST /b HTTP/1.0\r\nExpect: 100-continue\r\n\r\n"
+                          "GET /c HTTP/1.0\r\n\r\n";
+  int fds[2];
+  if (::pipe(fds) != 0) {
+    check(false, "pipe");
+    return;
+  }
+  ::write(fds[1], requests, std::strlen(requests));
+  ::close(fds[1]);
+
+  RequestParser parser;
+  check(parser.parse(fds[0]) && parser.get_request().expects_continue(),
+        "first request expects 100-continue");
+  char body;
+  ::read(fds[0], &body, 1);
+  check(parser.parse(fds[0]) && parser.get_request().url == "/b" &&
+            parser.get_request().expectation == Expectation::NONE,
+        "an HTTP/1.0 request after it does not");
+  check(parser.parse(fds[0]) && parser.get_request().url == "/c" &&
+            parser.get_request().headers.empty() &&
+            !parser.get_request().should_keep_alive(),
+        "nothing of the earlier requests is left");
+  ::close(fds[0]);
+
+  RequestParser buffered;
+  const char first[] = "POST / HTTP/1.1\r\nHost: a\r\nExpect: 100-continue\r\n\r\n";
+  const char second[] = "POST / HTTP/1.0\r\nExpect: 100-continue\r\n\r\n";
+  buffered.execute(first, std::strlen(first));
+  buffered.reset();
+  buffered.execute(second, std::strlen(second));
+  check(buffered.get_request().expectation == Expectation::NONE,
+        "reset() clears the expectation");
+}
+
+void testContinue() {
+  Request request = parse("PUT /f HTTP/1.1\r\nHost: a\r\n"
+                          "Expect: 100-continue\r\nContent-Length: 10\r\n\r\n");
+  ContinueHandler handler;
+  check(handler.start(request) == ContinueState::PENDING &&
+            handler.body_readable(),
+        "pending until answered");
+  check(handler.interim() == "HTTP/1.1 100 Continue\r\n\r\n", "interim bytes");
+  handler.consume(9);
+  check(handler.interim() == "100 Continue\r\n\r\n", "partly sent");
+
+  int fds[2];
+  if (::pipe(fds) != 0) {
+    check(false, "pipe");
+    return;
+  }
+  check(handler.send_continue(fds[1]) &&
+            handler.state() == ContinueState::CONTINUED &&
+            handler.interim().empty(),
+        "the rest is written");
+  ::close(fds[1]);
+  check(drain(fds[0]) == "100 Continue\r\n\r\n", "written bytes");
+  ::close(fds[0]);
+
+  Request empty = parse("POST / HTTP/1.1\r\nHost: a\r\n"
+                        "Expect: 100-continue\r\nContent-Length: 0\r\n\r\n");
+  check(handler.start(empty) == ContinueState::NONE,
+        "no exchange without a body");
+  check(handler.start(parse("GET / HTTP/1.1\r\nHost: a\r\n\r\n")) ==
+                ContinueState::NONE &&
+            handler.send_continue(-1),
+        "nothing to send without the expectation");
+}
+
+void testReject() {
+  Request request = parse("POST / HTTP/1.1\r\nHost: a\r\n"
+                          "Expect: 100-continue\r\n"
+                          "Transfer-Encoding: chunked\r\n\r\n");
+  ContinueHandler handler;
+  check(handler.start(request) == ContinueState::PENDING,
+        "chunked uploads wait too");
+  Response response;
+  response.status_code = StatusCode::CONTENT_TOO_LARGE;
+  handler.reject(request, response);
+  check(handler.state() == ContinueState::REJECTED &&
+            !handler.body_readable() && !request.keep_alive,
+        "the body is never read and the connection closes");
+  check(response.headers.value_of(HeaderId::CONNECTION) == "close" &&
+            response.headers.size() == 1,
+        "connection: close on the final response");
+  check(!handler.send_continue(-1) && handler.interim().empty(),
+        "no interim response after rejecting");
+  handler.reject(request, response);
+  check(response.headers.size() == 1, "close is added once");
+}
+
+} // namespace
+
+int main() {
+  testDetection();
+  testReusedParser();
+  testContinue();
+  testReject();
+  return test::test_result("expect_test");
+}
@@ -0,0 +1,155 @@
+/**
+ * @file header_editor_test.cpp
+ * @brief in-place header edits, hop-by-hop removal and the iovec output
+ */
+
+#include "Check.h"
+#include "HeaderEditor.hpp"
+#include <string>
+#include <unistd.h>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+std::string joined(const HeaderEditor &editor) {
+  std::string out;
+  for (std::size_t i = 0; i < editor.iovec_count(); i++) {
+    const iovec &part = editor.iovecs()[i];
+    out.append(static_cast<const char *>(part.iov_base), part.iov_len);
+  }
+  return out;
+}
+
+const std::string head = "GET http://example.com/a HTTP/1.1\r\n"
+                         "Host: example.com\r\n"
+                         "User-Agent:  test  \r\n"
+                         "X-Forwarded-For: 192.0.2.1\r\n"
+                         "Accept: */*\r\n"
+                         "\r\n";
+
+void testAttach() {
+  HeaderEditor editor;
+  check(editor.attach(head) && editor.size() == 4, "attach");
+  check(editor.start_line() == "GET http://example.com/a HTTP/1.1" &&
+            editor.key(1) == "User-Agent" && editor.value(1) == "test",
+        "lines are indexed and values trimmed");
+  check(!editor.attach("GET / HTTP/1.1\r\nHost: a\r\n") &&
+            !editor.attach("GET / HTTP/1.1\r\nbroken\r\n\r\n"),
+        "incomplete or malformed blocks");
+
+  check(editor.attach(head), "attach again");
+  editor.build();
+  check(joined(editor) == head && editor.iovec_count() == 1 &&
+            editor.output_size() == head.size(),
+        "an unedited block is one slice of the input");
+}
+
+void testEdits() {
+  HeaderEditor editor;
+  editor.attach(head);
+  editor.set_start_line("GET /a HTTP/1.1");
+  editor.remove(HeaderId::USER_AGENT);
+  editor.append("x-forwarded-for", "198.51.100.7");
+  editor.set("Accept", "text/html");
+  editor.add("Via", "1.1 proxy");
+  editor.build();
+  check(joined(editor) == "GET /a HTTP/1.1\r\n"
+                          "Host: example.com\r\n"
+                          "X-Forwarded-For: 192.0.2.1, 198.51.100.7\r\n"
+                          "Accept: text/html\r\n"
+                          "Via: 1.1 proxy\r\n"
+                          "\r\n",
+        "start line, removal, append, set and add");
+
+  editor.attach("GET / HTTP/1.1\r\nX-A: 1\r\nX-A: 2\r\n\r\n");
+  editor.set("x-a", "3");
+  editor.append("X-A", "4");
+  editor.build();
+  check(joined(editor) == "GET / HTTP/1.1\r\nX-A: 3, 4\r\n\r\n",
+        "set keeps one header, append extends the replaced value");
+}
+
+void testHopByHop() {
+  HeaderEditor editor;
+  editor.attach("GET / HTTP/1.1\r\n"
+                "Host: a\r\n"
+                "Connection: keep-alive, X-Private\r\n"
+                "Keep-Alive: timeout=5\r\n"
+                "X-Private: secret\r\n"
+                "TE: trailers\r\n"
+                "Upgrade: websocket\r\n"
+                "Proxy-Connection: close\r\n"
+                "Transfer-Encoding: chunked\r\n"
+                "\r\n");
+  editor.remove_hop_by_hop();
+  editor.build();
+  check(joined(editor) == "GET / HTTP/1.1\r\n"
+                          "Host: a\r\n"
+                          "Transfer-Encoding: chunked\r\n"
+                          "\r\n",
+        "hop-by-hop headers and connection options are removed");
+
+  // a client must not be able to strip the framing the proxy relies on
+  std::string smuggling = "POST / HTTP/1.1\r\n"
+                          "Host: a\r\n"
+                          "Content-Length: 5\r\n"
+                          "Connection: content-length, Transfer-Encoding, "
+                          "HOST\r\n"
+                          "\r\n";
+  editor.attach(smuggling);
+  editor.remove_hop_by_hop();
+  editor.build();
+  check(joined(editor) == "POST / HTTP/1.1\r\n"
+                          "Host: a\r\n"
+                          "Content-Length: 5\r\n"
+                          "\r\n",
+        "content-length and host named in Connection are kept");
+
+  editor.attach("POST / HTTP/1.1\r\n"
+                "Host: a\r\n"
+                "Transfer-Encoding: chunked\r\n"
+                "Connection: transfer-encoding\r\n"
+                "\r\n");
+  editor.remove_hop_by_hop();
+  editor.build();
+  check(joined(editor) == "POST / HTTP/1.1\r\n"
+                          "Host: a\r\n"
+                          "Transfer-Encoding: chunked\r\n"
+                          "\r\n",
+        "transfer-encoding named in Connection is kept");
+}
+
+void testWrite() {
+  HeaderEditor editor;
+  editor.attach(head);
+  editor.set("Accept", "text/plain");
+  editor.build();
+  std::string expected = joined(editor);
+  int fds[2];
+  if (::pipe(fds) != 0) {
+    check(false, "pipe");
+    return;
+  }
+  check(editor.write(fds[1]) && editor.output_size() == 0, "write");
+  ::close(fds[1]);
+  std::string received;
+  char buffer[512];
+  ssize_t n;
+  while ((n = ::read(fds[0], buffer, sizeof(buffer))) > 0) {
+    received.append(buffer, static_cast<std::size_t>(n));
+  }
+  ::close(fds[0]);
+  check(received == expected, "written bytes");
+}
+
+} // namespace
+
+int main() {
+  testAttach();
+  testEdits();
+  testHopByHop();
+  testWrite();
+  return test::test_result("header_editor_test");
+}
@@ -0,0 +1,102 @@
+/**
+ * @file header_list_test.cpp
+ * @brief HeaderList storage, lookups and the well known header ids
+ */
+
+#include "Check.h"
+#include "HeaderList.hpp"
+#include <string>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+void testHeaderIds() {
+  bool roundTrip = true;
+  for (std::size_t i = 1; i < static_cast<std::size_t>(HeaderId::HEADER_ID_COUNT);
+       i++) {
+    HeaderId id = static_cast<HeaderId>(i);
+    roundTrip = roundTrip && string_to_header_id(header_id_to_string(id)) == id;
+  }
+  check(roundTrip, "every id maps to its name and back");
+  check(string_to_header_id("Content-LENGTH") == HeaderId::CONTENT_LENGTH,
+        "ids are looked up case-insensitively");
+  check(string_to_header_id("x-custom") == HeaderId::UNKOWN &&
+            string_to_header_id("") == HeaderId::UNKOWN,
+        "unknown and empty names are UNKOWN");
+  check(header_id_to_string(HeaderId::UNKOWN).empty(),
+        "UNKOWN has no name");
+  check(header_name_equals("Accept", "aCCEPT") &&
+            !header_name_equals("accept", "accepts"),
+        "header_name_equals ignores case only");
+}
+
+void testInlineStorage() {
+  HeaderList<4> headers;
+  check(headers.empty(), "a new list is empty");
+  check(headers.add("Host", "example.com") &&
+            headers.add("X-Trace", "abc") && headers.add("Accept", "*/*"),
+        "headers are added");
+  check(headers.size() == 3, "size counts the headers");
+  check(headers[0].id == HeaderId::HOST && headers[0].key == "Host" &&
+            headers[0].value == "example.com",
+        "key and value keep their spelling");
+  check(headers[1].id == HeaderId::UNKOWN, "unknown names get no id");
+  check(headers.value_of(HeaderId::ACCEPT) == "*/*", "value_of by id");
+  check(headers.value_of("x-trace") == "abc",
+        "unknown names are found case-insensitively");
+  check(headers.value_of(HeaderId::COOKIE, "none") == "none",
+        "value_of returns the fallback when absent");
+  check(headers.contains(HeaderId::HOST) && !headers.contains(HeaderId::VIA),
+        "contains");
+  check(headers.find(HeaderId::UNKOWN) == headers.end(),
+        "UNKOWN is never found");
+}
+
+void testOverflow() {
+  HeaderList<2> headers;
+  for (int i = 0; i < 6; i++) {
+    headers.add(i % 2 == 0 ? "Via" : "X-Other", "v" + std::to_string(i));
+  }
+  check(headers.size() == 6, "entries past the inline capacity are kept");
+  check(headers[5].key == "X-Other" && headers[5].value == "v5" &&
+            headers.id_at(4) == HeaderId::VIA,
+        "overflow entries read back");
+
+  std::string values;
+  for (auto it = headers.find(HeaderId::VIA); it != headers.end();
+       it = headers.find(HeaderId::VIA, it.position() + 1)) {
+    values += (*it).value;
+  }
+  check(values == "v0v2v4", "repeated headers are found across the overflow");
+
+  std::size_t visited = 0;
+  for (HeaderView header : headers) {
+    visited += header.value.size();
+  }
+  check(visited == 12, "iteration visits inline and overflow entries");
+
+  headers.clear();
+  check(headers.empty() && headers.find("via") == headers.end(),
+        "clear drops everything");
+  check(headers.add("Via", "again") && headers[0].value == "again",
+        "the list is reusable after clear");
+}
+
+void testLimits() {
+  HeaderList<2> headers;
+  std::string longKey(70000, 'k');
+  check(!headers.add(longKey, "v"), "names longer than 64 KiB are rejected");
+  check(headers.empty(), "a rejected header is not stored");
+}
+
+} // namespace
+
+int main() {
+  testHeaderIds();
+  testInlineStorage();
+  testOverflow();
+  testLimits();
+  return test::test_result("header_list_test");
+}
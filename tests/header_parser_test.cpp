@@ -0,0 +1,126 @@
+/**
+ * @file header_parser_test.cpp
+ * @brief the header block parser on its own and inside ResponseParser
+ */
+
+#include "Check.h"
+#include "HeaderParser.h"
+#include "ResponseParser.hpp"
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+bool parseBlock(HeaderParser &parser, const std::string &block,
+                std::size_t &consumed) {
+  parser.reset();
+  consumed = parser.execute(block.data(), block.size());
+  return parser.done();
+}
+
+void testHeaderBlock() {
+  HeaderParser parser;
+  std::size_t consumed = 0;
+  std::string block = "Host:example.com\r\nAccept: \t text/html \t\r\n"
+                      "Empty:\r\nX-Obs: caf\xc3\xa9\r\n\r\nrest";
+  check(parseBlock(parser, block, consumed), "block parses");
+  check(consumed == block.size() - 4, "bytes after the block are left over");
+  const Headers &headers = parser.headers();
+  check(headers.size() == 4, "all headers stored");
+  check(headers.value_of(HeaderId::HOST) == "example.com" &&
+            headers.value_of(HeaderId::ACCEPT) == "text/html",
+        "optional whitespace around values is dropped");
+  check(headers.value_of("empty", "none").empty(), "empty values are kept");
+  check(headers.value_of("x-obs") == "caf\xc3\xa9", "obs-text is allowed");
+  check(parser.seen(HeaderId::HOST) && !parser.seen(HeaderId::COOKIE),
+        "seen reports the well known headers");
+
+  check(parseBlock(parser, "\r\n", consumed) && parser.headers().empty() &&
+            consumed == 2,
+        "an empty block");
+}
+
+void testSplitInput() {
+  std::string block = "Content-Type: text/plain\r\nX-Long-Name: abc def\r\n\r\n";
+  for (std::size_t split = 1; split < block.size(); split++) {
+    HeaderParser parser;
+    std::size_t consumed = parser.execute(block.data(), split);
+    consumed += parser.execute(block.data() + consumed, block.size() - consumed);
+    if (!parser.done() || consumed != block.size() ||
+        parser.headers().value_of("x-long-name") != "abc def") {
+      check(false, "a block split at any byte parses the same");
+      return;
+    }
+  }
+}
+
+void testInvalidBlocks() {
+  HeaderParser parser;
+  std::size_t consumed = 0;
+  check(!parseBlock(parser, "Bad Key: x\r\n\r\n", consumed) && parser.failed(),
+        "space in a key");
+  check(!parseBlock(parser, ": no key\r\n\r\n", consumed), "empty key");
+  check(!parseBlock(parser, "Key: a\rb\r\n\r\n", consumed),
+        "CR without LF inside a line");
+  check(!parseBlock(parser, std::string("Key: a\0b\r\n\r\n", 12), consumed),
+        "NUL in a value");
+  check(!parser.getErrorMessage().empty(), "errors are described");
+}
+
+void testResponseParser() {
+  ResponseParser parser;
+  std::string message = "HTTP/1.1 404 Not Found\r\nContent-Length: 3\r\n"
+                        "Connection: close\r\n\r\nabc";
+  std::size_t consumed = parser.execute(message.data(), message.size());
+  check(parser.get_state() == ResponseParseState::DONE &&
+            consumed == message.size() - 3,
+        "response head parses");
+  Response response = parser.get_response();
+  check(response.status_code == StatusCode::NOT_FOUND &&
+            response.status_message == "Not Found" &&
+            response.headers.value_of(HeaderId::CONTENT_LENGTH) == "3",
+        "status line and headers");
+  check(!response.keep_alive, "Connection: close is applied");
+
+  parser.reset();
+  message = "HTTP/1.1 200 OK\r\nBroken Header\r\n\r\n";
+  parser.execute(message.data(), message.size());
+  check(parser.get_state() == ResponseParseState::PARSE_ERROR,
+        "header errors fail the response");
+}
+
+void testDescriptorInput() {
+  int fds[2];
+  if (::pipe(fds) != 0) {
+    check(false, "pipe");
+    return;
+  }
+  std::string message = "X-A: 1\r\nX-B: 2\r\n\r\nbody";
+  check(::write(fds[1], message.data(), message.size()) ==
+            static_cast<ssize_t>(message.size()),
+        "write to the pipe");
+  ::close(fds[1]);
+  HeaderParser parser;
+  check(parser.parse(fds[0]) && parser.headers().size() == 2,
+        "block read from a descriptor");
+  char rest[8] = {};
+  check(::read(fds[0], rest, sizeof(rest)) == 4 &&
+            std::strcmp(rest, "body") == 0,
+        "the body stays in the descriptor");
+  ::close(fds[0]);
+}
+
+} // namespace
+
+int main() {
+  testHeaderBlock();
+  testSplitInput();
+  testInvalidBlocks();
+  testResponseParser();
+  testDescriptorInput();
+  return test::test_result("header_parser_test");
+}
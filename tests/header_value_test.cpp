@@ -0,0 +1,95 @@
+/**
+ * @file header_value_test.cpp
+ * @brief list elements, parameters and q-values of header values
+ */
+
+#include "Check.h"
+#include "HeaderValue.hpp"
+#include <string>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+std::string joined(std::string_view value) {
+  std::string out;
+  for (std::string_view element : TokenList(value)) {
+    out += std::string(element) + "|";
+  }
+  return out;
+}
+
+void testTokenList() {
+  check(joined("gzip, deflate ,br") == "gzip|deflate|br|", "elements");
+  check(joined(" , a,,\t, b ,") == "a|b|", "empty elements are skipped");
+  check(joined("").empty() && joined(" \t ").empty(), "no elements");
+  check(joined("a;x=\"1,2\", b") == "a;x=\"1,2\"|b|",
+        "commas in quoted strings do not split");
+  check(TokenList("Keep-Alive, Upgrade").contains("upgrade") &&
+            !TokenList("Keep-Alive").contains("keep"),
+        "contains ignores case, whole elements only");
+
+  TokenList list("a, b");
+  auto it = list.begin();
+  auto previous = it++;
+  check(*previous == "a" && *it == "b" && ++it == list.end(),
+        "iterator increments");
+}
+
+void testParameters() {
+  Parameters parameters;
+  std::string_view value =
+      split_parameters("text/html ; Level=1;charset=\"utf-8\"", parameters);
+  check(value == "text/html", "value before the parameters");
+  std::string seen;
+  for (const Parameter &parameter : parameters) {
+    seen += std::string(parameter.name) + "=" + std::string(parameter.value) +
+            (parameter.quoted ? "(q)" : "") + ";";
+  }
+  check(seen == "Level=1;charset=utf-8(q);", "parameters in order");
+  std::string_view found;
+  check(parameters.find("level", found) && found == "1",
+        "names are matched ignoring case");
+  check(!parameters.find("missing", found), "missing parameter");
+
+  split_parameters("a; x=\"semi;colon\" ; y=\"esc\\\"aped\"", parameters);
+  check(parameters.find("x", found) && found == "semi;colon" &&
+            parameters.find("y", found) && found == "esc\\\"aped",
+        "quoted strings keep delimiters and escapes");
+  check(split_parameters("plain", parameters) == "plain" &&
+            parameters.begin() == parameters.end(),
+        "no parameters");
+}
+
+void testQValues() {
+  std::uint16_t q = 0;
+  check(parse_qvalue("1", q) && q == 1000 && parse_qvalue("1.000", q) &&
+            q == 1000,
+        "one");
+  check(parse_qvalue("0.5", q) && q == 500 && parse_qvalue("0.125", q) &&
+            q == 125 && parse_qvalue("0", q) && q == 0,
+        "fractions");
+  check(!parse_qvalue("1.5", q) && !parse_qvalue("0.1234", q) &&
+            !parse_qvalue("", q) && !parse_qvalue(".5", q) &&
+            !parse_qvalue("2", q),
+        "malformed qvalues");
+
+  check(weighted_element("gzip;q=0.8", q) == "gzip" && q == 800,
+        "weighted element");
+  check(weighted_element("br", q) == "br" && q == 1000, "default weight");
+  check(weighted_element("text/html;level=1;Q=0.3", q) == "text/html" &&
+            q == 300,
+        "q among other parameters");
+  check(weighted_element("x;q=high", q) == "x" && q == 0,
+        "malformed q weighs nothing");
+}
+
+} // namespace
+
+int main() {
+  testTokenList();
+  testParameters();
+  testQValues();
+  return test::test_result("header_value_test");
+}
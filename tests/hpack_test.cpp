@@ -0,0 +1,271 @@
+/**
+ * @file hpack_test.cpp
+ * @brief HPACK header compression against the examples of RFC 7541
+ */
+
+#include "Check.h"
+#include "Hpack.hpp"
+#include <cstdint>
+#include <string>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+std::string bytes(const char *hex) {
+  std::string out;
+  for (const char *p = hex; p[0] != '\0' && p[1] != '\0'; p += 2) {
+    out += static_cast<char>(std::stoi(std::string(p, 2), nullptr, 16));
+  }
+  return out;
+}
+
+bool decodes(HpackDecoder &decoder, const std::string &block,
+             Headers &headers) {
+  headers.clear();
+  return decoder.decode(block.data(), block.size(), headers);
+}
+
+std::string listed(const Headers &headers) {
+  std::string out;
+  for (HeaderView header : headers) {
+    out += std::string(header.key) + ": " + std::string(header.value) + "\n";
+  }
+  return out;
+}
+
+void testHuffman() {
+  std::string encoded;
+  hpack_huffman_encode("www.example.com", encoded);
+  check(encoded == bytes("f1e3c2e5f23a6ba0ab90f4ff") &&
+            hpack_huffman_encoded_size("www.example.com") == encoded.size(),
+        "huffman code of C.4.1");
+  std::string all;
+  for (int c = 0; c < 256; c++) {
+    all += static_cast<char>(c);
+  }
+  encoded.clear();
+  hpack_huffman_encode(all, encoded);
+  std::string decoded;
+  check(hpack_huffman_decode(encoded, decoded) && decoded == all,
+        "every octet round trips");
+  decoded.clear();
+  check(!hpack_huffman_decode(bytes("ffffffff"), decoded),
+        "EOS in the string");
+  check(!hpack_huffman_decode(bytes("f1e3c2e5f23a6ba0ab90f4ffff"), decoded),
+        "padding longer than seven bits");
+  check(!hpack_huffman_decode(bytes("00"), decoded),
+        "padding that is not the EOS prefix");
+}
+
+void testRequests() {
+  HpackDecoder decoder;
+  Headers headers;
+  // C.4, requests with Huffman coding
+  check(decodes(decoder, bytes("828684418cf1e3c2e5f23a6ba0ab90f4ff"),
+                headers) &&
+            listed(headers) == ":method: GET\n:scheme: http\n:path: /\n"
+                               ":authority: www.example.com\n" &&
+            decoder.table().size() == 57,
+        "C.4.1");
+  check(decodes(decoder, bytes("828684be5886a8eb10649cbf"), headers) &&
+            listed(headers) == ":method: GET\n:scheme: http\n:path: /\n"
+                               ":authority: www.example.com\n"
+                               "cache-control: no-cache\n" &&
+            decoder.table().size() == 110,
+        "C.4.2");
+  check(decodes(decoder,
+                bytes("828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf"),
+                headers) &&
+            listed(headers) == ":method: GET\n:scheme: https\n"
+                               ":path: /index.html\n"
+                               ":authority: www.example.com\n"
+                               "custom-key: custom-value\n" &&
+            decoder.table().size() == 164 && decoder.table().count() == 3 &&
+            decoder.table().name(0) == "custom-key",
+        "C.4.3");
+
+  HpackDecoder plain;
+  Request request;
+  std::string block = bytes("828684410f7777772e6578616d706c652e636f6d");
+  check(plain.decode_request(block.data(), block.size(), request) &&
+            request.method == Method::METHOD_GET && request.url == "/" &&
+            request.version == Version::HTTP_2 &&
+            request.headers.value_of(HeaderId::HOST) == "www.example.com",
+        "C.3.1 onto a request");
+}
+
+void testResponses() {
+  // C.6, responses with Huffman coding and a 256 octet table
+  HpackDecoder decoder(256);
+  Headers headers;
+  check(decodes(decoder,
+                bytes("488264025885aec3771a4b6196d07abe941054d444a8200595040b"
+                      "8166e082a62d1bff6e919d29ad171863c78f0b97c8e9ae82ae43"
+                      "d3"),
+                headers) &&
+            listed(headers) == ":status: 302\ncache-control: private\n"
+                               "date: Mon, 21 Oct 2013 20:13:21 GMT\n"
+                               "location: https://www.example.com\n" &&
+            decoder.table().size() == 222,
+        "C.6.1");
+  check(decodes(decoder, bytes("4883640effc1c0bf"), headers) &&
+            headers.value_of(":status") == "307" &&
+            decoder.table().size() == 222,
+        "C.6.2 evicts the oldest entry");
+  Response response;
+  std::string block = bytes(
+      "88c16196d07abe941054d444a8200595040b8166e084a62d1bffc05a839bd9ab77ad94"
+      "e7821dd7f2e6c7b335dfdfcd5b3960d5af27087f3672c1ab270fb5291f9587316065"
+      "c003ed4ee5b1063d5007");
+  check(decoder.decode_response(block.data(), block.size(), response) &&
+            response.status_code == StatusCode::OK &&
+            response.headers.value_of(HeaderId::CONTENT_ENCODING) == "gzip" &&
+            response.headers.value_of(HeaderId::SET_COOKIE) ==
+                "foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1" &&
+            decoder.table().size() == 215,
+        "C.6.3 onto a response");
+}
+
+void testEncoder() {
+  HpackEncoder encoder;
+  HpackDecoder decoder;
+  Request request;
+  request.method = Method::METHOD_POST;
+  request.url = "/upload?x=1";
+  request.headers.add("Host", "example.com");
+  request.headers.add("Connection", "keep-alive");
+  request.headers.add("Content-Type", "text/plain");
+  for (int i = 0; i < 2; i++) {
+    std::string block;
+    encoder.encode_request(request, block, "https");
+    Request decoded;
+    check(decoder.decode_request(block.data(), block.size(), decoded) &&
+              decoded.method == Method::METHOD_POST &&
+              decoded.url == "/upload?x=1" &&
+              decoded.headers.value_of(HeaderId::HOST) == "example.com" &&
+              decoded.headers.value_of("content-type") == "text/plain" &&
+              !decoded.headers.contains(HeaderId::CONNECTION),
+          "request round trip, connection fields dropped");
+  }
+
+  Response response;
+  response.status_code = StatusCode::OK;
+  std::string block;
+  check(encoder.encode_response(response, block) && block == "\x88",
+        ":status 200 from the static table");
+  block.clear();
+  response.status_code = StatusCode::NOT_FOUND;
+  Response decoded;
+  check(encoder.encode_response(response, block) &&
+            decoder.decode_response(block.data(), block.size(), decoded) &&
+            decoded.status_code == StatusCode::NOT_FOUND,
+        "numeric status round trip");
+
+  std::size_t entries = encoder.table().count();
+  block.clear();
+  encoder.encode("authorization", "secret", block, true);
+  check(!block.empty() && (block[0] & 0xf0) == 0x10 &&
+            encoder.table().count() == entries,
+        "sensitive fields are never indexed");
+
+  encoder.set_max_table_size(0);
+  block.clear();
+  encoder.encode("x-custom", "value", block);
+  Headers headers;
+  check(block[0] == 0x20 && decodes(decoder, block, headers) &&
+            decoder.table().count() == 0 && encoder.table().count() == 0,
+        "table size update at the start of the next block");
+}
+
+void testMalformed() {
+  Headers headers;
+  HpackDecoder decoder;
+  check(!decodes(decoder, bytes("80"), headers) &&
+            decoder.compression_error(),
+        "index zero");
+  HpackDecoder unknown;
+  check(!decodes(unknown, bytes("be"), headers), "empty dynamic table");
+  HpackDecoder overflow;
+  check(!decodes(overflow, bytes("8fffffffffffffffffffffff7f"), headers),
+        "integer overflow");
+  HpackDecoder late;
+  check(!decodes(late, bytes("8220"), headers),
+        "table size update after a field");
+  HpackDecoder limited;
+  limited.set_max_table_size(100);
+  check(!decodes(limited, bytes("3fe11f"), headers),
+        "table size above the announced limit");
+  HpackDecoder truncated;
+  check(!decodes(truncated, bytes("400a637573746f6d2d6b6579"), headers),
+        "string shorter than its length");
+
+  HpackDecoder small;
+  small.set_max_header_list_size(40);
+  check(!decodes(small, bytes("828684418cf1e3c2e5f23a6ba0ab90f4ff"),
+                 headers) &&
+            !small.compression_error(),
+        "list limit is a malformed message, not a compression error");
+
+  HpackDecoder pseudo;
+  Request request;
+  std::string block = bytes("8286845885aec3771a4b");
+  check(pseudo.decode_request(block.data(), block.size(), request),
+        "pseudo-headers first");
+  block = bytes("5885aec3771a4b828684");
+  check(!pseudo.decode_request(block.data(), block.size(), request) &&
+            !pseudo.compression_error(),
+        "pseudo-header after a regular field");
+  block = bytes("8286844003466f6f0362617a");
+  check(!pseudo.decode_request(block.data(), block.size(), request) &&
+            !pseudo.compression_error(),
+        "uppercase field name");
+}
+
+// random and mutated blocks must fail cleanly, under ASan any read out of
+// bounds aborts the test
+void testFuzz() {
+  std::uint32_t seed = 12345;
+  auto next = [&seed]() {
+    seed = seed * 1103515245 + 12345;
+    return seed >> 16;
+  };
+  const std::string valid[] = {
+      bytes("828684418cf1e3c2e5f23a6ba0ab90f4ff"),
+      bytes("828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf"),
+      bytes("488264025885aec3771a4b6196d07abe941054d444a8200595040b8166e082"
+            "a62d1bff6e919d29ad171863c78f0b97c8e9ae82ae43d3")};
+  Headers headers;
+  for (int i = 0; i < 20000; i++) {
+    std::string block;
+    if (i % 2 == 0) {
+      block.resize(next() % 64);
+      for (char &c : block) {
+        c = static_cast<char>(next());
+      }
+    } else {
+      block = valid[next() % 3];
+      for (unsigned n = next() % 4 + 1; n > 0; n--) {
+        block[next() % block.size()] = static_cast<char>(next());
+      }
+      block.resize(next() % (block.size() + 1));
+    }
+    HpackDecoder decoder(256);
+    decodes(decoder, block, headers);
+    std::string out;
+    hpack_huffman_decode(block, out);
+  }
+}
+
+} // namespace
+
+int main() {
+  testHuffman();
+  testRequests();
+  testResponses();
+  testEncoder();
+  testMalformed();
+  testFuzz();
+  return test::test_result("hpack_test");
+}
@@ -0,0 +1,488 @@
+/**
+ * @file http2_test.cpp
+ * @brief HTTP/2 framing, settings, flow control and malformed requests
+ */
+
+#include "Check.h"
+#include "Http2.hpp"
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+std::string u32(std::uint32_t value) {
+  std::string out;
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    out += static_cast<char>(value >> shift);
+  }
+  return out;
+}
+
+std::string frame(Http2FrameType type, std::uint8_t flags,
+                  std::uint32_t stream, const std::string &payload) {
+  std::uint32_t length = static_cast<std::uint32_t>(payload.size());
+  std::string out;
+  out += static_cast<char>(length >> 16);
+  out += static_cast<char>(length >> 8);
+  out += static_cast<char>(length);
+  out += static_cast<char>(type);
+  out += static_cast<char>(flags);
+  return out + u32(stream) + payload;
+}
+
+// preface and an empty SETTINGS frame, as a client starts
+const std::string start =
+    std::string(HTTP2_PREFACE) + frame(Http2FrameType::SETTINGS, 0, 0, "");
+
+struct Event {
+  Http2Event type;
+  std::uint32_t stream;
+  bool endStream;
+  std::string payload;
+};
+
+// feeds `input` in pieces of `step` bytes, consuming the body data
+std::vector<Event> feed(Http2Connection &connection, const std::string &input,
+                        std::size_t step = 1 << 30, bool consume = true) {
+  std::vector<Event> events;
+  for (std::size_t offset = 0; offset < input.size();) {
+    std::size_t length = std::min(step, input.size() - offset);
+    std::size_t used = 0;
+    while (used < length && !connection.failed()) {
+      Http2Event event = Http2Event::NONE;
+      std::string_view payload;
+      used += connection.execute(input.data() + offset + used, length - used,
+                                 event, payload);
+      if (event == Http2Event::NONE) {
+        continue;
+      }
+      events.push_back(Event{event, connection.stream_id(),
+                             connection.end_stream(), std::string(payload)});
+      if (event == Http2Event::DATA && consume) {
+        connection.consume(connection.stream_id(), payload.size());
+      }
+    }
+    offset += length;
+  }
+  return events;
+}
+
+struct Sent {
+  Http2FrameType type;
+  std::uint8_t flags;
+  std::uint32_t stream;
+  std::string payload;
+};
+
+// takes the pending output apart into frames
+std::vector<Sent> sent(Http2Connection &connection) {
+  std::string_view output = connection.pending_output();
+  std::vector<Sent> frames;
+  const unsigned char *p =
+      reinterpret_cast<const unsigned char *>(output.data());
+  std::size_t pos = 0;
+  while (pos + HTTP2_FRAME_HEADER_SIZE <= output.size()) {
+    std::size_t length = p[pos] << 16 | p[pos + 1] << 8 | p[pos + 2];
+    std::uint32_t stream = static_cast<std::uint32_t>(p[pos + 5]) << 24 |
+                           p[pos + 6] << 16 | p[pos + 7] << 8 | p[pos + 8];
+    frames.push_back(Sent{static_cast<Http2FrameType>(p[pos + 3]), p[pos + 4],
+                          stream,
+                          std::string(output.substr(pos + 9, length))});
+    pos += HTTP2_FRAME_HEADER_SIZE + length;
+  }
+  connection.output_written(output.size());
+  return frames;
+}
+
+bool wasReset(const std::vector<Sent> &frames, std::uint32_t stream,
+              Http2ErrorCode code) {
+  for (const Sent &sentFrame : frames) {
+    if (sentFrame.type == Http2FrameType::RST_STREAM &&
+        sentFrame.stream == stream &&
+        sentFrame.payload == u32(static_cast<std::uint32_t>(code))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string postBlock(HpackEncoder &encoder,
+                      std::string_view contentLength = std::string_view()) {
+  std::string block;
+  encoder.encode(":method", "POST", block);
+  encoder.encode(":scheme", "http", block);
+  encoder.encode(":path", "/upload", block);
+  if (!contentLength.empty()) {
+    encoder.encode("content-length", contentLength, block);
+  }
+  return block;
+}
+
+void testSettings() {
+  Http2Settings settings;
+  Http2ErrorCode error = Http2ErrorCode::NONE;
+  std::string payload = std::string("\x00\x03", 2) + u32(10) +
+                        std::string("\x00\x04", 2) + u32(1 << 20) +
+                        std::string("\x00\xff", 2) + u32(7);
+  check(apply_http2_settings(payload.data(), payload.size(), settings,
+                             error) &&
+            settings.maxConcurrentStreams == 10 &&
+            settings.initialWindowSize == 1 << 20,
+        "settings applied, unknown ones ignored");
+  check(!apply_http2_settings(payload.data(), 5, settings, error) &&
+            error == Http2ErrorCode::FRAME_SIZE_ERROR,
+        "partial setting");
+  payload = std::string("\x00\x04", 2) + u32(0x80000000);
+  check(!apply_http2_settings(payload.data(), payload.size(), settings,
+                              error) &&
+            error == Http2ErrorCode::FLOW_CONTROL_ERROR,
+        "window above the maximum");
+  payload = std::string("\x00\x05", 2) + u32(100);
+  check(!apply_http2_settings(payload.data(), payload.size(), settings,
+                              error) &&
+            error == Http2ErrorCode::PROTOCOL_ERROR,
+        "frame size below the minimum");
+
+  check(is_http2_preface("PRI *", 5) &&
+            is_http2_preface(HTTP2_PREFACE.data(), HTTP2_PREFACE.size()) &&
+            !is_http2_preface("GET / HTTP/1.1", 14),
+        "preface sniffing");
+
+  Http2Connection connection;
+  std::vector<Sent> frames = sent(connection);
+  check(frames.size() == 1 && frames[0].type == Http2FrameType::SETTINGS,
+        "the server's SETTINGS comes first");
+  feed(connection, "GET / HTTP/1.1\r\n");
+  frames = sent(connection);
+  check(connection.failed() && !frames.empty() &&
+            frames.back().type == Http2FrameType::GOAWAY &&
+            frames.back().payload.substr(4) ==
+                u32(static_cast<std::uint32_t>(
+                    Http2ErrorCode::PROTOCOL_ERROR)),
+        "wrong preface");
+}
+
+void testRequest() {
+  for (std::size_t step : {std::size_t(1), std::size_t(3), std::size_t(1000)}) {
+    Http2Connection connection;
+    sent(connection);
+    HpackEncoder encoder;
+    std::string block = postBlock(encoder);
+    std::string padded = std::string(1, '\x04') + "world" + std::string(4, '\0');
+    std::string trailers;
+    encoder.encode("grpc-status", "0", trailers);
+    std::string input =
+        start + frame(Http2FrameType::SETTINGS, 0x1, 0, "") +
+        frame(Http2FrameType::HEADERS, 0, 1, block.substr(0, 3)) +
+        frame(Http2FrameType::CONTINUATION, 0x4, 1, block.substr(3)) +
+        frame(Http2FrameType::DATA, 0, 1, "hello ") +
+        frame(Http2FrameType::DATA, 0x8, 1, padded) +
+        frame(Http2FrameType::HEADERS, 0x5, 1, trailers) +
+        frame(Http2FrameType::PING, 0, 0, "12345678");
+    std::vector<Event> events = feed(connection, input, step);
+    std::string body;
+    int requests = 0;
+    bool ended = false;
+    for (const Event &event : events) {
+      requests += event.type == Http2Event::REQUEST;
+      if (event.type == Http2Event::DATA) {
+        body += event.payload;
+      }
+      ended = ended || (event.type == Http2Event::TRAILERS && event.endStream);
+    }
+    check(!connection.failed() && requests == 1 && body == "hello world" &&
+              ended && connection.trailers().value_of("grpc-status") == "0",
+          "request with continuation, padding and trailers");
+    check(connection.request().method == Method::METHOD_POST &&
+              connection.request().url == "/upload",
+          "request headers");
+
+    bool ack = false;
+    bool pong = false;
+    for (const Sent &sentFrame : sent(connection)) {
+      ack = ack || (sentFrame.type == Http2FrameType::SETTINGS &&
+                    sentFrame.flags == 0x1);
+      pong = pong || (sentFrame.type == Http2FrameType::PING &&
+                      sentFrame.flags == 0x1 &&
+                      sentFrame.payload == "12345678");
+    }
+    check(ack && pong, "SETTINGS and PING are acknowledged");
+  }
+}
+
+void testFlowControl() {
+  Http2Connection connection;
+  sent(connection);
+  HpackEncoder encoder;
+  feed(connection,
+       start + frame(Http2FrameType::HEADERS, 0x5, 1, postBlock(encoder)));
+  Response response;
+  response.status_code = StatusCode::OK;
+  check(connection.submit_response(1, response, false) &&
+            !connection.submit_response(1, response, false),
+        "one final response");
+  std::string body(100000, 'x');
+  std::size_t taken = connection.submit_data(1, body.data(), body.size(), true);
+  std::size_t dataBytes = 0;
+  bool framesFit = true;
+  for (const Sent &sentFrame : sent(connection)) {
+    if (sentFrame.type == Http2FrameType::DATA) {
+      dataBytes += sentFrame.payload.size();
+      framesFit = framesFit && sentFrame.payload.size() <= 16384 &&
+                  (sentFrame.flags & 0x1) == 0;
+    }
+  }
+  check(taken == 65535 && dataBytes == 65535 && framesFit &&
+            connection.send_window(1) == 0,
+        "data stops at the send window");
+
+  std::vector<Event> events =
+      feed(connection, frame(Http2FrameType::WINDOW_UPDATE, 0, 0, u32(50000)) +
+                           frame(Http2FrameType::WINDOW_UPDATE, 0, 1,
+                                 u32(50000)));
+  check(events.size() == 2 && events[0].type == Http2Event::WINDOW_UPDATE &&
+            events[1].stream == 1 && connection.send_window(1) == 50000,
+        "window updates");
+  taken = connection.submit_data(1, body.data() + taken, body.size() - taken,
+                                 true);
+  check(taken == body.size() - 65535 && !connection.has_stream(1) &&
+            sent(connection).back().flags == 0x1,
+        "the rest ends the stream");
+
+  Http2Settings settings = Http2Connection::default_settings();
+  settings.initialWindowSize = 20000;
+  Http2Connection small(settings);
+  sent(small);
+  HpackEncoder smallEncoder;
+  std::string input = start + frame(Http2FrameType::SETTINGS, 0x1, 0, "") +
+                      frame(Http2FrameType::HEADERS, 0x4, 1,
+                            postBlock(smallEncoder));
+  for (int i = 0; i < 2; i++) {
+    input += frame(Http2FrameType::DATA, 0, 1, std::string(16384, 'a'));
+  }
+  feed(small, input, 1 << 30, false);
+  check(!small.failed() &&
+            wasReset(sent(small), 1, Http2ErrorCode::FLOW_CONTROL_ERROR),
+        "stream window exceeded");
+
+  Http2Connection flooded;
+  sent(flooded);
+  HpackEncoder floodEncoder;
+  input = start +
+          frame(Http2FrameType::HEADERS, 0x4, 1, postBlock(floodEncoder));
+  for (int i = 0; i < 5; i++) {
+    input += frame(Http2FrameType::DATA, 0, 1, std::string(16384, 'a'));
+  }
+  feed(flooded, input, 1 << 30, false);
+  check(flooded.failed() &&
+            flooded.error_code() == Http2ErrorCode::FLOW_CONTROL_ERROR,
+        "connection window exceeded");
+}
+
+// Every received DATA byte, padding included, reopens the connection window
+// exactly once, also when the stream is reset in the middle of a frame.
+void testPaddingCredit() {
+  Http2Connection connection;
+  sent(connection);
+  HpackEncoder encoder;
+  feed(connection,
+       start + frame(Http2FrameType::HEADERS, 0x4, 1, postBlock(encoder)));
+  std::string padded = std::string(1, '\xff') + std::string(16128, 'd') +
+                       std::string(255, '\0');
+  std::string first = frame(Http2FrameType::DATA, 0x8, 1, padded);
+  std::vector<Event> events = feed(connection, first.substr(0, 110));
+  connection.reset_stream(1, Http2ErrorCode::CANCEL);
+  feed(connection, first.substr(110));
+  // dropped since the stream is closed, counting against the window
+  feed(connection, frame(Http2FrameType::DATA, 0, 1, std::string(16383, 'd')));
+
+  std::uint64_t credited = 0;
+  for (const Sent &sentFrame : sent(connection)) {
+    if (sentFrame.type == Http2FrameType::WINDOW_UPDATE &&
+        sentFrame.stream == 0) {
+      const unsigned char *p =
+          reinterpret_cast<const unsigned char *>(sentFrame.payload.data());
+      credited += static_cast<std::uint32_t>(p[0]) << 24 | p[1] << 16 |
+                  p[2] << 8 | p[3];
+    }
+  }
+  check(!connection.failed() && events.size() == 1 &&
+            events[0].payload.size() == 100 && credited == 16384 + 16383,
+        "padding is credited once");
+}
+
+void testContentLength() {
+  struct Case {
+    const char *length;
+    std::vector<std::string> data; // the last piece ends the stream
+    bool valid;
+    const char *what;
+  };
+  const Case cases[] = {
+      {"5", {"hello"}, true, "matching content-length"},
+      {"5", {"hel", "lo"}, true, "matching over two frames"},
+      {"5", {"hello world"}, false, "more data than announced"},
+      {"10", {"hello"}, false, "less data than announced"},
+      {"5", {"hello", ""}, true, "empty frame ending the body"},
+      {"6", {"hello", ""}, false, "empty frame ending a short body"},
+      {"0", {"x"}, false, "data with a zero length"},
+  };
+  for (const Case &test : cases) {
+    Http2Connection connection;
+    sent(connection);
+    HpackEncoder encoder;
+    std::string input = start + frame(Http2FrameType::HEADERS, 0x4, 1,
+                                      postBlock(encoder, test.length));
+    for (std::size_t i = 0; i < test.data.size(); i++) {
+      input += frame(Http2FrameType::DATA, i + 1 == test.data.size() ? 0x1 : 0,
+                     1, test.data[i]);
+    }
+    std::vector<Event> events = feed(connection, input);
+    bool ended = !events.empty() && events.back().type == Http2Event::DATA &&
+                 events.back().endStream;
+    bool reset = wasReset(sent(connection), 1, Http2ErrorCode::PROTOCOL_ERROR);
+    check(!connection.failed() && ended == test.valid && reset != test.valid,
+          test.what);
+  }
+
+  Http2Connection connection;
+  sent(connection);
+  HpackEncoder encoder;
+  // blocks are encoded in the order they are sent, the table depends on it
+  std::string first = postBlock(encoder, "4");
+  std::string second = postBlock(encoder, "0");
+  std::string input = start + frame(Http2FrameType::HEADERS, 0x5, 1, first) +
+                      frame(Http2FrameType::HEADERS, 0x5, 3, second);
+  std::vector<Event> events = feed(connection, input);
+  check(events.size() == 2 && events[1].type == Http2Event::REQUEST &&
+            events[1].stream == 3 &&
+            wasReset(sent(connection), 1, Http2ErrorCode::PROTOCOL_ERROR),
+        "content-length without data");
+
+  Http2Connection trailed;
+  sent(trailed);
+  HpackEncoder trailerEncoder;
+  std::string block = postBlock(trailerEncoder, "5");
+  std::string trailers;
+  trailerEncoder.encode("x-checksum", "1", trailers);
+  input = start + frame(Http2FrameType::HEADERS, 0x4, 1, block) +
+          frame(Http2FrameType::DATA, 0, 1, "hel") +
+          frame(Http2FrameType::HEADERS, 0x5, 1, trailers);
+  events = feed(trailed, input);
+  check(events.back().type == Http2Event::DATA &&
+            wasReset(sent(trailed), 1, Http2ErrorCode::PROTOCOL_ERROR),
+        "trailers ending a short body");
+}
+
+void testTrailers() {
+  const std::pair<const char *, const char *> invalid[] = {
+      {":path", "/other"},
+      {"Grpc-Status", "0"},
+      {"connection", "close"},
+      {"transfer-encoding", "chunked"},
+  };
+  for (const auto &field : invalid) {
+    Http2Connection connection;
+    sent(connection);
+    HpackEncoder encoder;
+    std::string block = postBlock(encoder);
+    std::string trailers;
+    encoder.encode(field.first, field.second, trailers);
+    std::string input =
+        start + frame(Http2FrameType::HEADERS, 0x4, 1, block) +
+        frame(Http2FrameType::DATA, 0, 1, "body") +
+        frame(Http2FrameType::HEADERS, 0x5, 1, trailers);
+    std::vector<Event> events = feed(connection, input);
+    check(!connection.failed() &&
+              events.back().type != Http2Event::TRAILERS &&
+              wasReset(sent(connection), 1, Http2ErrorCode::PROTOCOL_ERROR),
+          field.first);
+  }
+}
+
+void testMalformed() {
+  Http2Connection connection;
+  sent(connection);
+  HpackEncoder encoder;
+  std::string incomplete;
+  encoder.encode(":method", "GET", incomplete);
+  encoder.encode(":path", "/", incomplete);
+  std::string block = postBlock(encoder);
+  std::string input =
+      start + frame(Http2FrameType::HEADERS, 0x5, 1, incomplete) +
+      frame(Http2FrameType::HEADERS, 0x4, 3, block) +
+      frame(Http2FrameType::RST_STREAM, 0, 3, u32(8)) +
+      frame(Http2FrameType::GOAWAY, 0, 0, u32(0) + u32(0) + "bye");
+  std::vector<Event> events = feed(connection, input);
+  check(!connection.failed() && events.size() == 4 &&
+            events[1].type == Http2Event::REQUEST && events[1].stream == 3 &&
+            events[2].type == Http2Event::STREAM_RESET &&
+            connection.peer_error_code() == Http2ErrorCode::NONE &&
+            events[3].type == Http2Event::GOAWAY &&
+            events[3].payload == "bye" && connection.stream_count() == 0,
+        "malformed request, reset and goaway");
+  check(wasReset(sent(connection), 1, Http2ErrorCode::PROTOCOL_ERROR),
+        "malformed request is reset");
+
+  Http2Connection broken;
+  sent(broken);
+  feed(broken, start + frame(Http2FrameType::HEADERS, 0x5, 1,
+                             std::string(6, '\xff')));
+  check(broken.failed() &&
+            broken.error_code() == Http2ErrorCode::COMPRESSION_ERROR,
+        "undecodable header block");
+}
+
+void testUpgrade() {
+  Request request;
+  request.method = Method::METHOD_GET;
+  request.url = "/";
+  request.version = Version::HTTP_1_1;
+  request.headers.add("Host", "example.com");
+  request.headers.add("Connection", "Upgrade, HTTP2-Settings");
+  request.headers.add("Upgrade", "h2c");
+  request.headers.add("HTTP2-Settings", "AAMAAABkAARAAAAAAAIAAAAA");
+  check(is_h2c_upgrade(request), "h2c upgrade request");
+
+  Response switching;
+  h2c_upgrade_response(switching);
+  check(switching.status_code == StatusCode::SWITCHING_PROTOCOLS &&
+            switching.headers.value_of(HeaderId::UPGRADE) == "h2c",
+        "101 response");
+
+  Http2Connection connection;
+  check(connection.upgrade(request) && !connection.upgrade(request),
+        "upgrade once");
+  check(connection.peer_settings().maxConcurrentStreams == 100 &&
+            connection.peer_settings().initialWindowSize == 0x40000000 &&
+            connection.peer_settings().enablePush == 0,
+        "HTTP2-Settings applied");
+  sent(connection);
+  Response response;
+  response.status_code = StatusCode::OK;
+  check(connection.has_stream(1) &&
+            connection.submit_response(1, response, true) &&
+            !connection.has_stream(1),
+        "stream 1 answers the upgraded request");
+  feed(connection, start);
+  check(!connection.failed(), "preface after the upgrade");
+}
+
+} // namespace
+
+int main() {
+  testSettings();
+  testRequest();
+  testFlowControl();
+  testPaddingCredit();
+  testContentLength();
+  testTrailers();
+  testMalformed();
+  testUpgrade();
+  return test::test_result("http2_test");
+}
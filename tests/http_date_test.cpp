@@ -0,0 +1,86 @@
+/**
+ * @file http_date_test.cpp
+ * @brief HTTP-date formatting, parsing and the per-thread cache
+ */
+
+#include "Check.h"
+#include "HttpDate.hpp"
+#include <ctime>
+#include <string>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+// Sun, 06 Nov 1994 08:49:37 GMT, the example of RFC 9110
+constexpr std::int64_t rfcExample = 784111777;
+
+void testFormat() {
+  char buffer[HTTP_DATE_LENGTH];
+  check(format_http_date(rfcExample, buffer) ==
+            "Sun, 06 Nov 1994 08:49:37 GMT",
+        "IMF-fixdate");
+  check(format_http_date(0, buffer) == "Thu, 01 Jan 1970 00:00:00 GMT",
+        "the epoch");
+  check(format_http_date(951782400, buffer) == "Tue, 29 Feb 2000 00:00:00 GMT",
+        "leap day of a century leap year");
+  check(format_http_date(4102444799, buffer) ==
+            "Thu, 31 Dec 2099 23:59:59 GMT",
+        "end of the century");
+}
+
+void testParse() {
+  std::int64_t seconds = 0;
+  check(parse_http_date("Sun, 06 Nov 1994 08:49:37 GMT", seconds) &&
+            seconds == rfcExample,
+        "IMF-fixdate");
+  check(parse_http_date("Sunday, 06-Nov-94 08:49:37 GMT", seconds) &&
+            seconds == rfcExample,
+        "RFC 850");
+  check(parse_http_date("Sun Nov  6 08:49:37 1994", seconds) &&
+            seconds == rfcExample,
+        "asctime");
+
+  check(!parse_http_date("Sun, 06 Nov 1994 08:49:37 UTC", seconds),
+        "only GMT");
+  check(!parse_http_date("Sun, 31 Feb 1994 08:49:37 GMT", seconds),
+        "day out of range for the month");
+  check(!parse_http_date("Sun, 06 Nov 1994 24:00:00 GMT", seconds),
+        "hour out of range");
+  check(!parse_http_date("Sun, 06 Foo 1994 08:49:37 GMT", seconds),
+        "unknown month");
+  check(!parse_http_date("", seconds) &&
+            !parse_http_date("Sun, 06 Nov 1994", seconds),
+        "empty and truncated dates");
+
+  char buffer[HTTP_DATE_LENGTH];
+  bool roundTrip = true;
+  for (std::int64_t t = 0; t < 4102444800; t += 86400 * 37 + 3671) {
+    std::int64_t back = -1;
+    roundTrip = roundTrip &&
+                parse_http_date(format_http_date(t, buffer), back) && back == t;
+  }
+  check(roundTrip, "formatted dates parse back");
+}
+
+void testNow() {
+  std::string_view now = http_date_now();
+  std::int64_t seconds = 0;
+  std::int64_t clock = static_cast<std::int64_t>(std::time(nullptr));
+  check(now.size() == HTTP_DATE_LENGTH && parse_http_date(now, seconds),
+        "current date is an IMF-fixdate");
+  check(seconds >= clock - 2 && seconds <= clock + 2,
+        "current date matches the clock");
+  check(http_date_now().data() == now.data(),
+        "the cached string is reused on the thread");
+}
+
+} // namespace
+
+int main() {
+  testFormat();
+  testParse();
+  testNow();
+  return test::test_result("http_date_test");
+}
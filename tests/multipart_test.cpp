@@ -0,0 +1,142 @@
+/**
+ * @file multipart_test.cpp
+ * @brief boundary parameters and the streaming multipart parser
+ */
+
+#include "Check.h"
+#include "Multipart.hpp"
+#include <string>
+#include <vector>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+struct Part {
+  std::string disposition;
+  std::string data;
+};
+
+// feeds `body` in pieces of `step` bytes and collects the parts
+bool collect(const std::string &body, std::string_view boundary,
+             std::size_t step, std::vector<Part> &parts) {
+  MultipartParser parser;
+  parts.clear();
+  if (!parser.reset(boundary)) {
+    return false;
+  }
+  bool open = false;
+  for (std::size_t offset = 0; offset < body.size() && !parser.failed();) {
+    std::size_t length = std::min(step, body.size() - offset);
+    std::size_t used = 0;
+    while (used < length && !parser.failed() && !parser.done()) {
+      MultipartEvent event = MultipartEvent::NONE;
+      std::string_view data;
+      used += parser.execute(body.data() + offset + used, length - used, event,
+                             data);
+      if (event == MultipartEvent::PART_BEGIN) {
+        parts.push_back(Part{std::string(parser.part_headers().value_of(
+                                 "content-disposition")),
+                             std::string()});
+        open = true;
+      } else if (event == MultipartEvent::PART_DATA && open) {
+        parts.back().data.append(data.data(), data.size());
+      } else if (event == MultipartEvent::PART_END) {
+        open = false;
+      }
+    }
+    if (parser.done()) {
+      break;
+    }
+    offset += length;
+  }
+  parser.finish();
+  return parser.done();
+}
+
+void testBoundaryParameter() {
+  std::string_view boundary;
+  check(parse_multipart_boundary("multipart/form-data; boundary=abc123",
+                                 boundary) &&
+            boundary == "abc123",
+        "token boundary");
+  check(parse_multipart_boundary(
+            "Multipart/Mixed; charset=utf-8; boundary=\"a b:c\"", boundary) &&
+            boundary == "a b:c",
+        "quoted boundary after another parameter");
+  check(!parse_multipart_boundary("text/plain; boundary=abc", boundary),
+        "not a multipart type");
+  check(!parse_multipart_boundary("multipart/form-data", boundary) &&
+            !parse_multipart_boundary("multipart/form-data; charset=x",
+                                      boundary),
+        "missing boundary");
+  check(!parse_multipart_boundary("multipart/form-data; boundary=\"a b \"",
+                                  boundary) &&
+            !parse_multipart_boundary("multipart/form-data; boundary=a{b}",
+                                      boundary) &&
+            !parse_multipart_boundary(
+                "multipart/form-data; boundary=" + std::string(71, 'x'),
+                boundary),
+        "invalid boundaries");
+  check(!parse_multipart_boundary("multipart/form-data; boundary=\"abc",
+                                  boundary),
+        "unterminated quoted string");
+}
+
+void testParts() {
+  std::string body = "preamble\r\n"
+                     "--XyZ\r\n"
+                     "Content-Disposition: form-data; name=\"field\"\r\n"
+                     "\r\n"
+                     "value\r\n"
+                     "--XyZ\r\n"
+                     "Content-Disposition: form-data; name=\"file\"\r\n"
+                     "Content-Type: application/octet-stream\r\n"
+                     "\r\n"
+                     "line\r\n--Xy not a delimiter\r\n-XyZ almost\r\n"
+                     "--XyZ--\r\n"
+                     "epilogue";
+  for (std::size_t step : {std::size_t(1), std::size_t(2), std::size_t(7),
+                           body.size()}) {
+    std::vector<Part> parts;
+    bool done = collect(body, "XyZ", step, parts);
+    check(done && parts.size() == 2, "two parts");
+    if (parts.size() != 2) {
+      continue;
+    }
+    check(parts[0].disposition == "form-data; name=\"field\"" &&
+              parts[0].data == "value",
+          "first part");
+    check(parts[1].data == "line\r\n--Xy not a delimiter\r\n-XyZ almost",
+          "delimiter prefixes stay in the data, even across buffers");
+  }
+
+  std::vector<Part> parts;
+  check(collect("--b\r\n\r\n\r\n--b--", "b", 3, parts) && parts.size() == 1 &&
+            parts[0].data.empty(),
+        "empty part without headers");
+}
+
+void testErrors() {
+  std::vector<Part> parts;
+  check(!collect("--b\r\n\r\ndata without end", "b", 4, parts),
+        "missing close delimiter");
+  check(!collect("--b\r\nbroken header\r\n\r\nx\r\n--b--", "b", 64, parts),
+        "malformed part header");
+  std::string big = "--b\r\nX-Big: " + std::string(9000, 'x') +
+                    "\r\n\r\nx\r\n--b--";
+  check(!collect(big, "b", 512, parts), "part headers too large");
+  MultipartParser parser;
+  check(!parser.reset("") && !parser.reset(std::string(71, 'a')),
+        "invalid boundary for reset");
+}
+
+} // namespace
+
+int main() {
+  testBoundaryParameter();
+  testParts();
+  testErrors();
+  return test::test_result("multipart_test");
+}
@@ -0,0 +1,80 @@
+/**
+ * @file negotiation_test.cpp
+ * @brief proactive negotiation of media types, codings and languages
+ */
+
+#include "Check.h"
+#include "Negotiation.hpp"
+#include <string>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+void testMediaTypes() {
+  Negotiator negotiator(NegotiationKind::MEDIA_TYPE,
+                        {"application/json", "text/html;charset=utf-8",
+                         "text/plain"});
+  check(negotiator.select("text/html") == 1, "exact match");
+  check(negotiator.select("text/*;q=0.5, text/plain") == 2,
+        "higher weight wins");
+  check(negotiator.select("*/*") == 0, "ties go to the server's order");
+  check(negotiator.select("text/*, text/html;q=0") == 2,
+        "the most specific range decides, q=0 excludes");
+  check(negotiator.select("image/png") == -1, "nothing acceptable");
+  check(negotiator.select("") == 0, "no header accepts anything");
+  check(negotiator.select("TEXT/PLAIN") == 2, "types ignore case");
+}
+
+void testEncodings() {
+  Negotiator negotiator(NegotiationKind::ENCODING, {"br", "gzip", "identity"});
+  check(negotiator.select("gzip, br") == 0, "server preference among equals");
+  check(negotiator.select("gzip;q=1.0, br;q=0.5") == 1, "weights");
+  check(negotiator.select("x-gzip") == 1, "x-gzip is gzip");
+  check(negotiator.select("compress") == 2, "identity is acceptable");
+  check(negotiator.select("") == 2, "an empty header only allows identity");
+  check(negotiator.select("*;q=0") == -1 &&
+            negotiator.select("identity;q=0, compress") == -1,
+        "identity can be excluded");
+
+  Negotiator compressedOnly(NegotiationKind::ENCODING, {"gzip"});
+  check(compressedOnly.select("") == -1, "no coding without the header");
+}
+
+void testLanguages() {
+  Negotiator negotiator(NegotiationKind::LANGUAGE,
+                        {"en-US", "de-CH", "fr"});
+  check(negotiator.select("de") == 1, "prefix match");
+  check(negotiator.select("en-us;q=0.2, de;q=0.9") == 1, "weighted");
+  check(negotiator.select("de-CH-1996") == -1,
+        "longer ranges don't match shorter tags");
+  check(negotiator.select("d") == -1, "prefixes end at a subtag");
+  check(negotiator.select("*, en;q=0") == 1, "wildcard with exclusion");
+  check(negotiator.select("fr-CA, *;q=0.1") == 0,
+        "wildcard weight for the remaining values");
+}
+
+void testCache() {
+  Negotiator negotiator(NegotiationKind::ENCODING, {"gzip", "identity"});
+  Negotiator other(NegotiationKind::ENCODING, {"identity", "gzip"});
+  check(negotiator.select("gzip, identity") == 0 &&
+            other.select("gzip, identity") == 0 &&
+            negotiator.select("gzip, identity") == 0,
+        "cached results are per negotiator");
+  std::string longValue(Negotiator::MAX_CACHED_VALUE + 10, ' ');
+  longValue += "gzip;q=0.5, identity";
+  check(negotiator.select(longValue) == 1 &&
+            negotiator.select(longValue) == negotiator.evaluate(longValue),
+        "long values are evaluated without the cache");
+}
+
+} // namespace
+
+int main() {
+  testMediaTypes();
+  testEncodings();
+  testLanguages();
+  testCache();
+  return test::test_result("negotiation_test");
+}
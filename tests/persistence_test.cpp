@@ -0,0 +1,129 @@
+/**
+ * @file persistence_test.cpp
+ * @brief HTTP/1.0 support and keep-alive decisions made while parsing
+ */
+
+#include "Check.h"
+#include "RequestParser.hpp"
+#include "ResponseParser.hpp"
+#include <cstring>
+#include <string>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+template <typename Parser> bool parses(Parser &parser, const char *message) {
+  parser.reset();
+  parser.execute(message, std::strlen(message));
+  return parser.get_state() == ParseState::DONE;
+}
+
+template <typename Parser> bool keepsAlive(const char *message) {
+  Parser parser;
+  return parses(parser, message) && parser.get_request().should_keep_alive();
+}
+
+void testVersions() {
+  check(string_to_version("HTTP/1.1") == Version::HTTP_1_1 &&
+            string_to_version("HTTP/1.0") == Version::HTTP_1_0,
+        "HTTP/1.0 and HTTP/1.1");
+  check(string_to_version("HTTP/1.7") == Version::HTTP_1_1,
+        "later minor versions get HTTP/1.1 semantics");
+  check(string_to_version("HTTP/3.0") == Version::VERSION_UNKOWN &&
+            string_to_version("http/1.1") == Version::VERSION_UNKOWN,
+        "other versions are unknown");
+  check(version_to_string(Version::HTTP_1_0) == "HTTP/1.0",
+        "HTTP/1.0 is written back");
+}
+
+void testConnectionOptions() {
+  ConnectionOptions options;
+  add_connection_options("Keep-Alive, X-Other", options);
+  check(options.keepAlive && !options.close, "keep-alive option");
+  add_connection_options(" close ", options);
+  check(options.close, "close option");
+  check(!is_persistent(Version::HTTP_1_1, options),
+        "close wins over keep-alive");
+
+  check(is_persistent(Version::HTTP_1_1, ConnectionOptions{}) &&
+            !is_persistent(Version::HTTP_1_0, ConnectionOptions{}),
+        "defaults of HTTP/1.1 and HTTP/1.0");
+  ConnectionOptions keepAlive;
+  keepAlive.keepAlive = true;
+  check(is_persistent(Version::HTTP_1_0, keepAlive),
+        "HTTP/1.0 persists with keep-alive");
+  check(is_persistent(Version::HTTP_2, ConnectionOptions{}),
+        "HTTP/2 always persists");
+}
+
+void testRequests() {
+  RequestParser parser;
+  check(parses(parser, "GET / HTTP/1.0\r\n\r\n") &&
+            parser.get_request().version == Version::HTTP_1_0,
+        "HTTP/1.0 needs no Host");
+  check(!parses(parser, "GET / HTTP/1.1\r\n\r\n"), "HTTP/1.1 needs Host");
+
+  check(keepsAlive<RequestParser>("GET / HTTP/1.1\r\nHost: a\r\n\r\n"),
+        "HTTP/1.1 persists by default");
+  check(!keepsAlive<RequestParser>(
+            "GET / HTTP/1.1\r\nHost: a\r\nConnection: Close\r\n\r\n"),
+        "HTTP/1.1 with close");
+  check(!keepsAlive<RequestParser>("GET / HTTP/1.0\r\n\r\n"),
+        "HTTP/1.0 closes by default");
+  check(keepsAlive<RequestParser>(
+            "GET / HTTP/1.0\r\nConnection: keep-alive\r\n\r\n"),
+        "HTTP/1.0 with keep-alive");
+  check(!keepsAlive<RequestParser>("GET / HTTP/1.1\r\nHost: a\r\n"
+                                   "Connection: upgrade\r\n"
+                                   "Connection: close\r\n\r\n"),
+        "options of every Connection header count");
+
+  // the previous request's decision must not leak into the next one
+  check(parses(parser, "GET / HTTP/1.0\r\n\r\n") &&
+            !parser.get_request().should_keep_alive() &&
+            parses(parser, "GET / HTTP/1.1\r\nHost: a\r\n\r\n") &&
+            parser.get_request().should_keep_alive(),
+        "decisions are per request");
+}
+
+void testHealthChecks() {
+  // headers are not stored, Connection is still honoured
+  check(!keepsAlive<HealthCheckRequestParser>(
+            "GET /health HTTP/1.1\r\nConnection: close\r\n\r\n"),
+        "health check with close");
+  check(keepsAlive<HealthCheckRequestParser>(
+            "GET /health HTTP/1.0\r\nconnection: Keep-Alive\r\n\r\n"),
+        "HTTP/1.0 health check with keep-alive");
+  check(!keepsAlive<HealthCheckRequestParser>("GET /health HTTP/1.0\r\n\r\n"),
+        "HTTP/1.0 health check closes");
+}
+
+void testResponses() {
+  const char response[] = "HTTP/1.0 200 OK\r\nContent-Length: 0\r\n\r\n";
+  ResponseParser parser;
+  parser.execute(response, std::strlen(response));
+  check(parser.get_state() == ResponseParseState::DONE &&
+            parser.get_response().version == Version::HTTP_1_0 &&
+            !parser.get_response().should_keep_alive(),
+        "HTTP/1.0 response closes");
+
+  const char persistent[] =
+      "HTTP/1.0 200 OK\r\nConnection: keep-alive\r\nContent-Length: 0\r\n\r\n";
+  ResponseParser keepAlive;
+  keepAlive.execute(persistent, std::strlen(persistent));
+  check(keepAlive.get_response().should_keep_alive(),
+        "HTTP/1.0 response with keep-alive");
+}
+
+} // namespace
+
+int main() {
+  testVersions();
+  testConnectionOptions();
+  testRequests();
+  testHealthChecks();
+  testResponses();
+  return test::test_result("persistence_test");
+}
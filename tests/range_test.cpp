@@ -0,0 +1,168 @@
+/**
+ * @file range_test.cpp
+ * @brief Range parsing, If-Range and 206 / multipart/byteranges bodies
+ */
+
+#include "Check.h"
+#include "Range.hpp"
+#include <string>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+std::string body(const RangeBody &range) {
+  std::string out;
+  for (std::size_t i = 0; i < range.part_count(); i++) {
+    out.append(range.parts()[i].data(), range.parts()[i].size());
+  }
+  return out;
+}
+
+void testParse() {
+  ByteRanges ranges;
+  check(parse_range("bytes=0-499", 10000, ranges) == RangeResult::SATISFIABLE &&
+            ranges.size() == 1 && ranges[0].first == 0 &&
+            ranges[0].last == 499,
+        "first 500 bytes");
+  check(parse_range("bytes=9500-", 10000, ranges) == RangeResult::SATISFIABLE &&
+            ranges[0].first == 9500 && ranges[0].last == 9999,
+        "open ended range");
+  check(parse_range("bytes=-500", 10000, ranges) == RangeResult::SATISFIABLE &&
+            ranges[0].first == 9500 && ranges[0].length() == 500,
+        "suffix range");
+  check(parse_range("bytes=-20000", 100, ranges) == RangeResult::SATISFIABLE &&
+            ranges[0].first == 0 && ranges[0].last == 99,
+        "suffix longer than the content");
+  check(parse_range("bytes=90-200", 100, ranges) == RangeResult::SATISFIABLE &&
+            ranges[0].last == 99,
+        "last position is clamped");
+  check(parse_range("bytes=0-9, 5-14 ,20-29,15-19", 100, ranges) ==
+                RangeResult::SATISFIABLE &&
+            ranges.size() == 1 && ranges[0].last == 29 && ranges.bytes() == 30,
+        "overlapping and adjacent ranges are coalesced");
+  check(parse_range("bytes=0-0,50-59", 100, ranges) ==
+                RangeResult::SATISFIABLE &&
+            ranges.size() == 2,
+        "disjoint ranges");
+
+  check(parse_range("bytes=200-300", 100, ranges) ==
+            RangeResult::UNSATISFIABLE,
+        "range past the end");
+  check(parse_range("bytes=-0", 100, ranges) == RangeResult::UNSATISFIABLE,
+        "empty suffix");
+  check(parse_range("items=0-1", 100, ranges) == RangeResult::NONE,
+        "unknown unit is ignored");
+  check(parse_range("bytes=5-1", 100, ranges) == RangeResult::NONE &&
+            parse_range("bytes=a-b", 100, ranges) == RangeResult::NONE &&
+            parse_range("bytes=", 100, ranges) == RangeResult::NONE,
+        "syntax errors are ignored");
+  check(parse_range("bytes=99999999999999999999-", 100, ranges) ==
+            RangeResult::NONE,
+        "overflowing positions are ignored");
+
+  std::string many = "bytes=";
+  for (int i = 0; i < 40; i++) {
+    many += std::to_string(i * 10) + "-" + std::to_string(i * 10 + 1) + ",";
+  }
+  many.pop_back();
+  check(parse_range(many, 1000, ranges) == RangeResult::NONE,
+        "too many ranges are ignored");
+}
+
+void testIfRange() {
+  ResourceValidators validators;
+  validators.etag = "\"v1\"";
+  validators.lastModified = 784111777; // Sun, 06 Nov 1994 08:49:37 GMT
+  Request request;
+  request.method = Method::METHOD_GET;
+  request.url = "/file";
+  request.headers.add("Range", "bytes=0-9");
+  ByteRanges ranges;
+  check(evaluate_range(request, 100, validators, ranges) ==
+            RangeResult::SATISFIABLE,
+        "Range without If-Range");
+
+  Request matching = request;
+  matching.headers.add("If-Range", "\"v1\"");
+  check(evaluate_range(matching, 100, validators, ranges) ==
+            RangeResult::SATISFIABLE,
+        "If-Range with the current tag");
+  Request weak = request;
+  weak.headers.add("If-Range", "W/\"v1\"");
+  check(evaluate_range(weak, 100, validators, ranges) == RangeResult::NONE,
+        "weak tags never match If-Range");
+  Request dated = request;
+  dated.headers.add("If-Range", "Sun, 06 Nov 1994 08:49:37 GMT");
+  check(evaluate_range(dated, 100, validators, ranges) ==
+            RangeResult::SATISFIABLE,
+        "If-Range with the modification date");
+  Request old = request;
+  old.headers.add("If-Range", "Sat, 05 Nov 1994 08:49:37 GMT");
+  check(evaluate_range(old, 100, validators, ranges) == RangeResult::NONE,
+        "outdated If-Range sends the full content");
+
+  Request post = request;
+  post.method = Method::METHOD_POST;
+  check(evaluate_range(post, 100, validators, ranges) == RangeResult::NONE,
+        "only GET is ranged");
+}
+
+void testBodies() {
+  std::string content = "0123456789abcdefghij";
+  ByteRanges ranges;
+  parse_range("bytes=2-5", content.size(), ranges);
+  RangeBody single;
+  Response response;
+  check(single.prepare(response, ranges, content, "text/plain"),
+        "single range");
+  check(response.status_code == StatusCode::PARTIAL_CONTENT &&
+            response.headers.value_of(HeaderId::CONTENT_RANGE) ==
+                "bytes 2-5/20" &&
+            response.headers.value_of(HeaderId::CONTENT_TYPE) == "text/plain",
+        "206 with content-range");
+  check(body(single) == "2345", "single range body");
+
+  parse_range("bytes=0-1,18-", content.size(), ranges);
+  RangeBody multi;
+  Response multipart;
+  check(multi.prepare(multipart, ranges, content, "text/plain"),
+        "multiple ranges");
+  std::string expectedType =
+      "multipart/byteranges; boundary=" + std::string(multi.boundary());
+  check(multipart.headers.value_of(HeaderId::CONTENT_TYPE) == expectedType &&
+            !multipart.headers.contains(HeaderId::CONTENT_RANGE),
+        "multipart content type");
+  std::string delimiter = "--" + std::string(multi.boundary());
+  std::string expected =
+      delimiter + "\r\ncontent-type: text/plain\r\n"
+      "content-range: bytes 0-1/20\r\n\r\n01\r\n" + delimiter +
+      "\r\ncontent-type: text/plain\r\ncontent-range: bytes 18-19/20\r\n\r\n"
+      "ij\r\n" + delimiter + "--\r\n";
+  check(body(multi) == expected, "multipart/byteranges body");
+  check(body(multi).find(delimiter, 0) != std::string::npos &&
+            content.find(multi.boundary()) == std::string::npos,
+        "the boundary is not part of the content");
+
+  Response unsatisfiable;
+  single.prepare_unsatisfiable(unsatisfiable, 20);
+  check(unsatisfiable.status_code == StatusCode::RANGE_NOT_SATISFIABLE &&
+            unsatisfiable.headers.value_of(HeaderId::CONTENT_RANGE) ==
+                "bytes */20",
+        "416 with content-range");
+
+  ByteRanges empty;
+  Response unused;
+  check(!single.prepare(unused, empty, content, "text/plain"),
+        "no ranges to prepare");
+}
+
+} // namespace
+
+int main() {
+  testParse();
+  testIfRange();
+  testBodies();
+  return test::test_result("range_test");
+}
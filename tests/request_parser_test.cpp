@@ -0,0 +1,108 @@
+/**
+ * @file request_parser_test.cpp
+ * @brief the request parser specializations of the shipped parser policies
+ */
+
+#include "Check.h"
+#include "RequestParser.hpp"
+#include <cstring>
+#include <string>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+template <typename Parser> bool parses(Parser &parser, const char *message) {
+  parser.reset();
+  parser.execute(message, std::strlen(message));
+  return parser.get_state() == ParseState::DONE;
+}
+
+void testDefaultPolicy() {
+  RequestParser parser;
+  check(parses(parser, "GET /index.html HTTP/1.1\r\nHost: a\r\n"
+                       "X-Mixed-Case:  value \r\n\r\n"),
+        "plain request");
+  Request request = parser.get_request();
+  check(request.method == Method::METHOD_GET && request.url == "/index.html" &&
+            request.version == Version::HTTP_1_1,
+        "request line");
+  check(request.headers.size() == 2 && request.headers[1].key == "x-mixed-case" &&
+            request.headers.value_of("X-Mixed-Case") == "value",
+        "keys lower-cased, value trimmed");
+
+  check(parses(parser, "GET / HTTP/1.1\nHost: a\n\n"),
+        "bare LF line endings are tolerated");
+  check(parses(parser, "\r\nGET  /  HTTP/1.1\r\nHost: a\r\n\r\n"),
+        "extra whitespace is tolerated");
+  check(!parses(parser, "GET / HTTP/1.1\r\nUser-Agent: x\r\n\r\n"),
+        "HTTP/1.1 without Host is rejected");
+  check(!parser.getErrorMessage().empty(), "the error is described");
+  check(!parses(parser, "G@T / HTTP/1.1\r\nHost: a\r\n\r\n"),
+        "invalid method");
+  check(!parses(parser, "GET / HTTQ/1.1\r\nHost: a\r\n\r\n"),
+        "invalid version");
+}
+
+void testIncrementalInput() {
+  const char message[] = "POST /upload HTTP/1.1\r\nHost: a\r\n"
+                         "Content-Length: 4\r\n\r\nbody";
+  std::size_t headerLength = std::strlen(message) - 4;
+
+  RequestParser parser;
+  std::size_t consumed = parser.execute(message, std::strlen(message));
+  check(parser.get_state() == ParseState::DONE && consumed == headerLength,
+        "the body is left to the caller");
+
+  parser.reset();
+  consumed = 0;
+  for (std::size_t i = 0; i < std::strlen(message); i++) {
+    consumed += parser.execute(message + i, 1);
+  }
+  check(parser.get_state() == ParseState::DONE && consumed == headerLength &&
+            parser.get_request().headers.value_of(HeaderId::CONTENT_LENGTH) ==
+                "4",
+        "byte by byte input gives the same result");
+}
+
+void testStrictPolicy() {
+  StrictRequestParser parser;
+  check(parses(parser, "GET / HTTP/1.1\r\nHost: a\r\n\r\n"), "strict request");
+  check(!parses(parser, "GET / HTTP/1.1\nHost: a\n\n"),
+        "bare LF is rejected");
+  check(!parses(parser, "GET  / HTTP/1.1\r\nHost: a\r\n\r\n"),
+        "double space is rejected");
+  check(!parses(parser, "\r\nGET / HTTP/1.1\r\nHost: a\r\n\r\n"),
+        "leading empty line is rejected");
+}
+
+void testLenientPolicy() {
+  LenientRequestParser parser;
+  check(parses(parser, "GET / HTTP/1.1\r\nX-Internal: 1\r\n\r\n"),
+        "Host is not required");
+  check(parser.get_request().headers.value_of("x-internal") == "1",
+        "headers are stored");
+}
+
+void testHealthCheckPolicy() {
+  HealthCheckRequestParser parser;
+  check(parses(parser, "GET /health HTTP/1.1\r\nUser-Agent: lb\r\n\r\n"),
+        "health check without Host");
+  Request request = parser.get_request();
+  check(request.url == "/health" && request.headers.empty(),
+        "headers are validated, not stored");
+  check(!parses(parser, "GET /health HTTP/1.1\r\nBad Key: x\r\n\r\n"),
+        "invalid headers are still rejected");
+}
+
+} // namespace
+
+int main() {
+  testDefaultPolicy();
+  testIncrementalInput();
+  testStrictPolicy();
+  testLenientPolicy();
+  testHealthCheckPolicy();
+  return test::test_result("request_parser_test");
+}
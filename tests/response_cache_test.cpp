@@ -0,0 +1,199 @@
+/**
+ * @file response_cache_test.cpp
+ * @brief ResponseCache keys, storability, freshness and eviction
+ */
+
+#include "Check.h"
+#include "HttpDate.hpp"
+#include "ResponseCache.hpp"
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <thread>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+Request makeRequest(const char *host, const char *url = "/page") {
+  Request request;
+  request.method = Method::METHOD_GET;
+  request.url = url;
+  request.version = Version::HTTP_1_1;
+  request.headers.add("Host", host);
+  return request;
+}
+
+Response makeResponse(const char *cacheControl = "max-age=60") {
+  Response response;
+  response.status_code = StatusCode::OK;
+  if (cacheControl != nullptr) {
+    response.headers.add("Cache-Control", cacheControl);
+  }
+  return response;
+}
+
+std::string dateIn(std::int64_t seconds) {
+  char buffer[HTTP_DATE_LENGTH];
+  return std::string(format_http_date(
+      static_cast<std::int64_t>(std::time(nullptr)) + seconds, buffer));
+}
+
+void testHitsAndKeys() {
+  ResponseCache cache(1 << 20, 4);
+  Request request = makeRequest("a.example");
+  check(cache.lookup(request) == nullptr, "empty cache misses");
+  check(cache.insert(request, makeResponse(), "A"), "store");
+  ResponseCache::Entry entry = cache.lookup(request);
+  check(entry != nullptr && *entry == "A", "hit");
+  check(cache.lookup(makeRequest("A.EXAMPLE", "/%70age")) != nullptr,
+        "host and target are normalized");
+  check(cache.lookup(makeRequest("b.example")) == nullptr,
+        "virtual hosts don't share entries");
+  check(cache.lookup(makeRequest("a.example", "/other")) == nullptr,
+        "other targets miss");
+
+  Request refresh = request;
+  refresh.headers.add("Cache-Control", "no-cache");
+  check(cache.lookup(refresh) == nullptr, "no-cache requests go to the origin");
+  Request head = request;
+  head.method = Method::METHOD_HEAD;
+  check(cache.lookup(head) == nullptr, "only GET is cached");
+
+  CacheStats stats = cache.stats();
+  check(stats.hits == 2 && stats.misses == 5 && stats.insertions == 1 &&
+            stats.entries == 1,
+        "statistics");
+  cache.clear();
+  check(cache.lookup(request) == nullptr && cache.stats().entries == 0,
+        "clear");
+}
+
+void testStorability() {
+  ResponseCache cache(1 << 20);
+  Request request = makeRequest("a.example");
+  check(!cache.insert(request, makeResponse("no-store"), "x") &&
+            !cache.insert(request, makeResponse("private, max-age=60"), "x"),
+        "no-store and private");
+  Response cookie = makeResponse();
+  cookie.headers.add("Set-Cookie", "id=1");
+  check(!cache.insert(request, cookie, "x"), "Set-Cookie");
+  Response notFound = makeResponse();
+  notFound.status_code = StatusCode::NOT_FOUND;
+  check(!cache.insert(request, notFound, "x"), "only 200 is stored");
+  Response any = makeResponse();
+  any.headers.add("Vary", "*");
+  check(!cache.insert(request, any, "x"), "vary: *");
+
+  Request credentials = makeRequest("a.example");
+  credentials.headers.add("Authorization", "Basic YTpi");
+  check(!cache.insert(credentials, makeResponse(), "x"),
+        "credentials need explicit sharing");
+  check(cache.insert(credentials, makeResponse("public, max-age=60"), "x"),
+        "public responses to credentials");
+}
+
+void testFreshness() {
+  ResponseCache cache(1 << 20);
+  Request request = makeRequest("a.example");
+  check(!cache.insert(request, makeResponse("no-cache, max-age=60"), "x"),
+        "no-cache needs revalidation");
+  check(!cache.insert(request, makeResponse("max-age=0"), "x"),
+        "max-age=0 is stale at once");
+  check(!cache.insert(request, makeResponse("max-age=60, s-maxage=0"), "x"),
+        "s-maxage takes precedence over max-age");
+  check(!cache.insert(request, makeResponse("max-age=soon"), "x"),
+        "malformed max-age is stale");
+  check(!cache.insert(request, makeResponse(nullptr), "x"),
+        "no freshness information");
+
+  Response aged = makeResponse("max-age=60");
+  aged.headers.add("Age", "60");
+  check(!cache.insert(request, aged, "x"), "age counts against the lifetime");
+
+  Response expired = makeResponse(nullptr);
+  expired.headers.add("Expires", dateIn(-60));
+  check(!cache.insert(request, expired, "x"), "past Expires");
+  Response invalid = makeResponse(nullptr);
+  invalid.headers.add("Expires", "0");
+  check(!cache.insert(request, invalid, "x"), "invalid Expires");
+  Response expires = makeResponse(nullptr);
+  expires.headers.add("Date", dateIn(0));
+  expires.headers.add("Expires", dateIn(60));
+  check(cache.insert(request, expires, "x") && cache.lookup(request),
+        "future Expires");
+
+  Response heuristic = makeResponse(nullptr);
+  heuristic.headers.add("Last-Modified", dateIn(-3600));
+  check(cache.insert(makeRequest("b.example"), heuristic, "x"),
+        "heuristic freshness from Last-Modified");
+  check(ResponseCache::is_storable(makeResponse()) &&
+            !ResponseCache::is_storable(makeResponse("max-age=0")),
+        "is_storable checks freshness");
+
+  Request shortLived = makeRequest("c.example");
+  check(cache.insert(shortLived, makeResponse("max-age=1"), "x") &&
+            cache.lookup(shortLived) != nullptr,
+        "fresh entry");
+  std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+  check(cache.lookup(shortLived) == nullptr, "stale entries are misses");
+}
+
+void testVary() {
+  ResponseCache cache(1 << 20);
+  Request gzip = makeRequest("a.example");
+  gzip.headers.add("Accept-Encoding", "gzip");
+  Request br = makeRequest("a.example");
+  br.headers.add("Accept-Encoding", "br");
+  Response response = makeResponse();
+  response.headers.add("Vary", "accept-encoding");
+  check(cache.insert(gzip, response, "gzip") && cache.insert(br, response, "br"),
+        "two variants");
+  check(*cache.lookup(gzip) == "gzip" && *cache.lookup(br) == "br",
+        "variants are told apart");
+  check(cache.lookup(makeRequest("a.example")) == nullptr,
+        "requests without the header get no variant");
+
+  // an oversized entry is refused and must not change the vary list
+  Response other = makeResponse();
+  other.headers.add("Vary", "User-Agent");
+  check(!cache.insert(gzip, other, std::string(2 << 20, 'x')),
+        "oversized entry is refused");
+  ResponseCache::Entry entry = cache.lookup(gzip);
+  check(entry != nullptr && *entry == "gzip",
+        "refused entries keep the stored variants reachable");
+}
+
+void testEviction() {
+  ResponseCache cache(4096, 1);
+  std::string body(500, 'b');
+  for (int i = 0; i < 20; i++) {
+    std::string url = "/" + std::to_string(i);
+    cache.insert(makeRequest("a.example", url.c_str()), makeResponse(), body);
+  }
+  CacheStats stats = cache.stats();
+  check(stats.evictions > 0 && stats.bytes <= 4096 && stats.entries < 20,
+        "the shard stays within its budget");
+  check(cache.lookup(makeRequest("a.example", "/19")) != nullptr,
+        "the latest entry is kept");
+
+  ResponseCache replaced(4096, 1);
+  Request request = makeRequest("a.example");
+  for (int i = 0; i < 10; i++) {
+    replaced.insert(request, makeResponse(), body);
+  }
+  check(replaced.stats().entries == 1 && replaced.stats().evictions == 0,
+        "replacing an entry doesn't grow the shard");
+}
+
+} // namespace
+
+int main() {
+  testHitsAndKeys();
+  testStorability();
+  testFreshness();
+  testVary();
+  testEviction();
+  return test::test_result("response_cache_test");
+}
@@ -0,0 +1,146 @@
+/**
+ * @file response_serializer_test.cpp
+ * @brief ResponseSerializer output, framing headers and writev
+ */
+
+#include "Check.h"
+#include "ResponseSerializer.hpp"
+#include <string>
+#include <unistd.h>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+std::string joined(const ResponseSerializer &serializer) {
+  std::string out;
+  for (std::size_t i = 0; i < serializer.iovec_count(); i++) {
+    const iovec &part = serializer.iovecs()[i];
+    out.append(static_cast<const char *>(part.iov_base), part.iov_len);
+  }
+  return out;
+}
+
+Response makeResponse(int code) {
+  Response response;
+  response.status_code = static_cast<StatusCode>(code);
+  return response;
+}
+
+void testStatusLines() {
+  ResponseSerializer serializer;
+  serializer.set_date_header(false);
+  Response response = makeResponse(200);
+  response.headers.add("content-type", "text/plain");
+  check(serializer.serialize(response, "hello"), "serialize 200");
+  check(joined(serializer) == "HTTP/1.1 200 OK\r\ncontent-type: text/plain\r\n"
+                              "content-length: 5\r\n\r\nhello",
+        "table status line, headers, length and body");
+  check(serializer.size() == joined(serializer).size() &&
+            serializer.body_size() == 5,
+        "sizes");
+
+  response = makeResponse(404);
+  response.status_message = "Nope";
+  check(serializer.serialize(response) &&
+            joined(serializer).rfind("HTTP/1.1 404 Nope\r\n", 0) == 0,
+        "custom reason phrase");
+
+  check(serializer.serialize(makeResponse(429)) &&
+            joined(serializer).rfind("HTTP/1.1 429 \r\n", 0) == 0,
+        "codes without a table entry are written as numbers");
+
+  check(!serializer.serialize(makeResponse(99)) &&
+            !serializer.serialize(makeResponse(600)) &&
+            !serializer.serialize(makeResponse(999)) &&
+            !serializer.serialize(makeResponse(0)),
+        "codes outside 100 to 599 are refused");
+
+  response = makeResponse(200);
+  response.status_message = "OK\r\nX-Injected: 1";
+  check(!serializer.serialize(response), "line breaks in the reason");
+  response = makeResponse(200);
+  response.headers.add("x-split", "a\r\nx-injected: 1");
+  check(!serializer.serialize(response), "line breaks in a header value");
+}
+
+void testFraming() {
+  ResponseSerializer serializer;
+  serializer.set_date_header(false);
+  check(serializer.serialize(makeResponse(204)) &&
+            joined(serializer) == "HTTP/1.1 204 No Content\r\n\r\n",
+        "no content-length on 204");
+  check(serializer.serialize(makeResponse(304)) &&
+            joined(serializer) == "HTTP/1.1 304 Not Modified\r\n\r\n",
+        "no content-length on 304");
+  check(serializer.serialize(makeResponse(100)) &&
+            joined(serializer) == "HTTP/1.1 100 Continue\r\n\r\n",
+        "no content-length on 1xx");
+
+  Response chunked = makeResponse(200);
+  chunked.headers.add("transfer-encoding", "chunked");
+  check(serializer.serialize(chunked) &&
+            joined(serializer).find("content-length") == std::string::npos,
+        "no content-length next to transfer-encoding");
+
+  // answer to HEAD: the caller states the GET length or leaves it out
+  serializer.set_content_length_header(false);
+  check(serializer.serialize(makeResponse(200)) &&
+            joined(serializer) == "HTTP/1.1 200 OK\r\n\r\n",
+        "content-length can be suppressed");
+  Response head = makeResponse(200);
+  head.headers.add("content-length", "1234");
+  check(serializer.serialize(head) &&
+            joined(serializer) ==
+                "HTTP/1.1 200 OK\r\ncontent-length: 1234\r\n\r\n",
+        "an explicit content-length is kept");
+  serializer.set_content_length_header(true);
+  check(serializer.serialize(makeResponse(200)) &&
+            joined(serializer).find("content-length: 0") != std::string::npos,
+        "empty bodies are announced again once re-enabled");
+
+  serializer.set_date_header(true);
+  check(serializer.serialize(makeResponse(200)) &&
+            joined(serializer).find("\r\ndate: ") != std::string::npos,
+        "date header by default");
+}
+
+void testBodyPartsAndWrite() {
+  ResponseSerializer serializer;
+  serializer.set_date_header(false);
+  std::string_view parts[] = {"ab", "", "cde"};
+  check(serializer.serialize(makeResponse(200), parts, 3) &&
+            serializer.body_size() == 5 && serializer.iovec_count() == 4,
+        "body parts are referenced, empty ones skipped");
+
+  std::string expected = joined(serializer);
+  serializer.consume(3);
+  check(joined(serializer) == expected.substr(3), "consume skips sent bytes");
+
+  int fds[2];
+  if (::pipe(fds) != 0) {
+    check(false, "pipe");
+    return;
+  }
+  check(serializer.write(fds[1]) && serializer.size() == 0,
+        "write sends the rest");
+  ::close(fds[1]);
+  std::string received;
+  char buffer[256];
+  ssize_t n;
+  while ((n = ::read(fds[0], buffer, sizeof(buffer))) > 0) {
+    received.append(buffer, static_cast<std::size_t>(n));
+  }
+  ::close(fds[0]);
+  check(received == expected.substr(3), "written bytes");
+}
+
+} // namespace
+
+int main() {
+  testStatusLines();
+  testFraming();
+  testBodyPartsAndWrite();
+  return test::test_result("response_serializer_test");
+}
@@ -0,0 +1,128 @@
+/**
+ * @file router_test.cpp
+ * @brief Router registration, matching precedence and captures
+ */
+
+#include "Check.h"
+#include "Router.hpp"
+#include <string>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+enum Route : std::size_t {
+  USERS = 1,
+  USER,
+  USER_POSTS,
+  USERS_ME,
+  STATIC_FILES,
+  ROOT,
+  USER_POST,
+};
+
+bool matches(const Router &router, const char *path, std::size_t route,
+             RouteMatch &match) {
+  return router.match(Method::METHOD_GET, path, match) &&
+         match.route_id() == route;
+}
+
+void testMatching() {
+  Router router;
+  check(router.add(Method::METHOD_GET, "/", ROOT) &&
+            router.add(Method::METHOD_GET, "/users", USERS) &&
+            router.add(Method::METHOD_GET, "/users/:id", USER) &&
+            router.add(Method::METHOD_GET, "/users/me", USERS_ME) &&
+            router.add(Method::METHOD_GET, "/users/:id/posts", USER_POSTS) &&
+            router.add(Method::METHOD_GET, "/static/*path", STATIC_FILES),
+        "routes are registered");
+
+  RouteMatch match;
+  check(matches(router, "/", ROOT, match) && match.size() == 0, "root");
+  check(matches(router, "/users", USERS, match), "static route");
+  check(matches(router, "/users/me", USERS_ME, match),
+        "static segments win over parameters");
+  check(matches(router, "/users/42", USER, match) &&
+            match.param("id") == "42" && match.size() == 1,
+        "named segment is captured");
+  check(matches(router, "/users/42/posts", USER_POSTS, match) &&
+            match.param("id") == "42",
+        "parameter followed by static text");
+  check(matches(router, "/static/css/site.css", STATIC_FILES, match) &&
+            match.param("path") == "css/site.css",
+        "wildcard captures the rest of the path");
+  check(match.param("missing").empty(), "unknown parameter names are empty");
+
+  check(!router.match(Method::METHOD_GET, "/users/42/other", match),
+        "unknown suffix does not match");
+  check(!router.match(Method::METHOD_GET, "/user", match),
+        "a prefix of a route does not match");
+  check(!router.match(Method::METHOD_POST, "/users", match),
+        "routes are per method");
+
+  std::string path = "/users/7";
+  check(router.match(Method::METHOD_GET, path, match) &&
+            match.param("id").data() == path.data() + 7,
+        "captures are views into the path");
+
+  Request request;
+  request.method = Method::METHOD_GET;
+  request.url = "/users/9?verbose=1";
+  check(router.match(request, match) && match.route_id() == USER &&
+            match.param("id") == "9",
+        "requests match on the path of the target");
+}
+
+void testRejectedPatterns() {
+  Router router;
+  check(!router.add(Method::METHOD_GET, "", ROOT) &&
+            !router.add(Method::METHOD_GET, "users", ROOT),
+        "patterns start with a slash");
+  check(!router.add(Method::METHOD_GET, "/a/:", ROOT) &&
+            !router.add(Method::METHOD_GET, "/a/*", ROOT),
+        "parameters need a name");
+  check(!router.add(Method::METHOD_GET, "/a/*rest/more", ROOT),
+        "wildcards must be last");
+  check(!router.add(Method::METHOD_GET,
+                    "/:a/:b/:c/:d/:e/:f/:g/:h/:i", ROOT),
+        "more parameters than a match holds");
+
+  check(router.add(Method::METHOD_GET, "/users/:id", USER),
+        "route is registered");
+  check(!router.add(Method::METHOD_GET, "/users/:id", USER),
+        "duplicate routes are rejected");
+  check(!router.add(Method::METHOD_GET, "/users/:name/posts", USER_POSTS),
+        "one position can't have two parameter names");
+}
+
+// a pattern rejected late must not leave static nodes or parameters behind
+void testRejectedPatternLeavesTreeAlone() {
+  Router router;
+  check(router.add(Method::METHOD_GET, "/files/:id", USER), "route added");
+  check(!router.add(Method::METHOD_GET, "/new/path/*rest/tail", USER_POST),
+        "invalid wildcard is rejected");
+  check(!router.add(Method::METHOD_GET, "/files/:name", USER_POST),
+        "conflicting name is rejected");
+
+  RouteMatch match;
+  check(!router.match(Method::METHOD_GET, "/new/path/x", match) &&
+            !router.match(Method::METHOD_GET, "/new/path", match),
+        "nothing of the rejected pattern was inserted");
+  check(router.match(Method::METHOD_GET, "/files/3", match) &&
+            match.param("id") == "3",
+        "existing route keeps its parameter name");
+  check(router.add(Method::METHOD_GET, "/new/path/*rest", STATIC_FILES) &&
+            router.match(Method::METHOD_GET, "/new/path/x/y", match) &&
+            match.param("rest") == "x/y",
+        "the corrected pattern can be added afterwards");
+}
+
+} // namespace
+
+int main() {
+  testMatching();
+  testRejectedPatterns();
+  testRejectedPatternLeavesTreeAlone();
+  return test::test_result("router_test");
+}
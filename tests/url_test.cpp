@@ -0,0 +1,111 @@
+/**
+ * @file url_test.cpp
+ * @brief UrlView decomposition, query iteration, percent decoding and
+ * target normalization
+ */
+
+#include "Check.h"
+#include "Url.hpp"
+#include <string>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+void testForms() {
+  UrlView origin("/search/items?q=a+b&page=2#top");
+  check(origin.form() == TargetForm::ORIGIN, "origin form");
+  check(origin.path() == "/search/items" && origin.query() == "q=a+b&page=2" &&
+            origin.fragment() == "top",
+        "origin form parts");
+  check(origin.scheme().empty() && origin.host().empty(),
+        "origin form has no scheme or host");
+
+  UrlView absolute("http://user@Example.com:8080/a/b?x=1");
+  check(absolute.form() == TargetForm::ABSOLUTE, "absolute form");
+  check(absolute.scheme() == "http" &&
+            absolute.authority() == "user@Example.com:8080" &&
+            absolute.host() == "Example.com" && absolute.port() == "8080" &&
+            absolute.path() == "/a/b" && absolute.query() == "x=1",
+        "absolute form parts");
+
+  UrlView ipv6("http://[::1]:80/");
+  check(ipv6.host() == "::1" && ipv6.port() == "80",
+        "IPv6 literals lose their brackets");
+
+  UrlView authority("example.com:443");
+  check(authority.form() == TargetForm::AUTHORITY &&
+            authority.host() == "example.com" && authority.port() == "443",
+        "authority form");
+  check(UrlView("*").form() == TargetForm::ASTERISK, "asterisk form");
+
+  std::string target = "/views?into=target";
+  UrlView view(target);
+  check(view.path().data() == target.data(),
+        "parts are views into the target");
+}
+
+void testQueryParams() {
+  UrlView url("/p?a=1&empty=&flag&b=two&&a=3");
+  std::string seen;
+  for (const QueryParam &param : url.query_params()) {
+    seen += std::string(param.key) + "=" + std::string(param.value) + ";";
+  }
+  check(seen == "a=1;empty=;flag=;b=two;a=3;",
+        "parameters in order, empty pairs skipped");
+  std::string_view value;
+  check(url.query_params().find("b", value) && value == "two",
+        "find returns the value");
+  check(url.query_params().find("a", value) && value == "1",
+        "find returns the first match");
+  check(!url.query_params().find("missing", value), "find of a missing key");
+  check(UrlView("/p").query_params().begin() ==
+            UrlView("/p").query_params().end(),
+        "no query, no parameters");
+}
+
+void testPercentDecode() {
+  char buffer[64];
+  std::string_view decoded;
+  std::string plain = "no-escapes";
+  check(!needs_percent_decoding(plain) &&
+            percent_decode(plain, buffer, decoded) &&
+            decoded.data() == plain.data(),
+        "input without escapes is returned as is");
+  check(percent_decode("a%20b%2Fc", buffer, decoded) && decoded == "a b/c",
+        "escapes are decoded");
+  check(percent_decode("a+b%2b", buffer, decoded, true) && decoded == "a b+",
+        "'+' is a space in form encoding");
+  check(percent_decode("a+b", buffer, decoded) && decoded == "a+b",
+        "'+' is literal otherwise");
+  check(!percent_decode("bad%2", buffer, decoded) &&
+            !percent_decode("bad%zz", buffer, decoded),
+        "truncated and non-hex escapes are rejected");
+}
+
+void testNormalize() {
+  std::string out;
+  check(normalize_target("/a%7Eb/%2f?q=%3d", out) && out == "/a~b/%2F?q=%3D",
+        "unreserved escapes decoded, others upper-cased");
+  out.clear();
+  check(normalize_target("HTTP://Example.COM:80/x#frag", out) &&
+            out == "http://example.com/x",
+        "scheme and host lower-cased, default port and fragment dropped");
+  out.clear();
+  check(normalize_target("https://example.com:8443", out) &&
+            out == "https://example.com:8443/",
+        "other ports are kept and an empty path becomes /");
+  out.clear();
+  check(!normalize_target("/%g0", out), "malformed escapes fail");
+}
+
+} // namespace
+
+int main() {
+  testForms();
+  testQueryParams();
+  testPercentDecode();
+  testNormalize();
+  return test::test_result("url_test");
+}
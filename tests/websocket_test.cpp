@@ -0,0 +1,230 @@
+/**
+ * @file websocket_test.cpp
+ * @brief WebSocket opening handshake and frame parsing
+ */
+
+#include "Check.h"
+#include "WebSocket.hpp"
+#include <string>
+#include <vector>
+
+using namespace http_parser;
+using test::check;
+
+namespace {
+
+Request upgradeRequest(std::string_view connection = "keep-alive, Upgrade",
+                       std::string_view key = "dGhlIHNhbXBsZSBub25jZQ==",
+                       std::string_view version = "13") {
+  Request request;
+  request.method = Method::METHOD_GET;
+  request.version = Version::HTTP_1_1;
+  request.headers.add("Host", "server.example.com");
+  request.headers.add("Upgrade", "websocket");
+  request.headers.add("Connection", connection);
+  request.headers.add("Sec-WebSocket-Key", key);
+  request.headers.add("Sec-WebSocket-Version", version);
+  return request;
+}
+
+struct Frame {
+  WebSocketFrameHeader header;
+  std::string payload;
+};
+
+// feeds `data` in pieces of `step` bytes and collects the frames; returns
+// false when the parser fails
+bool parse(WebSocketFrameParser &parser, std::string data, std::size_t step,
+           std::vector<Frame> &frames) {
+  frames.clear();
+  std::size_t offset = 0;
+  while (offset < data.size()) {
+    std::size_t length = std::min(step, data.size() - offset);
+    std::size_t used = 0;
+    while (used < length) {
+      WebSocketEvent event = WebSocketEvent::NONE;
+      std::string_view payload;
+      used += parser.execute(&data[offset + used], length - used, event,
+                             payload);
+      if (parser.failed()) {
+        return false;
+      }
+      if (event == WebSocketEvent::FRAME_BEGIN) {
+        frames.push_back(Frame{parser.frame(), std::string()});
+      } else if (event == WebSocketEvent::PAYLOAD) {
+        frames.back().payload.append(payload.data(), payload.size());
+      }
+    }
+    offset += length;
+  }
+  return parser.frame_complete();
+}
+
+bool rejected(std::string data, std::uint16_t code, bool server = true) {
+  WebSocketFrameParser parser(server);
+  std::vector<Frame> frames;
+  return !parse(parser, data, data.size(), frames) && parser.failed() &&
+         parser.close_code() == code;
+}
+
+void testHandshake() {
+  std::string_view key;
+  Request request = upgradeRequest();
+  check(validate_websocket_upgrade(request, key) == WebSocketUpgrade::VALID &&
+            key == "dGhlIHNhbXBsZSBub25jZQ==",
+        "valid upgrade");
+
+  char accept[WEBSOCKET_ACCEPT_LENGTH];
+  websocket_accept(key, accept);
+  check(std::string(accept, sizeof(accept)) == "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=",
+        "accept value of RFC 6455 section 1.3");
+
+  Response response;
+  websocket_accept_response(key, response);
+  check(response.status_code == StatusCode::SWITCHING_PROTOCOLS &&
+            response.headers.value_of(HeaderId::UPGRADE) == "websocket" &&
+            response.headers.value_of(HeaderId::SEC_WEBSOCKET_ACCEPT) ==
+                "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=",
+        "101 response");
+
+  Request plain;
+  plain.method = Method::METHOD_GET;
+  plain.version = Version::HTTP_1_1;
+  plain.headers.add("Host", "server.example.com");
+  check(validate_websocket_upgrade(plain, key) == WebSocketUpgrade::NONE,
+        "not an upgrade");
+
+  Request version =
+      upgradeRequest("Upgrade", "dGhlIHNhbXBsZSBub25jZQ==", "8");
+  check(validate_websocket_upgrade(version, key) ==
+            WebSocketUpgrade::BAD_VERSION,
+        "unsupported version");
+
+  Request post = upgradeRequest();
+  post.method = Method::METHOD_POST;
+  check(validate_websocket_upgrade(post, key) == WebSocketUpgrade::INVALID,
+        "only GET upgrades");
+  Request shortKey = upgradeRequest("Upgrade", "c2hvcnQ=");
+  check(validate_websocket_upgrade(shortKey, key) ==
+            WebSocketUpgrade::INVALID,
+        "the key must be 16 bytes");
+  Request noConnection = upgradeRequest("keep-alive");
+  check(validate_websocket_upgrade(noConnection, key) ==
+            WebSocketUpgrade::INVALID,
+        "Connection must name the upgrade");
+}
+
+void testMasking() {
+  const std::uint8_t mask[4] = {0x37, 0xfa, 0x21, 0x3d};
+  std::string data = "Hello";
+  websocket_unmask(&data[0], data.size(), mask);
+  check(data == "\x7f\x9f\x4d\x51\x58", "masked example of RFC 6455 5.7");
+  websocket_unmask(&data[0], 2, mask);
+  websocket_unmask(&data[2], 3, mask, 2);
+  check(data == "Hello", "unmasking in pieces continues at the offset");
+}
+
+void testFrameHeaders() {
+  char out[WEBSOCKET_MAX_FRAME_HEADER];
+  check(websocket_frame_header(WebSocketOpcode::TEXT, true, 5, nullptr, out) ==
+                2 &&
+            std::string(out, 2) == "\x81\x05",
+        "7-bit length");
+  check(websocket_frame_header(WebSocketOpcode::BINARY, true, 256, nullptr,
+                               out) == 4 &&
+            std::string(out, 4) == std::string("\x82\x7e\x01\x00", 4),
+        "16-bit length");
+  check(websocket_frame_header(WebSocketOpcode::BINARY, false, 65536, nullptr,
+                               out) == 10 &&
+            std::string(out, 10) ==
+                std::string("\x02\x7f\x00\x00\x00\x00\x00\x01\x00\x00", 10),
+        "64-bit length");
+  const std::uint8_t mask[4] = {1, 2, 3, 4};
+  check(websocket_frame_header(WebSocketOpcode::PING, true, 0, mask, out) ==
+                6 &&
+            std::string(out, 6) == std::string("\x89\x80\x01\x02\x03\x04", 6),
+        "masked header");
+}
+
+void testParsing() {
+  std::string masked = "\x81\x85\x37\xfa\x21\x3d\x7f\x9f\x4d\x51\x58";
+  for (std::size_t step : {std::size_t(1), std::size_t(3), masked.size()}) {
+    WebSocketFrameParser parser;
+    std::vector<Frame> frames;
+    check(parse(parser, masked, step, frames) && frames.size() == 1 &&
+              frames[0].header.opcode == WebSocketOpcode::TEXT &&
+              frames[0].payload == "Hello" && parser.message_complete(),
+          "masked text frame in pieces");
+  }
+
+  WebSocketFrameParser client(false);
+  std::vector<Frame> frames;
+  std::string fragmented = std::string("\x01\x03Hel", 5) +
+                           std::string("\x89\x00", 2) +
+                           std::string("\x80\x02lo", 4);
+  check(parse(client, fragmented, 2, frames) && frames.size() == 3 &&
+            frames[0].payload == "Hel" &&
+            frames[1].header.opcode == WebSocketOpcode::PING &&
+            frames[2].header.opcode == WebSocketOpcode::CONTINUATION &&
+            frames[2].payload == "lo" &&
+            client.message_opcode() == WebSocketOpcode::TEXT &&
+            client.message_complete(),
+        "fragmented message with a control frame in between");
+
+  std::string binary = std::string("\x82\x7e\x01\x00", 4) +
+                       std::string(256, 'b');
+  client.reset();
+  check(parse(client, binary, 100, frames) && frames.size() == 1 &&
+            frames[0].header.length == 256 && frames[0].payload.size() == 256,
+        "16-bit payload length");
+}
+
+void testErrors() {
+  check(rejected(std::string("\x81\x05Hello", 7), 1002),
+        "servers need masked frames");
+  check(rejected("\x81\x85\x37\xfa\x21\x3d\x7f\x9f\x4d\x51\x58", 1002, false),
+        "clients need unmasked frames");
+  check(rejected(std::string("\x09\x00", 2), 1002, false),
+        "fragmented control frame");
+  check(rejected(std::string("\x89\x7e\x00\x7e", 4), 1002, false),
+        "control frame above 125 bytes");
+  check(rejected(std::string("\x83\x00", 2), 1002, false), "reserved opcode");
+  check(rejected(std::string("\x80\x00", 2), 1002, false),
+        "continuation without a message");
+  check(rejected(std::string("\x01\x00\x81\x00", 4), 1002, false),
+        "new message inside a fragmented one");
+  check(rejected(std::string("\xc1\x00", 2), 1002, false),
+        "RSV1 without an extension");
+  check(rejected(std::string("\x82\x7f\x80\x00\x00\x00\x00\x00\x00\x00", 10),
+                 1002, false),
+        "64-bit length with the top bit set");
+
+  WebSocketFrameParser extension(false);
+  extension.set_allow_rsv1(true);
+  std::vector<Frame> frames;
+  check(parse(extension, std::string("\xc1\x00", 2), 2, frames) &&
+            frames[0].header.rsv1,
+        "RSV1 once an extension allows it");
+
+  WebSocketFrameParser limited(false);
+  limited.set_max_frame_size(4);
+  check(!parse(limited, std::string("\x82\x05hello", 7), 7, frames) &&
+            limited.close_code() == 1009 &&
+            !limited.getErrorMessage().empty(),
+        "frame above the limit");
+  limited.reset();
+  check(!limited.failed() && limited.close_code() == 0 &&
+            parse(limited, std::string("\x82\x04" "four", 6), 6, frames),
+        "reset clears the error");
+}
+
+} // namespace
+
+int main() {
+  testHandshake();
+  testMasking();
+  testFrameHeaders();
+  testParsing();
+  testErrors();
+  return test::test_result("websocket_test");
+}
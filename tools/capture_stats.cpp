@@ -0,0 +1,99 @@
+/**
+ * @file capture_stats.cpp
+ * @brief prints statistics of an HTTP request capture, optionally writes
+ * the requests as binary records
+ *
+ * usage: capture_stats <capture> [-t threads] [-o records.bin]
+ */
+
+#include "CaptureParser.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+using namespace http_parser;
+
+namespace {
+
+int usage(const char *program) {
+  std::fprintf(stderr, "usage: %s <capture> [-t threads] [-o records.bin]\n",
+               program);
+  return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    return usage(argv[0]);
+  }
+  CaptureOptions options;
+  const char *output = nullptr;
+  for (int i = 2; i < argc; i += 2) {
+    if (i + 1 == argc) {
+      return usage(argv[0]);
+    }
+    if (std::strcmp(argv[i], "-t") == 0) {
+      options.threads = static_cast<unsigned>(std::atoi(argv[i + 1]));
+    } else if (std::strcmp(argv[i], "-o") == 0) {
+      output = argv[i + 1];
+      options.emitRecords = true;
+    } else {
+      return usage(argv[0]);
+    }
+  }
+
+  CaptureFile capture;
+  if (!capture.open(argv[1])) {
+    std::perror("Error mapping capture file");
+    return 1;
+  }
+  std::FILE *file = nullptr;
+  if (output != nullptr) {
+    file = std::fopen(output, "wb");
+    if (file == nullptr) {
+      std::perror("Error opening output file");
+      return 1;
+    }
+  }
+  // records are written region by region as the regions are done
+  bool written = true;
+  auto begin = std::chrono::steady_clock::now();
+  CaptureStats stats = parse_capture(
+      capture.data(), capture.size(), options, [&](std::string_view region) {
+        written = written && std::fwrite(region.data(), 1, region.size(),
+                                         file) == region.size();
+      });
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - begin;
+  if (file != nullptr && (std::fclose(file) != 0 || !written)) {
+    std::perror("Error writing output file");
+    return 1;
+  }
+
+  std::printf("bytes          %zu\n", capture.size());
+  std::printf("messages       %llu\n",
+              static_cast<unsigned long long>(stats.messages));
+  std::printf("parse errors   %llu (%llu bytes skipped)\n",
+              static_cast<unsigned long long>(stats.parseErrors),
+              static_cast<unsigned long long>(stats.skippedBytes));
+  std::printf("header bytes   %llu\n",
+              static_cast<unsigned long long>(stats.headerBytes));
+  std::printf("body bytes     %llu\n",
+              static_cast<unsigned long long>(stats.bodyBytes));
+  std::printf("headers        %llu\n",
+              static_cast<unsigned long long>(stats.headers));
+  for (std::size_t i = 0; i < stats.methods.size(); i++) {
+    if (stats.methods[i] != 0) {
+      std::printf("  %-12s %llu\n",
+                  method_to_string(static_cast<Method>(i)).c_str(),
+                  static_cast<unsigned long long>(stats.methods[i]));
+    }
+  }
+  std::printf("elapsed        %.3f s (%.1f MB/s)\n", elapsed.count(),
+              static_cast<double>(capture.size()) / 1e6 / elapsed.count());
+  return 0;
+}
@@ -0,0 +1,206 @@
+/**
+ * @file hpack_bench.cpp
+ * @brief checks the HPACK coder against the examples of RFC 7541 appendix C
+ * and times decoding and encoding of them
+ *
+ * usage: hpack_bench [-n iterations]
+ */
+
+#include "Hpack.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace http_parser;
+
+namespace {
+
+struct Example {
+  const char *hex;
+  std::vector<std::pair<std::string, std::string>> fields;
+  std::size_t tableSize; // dynamic table size after the block
+};
+
+struct Sequence {
+  const char *name;
+  std::size_t maxTableSize;
+  std::vector<Example> blocks;
+};
+
+const std::string exampleDate = "Mon, 21 Oct 2013 20:13:21 GMT";
+const std::string exampleCookie =
+    "foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1";
+
+// C.4 requests and C.6 responses, both Huffman coded
+const std::vector<Sequence> sequences = {
+    {"C.4",
+     4096,
+     {{"828684418cf1e3c2e5f23a6ba0ab90f4ff",
+       {{":method", "GET"},
+        {":scheme", "http"},
+        {":path", "/"},
+        {":authority", "www.example.com"}},
+       57},
+      {"828684be5886a8eb10649cbf",
+       {{":method", "GET"},
+        {":scheme", "http"},
+        {":path", "/"},
+        {":authority", "www.example.com"},
+        {"cache-control", "no-cache"}},
+       110},
+      {"828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf",
+       {{":method", "GET"},
+        {":scheme", "https"},
+        {":path", "/index.html"},
+        {":authority", "www.example.com"},
+        {"custom-key", "custom-value"}},
+       164}}},
+    {"C.6",
+     256,
+     {{"488264025885aec3771a4b6196d07abe941054d444a8200595040b8166e082a62d1b"
+       "ff6e919d29ad171863c78f0b97c8e9ae82ae43d3",
+       {{":status", "302"},
+        {"cache-control", "private"},
+        {"date", exampleDate},
+        {"location", "https://www.example.com"}},
+       222},
+      {"4883640effc1c0bf",
+       {{":status", "307"},
+        {"cache-control", "private"},
+        {"date", exampleDate},
+        {"location", "https://www.example.com"}},
+       222},
+      {"88c16196d07abe941054d444a8200595040b8166e084a62d1bffc05a839bd9ab77ad"
+       "94e7821dd7f2e6c7b335dfdfcd5b3960d5af27087f3672c1ab270fb5291f958731"
+       "6065c003ed4ee5b1063d5007",
+       {{":status", "200"},
+        {"cache-control", "private"},
+        {"date", "Mon, 21 Oct 2013 20:13:22 GMT"},
+        {"location", "https://www.example.com"},
+        {"content-encoding", "gzip"},
+        {"set-cookie", exampleCookie}},
+       215}}},
+};
+
+std::string fromHex(const char *hex) {
+  std::string out;
+  for (std::size_t i = 0; hex[i] != '\0' && hex[i + 1] != '\0'; i += 2) {
+    char byte[3] = {hex[i], hex[i + 1], '\0'};
+    out.push_back(static_cast<char>(std::strtoul(byte, nullptr, 16)));
+  }
+  return out;
+}
+
+bool check(const Sequence &sequence) {
+  HpackDecoder decoder(sequence.maxTableSize);
+  HpackEncoder encoder(sequence.maxTableSize);
+  HpackDecoder roundTrip(sequence.maxTableSize);
+  for (std::size_t i = 0; i < sequence.blocks.size(); i++) {
+    const Example &example = sequence.blocks[i];
+    std::string block = fromHex(example.hex);
+    Headers headers;
+    if (!decoder.decode(block.data(), block.size(), headers)) {
+      std::printf("%s.%zu: %s\n", sequence.name, i + 1,
+                  decoder.getErrorMessage().c_str());
+      return false;
+    }
+    bool same = headers.size() == example.fields.size();
+    for (std::size_t j = 0; same && j < headers.size(); j++) {
+      same = headers[j].key == example.fields[j].first &&
+             headers[j].value == example.fields[j].second;
+    }
+    if (!same || decoder.table().size() != example.tableSize) {
+      std::printf("%s.%zu: decoded fields or table size differ\n",
+                  sequence.name, i + 1);
+      return false;
+    }
+
+    // the encoder output has to decode to the same fields
+    std::string encoded;
+    for (const auto &field : example.fields) {
+      encoder.encode(field.first, field.second, encoded);
+    }
+    Headers decoded;
+    if (!roundTrip.decode(encoded.data(), encoded.size(), decoded) ||
+        decoded.size() != headers.size()) {
+      std::printf("%s.%zu: encoded block does not round trip\n",
+                  sequence.name, i + 1);
+      return false;
+    }
+    for (std::size_t j = 0; j < decoded.size(); j++) {
+      if (decoded[j].key != headers[j].key ||
+          decoded[j].value != headers[j].value) {
+        std::printf("%s.%zu: encoded block does not round trip\n",
+                    sequence.name, i + 1);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::size_t iterations = 100000;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "-n") == 0) {
+      iterations = std::strtoull(argv[i + 1], nullptr, 10);
+    }
+  }
+
+  for (const Sequence &sequence : sequences) {
+    if (!check(sequence)) {
+      return 1;
+    }
+    std::printf("%s ok\n", sequence.name);
+  }
+
+  for (const Sequence &sequence : sequences) {
+    std::vector<std::string> blocks;
+    std::size_t bytes = 0;
+    for (const Example &example : sequence.blocks) {
+      blocks.push_back(fromHex(example.hex));
+      bytes += blocks.back().size();
+    }
+    // a fresh pair per iteration, the blocks depend on the table state
+    Headers headers;
+    std::size_t fields = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (std::size_t n = 0; n < iterations; n++) {
+      HpackDecoder decoder(sequence.maxTableSize);
+      for (const std::string &block : blocks) {
+        headers.clear();
+        decoder.decode(block.data(), block.size(), headers);
+        fields += headers.size();
+      }
+    }
+    std::chrono::duration<double> decodeTime =
+        std::chrono::steady_clock::now() - begin;
+
+    std::string out;
+    begin = std::chrono::steady_clock::now();
+    for (std::size_t n = 0; n < iterations; n++) {
+      HpackEncoder encoder(sequence.maxTableSize);
+      for (const Example &example : sequence.blocks) {
+        out.clear();
+        for (const auto &field : example.fields) {
+          encoder.encode(field.first, field.second, out);
+        }
+      }
+    }
+    std::chrono::duration<double> encodeTime =
+        std::chrono::steady_clock::now() - begin;
+
+    std::printf("%s decode  %.1f MB/s, %.1f M fields/s\n", sequence.name,
+                bytes * iterations / decodeTime.count() / 1e6,
+                fields / decodeTime.count() / 1e6);
+    std::printf("%s encode  %.1f M fields/s\n", sequence.name,
+                fields / encodeTime.count() / 1e6);
+  }
+  return 0;
+}